@@ -144,6 +144,13 @@ Java_com_google_android_filament_IndirectLight_nGetColorEstimate(JNIEnv* env, jc
     env->ReleaseFloatArrayElements(outColor_, outColor, 0);
 }
 
+extern "C" JNIEXPORT void JNICALL
+Java_com_google_android_filament_IndirectLight_nSetReflections(JNIEnv*, jclass,
+        jlong nativeIndirectLight, jlong nativeTexture) {
+    IndirectLight* indirectLight = (IndirectLight*) nativeIndirectLight;
+    indirectLight->setReflections((Texture const*) nativeTexture);
+}
+
 extern "C" JNIEXPORT jlong JNICALL
 Java_com_google_android_filament_IndirectLight_nGetReflectionsTexture(JNIEnv* env, jclass,
         jlong nativeIndirectLight) {
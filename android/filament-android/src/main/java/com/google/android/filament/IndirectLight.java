@@ -475,6 +475,18 @@ public class IndirectLight {
         return colorIntensity;
     }
 
+    /**
+     * Replaces the reflections cubemap mipmap chain.
+     *
+     * <p>The new texture is used starting with the next frame rendered, all the views using this
+     * <code>IndirectLight</code> switch to it at once. The previous texture is not destroyed.</p>
+     *
+     * @param cubemap A mip-mapped cubemap, see {@link Builder#reflections}, or null.
+     */
+    public void setReflections(@Nullable Texture cubemap) {
+        nSetReflections(getNativeObject(), cubemap != null ? cubemap.getNativeObject() : 0);
+    }
+
     @Nullable
     public Texture getReflectionsTexture() {
         long nativeTexture = nGetReflectionsTexture(getNativeObject());
@@ -510,6 +522,7 @@ public class IndirectLight {
     private static native void nRotation(long nativeBuilder, float v0, float v1, float v2, float v3, float v4, float v5, float v6, float v7, float v8) ;
 
     private static native void nSetIntensity(long nativeIndirectLight, float intensity);
+    private static native void nSetReflections(long nativeIndirectLight, long nativeTexture);
     private static native float nGetIntensity(long nativeIndirectLight);
     private static native void nSetRotation(long nativeIndirectLight, float v0, float v1, float v2, float v3, float v4, float v5, float v6, float v7, float v8);
     private static native void nGetRotation(long nativeIndirectLight, float[] outRotation);
@@ -0,0 +1,96 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TNT_FILAMENT_BACKEND_PRIVATE_BINDINGCACHE_H
+#define TNT_FILAMENT_BACKEND_PRIVATE_BINDINGCACHE_H
+
+#include <backend/DriverEnums.h>
+#include <backend/Handle.h>
+
+#include <utils/compiler.h>
+
+#include <algorithm>
+#include <iterator>
+
+#include <stdint.h>
+
+namespace filament {
+namespace backend {
+
+/*
+ * BindingCache remembers the uniform buffer and the sampler group bound at each binding point,
+ * so that binding again what's already bound can be skipped.
+ *
+ * A binding is never considered redundant when its handle is null, or when its index is out of
+ * range, so that the driver still gets to see (and report) these.
+ */
+class BindingCache {
+public:
+    // the whole buffer is bound when size is WHOLE_BUFFER
+    static constexpr uint32_t WHOLE_BUFFER = 0xFFFFFFFFu;
+
+    BindingCache() noexcept { reset(); }
+
+    // Forgets all the bindings, must be called when commands could have been issued to the
+    // driver behind our back.
+    void reset() noexcept {
+        std::fill(std::begin(mUniformBindings), std::end(mUniformBindings), UniformBinding{});
+        std::fill(std::begin(mSamplerBindings), std::end(mSamplerBindings), HandleBase::nullid);
+    }
+
+    // Records a bindUniformBuffer() or bindUniformBufferRange(), returns whether it changes
+    // the current binding. Use WHOLE_BUFFER as the size of bindUniformBuffer().
+    bool bindUniformBuffer(uint32_t index, HandleBase::HandleId id,
+            uint32_t offset, uint32_t size) noexcept {
+        if (UTILS_UNLIKELY(index >= CONFIG_BINDING_COUNT)) {
+            return true;
+        }
+        UniformBinding& binding = mUniformBindings[index];
+        if (id != HandleBase::nullid &&
+                binding.id == id && binding.offset == offset && binding.size == size) {
+            return false;
+        }
+        binding = { id, offset, size };
+        return true;
+    }
+
+    // Records a bindSamplers(), returns whether it changes the current binding.
+    bool bindSamplers(uint32_t index, HandleBase::HandleId id) noexcept {
+        if (UTILS_UNLIKELY(index >= CONFIG_BINDING_COUNT)) {
+            return true;
+        }
+        if (id != HandleBase::nullid && mSamplerBindings[index] == id) {
+            return false;
+        }
+        mSamplerBindings[index] = id;
+        return true;
+    }
+
+private:
+    struct UniformBinding {
+        HandleBase::HandleId id = HandleBase::nullid;
+        uint32_t offset = 0;
+        uint32_t size = 0;
+    };
+
+    UniformBinding mUniformBindings[CONFIG_BINDING_COUNT];
+    HandleBase::HandleId mSamplerBindings[CONFIG_BINDING_COUNT];
+};
+
+} // namespace backend
+} // namespace filament
+
+#endif // TNT_FILAMENT_BACKEND_PRIVATE_BINDINGCACHE_H
@@ -32,11 +32,13 @@ namespace backend {
  * A producer-consumer command queue that uses a CircularBuffer as main storage
  */
 class CommandBufferQueue {
+public:
     struct Slice {
         void* begin;
         void* end;
     };
 
+private:
     const size_t mRequiredSize;
 
     CircularBuffer mCircularBuffer;
@@ -56,6 +56,7 @@ namespace backend {
 
 class Driver;
 class CommandBase;
+class CommandStreamDecoder;
 
 /*
  * Dispatcher is a data structure containing only function pointers.
@@ -105,6 +106,7 @@ public:
     inline ~CommandBase() noexcept = default;
 
 private:
+    friend class CommandStreamDecoder;
     Execute mExecute;
 };
 
@@ -155,6 +157,8 @@ struct CommandType<void (Driver::*)(ARGS...)> {
         void log() noexcept;
         template<std::size_t... I> void log(std::index_sequence<I...>) noexcept;
 
+        friend class CommandStreamDecoder;
+
     public:
         template<typename M, typename D>
         static inline void execute(M&& method, D&& driver, CommandBase* base, intptr_t* next) noexcept {
@@ -192,6 +196,7 @@ struct CommandType<void (Driver::*)(ARGS...)> {
 class CustomCommand : public CommandBase {
     std::function<void()> mCommand;
     static void execute(Driver&, CommandBase* base, intptr_t* next) noexcept;
+    friend class CommandStreamDecoder;
 public:
     inline CustomCommand(CustomCommand&& rhs) = default;
     inline explicit CustomCommand(std::function<void()> cmd)
@@ -205,6 +210,7 @@ class NoopCommand : public CommandBase {
     static void execute(Driver&, CommandBase* self, intptr_t* next) noexcept {
         *next = static_cast<NoopCommand*>(self)->mNext;
     }
+    friend class CommandStreamDecoder;
 public:
     inline constexpr explicit NoopCommand(void* next) noexcept
             : CommandBase(execute), mNext(size_t((char *)next - (char *)this)) { }
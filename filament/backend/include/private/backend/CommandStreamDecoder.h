@@ -0,0 +1,120 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TNT_FILAMENT_BACKEND_PRIVATE_COMMANDSTREAMDECODER_H
+#define TNT_FILAMENT_BACKEND_PRIVATE_COMMANDSTREAMDECODER_H
+
+#include "private/backend/BindingCache.h"
+#include "private/backend/CommandStream.h"
+
+#include <backend/DriverEnums.h>
+#include <backend/Handle.h>
+
+#include <utils/compiler.h>
+
+#include <vector>
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace filament {
+namespace backend {
+
+/*
+ * CommandStreamDecoder walks a slice of the CommandStream without executing it, so that this
+ * work can happen on a different thread than the one submitting the commands to the GPU.
+ *
+ * While walking the commands, the decoder:
+ * - validates that each command is a known driver command and that it fits in its slice,
+ * - replaces redundant bindUniformBuffer(), bindUniformBufferRange() and bindSamplers() calls
+ *   with a NoopCommand, so they're skipped by the driver.
+ *
+ * A binding is redundant when it's identical to the previous binding at the same index, and
+ * only draw(), other bindings and debug markers were issued in between. Any other command
+ * conservatively forgets all the bindings.
+ *
+ * The size of a command isn't stored in the CommandStream, it's only known by its Execute
+ * function; the decoder builds a table from the Dispatcher to recover it. If two commands
+ * share the same Execute function (e.g. due to identical code folding), the decoder can't
+ * tell them apart and isValid() returns false; the caller must then fall back to executing
+ * the CommandStream directly.
+ */
+class CommandStreamDecoder {
+public:
+    struct Statistics {
+        size_t slices = 0;      // number of slices decoded
+        size_t commands = 0;    // number of commands decoded (excluding NoopCommands)
+        size_t elided = 0;      // number of commands replaced by a NoopCommand
+    };
+
+    explicit CommandStreamDecoder(Dispatcher const& dispatcher);
+
+    CommandStreamDecoder(CommandStreamDecoder const& rhs) = delete;
+    CommandStreamDecoder& operator=(CommandStreamDecoder const& rhs) = delete;
+
+    // whether this decoder can be used with the Dispatcher it was created with
+    bool isValid() const noexcept { return mValid; }
+
+    // Decodes the slice [begin, end) of the CommandStream, which must be terminated by a
+    // NoopCommand(nullptr), as written by CommandBufferQueue::flush().
+    void decode(void* begin, void* end) noexcept;
+
+    Statistics const& getStatistics() const noexcept { return mStatistics; }
+    void resetStatistics() noexcept { mStatistics = {}; }
+
+private:
+    using Execute = Dispatcher::Execute;
+
+    enum class Kind : uint8_t {
+        OTHER,                      // forgets all bindings
+        NOOP,                       // NoopCommand, variable size
+        DRAW,                       // doesn't affect the bindings
+        MARKER,                     // doesn't affect the bindings
+        BIND_UNIFORM_BUFFER,
+        BIND_UNIFORM_BUFFER_RANGE,
+        BIND_SAMPLERS,
+    };
+
+    struct Entry {
+        uintptr_t execute;
+        uint32_t size;
+        Kind kind;
+    };
+
+    // fibonacci hashing, uses the high bits of the product
+    size_t slot(uintptr_t key) const noexcept {
+        return size_t((uint64_t(key) * 0x9E3779B97F4A7C15ull) >> mShift);
+    }
+
+    void add(Execute execute, size_t size, Kind kind);
+    Entry* find(Execute execute) noexcept;
+
+    // open-addressing hash table of all the commands, indexed by their Execute function
+    std::vector<Entry> mEntries;
+    size_t mMask = 0;
+    uint32_t mShift = 64;
+    bool mValid = true;
+
+    // current bindings, as seen by the driver
+    BindingCache mBindings;
+
+    Statistics mStatistics;
+};
+
+} // namespace backend
+} // namespace filament
+
+#endif // TNT_FILAMENT_BACKEND_PRIVATE_COMMANDSTREAMDECODER_H
@@ -0,0 +1,70 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TNT_FILAMENT_BACKEND_PRIVATE_DECODEDCOMMANDBUFFERQUEUE_H
+#define TNT_FILAMENT_BACKEND_PRIVATE_DECODEDCOMMANDBUFFERQUEUE_H
+
+#include "private/backend/CommandBufferQueue.h"
+
+#include <utils/Condition.h>
+#include <utils/Mutex.h>
+#include <utils/SpscQueue.h>
+
+#include <atomic>
+
+namespace filament {
+namespace backend {
+
+/*
+ * Hands the command buffers (Slices) over from the thread decoding them to the thread executing
+ * them, in order.
+ *
+ * The hand-over itself is lock-free, the lock is only taken when either side needs to sleep
+ * because the queue is empty or full.
+ */
+class DecodedCommandBufferQueue {
+    using Slice = CommandBufferQueue::Slice;
+
+    // The number of slices in flight is bounded by the size of the CircularBuffer, so the
+    // producer rarely has to wait.
+    static constexpr size_t CAPACITY = 64;
+
+    utils::SpscQueue<Slice, CAPACITY> mQueue;
+    std::atomic<bool> mProducerWaiting = { false };
+    std::atomic<bool> mConsumerWaiting = { false };
+    utils::Mutex mLock;
+    utils::Condition mCondition;
+
+    void wake(std::atomic<bool> const& waiting) noexcept;
+
+public:
+    // Adds a slice to execute, blocks if the queue is full.
+    // Must be called from the decoding thread.
+    void push(Slice const& slice) noexcept;
+
+    // Returns the next slice to execute, blocks until one is available.
+    // Must be called from the executing thread.
+    Slice pop() noexcept;
+
+    // Unblocks pop(), which then returns an empty Slice.
+    // Must be called from the decoding thread.
+    void requestExit() noexcept { push({}); }
+};
+
+} // namespace backend
+} // namespace filament
+
+#endif // TNT_FILAMENT_BACKEND_PRIVATE_DECODEDCOMMANDBUFFERQUEUE_H
@@ -19,11 +19,16 @@
 
 #include <backend/Handle.h>
 
-#include <utils/Allocator.h>
 #include <utils/Log.h>
+#include <utils/Mutex.h>
 #include <utils/compiler.h>
-#include <tsl/robin_map.h>
-#include <unordered_map>
+#include <utils/debug.h>
+
+#include <atomic>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 #if !defined(NDEBUG) && UTILS_HAS_RTTI
 #   define HANDLE_TYPE_SAFETY 1
@@ -31,6 +36,11 @@
 #   define HANDLE_TYPE_SAFETY 0
 #endif
 
+#if HANDLE_TYPE_SAFETY
+#   include <typeinfo>
+#   include <unordered_map>
+#endif
+
 #define HandleAllocatorGL  HandleAllocator<16, 64, 208>
 #define HandleAllocatorVK  HandleAllocator<16, 64, 880>
 #define HandleAllocatorMTL HandleAllocator<16, 64, 576>
@@ -39,6 +49,12 @@ namespace filament::backend {
 
 /*
  * A utility class to efficiently allocate and manage Handle<>
+ *
+ * Handles are allocated from three size classes (P0, P1 and P2 bytes) in an arena made of
+ * segments, which grows when it's full. Allocating and freeing a handle is usually served by a
+ * per-thread cache without synchronization; the caches exchange handles in batches through
+ * lock-free free lists, so that a thread allocating handles and another one freeing them don't
+ * contend on a lock. handle_cast<> never takes a lock.
  */
 template <size_t P0, size_t P1, size_t P2>
 class HandleAllocator {
@@ -61,7 +77,7 @@ public:
      */
     template<typename D, typename ... ARGS>
     Handle<D> allocateAndConstruct(ARGS&& ... args) noexcept {
-        Handle<D> h{ allocateHandle(sizeof(D)) };
+        Handle<D> h{ allocateHandle<sizeof(D)>() };
         D* addr = handle_cast<D*>(h);
         new(addr) D(std::forward<ARGS>(args)...);
 #if HANDLE_TYPE_SAFETY
@@ -84,7 +100,7 @@ public:
      */
     template<typename D>
     Handle<D> allocate() noexcept {
-        Handle<D> h{ allocateHandle(sizeof(D)) };
+        Handle<D> h{ allocateHandle<sizeof(D)>() };
 #if HANDLE_TYPE_SAFETY
         D* addr = handle_cast<D*>(h);
         mLock.lock();
@@ -167,7 +183,7 @@ public:
             }
 #endif
             p->~D();
-            deallocateHandle(handle.getId(), sizeof(D));
+            deallocateHandle<sizeof(D)>(handle.getId());
         }
     }
 
@@ -209,105 +225,158 @@ public:
 
 
 private:
+    // handles are offsets in the arena, in units of MIN_ALIGNMENT
+    static constexpr size_t MIN_ALIGNMENT_SHIFT = 4;
+    static constexpr size_t MIN_ALIGNMENT = size_t(1) << MIN_ALIGNMENT_SHIFT;
 
-    // template <int P0, int P1, int P2>
-    class Allocator {
-        friend class HandleAllocator;
-        utils::PoolAllocator<P0, 16>   mPool0;
-        utils::PoolAllocator<P1, 16>   mPool1;
-        utils::PoolAllocator<P2, 16>   mPool2;
-        UTILS_UNUSED_IN_RELEASE const utils::AreaPolicy::HeapArea& mArea;
-    public:
-        static constexpr size_t MIN_ALIGNMENT_SHIFT = 4;
-        explicit Allocator(const utils::AreaPolicy::HeapArea& area);
-
-        // this is in fact always called with a constexpr size argument
-        [[nodiscard]] inline void* alloc(size_t size, size_t alignment, size_t extra) noexcept {
-            void* p = nullptr;
-                 if (size <= mPool0.getSize()) p = mPool0.alloc(size, 16, extra);
-            else if (size <= mPool1.getSize()) p = mPool1.alloc(size, 16, extra);
-            else if (size <= mPool2.getSize()) p = mPool2.alloc(size, 16, extra);
-            return p;
-        }
+    // the arena grows by segments of the size given at construction, up to this many
+    static constexpr size_t MAX_SEGMENT_COUNT = 256;
 
-        // this is in fact always called with a constexpr size argument
-        inline void free(void* p, size_t size) noexcept {
-            assert_invariant(p >= mArea.begin() && (char*)p + size <= (char*)mArea.end());
-            if (size <= mPool0.getSize()) { mPool0.free(p); return; }
-            if (size <= mPool1.getSize()) { mPool1.free(p); return; }
-            if (size <= mPool2.getSize()) { mPool2.free(p); return; }
-        }
-    };
+    // number of handles of each size class cached per thread, and number of handles moved at
+    // once between a thread's cache and the shared free lists
+    static constexpr uint32_t CACHE_CAPACITY = 64;
+    static constexpr uint32_t CACHE_BATCH = 32;
 
+    static constexpr size_t SIZE_CLASS_COUNT = 3;
+    static constexpr size_t SIZE_CLASSES[SIZE_CLASS_COUNT] = { P0, P1, P2 };
 
-#ifndef NDEBUG
-    using HandleArena = utils::Arena<Allocator,
-            utils::LockingPolicy::SpinLock,
-            utils::TrackingPolicy::DebugAndHighWatermark>;
-#else
-    using HandleArena = utils::Arena<Allocator,
-            utils::LockingPolicy::SpinLock>;
-#endif
+    static_assert(P0 < P1 && P1 < P2, "sizes must be in increasing order");
+    static_assert(P0 % MIN_ALIGNMENT == 0 && P1 % MIN_ALIGNMENT == 0 && P2 % MIN_ALIGNMENT == 0,
+            "sizes must be multiples of the minimum alignment");
 
-    // this is inlined because we're always called with a constexpr size
-    HandleBase::HandleId allocateHandle(size_t size) noexcept {
-        void* p = mHandleArena.alloc(size);
-        if (UTILS_LIKELY(p)) {
-            return pointerToHandle(p);
-        } else {
-            return allocateHandleSlow(size);
+    // the null handle has this bit set, no other handle does
+    static constexpr HandleBase::HandleId INVALID_HANDLE_FLAG = 0x80000000u;
+
+    template<size_t SIZE>
+    static constexpr size_t getSizeClass() noexcept {
+        static_assert(SIZE <= P2, "type is too large for this HandleAllocator");
+        return SIZE <= P0 ? 0 : (SIZE <= P1 ? 1 : 2);
+    }
+
+    /*
+     * Handles freed by a thread are kept in its cache, and handed out again to that thread
+     * without any synchronization. A cache belongs to one HandleAllocator at a time, identified
+     * by its instance id, which is never reused.
+     */
+    struct ThreadCache {
+        struct Bin {
+            uint32_t count = 0;
+            HandleBase::HandleId handles[CACHE_CAPACITY];
+        };
+        uint64_t owner = 0;
+        Bin bins[SIZE_CLASS_COUNT];
+        ~ThreadCache() noexcept { releaseThreadCache(*this); }
+        void clear() noexcept {
+            owner = 0;
+            for (Bin& bin : bins) {
+                bin.count = 0;
+            }
         }
+    };
+
+    static ThreadCache& getThreadCache() noexcept {
+        static thread_local ThreadCache cache;
+        return cache;
     }
 
     // this is inlined because we're always called with a constexpr size
-    void deallocateHandle(HandleBase::HandleId id, size_t size) noexcept {
-        if (UTILS_LIKELY(isPoolHandle(id))) {
-            void* p = handleToPointer(id);
-            mHandleArena.free(p, size);
-        } else {
-            deallocateHandleSlow(id, size);
+    template<size_t SIZE>
+    HandleBase::HandleId allocateHandle() noexcept {
+        constexpr size_t sizeClass = getSizeClass<SIZE>();
+        ThreadCache& cache = getThreadCache();
+        typename ThreadCache::Bin& bin = cache.bins[sizeClass];
+        if (UTILS_LIKELY(cache.owner == mInstanceId && bin.count)) {
+            return bin.handles[--bin.count];
         }
+        return allocateHandleSlow(sizeClass);
     }
 
-    static constexpr uint32_t HEAP_HANDLE_FLAG = 0x80000000u;
-
-    static bool isPoolHandle(HandleBase::HandleId id) noexcept {
-        return (id & HEAP_HANDLE_FLAG) == 0u;
+    // this is inlined because we're always called with a constexpr size
+    template<size_t SIZE>
+    void deallocateHandle(HandleBase::HandleId id) noexcept {
+        constexpr size_t sizeClass = getSizeClass<SIZE>();
+        ThreadCache& cache = getThreadCache();
+        typename ThreadCache::Bin& bin = cache.bins[sizeClass];
+        if (UTILS_LIKELY(cache.owner == mInstanceId && bin.count < CACHE_CAPACITY)) {
+            bin.handles[bin.count++] = id;
+            return;
+        }
+        deallocateHandleSlow(id, sizeClass);
     }
 
-    HandleBase::HandleId allocateHandleSlow(size_t size) noexcept;
-    void deallocateHandleSlow(HandleBase::HandleId id, size_t size) noexcept;
+    HandleBase::HandleId allocateHandleSlow(size_t sizeClass) noexcept;
+    void deallocateHandleSlow(HandleBase::HandleId id, size_t sizeClass) noexcept;
 
-    // We inline this because it's just 4 instructions in the fast case
+    // We inline this because it's just a few instructions
     inline void* handleToPointer(HandleBase::HandleId id) const noexcept {
-        // note: the null handle will end-up returning nullptr b/c it'll be handled as
-        // a non-pool handle.
-        if (UTILS_LIKELY(isPoolHandle(id))) {
-            char* const base = (char*)mHandleArena.getArea().begin();
-            size_t offset = id << Allocator::MIN_ALIGNMENT_SHIFT;
-            return static_cast<void*>(base + offset);
+        // note: the null handle ends-up returning nullptr
+        if (UTILS_UNLIKELY(id & INVALID_HANDLE_FLAG)) {
+            return nullptr;
         }
-        return handleToPointerSlow(id);
+        char* const base = mSegments[id >> mSegmentShift].load(std::memory_order_relaxed);
+        return base + (size_t(id & mSegmentMask) << MIN_ALIGNMENT_SHIFT);
     }
 
-    void* handleToPointerSlow(HandleBase::HandleId id) const noexcept;
+    /*
+     * The shared free lists are lists of batches of handles, so that a whole batch is moved
+     * with a single compare-and-swap. The links are stored in the free handles' memory.
+     */
+    struct FreeNode {
+        std::atomic<HandleBase::HandleId> next;         // next handle of this batch
+        std::atomic<HandleBase::HandleId> nextBatch;    // next batch, only valid on its first handle
+        uint32_t count;                                 // only valid on the first handle
+    };
 
-    // We inline this because it's just 3 instructions
-    inline HandleBase::HandleId pointerToHandle(void* p) const noexcept {
-        char* const base = (char*)mHandleArena.getArea().begin();
-        size_t offset = (char*)p - base;
-        auto id = HandleBase::HandleId(offset >> Allocator::MIN_ALIGNMENT_SHIFT);
-        assert_invariant((id & HEAP_HANDLE_FLAG) == 0);
-        return id;
+    static_assert(sizeof(FreeNode) <= P0, "the smallest size can't hold a free list node");
+
+    FreeNode& getFreeNode(HandleBase::HandleId id) const noexcept {
+        return *static_cast<FreeNode*>(handleToPointer(id));
     }
 
-    HandleArena mHandleArena;
+    // lock-free free lists shared by all threads, these take/return at most CACHE_BATCH handles
+    uint32_t popFreeHandles(size_t sizeClass, HandleBase::HandleId* ids) noexcept;
+    void pushFreeHandles(size_t sizeClass, HandleBase::HandleId const* ids, size_t count) noexcept;
+
+    // takes handles that were never used from the arena, growing it if needed
+    void allocateFromArena(size_t sizeClass, HandleBase::HandleId* ids, size_t count) noexcept;
+
+    // makes the cache of the calling thread belong to this allocator
+    void adoptThreadCache(ThreadCache& cache) noexcept;
+
+    // returns the cached handles to their allocator, if it still exists
+    static void releaseThreadCache(ThreadCache& cache) noexcept;
+
+    // the allocators alive, to which thread caches can be returned
+    struct Registry {
+        utils::Mutex lock;
+        std::vector<std::pair<uint64_t, HandleAllocator*>> allocators;
+    };
+    static Registry& getRegistry() noexcept;
+
+    const char* const mName;
+    uint64_t const mInstanceId;
+
+    // The segments never move nor are freed before the HandleAllocator is destroyed, so that
+    // handleToPointer() doesn't need to synchronize with the threads growing the arena.
+    std::atomic<char*> mSegments[MAX_SEGMENT_COUNT] = {};
+    size_t const mSegmentSize;
+    uint32_t mSegmentShift = 0;
+    HandleBase::HandleId mSegmentMask = 0;
+    size_t mMaxSegmentCount = 0;
+
+    // head of each free list: a handle id, and a tag in the high bits to avoid the ABA problem
+    struct alignas(64) FreeList {
+        std::atomic<uint64_t> head = { HandleBase::nullid };
+    };
+    FreeList mFreeLists[SIZE_CLASS_COUNT];
+
+    // only used when the free lists are empty
+    utils::Mutex mArenaLock;
+    size_t mSegmentCount = 0;
+    size_t mArenaOffset = 0;
 
-    // Below is only used when running out of space in the HandleArena
-    mutable utils::Mutex mLock;
-    tsl::robin_map<HandleBase::HandleId, void*> mOverflowMap;
-    HandleBase::HandleId mId = 0;
 #if HANDLE_TYPE_SAFETY
+    mutable utils::Mutex mLock;
     mutable std::unordered_map<const void*, const char*> mHandleTypeId;
 #endif
 };
@@ -0,0 +1,192 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "private/backend/CommandStreamDecoder.h"
+
+#include <utils/Allocator.h>
+#include <utils/Panic.h>
+#include <utils/Systrace.h>
+#include <utils/debug.h>
+
+#include <algorithm>
+#include <new>
+#include <tuple>
+#include <type_traits>
+
+using namespace utils;
+
+namespace filament {
+namespace backend {
+
+using BindUniformBuffer = COMMAND_TYPE(bindUniformBuffer);
+using BindUniformBufferRange = COMMAND_TYPE(bindUniformBufferRange);
+using BindSamplers = COMMAND_TYPE(bindSamplers);
+using Draw = COMMAND_TYPE(draw);
+
+// elided commands are overwritten in place by a NoopCommand, without calling their destructor
+static_assert(std::is_trivially_destructible<BindUniformBuffer>::value &&
+              std::is_trivially_destructible<BindUniformBufferRange>::value &&
+              std::is_trivially_destructible<BindSamplers>::value,
+        "elided commands must be trivially destructible");
+
+static_assert(sizeof(NoopCommand) <= CommandBase::align(sizeof(BindUniformBuffer)) &&
+              sizeof(NoopCommand) <= CommandBase::align(sizeof(BindUniformBufferRange)) &&
+              sizeof(NoopCommand) <= CommandBase::align(sizeof(BindSamplers)),
+        "elided commands must be large enough to hold a NoopCommand");
+
+CommandStreamDecoder::CommandStreamDecoder(Dispatcher const& dispatcher) {
+    // a table at most 1/4 full, so most lookups only need one probe
+    size_t count = 2; // CustomCommand and NoopCommand
+#define DECL_DRIVER_API_SYNCHRONOUS(RetType, methodName, paramsDecl, params)
+#define DECL_DRIVER_API(methodName, paramsDecl, params)                 count++;
+#define DECL_DRIVER_API_RETURN(RetType, methodName, paramsDecl, params) count++;
+#include "private/backend/DriverAPI.inc"
+    size_t size = 1;
+    while (size < count * 4) {
+        size *= 2;
+        mShift--;
+    }
+    mEntries.resize(size, Entry{});
+    mMask = size - 1;
+
+    // all the commands that can be found in the CommandStream, and their size
+#define DECL_DRIVER_API_SYNCHRONOUS(RetType, methodName, paramsDecl, params)
+#define DECL_DRIVER_API(methodName, paramsDecl, params)                                         \
+    add(dispatcher.methodName##_,                                                               \
+            CommandBase::align(sizeof(COMMAND_TYPE(methodName))), Kind::OTHER);
+#define DECL_DRIVER_API_RETURN(RetType, methodName, paramsDecl, params)                         \
+    add(dispatcher.methodName##_,                                                               \
+            CommandBase::align(sizeof(COMMAND_TYPE(methodName##R))), Kind::OTHER);
+#include "private/backend/DriverAPI.inc"
+
+    add(&CustomCommand::execute, CommandBase::align(sizeof(CustomCommand)), Kind::OTHER);
+    add(&NoopCommand::execute, 0, Kind::NOOP);
+
+    if (UTILS_UNLIKELY(!mValid)) {
+        return;
+    }
+
+    // the commands that don't invalidate the bindings we're tracking
+    find(dispatcher.draw_)->kind = Kind::DRAW;
+    find(dispatcher.insertEventMarker_)->kind = Kind::MARKER;
+    find(dispatcher.pushGroupMarker_)->kind = Kind::MARKER;
+    find(dispatcher.popGroupMarker_)->kind = Kind::MARKER;
+    find(dispatcher.bindUniformBuffer_)->kind = Kind::BIND_UNIFORM_BUFFER;
+    find(dispatcher.bindUniformBufferRange_)->kind = Kind::BIND_UNIFORM_BUFFER_RANGE;
+    find(dispatcher.bindSamplers_)->kind = Kind::BIND_SAMPLERS;
+}
+
+void CommandStreamDecoder::add(Execute execute, size_t size, Kind kind) {
+    uintptr_t const key = uintptr_t(execute);
+    if (UTILS_UNLIKELY(!key || find(execute))) {
+        // If two commands share their Execute function (e.g. because of identical code
+        // folding), we can't know their size or what they do.
+        mValid = false;
+        return;
+    }
+    size_t i = slot(key);
+    while (mEntries[i].execute) {
+        i = (i + 1) & mMask;
+    }
+    mEntries[i] = { key, uint32_t(size), kind };
+}
+
+CommandStreamDecoder::Entry* CommandStreamDecoder::find(Execute execute) noexcept {
+    uintptr_t const key = uintptr_t(execute);
+    for (size_t i = slot(key); mEntries[i].execute; i = (i + 1) & mMask) {
+        if (mEntries[i].execute == key) {
+            return &mEntries[i];
+        }
+    }
+    return nullptr;
+}
+
+void CommandStreamDecoder::decode(void* begin, void* end) noexcept {
+    SYSTRACE_CALL();
+    assert_invariant(mValid);
+
+    // Commands issued before this slice have been decoded already, but synchronous driver calls
+    // could have been made since then; we start from a clean slate.
+    mBindings.reset();
+
+    size_t commands = 0;
+    size_t elided = 0;
+    CommandBase* base = static_cast<CommandBase*>(begin);
+    while (UTILS_LIKELY(base)) {
+        Entry const* const entry = find(base->mExecute);
+        ASSERT_POSTCONDITION(entry,
+                "Unknown command in the CommandStream. Commands are corrupted and unrecoverable.");
+
+        // The size of the most common commands is a constant: this lets the CPU speculate
+        // past the table lookup, which the next command's address would otherwise depend on.
+        intptr_t next;
+        bool elide = false;
+        switch (entry->kind) {
+            case Kind::NOOP:
+                next = static_cast<NoopCommand*>(base)->mNext;
+                break;
+            case Kind::OTHER:
+                next = entry->size;
+                mBindings.reset();
+                break;
+            case Kind::DRAW:
+                next = CommandBase::align(sizeof(Draw));
+                break;
+            case Kind::MARKER:
+                next = entry->size;
+                break;
+            case Kind::BIND_UNIFORM_BUFFER: {
+                next = CommandBase::align(sizeof(BindUniformBuffer));
+                auto const& args = static_cast<BindUniformBuffer*>(base)->mArgs;
+                elide = !mBindings.bindUniformBuffer(std::get<0>(args),
+                        std::get<1>(args).getId(), 0, BindingCache::WHOLE_BUFFER);
+                break;
+            }
+            case Kind::BIND_UNIFORM_BUFFER_RANGE: {
+                next = CommandBase::align(sizeof(BindUniformBufferRange));
+                auto const& args = static_cast<BindUniformBufferRange*>(base)->mArgs;
+                elide = !mBindings.bindUniformBuffer(std::get<0>(args),
+                        std::get<1>(args).getId(), std::get<2>(args), std::get<3>(args));
+                break;
+            }
+            case Kind::BIND_SAMPLERS: {
+                next = CommandBase::align(sizeof(BindSamplers));
+                auto const& args = static_cast<BindSamplers*>(base)->mArgs;
+                elide = !mBindings.bindSamplers(std::get<0>(args), std::get<1>(args).getId());
+                break;
+            }
+        }
+        commands += entry->kind != Kind::NOOP;
+
+        // the last command of the slice is a NoopCommand that points to nullptr
+        CommandBase* const nextCommand = reinterpret_cast<CommandBase*>(intptr_t(base) + next);
+        ASSERT_POSTCONDITION(!nextCommand || (nextCommand > base && (void*)nextCommand < end),
+                "CommandStream overflow. Commands are corrupted and unrecoverable.");
+
+        if (elide) {
+            new(base) NoopCommand(nextCommand);
+            elided++;
+        }
+        base = nextCommand;
+    }
+
+    mStatistics.slices++;
+    mStatistics.commands += commands;
+    mStatistics.elided += elided;
+}
+
+} // namespace backend
+} // namespace filament
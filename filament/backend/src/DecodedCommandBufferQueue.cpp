@@ -0,0 +1,76 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "private/backend/DecodedCommandBufferQueue.h"
+
+#include <utils/compiler.h>
+#include <utils/Systrace.h>
+
+#include <mutex>
+
+using namespace utils;
+
+namespace filament {
+namespace backend {
+
+/*
+ * The consumer only waits when the queue is empty and the producer only when it is full, so at
+ * most one of them is ever waiting. The waiting side raises its flag under the lock, then checks
+ * the queue again before sleeping; the other side modifies the queue, then checks that flag.
+ * The seq_cst fences guarantee that at least one of them sees the other's write, so a wake-up
+ * can't be lost.
+ */
+
+void DecodedCommandBufferQueue::wake(std::atomic<bool> const& waiting) noexcept {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (UTILS_UNLIKELY(waiting.load(std::memory_order_relaxed))) {
+        std::lock_guard<Mutex> lock(mLock);
+        mCondition.notify_one();
+    }
+}
+
+void DecodedCommandBufferQueue::push(Slice const& slice) noexcept {
+    while (UTILS_UNLIKELY(!mQueue.push(slice))) {
+        SYSTRACE_NAME("waiting: DecodedCommandBufferQueue::push()");
+        std::unique_lock<Mutex> lock(mLock);
+        mProducerWaiting.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (mQueue.full()) {
+            mCondition.wait(lock);
+        }
+        mProducerWaiting.store(false, std::memory_order_relaxed);
+    }
+    wake(mConsumerWaiting);
+}
+
+DecodedCommandBufferQueue::Slice DecodedCommandBufferQueue::pop() noexcept {
+    Slice slice{};
+    while (UTILS_UNLIKELY(!mQueue.pop(slice))) {
+        SYSTRACE_NAME("waiting: DecodedCommandBufferQueue::pop()");
+        std::unique_lock<Mutex> lock(mLock);
+        mConsumerWaiting.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (mQueue.empty()) {
+            mCondition.wait(lock);
+        }
+        mConsumerWaiting.store(false, std::memory_order_relaxed);
+    }
+    wake(mProducerWaiting);
+    return slice;
+}
+
+} // namespace backend
+} // namespace filament
@@ -16,89 +16,211 @@
 
 #include "private/backend/HandleAllocator.h"
 
+#include <utils/Log.h>
 #include <utils/Panic.h>
+#include <utils/memalign.h>
 
-#include <stdlib.h>
+#include <algorithm>
+#include <mutex>
 
 namespace filament::backend {
 
 using namespace utils;
 
-template <size_t P0, size_t P1, size_t P2>
-UTILS_NOINLINE
-HandleAllocator<P0, P1, P2>::Allocator::Allocator(AreaPolicy::HeapArea const& area)
-        : mArea(area) {
-    // TODO: we probably need a better way to set the size of these pools
-    const size_t unit = area.size() / 32;
-    const size_t offsetPool1 =      unit;
-    const size_t offsetPool2 = 16 * unit;
-    char* const p = (char*)area.begin();
-    mPool0 = PoolAllocator< P0, 16>(p, p + offsetPool1);
-    mPool1 = PoolAllocator< P1, 16>(p + offsetPool1, p + offsetPool2);
-    mPool2 = PoolAllocator< P2, 16>(p + offsetPool2, area.end());
+static uint64_t nextInstanceId() noexcept {
+    static std::atomic<uint64_t> sInstanceId = { 0 };
+    return ++sInstanceId;
 }
 
-// ------------------------------------------------------------------------------------------------
-
 template <size_t P0, size_t P1, size_t P2>
 HandleAllocator<P0, P1, P2>::HandleAllocator(const char* name, size_t size) noexcept
-    : mHandleArena(name, size) {
+    : mName(name), mInstanceId(nextInstanceId()), mSegmentSize(size) {
+    assert_invariant(size >= P2);
+
+    // ids are offsets in the arena: the low bits address a segment, the high bits select it
+    while ((size_t(1) << mSegmentShift) * MIN_ALIGNMENT < size) {
+        mSegmentShift++;
+    }
+    mSegmentMask = HandleBase::HandleId((1u << mSegmentShift) - 1u);
+    assert_invariant(mSegmentShift < 31);
+    mMaxSegmentCount = std::min(MAX_SEGMENT_COUNT, size_t(INVALID_HANDLE_FLAG >> mSegmentShift));
+
+    mSegments[0].store((char*)utils::aligned_alloc(size, MIN_ALIGNMENT), std::memory_order_relaxed);
+    mSegmentCount = 1;
+
+    Registry& registry = getRegistry();
+    std::lock_guard lock(registry.lock);
+    registry.allocators.emplace_back(mInstanceId, this);
 }
 
 template <size_t P0, size_t P1, size_t P2>
 HandleAllocator<P0, P1, P2>::~HandleAllocator() {
-    auto& overflowMap = mOverflowMap;
-    if (!overflowMap.empty()) {
-        PANIC_LOG("Not all handles have been freed. Probably leaking memory.");
-        // Free remaining handle memory
-        for (auto& entry : overflowMap) {
-            ::free(entry.second);
-        }
+    Registry& registry = getRegistry();
+    std::unique_lock lock(registry.lock);
+    auto& allocators = registry.allocators;
+    allocators.erase(std::find_if(allocators.begin(), allocators.end(),
+            [this](auto const& entry) { return entry.first == mInstanceId; }));
+    lock.unlock();
+
+    // the caches of the other threads are dropped the next time they're used
+    ThreadCache& cache = getThreadCache();
+    if (cache.owner == mInstanceId) {
+        cache.clear();
     }
+
+    for (size_t i = 0; i < mSegmentCount; i++) {
+        utils::aligned_free(mSegments[i].load(std::memory_order_relaxed));
+    }
+}
+
+template <size_t P0, size_t P1, size_t P2>
+typename HandleAllocator<P0, P1, P2>::Registry&
+HandleAllocator<P0, P1, P2>::getRegistry() noexcept {
+    // never destroyed, because threads can exit after the static destructors have run
+    static Registry* const sRegistry = new Registry;
+    return *sRegistry;
 }
 
 template <size_t P0, size_t P1, size_t P2>
 UTILS_NOINLINE
-void* HandleAllocator<P0, P1, P2>::handleToPointerSlow(HandleBase::HandleId id) const noexcept {
-    auto& overflowMap = mOverflowMap;
-    std::lock_guard lock(mLock);
-    auto pos = overflowMap.find(id);
-    if (pos != overflowMap.end()) {
-        return pos.value();
+HandleBase::HandleId HandleAllocator<P0, P1, P2>::allocateHandleSlow(size_t sizeClass) noexcept {
+    ThreadCache& cache = getThreadCache();
+    adoptThreadCache(cache);
+
+    // refill the cache from the free lists first, so that memory is reused
+    typename ThreadCache::Bin& bin = cache.bins[sizeClass];
+    assert_invariant(!bin.count);
+    bin.count = popFreeHandles(sizeClass, bin.handles);
+    if (!bin.count) {
+        allocateFromArena(sizeClass, bin.handles, CACHE_BATCH);
+        bin.count = CACHE_BATCH;
     }
-    return nullptr;
+    return bin.handles[--bin.count];
 }
 
 template <size_t P0, size_t P1, size_t P2>
-HandleBase::HandleId HandleAllocator<P0, P1, P2>::allocateHandleSlow(size_t size) noexcept {
-    void* p = ::malloc(size);
-    std::unique_lock lock(mLock);
-    HandleBase::HandleId id = (++mId) | HEAP_HANDLE_FLAG;
-    mOverflowMap.emplace(id, p);
-    lock.unlock();
+UTILS_NOINLINE
+void HandleAllocator<P0, P1, P2>::deallocateHandleSlow(HandleBase::HandleId id,
+        size_t sizeClass) noexcept {
+    ThreadCache& cache = getThreadCache();
+    adoptThreadCache(cache);
+
+    // the cache is full, hand a batch over to the other threads
+    typename ThreadCache::Bin& bin = cache.bins[sizeClass];
+    if (bin.count == CACHE_CAPACITY) {
+        bin.count -= CACHE_BATCH;
+        pushFreeHandles(sizeClass, bin.handles + bin.count, CACHE_BATCH);
+    }
+    bin.handles[bin.count++] = id;
+}
 
-    if (UTILS_UNLIKELY(id == (HEAP_HANDLE_FLAG|1u))) { // meaning id was zero
-        PANIC_LOG("HandleAllocator arena is full, using slower system heap. Please increase "
-                  "the appropriate constant (e.g. FILAMENT_OPENGL_HANDLE_ARENA_SIZE_IN_MB).");
+template <size_t P0, size_t P1, size_t P2>
+uint32_t HandleAllocator<P0, P1, P2>::popFreeHandles(size_t sizeClass,
+        HandleBase::HandleId* ids) noexcept {
+    std::atomic<uint64_t>& head = mFreeLists[sizeClass].head;
+    uint64_t current = head.load(std::memory_order_acquire);
+    while (HandleBase::HandleId(current) != HandleBase::nullid) {
+        // If another thread raced ahead of us, the link we read here might be stale or already
+        // overwritten, but then the tag has changed and compare_exchange fails. Free handles are
+        // never unmapped, so reading it is always safe.
+        HandleBase::HandleId const first = HandleBase::HandleId(current);
+        FreeNode& node = getFreeNode(first);
+        HandleBase::HandleId const next = node.nextBatch.load(std::memory_order_relaxed);
+        uint64_t const tag = (current >> 32u) + 1u;
+        if (head.compare_exchange_weak(current, (tag << 32u) | next,
+                std::memory_order_acquire, std::memory_order_acquire)) {
+            // the batch is ours now
+            uint32_t const count = node.count;
+            assert_invariant(count && count <= CACHE_BATCH);
+            HandleBase::HandleId id = first;
+            for (uint32_t i = 0; i < count; i++) {
+                ids[i] = id;
+                id = getFreeNode(id).next.load(std::memory_order_relaxed);
+            }
+            return count;
+        }
     }
-    return id;
+    return 0;
 }
 
 template <size_t P0, size_t P1, size_t P2>
-void HandleAllocator<P0, P1, P2>::deallocateHandleSlow(HandleBase::HandleId id, size_t) noexcept {
-    assert_invariant(id & HEAP_HANDLE_FLAG);
-    void* p = nullptr;
-    auto& overflowMap = mOverflowMap;
-
-    std::unique_lock lock(mLock);
-    auto pos = overflowMap.find(id);
-    if (pos != overflowMap.end()) {
-        p = pos.value();
-        overflowMap.erase(pos);
+void HandleAllocator<P0, P1, P2>::pushFreeHandles(size_t sizeClass,
+        HandleBase::HandleId const* ids, size_t count) noexcept {
+    assert_invariant(count && count <= CACHE_BATCH);
+    for (size_t i = 0; i < count - 1; i++) {
+        getFreeNode(ids[i]).next.store(ids[i + 1], std::memory_order_relaxed);
     }
-    lock.unlock();
+    FreeNode& node = getFreeNode(ids[0]);
+    node.count = uint32_t(count);
+    std::atomic<uint64_t>& head = mFreeLists[sizeClass].head;
+    uint64_t current = head.load(std::memory_order_relaxed);
+    uint64_t desired;
+    do {
+        node.nextBatch.store(HandleBase::HandleId(current), std::memory_order_relaxed);
+        uint64_t const tag = (current >> 32u) + 1u;
+        desired = (tag << 32u) | ids[0];
+    } while (!head.compare_exchange_weak(current, desired,
+            std::memory_order_release, std::memory_order_relaxed));
+}
+
+template <size_t P0, size_t P1, size_t P2>
+UTILS_NOINLINE
+void HandleAllocator<P0, P1, P2>::allocateFromArena(size_t sizeClass,
+        HandleBase::HandleId* ids, size_t count) noexcept {
+    size_t const size = SIZE_CLASSES[sizeClass];
+    std::lock_guard lock(mArenaLock);
+    for (size_t i = 0; i < count; i++) {
+        if (UTILS_UNLIKELY(mArenaOffset + size > mSegmentSize)) {
+            ASSERT_POSTCONDITION(mSegmentCount < mMaxSegmentCount,
+                    "HandleAllocator arena \"%s\" is full (%u segments of %u bytes)",
+                    mName, unsigned(mSegmentCount), unsigned(mSegmentSize));
+            if (mSegmentCount == 1) {
+                slog.w << "HandleAllocator arena \"" << mName << "\" is full, growing it. "
+                          "Consider increasing the appropriate constant "
+                          "(e.g. FILAMENT_OPENGL_HANDLE_ARENA_SIZE_IN_MB)." << io::endl;
+            }
+            // The new segment is published to other threads along with the handles it holds.
+            char* const segment = (char*)utils::aligned_alloc(mSegmentSize, MIN_ALIGNMENT);
+            mSegments[mSegmentCount++].store(segment, std::memory_order_relaxed);
+            mArenaOffset = 0;
+        }
+        ids[i] = HandleBase::HandleId(((mSegmentCount - 1) << mSegmentShift) |
+                (mArenaOffset >> MIN_ALIGNMENT_SHIFT));
+        mArenaOffset += size;
+    }
+}
 
-    ::free(p);
+template <size_t P0, size_t P1, size_t P2>
+void HandleAllocator<P0, P1, P2>::adoptThreadCache(ThreadCache& cache) noexcept {
+    if (UTILS_UNLIKELY(cache.owner != mInstanceId)) {
+        // this thread was last used with another allocator
+        releaseThreadCache(cache);
+        cache.owner = mInstanceId;
+    }
+}
+
+template <size_t P0, size_t P1, size_t P2>
+void HandleAllocator<P0, P1, P2>::releaseThreadCache(ThreadCache& cache) noexcept {
+    if (!cache.owner) {
+        return;
+    }
+    Registry& registry = getRegistry();
+    std::unique_lock lock(registry.lock);
+    auto const& allocators = registry.allocators;
+    auto pos = std::find_if(allocators.begin(), allocators.end(),
+            [&cache](auto const& entry) { return entry.first == cache.owner; });
+    if (pos != allocators.end()) {
+        // the owner can't be destroyed while we hold the registry's lock
+        HandleAllocator* const owner = pos->second;
+        for (size_t i = 0; i < SIZE_CLASS_COUNT; i++) {
+            typename ThreadCache::Bin const& bin = cache.bins[i];
+            for (uint32_t j = 0; j < bin.count; j += CACHE_BATCH) {
+                owner->pushFreeHandles(i, bin.handles + j, std::min(CACHE_BATCH, bin.count - j));
+            }
+        }
+    }
+    lock.unlock();
+    cache.clear();
 }
 
 // Explicit template instantiations.
@@ -75,14 +75,20 @@ void MetalBuffer::copyIntoBuffer(void* src, size_t size, size_t byteOffset) {
         return;
     }
 
-    // We're about to acquire a new buffer to hold the new contents. If we previously had obtained a
-    // buffer we release it, decrementing its reference count, as we no longer needs it.
-    if (mBufferPoolEntry) {
-        mContext.bufferPool->releaseBuffer(mBufferPoolEntry);
-    }
-
+    // We're about to acquire a new buffer to hold the new contents. If this is a partial update,
+    // the rest of the previous contents must be carried over to the new buffer.
+    MetalBufferPoolEntry const* previousEntry = mBufferPoolEntry;
     mBufferPoolEntry = mContext.bufferPool->acquireBuffer(mBufferSize);
+    if (previousEntry && (byteOffset > 0 || size < mBufferSize)) {
+        memcpy(mBufferPoolEntry->buffer.contents, previousEntry->buffer.contents, mBufferSize);
+    }
     memcpy(static_cast<uint8_t*>(mBufferPoolEntry->buffer.contents) + byteOffset, src, size);
+
+    // If we previously had obtained a buffer we release it, decrementing its reference count, as
+    // we no longer need it.
+    if (previousEntry) {
+        mContext.bufferPool->releaseBuffer(previousEntry);
+    }
 }
 
 void MetalBuffer::copyIntoStreamBuffer(void* src, size_t size) {
@@ -107,7 +107,10 @@ void VulkanContext::selectPhysicalDevice() {
                 maintenanceSupported[2] = true;
             }
         }
-        if (!supportsSwapchain) continue;
+        // Devices that cannot present are only considered when presenting is not possible anyway,
+        // e.g. with a software implementation on a server without a window system.
+        if (!supportsSwapchain && surfaceSupported) continue;
+        swapchainSupported = supportsSwapchain;
 
         // Bingo, we finally found a physical device that supports everything we need.
         vkGetPhysicalDeviceFeatures(physicalDevice, &physicalDeviceFeatures);
@@ -167,7 +170,9 @@ void VulkanContext::createLogicalDevice() {
     VkDeviceCreateInfo deviceCreateInfo = {};
     FixedCapacityVector<const char*> deviceExtensionNames;
     deviceExtensionNames.reserve(6);
-    deviceExtensionNames.push_back(VK_KHR_SWAPCHAIN_EXTENSION_NAME);
+    if (swapchainSupported) {
+        deviceExtensionNames.push_back(VK_KHR_SWAPCHAIN_EXTENSION_NAME);
+    }
     if (debugMarkersSupported && !debugUtilsSupported) {
         deviceExtensionNames.push_back(VK_EXT_DEBUG_MARKER_EXTENSION_NAME);
     }
@@ -182,8 +182,35 @@ VulkanDriver::VulkanDriver(VulkanPlatform* platform,
     const char* ppEnabledExtensions[MAX_INSTANCE_EXTENSION_COUNT];
     uint32_t enabledExtensionCount = 0;
 
+    // Software implementations such as SwiftShader or lavapipe might be built without any window
+    // system integration, in which case only headless swap chains can be used.
+    uint32_t instanceExtsCount = 0;
+    vkEnumerateInstanceExtensionProperties(nullptr, &instanceExtsCount, nullptr);
+    FixedCapacityVector<VkExtensionProperties> instanceExts(instanceExtsCount);
+    vkEnumerateInstanceExtensionProperties(nullptr, &instanceExtsCount, instanceExts.data());
+    auto isInstanceExtensionSupported = [&instanceExts](const char* name) {
+        for (const auto& extProps : instanceExts) {
+            if (!strcmp(extProps.extensionName, name)) {
+                return true;
+            }
+        }
+        return false;
+    };
+    mContext.surfaceSupported = isInstanceExtensionSupported("VK_KHR_surface");
+    for (uint32_t i = 0; i < requiredExtensionCount; ++i) {
+        if (!isInstanceExtensionSupported(ppRequiredExtensions[i])) {
+            mContext.surfaceSupported = false;
+        }
+    }
+    if (!mContext.surfaceSupported) {
+        utils::slog.i << "Vulkan window system integration is not available, "
+                << "only headless swap chains are supported." << utils::io::endl;
+    }
+
     // Request all cross-platform extensions.
-    ppEnabledExtensions[enabledExtensionCount++] = "VK_KHR_surface";
+    if (mContext.surfaceSupported) {
+        ppEnabledExtensions[enabledExtensionCount++] = "VK_KHR_surface";
+    }
     ppEnabledExtensions[enabledExtensionCount++] = "VK_KHR_get_physical_device_properties2";
 #if VK_ENABLE_VALIDATION
 #if defined(ANDROID)
@@ -198,7 +225,7 @@ VulkanDriver::VulkanDriver(VulkanPlatform* platform,
     }
 
     // Request platform-specific extensions.
-    for (uint32_t i = 0; i < requiredExtensionCount; ++i) {
+    for (uint32_t i = 0; mContext.surfaceSupported && i < requiredExtensionCount; ++i) {
         assert_invariant(enabledExtensionCount < MAX_INSTANCE_EXTENSION_COUNT);
         ppEnabledExtensions[enabledExtensionCount++] = ppRequiredExtensions[i];
     }
@@ -572,6 +599,8 @@ void VulkanDriver::createSyncR(Handle<HwSync> sh, int) {
 }
 
 void VulkanDriver::createSwapChainR(Handle<HwSwapChain> sch, void* nativeWindow, uint64_t flags) {
+    ASSERT_PRECONDITION(mContext.surfaceSupported && mContext.swapchainSupported,
+            "This Vulkan implementation only supports headless swap chains.");
     const VkInstance instance = mContext.instance;
     auto vksurface = (VkSurfaceKHR) mContextManager.createVkSurfaceKHR(nativeWindow, instance,
             flags);
@@ -690,7 +719,10 @@ void VulkanDriver::destroySwapChain(Handle<HwSwapChain> sch) {
         VulkanSwapChain& surfaceContext = *handle_cast<VulkanSwapChain*>(sch);
         surfaceContext.destroy();
 
-        vkDestroySurfaceKHR(mContext.instance, surfaceContext.surface, VKALLOC);
+        // Headless swap chains have no surface, and without VK_KHR_surface the entry point is null.
+        if (mContext.surfaceSupported && surfaceContext.surface) {
+            vkDestroySurfaceKHR(mContext.instance, surfaceContext.surface, VKALLOC);
+        }
         if (mContext.currentSurface == &surfaceContext) {
             mContext.currentSurface = nullptr;
         }
@@ -0,0 +1,39 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "PlatformRunner.h"
+
+// A runner without any window, for the tests that only use headless swap chains. With a software
+// Vulkan implementation this runs on machines without a GPU or a display, e.g.:
+//
+//   VK_ICD_FILENAMES=/usr/share/vulkan/icd.d/lvp_icd.x86_64.json backend_test_linux -a vulkan
+
+namespace test {
+
+NativeView getNativeView() {
+    NativeView view;
+    view.width = 512;
+    view.height = 512;
+    return view;
+}
+
+} // namespace test
+
+int main(int argc, char* argv[]) {
+    auto backend = test::parseArgumentsForBackend(argc, argv);
+    test::initTests(backend, false, argc, argv);
+    return test::runTests();
+}
@@ -0,0 +1,265 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "CommandStreamDispatcher.h"
+#include "DriverBase.h"
+
+#include "private/backend/CommandBufferQueue.h"
+#include "private/backend/CommandStream.h"
+#include "private/backend/CommandStreamDecoder.h"
+#include "private/backend/DecodedCommandBufferQueue.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace filament;
+using namespace filament::backend;
+
+namespace {
+
+// Logs the driver commands that have an effect, in the order they're executed.
+class RecordingDriverBase : public DriverBase {
+public:
+    explicit RecordingDriverBase(Dispatcher* dispatcher) noexcept : DriverBase(dispatcher) { }
+
+    ShaderModel getShaderModel() const noexcept final { return ShaderModel::GL_CORE_41; }
+
+    std::vector<std::string> log;
+
+#define DECL_DRIVER_API(methodName, paramsDecl, params) \
+    void methodName(paramsDecl) { log.emplace_back(#methodName); }
+
+#define DECL_DRIVER_API_SYNCHRONOUS(RetType, methodName, paramsDecl, params) \
+    RetType methodName(paramsDecl) override { return RetType(); }
+
+#define DECL_DRIVER_API_RETURN(RetType, methodName, paramsDecl, params) \
+    RetType methodName##S() noexcept override { return RetType(); } \
+    void methodName##R(RetType, paramsDecl) { log.emplace_back(#methodName); }
+
+#include "private/backend/DriverAPI.inc"
+};
+
+// Bindings are only logged when they change what the driver has bound, so that the log doesn't
+// depend on whether redundant bindings were removed from the CommandStream.
+class RecordingDriver final : public RecordingDriverBase {
+public:
+    RecordingDriver() noexcept : RecordingDriverBase(new ConcreteDispatcher<RecordingDriver>()) { }
+
+    size_t bindingCount = 0;
+
+    void bindUniformBuffer(uint32_t index, BufferObjectHandle ubh) {
+        bindUniform("bindUniformBuffer", index, ubh.getId(), 0, WHOLE_BUFFER);
+    }
+
+    void bindUniformBufferRange(uint32_t index, BufferObjectHandle ubh,
+            uint32_t offset, uint32_t size) {
+        bindUniform("bindUniformBufferRange", index, ubh.getId(), offset, size);
+    }
+
+    void bindSamplers(uint32_t index, SamplerGroupHandle sbh) {
+        bindingCount++;
+        if (mSamplers[index] != sbh.getId()) {
+            mSamplers[index] = sbh.getId();
+            log.push_back("bindSamplers " + std::to_string(index) + " " +
+                    std::to_string(sbh.getId()));
+        }
+    }
+
+    void draw(PipelineState state, RenderPrimitiveHandle rph) {
+        log.push_back("draw " + std::to_string(state.program.getId()) + " " +
+                std::to_string(rph.getId()));
+    }
+
+private:
+    static constexpr uint32_t WHOLE_BUFFER = 0xFFFFFFFFu;
+
+    struct UniformBinding {
+        HandleBase::HandleId id = HandleBase::nullid;
+        uint32_t offset = 0;
+        uint32_t size = 0;
+    };
+
+    void bindUniform(const char* name, uint32_t index, HandleBase::HandleId id,
+            uint32_t offset, uint32_t size) {
+        bindingCount++;
+        UniformBinding& binding = mUniforms[index];
+        if (binding.id != id || binding.offset != offset || binding.size != size) {
+            binding = { id, offset, size };
+            log.push_back(std::string(name) + " " + std::to_string(index) + " " +
+                    std::to_string(id) + " " + std::to_string(offset) + " " +
+                    std::to_string(size));
+        }
+    }
+
+    UniformBinding mUniforms[CONFIG_BINDING_COUNT];
+    HandleBase::HandleId mSamplers[CONFIG_BINDING_COUNT] = {};
+};
+
+class CommandStreamTest : public testing::Test {
+protected:
+    static constexpr size_t REQUIRED_SIZE = 1u * 1024u * 1024u;
+    static constexpr size_t BUFFER_SIZE = 3u * 1024u * 1024u;
+
+    // binding points, as used by filament
+    static constexpr uint32_t PER_RENDERABLE = 1;
+    static constexpr uint32_t PER_MATERIAL_INSTANCE = 6;
+
+    static constexpr size_t DRAW_COUNT = 64;
+
+    // consecutive draws sharing a material instance, as after sorting the commands
+    static constexpr size_t DRAWS_PER_MATERIAL_INSTANCE = 16;
+
+    void drawAll(CommandStream& driverApi, CommandBufferQueue& queue, uint32_t pass) {
+        PipelineState pipeline;
+        driverApi.beginRenderPass(RenderTargetHandle(pass), {});
+        for (uint32_t i = 0; i < DRAW_COUNT; i++) {
+            uint32_t const mi = uint32_t(i / DRAWS_PER_MATERIAL_INSTANCE);
+            pipeline.program = ProgramHandle(mi % 3);
+            driverApi.bindUniformBufferRange(PER_RENDERABLE, BufferObjectHandle(1), i * 256, 256);
+            driverApi.bindUniformBuffer(PER_MATERIAL_INSTANCE, BufferObjectHandle(2 + mi));
+            driverApi.bindSamplers(PER_MATERIAL_INSTANCE, SamplerGroupHandle(mi));
+            driverApi.draw(pipeline, RenderPrimitiveHandle(i));
+            if (i == DRAWS_PER_MATERIAL_INSTANCE + 2) {
+                // the next slice starts with bindings that are identical to the current ones
+                queue.flush();
+            }
+        }
+        driverApi.endRenderPass();
+    }
+
+    // Records a frame spanning several slices, with flush() and finish() in between.
+    void record(CommandStream& driverApi, CommandBufferQueue& queue) {
+        driverApi.beginFrame(0, 1);
+        drawAll(driverApi, queue, 1);
+        driverApi.flush();
+        queue.flush();
+
+        drawAll(driverApi, queue, 2);
+        driverApi.finish();
+        queue.flush();
+
+        // the same bindings again, after a command that isn't a binding nor a draw
+        drawAll(driverApi, queue, 3);
+        driverApi.endFrame(1);
+        queue.flush();
+    }
+
+    // Executes the commands as they're flushed, like FEngine::execute().
+    std::vector<std::string> executeDirectly(size_t* bindingCount) {
+        RecordingDriver driver;
+        CommandBufferQueue queue(REQUIRED_SIZE, BUFFER_SIZE);
+        CommandStream driverApi(driver, queue.getCircularBuffer());
+
+        std::thread driverThread([&]() {
+            while (true) {
+                auto buffers = queue.waitForCommands();
+                if (buffers.empty()) {
+                    break;
+                }
+                for (auto& item : buffers) {
+                    if (item.begin) {
+                        driverApi.execute(item.begin);
+                        queue.releaseBuffer(item);
+                    }
+                }
+            }
+        });
+
+        record(driverApi, queue);
+        queue.requestExit();
+        driverThread.join();
+
+        *bindingCount = driver.bindingCount;
+        return std::move(driver.log);
+    }
+
+    // Decodes the commands on their own thread and executes them on another one, like the
+    // pipelined driver (FEngine::decode() and FEngine::execute()).
+    std::vector<std::string> executePipelined(size_t* bindingCount, size_t* elidedCount) {
+        RecordingDriver driver;
+        CommandStreamDecoder decoder(driver.getDispatcher());
+        if (!decoder.isValid()) {
+            return {};
+        }
+        CommandBufferQueue queue(REQUIRED_SIZE, BUFFER_SIZE);
+        DecodedCommandBufferQueue decodedQueue;
+        CommandStream driverApi(driver, queue.getCircularBuffer());
+
+        std::thread decoderThread([&]() {
+            while (true) {
+                auto buffers = queue.waitForCommands();
+                if (buffers.empty()) {
+                    break;
+                }
+                for (auto& item : buffers) {
+                    if (item.begin) {
+                        decoder.decode(item.begin, item.end);
+                        decodedQueue.push(item);
+                    }
+                }
+            }
+            decodedQueue.requestExit();
+        });
+
+        std::thread driverThread([&]() {
+            while (true) {
+                auto const item = decodedQueue.pop();
+                if (!item.begin) {
+                    break;
+                }
+                driverApi.execute(item.begin);
+                queue.releaseBuffer(item);
+            }
+        });
+
+        record(driverApi, queue);
+        queue.requestExit();
+        decoderThread.join();
+        driverThread.join();
+
+        *bindingCount = driver.bindingCount;
+        *elidedCount = decoder.getStatistics().elided;
+        return std::move(driver.log);
+    }
+};
+
+} // anonymous namespace
+
+TEST_F(CommandStreamTest, PipelinedMatchesDirect) {
+    size_t directBindingCount = 0;
+    std::vector<std::string> const direct = executeDirectly(&directBindingCount);
+
+    size_t pipelinedBindingCount = 0;
+    size_t elidedCount = 0;
+    std::vector<std::string> const pipelined =
+            executePipelined(&pipelinedBindingCount, &elidedCount);
+    if (pipelined.empty()) {
+        GTEST_SKIP() << "the CommandStream can't be decoded in this build";
+    }
+
+    ASSERT_FALSE(direct.empty());
+    EXPECT_EQ(direct.front(), "beginFrame");
+    EXPECT_EQ(direct.back(), "endFrame");
+    EXPECT_EQ(pipelined, direct);
+
+    // Only redundant bindings were removed: within a render pass, the uniform buffer and the
+    // samplers of a material instance are only bound by its first draw.
+    EXPECT_GT(elidedCount, 0u);
+    EXPECT_EQ(pipelinedBindingCount + elidedCount, directBindingCount);
+}
@@ -0,0 +1,270 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "private/backend/HandleAllocator.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
+// HandleAllocatorGL is only instantiated with the OpenGL backend
+#if defined(FILAMENT_SUPPORTS_OPENGL)
+
+using namespace filament::backend;
+
+namespace {
+
+// the three size classes of HandleAllocatorGL
+struct SmallObject { uint32_t data[4]; };
+struct MediumObject { uint32_t data[16]; };
+struct LargeObject { uint32_t data[52]; };
+
+// small enough that all the tests below have to grow the arena
+constexpr size_t ARENA_SIZE = 4096;
+
+template<typename T>
+void fill(T* p, uint32_t value) {
+    for (uint32_t& v : p->data) {
+        v = value;
+    }
+}
+
+template<typename T>
+bool check(T const* p, uint32_t value) {
+    for (uint32_t v : p->data) {
+        if (v != value) {
+            return false;
+        }
+    }
+    return true;
+}
+
+template<typename T>
+std::vector<Handle<T>> allocate(HandleAllocatorGL& allocator, size_t count, uint32_t tag) {
+    std::vector<Handle<T>> handles(count);
+    for (auto& handle : handles) {
+        handle = allocator.allocateAndConstruct<T>();
+        fill(allocator.handle_cast<T*>(handle), handle.getId() ^ tag);
+    }
+    return handles;
+}
+
+template<typename T>
+void verify(HandleAllocatorGL& allocator, std::vector<Handle<T>> const& handles, uint32_t tag,
+        std::set<uintptr_t>& pointers) {
+    for (auto const& handle : handles) {
+        T const* const p = allocator.handle_cast<T*>(handle);
+        EXPECT_TRUE(pointers.insert(uintptr_t(p)).second);
+        EXPECT_TRUE(check(p, handle.getId() ^ tag));
+    }
+}
+
+template<typename T>
+void deallocate(HandleAllocatorGL& allocator, std::vector<Handle<T>>& handles) {
+    for (auto& handle : handles) {
+        allocator.deallocate(handle);
+    }
+}
+
+// Allocates and frees handles in a random order, and returns the handles still alive at the end.
+template<typename T>
+std::vector<Handle<T>> churn(HandleAllocatorGL& allocator, uint32_t tag, size_t iterations,
+        size_t maxAlive, std::atomic<uint32_t>& errors) {
+    std::vector<Handle<T>> handles;
+    uint32_t seed = tag * 7919u;
+    for (size_t i = 0; i < iterations; i++) {
+        seed = seed * 1103515245u + 12345u;
+        if (handles.size() < maxAlive && (seed >> 16u) % 3u) {
+            Handle<T> handle = allocator.allocateAndConstruct<T>();
+            fill(allocator.handle_cast<T*>(handle), handle.getId() ^ tag);
+            handles.push_back(handle);
+        } else if (!handles.empty()) {
+            size_t const index = (seed >> 8u) % handles.size();
+            Handle<T> handle = handles[index];
+            handles[index] = handles.back();
+            handles.pop_back();
+            if (!check(allocator.handle_cast<T*>(handle), handle.getId() ^ tag)) {
+                errors++;
+            }
+            allocator.deallocate(handle);
+        }
+    }
+    return handles;
+}
+
+} // anonymous namespace
+
+TEST(HandleAllocatorTest, ReusesFreedHandles) {
+    HandleAllocatorGL allocator("Handles", ARENA_SIZE);
+
+    Handle<MediumObject> handle = allocator.allocateAndConstruct<MediumObject>();
+    HandleBase::HandleId const id = handle.getId();
+    allocator.deallocate(handle);
+    handle = allocator.allocateAndConstruct<MediumObject>();
+    EXPECT_EQ(handle.getId(), id);
+    allocator.deallocate(handle);
+
+    // Handles are taken from the arena in batches of 32, so after allocating a multiple of that
+    // the thread's cache is empty, and allocating again must only return freed handles.
+    constexpr size_t COUNT = 32 * 16;
+    std::set<HandleBase::HandleId> freed;
+    for (auto& h : allocate<MediumObject>(allocator, COUNT, 0)) {
+        freed.insert(h.getId());
+        allocator.deallocate(h);
+    }
+    EXPECT_EQ(freed.size(), COUNT);
+
+    std::vector<Handle<MediumObject>> handles = allocate<MediumObject>(allocator, COUNT, 1);
+    std::set<HandleBase::HandleId> reused;
+    for (auto& h : handles) {
+        reused.insert(h.getId());
+        EXPECT_TRUE(check(allocator.handle_cast<MediumObject*>(h), h.getId() ^ 1u));
+        allocator.deallocate(h);
+    }
+    EXPECT_EQ(reused, freed);
+}
+
+TEST(HandleAllocatorTest, GrowsArena) {
+    HandleAllocatorGL allocator("Handles", ARENA_SIZE);
+
+    // this spans dozens of segments
+    constexpr size_t COUNT = 512;
+    auto small = allocate<SmallObject>(allocator, COUNT, 1);
+    auto medium = allocate<MediumObject>(allocator, COUNT, 2);
+    auto large = allocate<LargeObject>(allocator, COUNT, 3);
+
+    // all the objects are distinct, and growing the arena didn't move or overwrite any of them
+    std::set<uintptr_t> pointers;
+    verify(allocator, small, 1, pointers);
+    verify(allocator, medium, 2, pointers);
+    verify(allocator, large, 3, pointers);
+    EXPECT_EQ(pointers.size(), COUNT * 3);
+
+    deallocate(allocator, small);
+    deallocate(allocator, medium);
+    deallocate(allocator, large);
+}
+
+TEST(HandleAllocatorTest, ConcurrentAllocateAndFree) {
+    HandleAllocatorGL allocator("Handles", ARENA_SIZE);
+    std::atomic<uint32_t> errors = { 0 };
+
+    // each thread allocates and frees its own handles, and keeps some of them alive at the end
+    constexpr size_t THREAD_COUNT = 4;
+    std::vector<Handle<SmallObject>> small[THREAD_COUNT];
+    std::vector<Handle<LargeObject>> large[THREAD_COUNT];
+    std::vector<std::thread> threads;
+    for (uint32_t t = 0; t < THREAD_COUNT; t++) {
+        threads.emplace_back([&, t]() {
+            small[t] = churn<SmallObject>(allocator, t * 2 + 1, 20000, 1000, errors);
+            large[t] = churn<LargeObject>(allocator, t * 2 + 2, 20000, 1000, errors);
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(errors.load(), 0u);
+
+    // no handle was given to two threads, and the survivors are intact
+    std::set<HandleBase::HandleId> ids;
+    size_t count = 0;
+    for (uint32_t t = 0; t < THREAD_COUNT; t++) {
+        for (auto& h : small[t]) {
+            EXPECT_TRUE(check(allocator.handle_cast<SmallObject*>(h), h.getId() ^ (t * 2 + 1)));
+            ids.insert(h.getId());
+        }
+        for (auto& h : large[t]) {
+            EXPECT_TRUE(check(allocator.handle_cast<LargeObject*>(h), h.getId() ^ (t * 2 + 2)));
+            ids.insert(h.getId());
+        }
+        count += small[t].size() + large[t].size();
+    }
+    EXPECT_EQ(ids.size(), count);
+
+    // the survivors are freed by a thread that didn't allocate them
+    for (uint32_t t = 0; t < THREAD_COUNT; t++) {
+        deallocate(allocator, small[t]);
+        deallocate(allocator, large[t]);
+    }
+}
+
+TEST(HandleAllocatorTest, ProducerConsumer) {
+    HandleAllocatorGL allocator("Handles", ARENA_SIZE);
+    std::atomic<uint32_t> errors = { 0 };
+
+    // the producer allocates handles, the consumer checks and frees them
+    constexpr size_t COUNT = 100000;
+    constexpr size_t MAX_QUEUED = 256;
+    std::mutex lock;
+    std::deque<Handle<MediumObject>> queue;
+    std::set<HandleBase::HandleId> ids;
+    bool done = false;
+
+    std::thread consumer([&]() {
+        for (;;) {
+            Handle<MediumObject> handle;
+            {
+                std::lock_guard guard(lock);
+                if (!queue.empty()) {
+                    handle = queue.front();
+                    queue.pop_front();
+                } else if (done) {
+                    break;
+                }
+            }
+            if (handle) {
+                if (!check(allocator.handle_cast<MediumObject*>(handle), handle.getId())) {
+                    errors++;
+                }
+                allocator.deallocate(handle);
+            } else {
+                std::this_thread::yield();
+            }
+        }
+    });
+
+    for (size_t i = 0; i < COUNT; i++) {
+        Handle<MediumObject> handle = allocator.allocateAndConstruct<MediumObject>();
+        fill(allocator.handle_cast<MediumObject*>(handle), handle.getId());
+        ids.insert(handle.getId());
+        for (;;) {
+            std::unique_lock guard(lock);
+            if (queue.size() < MAX_QUEUED) {
+                queue.push_back(handle);
+                break;
+            }
+            guard.unlock();
+            std::this_thread::yield();
+        }
+    }
+    {
+        std::lock_guard guard(lock);
+        done = true;
+    }
+    consumer.join();
+
+    EXPECT_EQ(errors.load(), 0u);
+    // The handles freed by the consumer make it back to the producer, so only a few more than can
+    // be queued or cached at once are ever allocated from the arena.
+    EXPECT_LT(ids.size(), MAX_QUEUED * 8);
+}
+
+#endif // FILAMENT_SUPPORTS_OPENGL
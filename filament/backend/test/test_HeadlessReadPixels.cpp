@@ -0,0 +1,134 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "BackendTest.h"
+
+#include "ShaderGenerator.h"
+#include "TrianglePrimitive.h"
+
+using namespace filament;
+using namespace filament::backend;
+
+namespace {
+
+std::string vertex (R"(#version 450 core
+
+layout(location = 0) in vec4 mesh_position;
+
+void main() {
+    gl_Position = vec4(mesh_position.xy, 0.0, 1.0);
+}
+)");
+
+std::string fragment (R"(#version 450 core
+
+layout(location = 0) out vec4 fragColor;
+
+void main() {
+    fragColor = vec4(1.0);
+}
+
+)");
+
+struct ReadPixelsResult {
+    bool called = false;
+    uint32_t left = 0;
+    uint32_t right = 0;
+};
+
+}
+
+namespace test {
+
+class HeadlessReadPixelsTest : public BackendTest {};
+
+// Renders with a headless swap chain only, which is all that software Vulkan implementations built
+// without window system integration (e.g. lavapipe or SwiftShader on a server) support.
+// Unlike ReadPixelsTest, the result is checked pixel by pixel rather than with a hash, since the
+// exact rasterization of the triangle's edge varies between implementations.
+TEST_F(HeadlessReadPixelsTest, RenderAndReadPixels) {
+    constexpr size_t size = 512;
+    auto& api = getDriverApi();
+
+    auto swapChain = api.createSwapChainHeadless(size, size, 0);
+    api.makeCurrent(swapChain, swapChain);
+
+    ShaderGenerator shaderGen(vertex, fragment, sBackend, sIsMobilePlatform);
+    Program p = shaderGen.getProgram();
+    auto program = api.createProgram(std::move(p));
+
+    Handle<HwTexture> texture = api.createTexture(SamplerType::SAMPLER_2D, 1,
+            TextureFormat::RGBA8, 1, size, size, 1,
+            TextureUsage::COLOR_ATTACHMENT | TextureUsage::SAMPLEABLE);
+    Handle<HwRenderTarget> renderTarget = api.createRenderTarget(TargetBufferFlags::COLOR,
+            size, size, 1, TargetBufferInfo(texture, 0), {}, {});
+
+    TrianglePrimitive triangle(api);
+
+    RenderPassParams params = {};
+    params.viewport.width = size;
+    params.viewport.height = size;
+    params.flags.clear = TargetBufferFlags::COLOR;
+    params.clearColor = { 0.f, 0.f, 1.f, 1.f };
+    params.flags.discardStart = TargetBufferFlags::ALL;
+    params.flags.discardEnd = TargetBufferFlags::NONE;
+
+    api.beginFrame(0, 0);
+
+    // Render a white triangle over blue. The triangle covers the bottom-left half of the target.
+    api.beginRenderPass(renderTarget, params);
+    PipelineState state;
+    state.program = program;
+    state.rasterState.colorWrite = true;
+    state.rasterState.depthWrite = false;
+    state.rasterState.depthFunc = RasterState::DepthFunc::A;
+    state.rasterState.culling = CullingMode::NONE;
+    api.draw(state, triangle.getRenderPrimitive());
+    api.endRenderPass();
+
+    // Sample the middle row, where the result doesn't depend on the row order of the buffer.
+    ReadPixelsResult result;
+    void* buffer = calloc(1, size * size * 4);
+    PixelBufferDescriptor descriptor(buffer, size * size * 4, PixelDataFormat::RGBA,
+            PixelDataType::UBYTE, 1, 0, 0, size, [](void* buffer, size_t, void* user) {
+                auto* result = (ReadPixelsResult*) user;
+                const uint32_t* row = (const uint32_t*) buffer + (size / 2) * size;
+                result->called = true;
+                result->left = row[size / 8];
+                result->right = row[size - size / 8];
+                free(buffer);
+            }, &result);
+    api.readPixels(renderTarget, 0, 0, size, size, std::move(descriptor));
+
+    api.flush();
+    api.commit(swapChain);
+    api.endFrame(0);
+
+    api.destroyProgram(program);
+    api.destroyRenderTarget(renderTarget);
+    api.destroyTexture(texture);
+    api.destroySwapChain(swapChain);
+
+    flushAndWait();
+    getDriver().purge();
+
+    // RGBA8 pixels, read as little-endian words.
+    ASSERT_TRUE(result.called);
+    EXPECT_EQ(result.left, 0xffffffffu);
+    EXPECT_EQ(result.right, 0xffff0000u);
+}
+
+} // namespace test
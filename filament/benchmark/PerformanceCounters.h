@@ -31,7 +31,8 @@ class PerformanceCounters {
 public:
     explicit PerformanceCounters(benchmark::State& state)
             : state(state) {
-        profiler.resetEvents(utils::Profiler::EV_CPU_CYCLES | utils::Profiler::EV_BPU_MISSES);
+        profiler.resetEvents(utils::Profiler::EV_CPU_CYCLES | utils::Profiler::EV_BPU_MISSES |
+                utils::Profiler::EV_L1D_MISSES);
         profiler.start();
     }
 
@@ -48,6 +49,7 @@ public:
                     { "C",   { avgItem * (double)counters.getCpuCycles(),    benchmark::Counter::kAvgIterations }},
                     { "I",   { avgItem * (double)counters.getInstructions(), benchmark::Counter::kAvgIterations }},
                     { "BPU", { std::floor(0.5 + avgItem * (double)counters.getBranchMisses() / state.iterations()), benchmark::Counter::kDefaults }},
+                    { "L1D", { avgItem * (double)counters.getL1DMisses(),   benchmark::Counter::kAvgIterations }},
                     { "CPI", {           (double)counters.getCPI(),          benchmark::Counter::kAvgThreads }},
             });
         }
@@ -0,0 +1,219 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TNT_FILAMENT_BENCHMARK_SYNTHETICSCENE_H
+#define TNT_FILAMENT_BENCHMARK_SYNTHETICSCENE_H
+
+#include <filament/Box.h>
+#include <filament/Camera.h>
+#include <filament/Engine.h>
+#include <filament/IndexBuffer.h>
+#include <filament/LightManager.h>
+#include <filament/Material.h>
+#include <filament/MaterialInstance.h>
+#include <filament/RenderableManager.h>
+#include <filament/Scene.h>
+#include <filament/TransformManager.h>
+#include <filament/VertexBuffer.h>
+#include <filament/View.h>
+#include <filament/Viewport.h>
+
+#include <utils/Entity.h>
+#include <utils/EntityManager.h>
+
+#include <math/mat4.h>
+#include <math/quat.h>
+#include <math/vec3.h>
+#include <math/vec4.h>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * A procedurally generated scene used by the benchmarks: a number of cubes scattered in front
+ * of the camera, all parented to a single root transform, lit by a shadow-casting sun and a
+ * number of point lights. A good part of the cubes are outside of the camera frustum.
+ *
+ * The scene only needs an Engine, so it works with the noop backend.
+ */
+class SyntheticScene {
+public:
+    struct Config {
+        size_t renderableCount = 1024;
+        size_t lightCount = 16;
+        // renderables cycle through this many material instances, which affects sorting
+        size_t materialInstanceCount = 8;
+        bool shadows = true;
+        bool postProcessing = true;
+        uint32_t width = 1920;
+        uint32_t height = 1080;
+    };
+
+    SyntheticScene(filament::Engine& engine, Config const& config) : mEngine(engine) {
+        using namespace filament;
+        using namespace filament::math;
+
+        utils::EntityManager& em = utils::EntityManager::get();
+        TransformManager& tcm = engine.getTransformManager();
+
+        mScene = engine.createScene();
+        mView = engine.createView();
+        mCameraEntity = em.create();
+        mCamera = engine.createCamera(mCameraEntity);
+        mCamera->setProjection(45.0, double(config.width) / config.height, 0.1, 300.0);
+        mView->setCamera(mCamera);
+        mView->setScene(mScene);
+        mView->setViewport({ 0, 0, config.width, config.height });
+        mView->setShadowingEnabled(config.shadows);
+        mView->setPostProcessingEnabled(config.postProcessing);
+
+        // a unit cube with its tangent frames (the default material is lit)
+        static const float3 positions[8] = {
+                { -1, -1, -1 }, { 1, -1, -1 }, { 1, 1, -1 }, { -1, 1, -1 },
+                { -1, -1,  1 }, { 1, -1,  1 }, { 1, 1,  1 }, { -1, 1,  1 },
+        };
+        static const short4 tangents[8] = {};
+        static const uint16_t indices[36] = {
+                0, 1, 2,  2, 3, 0,  4, 6, 5,  6, 4, 7,  0, 3, 7,  7, 4, 0,
+                1, 5, 6,  6, 2, 1,  3, 2, 6,  6, 7, 3,  0, 4, 5,  5, 1, 0,
+        };
+        mVertexBuffer = VertexBuffer::Builder()
+                .vertexCount(8)
+                .bufferCount(2)
+                .attribute(VertexAttribute::POSITION, 0, VertexBuffer::AttributeType::FLOAT3)
+                .attribute(VertexAttribute::TANGENTS, 1, VertexBuffer::AttributeType::SHORT4)
+                .normalized(VertexAttribute::TANGENTS)
+                .build(engine);
+        mVertexBuffer->setBufferAt(engine, 0,
+                VertexBuffer::BufferDescriptor(positions, sizeof(positions), nullptr));
+        mVertexBuffer->setBufferAt(engine, 1,
+                VertexBuffer::BufferDescriptor(tangents, sizeof(tangents), nullptr));
+        mIndexBuffer = IndexBuffer::Builder()
+                .indexCount(36)
+                .bufferType(IndexBuffer::IndexType::USHORT)
+                .build(engine);
+        mIndexBuffer->setBuffer(engine,
+                IndexBuffer::BufferDescriptor(indices, sizeof(indices), nullptr));
+
+        Material const* material = engine.getDefaultMaterial();
+        for (size_t i = 0; i < std::max(size_t(1), config.materialInstanceCount); i++) {
+            mMaterialInstances.push_back(material->createInstance());
+        }
+
+        mRoot = em.create();
+        tcm.create(mRoot);
+        TransformManager::Instance const root = tcm.getInstance(mRoot);
+
+        std::default_random_engine gen; // NOLINT
+        std::uniform_real_distribution<float> rand(-1.0f, 1.0f);
+
+        // the camera looks down -z, the cubes are spread wider than its field of view
+        mRenderables.resize(config.renderableCount);
+        em.create(mRenderables.size(), mRenderables.data());
+        for (size_t i = 0; i < mRenderables.size(); i++) {
+            utils::Entity const e = mRenderables[i];
+            float3 const p = {
+                    rand(gen) * 200.0f, rand(gen) * 100.0f, -150.0f + rand(gen) * 140.0f };
+            mat4f const transform = mat4f::translation(p) *
+                    mat4f::rotation(rand(gen) * 3.14159f, normalize(float3{ rand(gen), 1, 0 }));
+            tcm.create(e, root, transform);
+            RenderableManager::Builder(1)
+                    .boundingBox({{ -1, -1, -1 }, { 1, 1, 1 }})
+                    .material(0, mMaterialInstances[i % mMaterialInstances.size()])
+                    .geometry(0, RenderableManager::PrimitiveType::TRIANGLES,
+                            mVertexBuffer, mIndexBuffer)
+                    .castShadows(config.shadows)
+                    .receiveShadows(config.shadows)
+                    .build(engine, e);
+        }
+        mScene->addEntities(mRenderables.data(), mRenderables.size());
+
+        mLights.resize(config.lightCount + 1);
+        em.create(mLights.size(), mLights.data());
+        LightManager::Builder(LightManager::Type::SUN)
+                .direction({ 0.3f, -1.0f, -0.5f })
+                .intensity(100000.0f)
+                .castShadows(config.shadows)
+                .build(engine, mLights[0]);
+        for (size_t i = 1; i < mLights.size(); i++) {
+            LightManager::Builder(LightManager::Type::POINT)
+                    .position({ rand(gen) * 100.0f, rand(gen) * 50.0f, -80.0f + rand(gen) * 70.0f })
+                    .intensity(10000.0f)
+                    .falloff(20.0f)
+                    .build(engine, mLights[i]);
+        }
+        mScene->addEntities(mLights.data(), mLights.size());
+    }
+
+    ~SyntheticScene() {
+        using namespace filament;
+        utils::EntityManager& em = utils::EntityManager::get();
+        for (utils::Entity e : mRenderables) {
+            mEngine.destroy(e);
+        }
+        for (utils::Entity e : mLights) {
+            mEngine.destroy(e);
+        }
+        mEngine.destroy(mRoot);
+        em.destroy(mRenderables.size(), mRenderables.data());
+        em.destroy(mLights.size(), mLights.data());
+        em.destroy(mRoot);
+        for (MaterialInstance* mi : mMaterialInstances) {
+            mEngine.destroy(mi);
+        }
+        mEngine.destroy(mIndexBuffer);
+        mEngine.destroy(mVertexBuffer);
+        mEngine.destroyCameraComponent(mCameraEntity);
+        em.destroy(mCameraEntity);
+        mEngine.destroy(mView);
+        mEngine.destroy(mScene);
+    }
+
+    SyntheticScene(SyntheticScene const&) = delete;
+    SyntheticScene& operator=(SyntheticScene const&) = delete;
+
+    // moves all the renderables at once, as an animated scene would do every frame
+    void animate(float time) {
+        using namespace filament::math;
+        filament::TransformManager& tcm = mEngine.getTransformManager();
+        tcm.setTransform(tcm.getInstance(mRoot), mat4f::rotation(time * 0.1f, float3{ 0, 1, 0 }));
+    }
+
+    filament::Scene* getScene() const noexcept { return mScene; }
+    filament::View* getView() const noexcept { return mView; }
+    filament::Camera* getCamera() const noexcept { return mCamera; }
+    utils::Entity getRoot() const noexcept { return mRoot; }
+    size_t getRenderableCount() const noexcept { return mRenderables.size(); }
+
+private:
+    filament::Engine& mEngine;
+    filament::Scene* mScene = nullptr;
+    filament::View* mView = nullptr;
+    filament::Camera* mCamera = nullptr;
+    filament::VertexBuffer* mVertexBuffer = nullptr;
+    filament::IndexBuffer* mIndexBuffer = nullptr;
+    std::vector<filament::MaterialInstance*> mMaterialInstances;
+    utils::Entity mCameraEntity;
+    utils::Entity mRoot;
+    std::vector<utils::Entity> mRenderables;
+    std::vector<utils::Entity> mLights;
+};
+
+#endif // TNT_FILAMENT_BENCHMARK_SYNTHETICSCENE_H
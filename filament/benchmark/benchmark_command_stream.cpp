@@ -0,0 +1,150 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <backend/Platform.h>
+
+#include "private/backend/CircularBuffer.h"
+#include "private/backend/CommandBufferQueue.h"
+#include "private/backend/CommandStream.h"
+#include "private/backend/CommandStreamDecoder.h"
+
+#include <memory>
+
+using namespace filament;
+using namespace backend;
+
+/*
+ * Measures the decoding of the CommandStream, as done by the pipelined driver, and its execution
+ * by the noop driver. The argument is the number of draw calls in the recorded render pass.
+ */
+class CommandStreamFixture : public benchmark::Fixture {
+protected:
+    static constexpr size_t BUFFER_SIZE = 16u * 1024u * 1024u;
+
+    // consecutive draws sharing a material instance, as after sorting the commands
+    static constexpr size_t DRAWS_PER_MATERIAL_INSTANCE = 16;
+
+    // binding points, as used by filament
+    static constexpr uint32_t PER_RENDERABLE = 1;
+    static constexpr uint32_t PER_MATERIAL_INSTANCE = 6;
+
+    Backend backend = Backend::NOOP;
+    DefaultPlatform* platform = nullptr;
+    Driver* driver = nullptr;
+    std::unique_ptr<CircularBuffer> buffer;
+    std::unique_ptr<CommandStream> stream;
+
+    // Records a render pass similar to the ones generated by RenderPass::Executor and returns
+    // the slice of the CircularBuffer holding it.
+    CommandBufferQueue::Slice record(size_t drawCount) {
+        CommandStream& driverApi = *stream;
+        PipelineState pipeline;
+        driverApi.beginRenderPass(RenderTargetHandle(1), {});
+        for (uint32_t i = 0; i < drawCount; i++) {
+            uint32_t const mi = uint32_t(i / DRAWS_PER_MATERIAL_INSTANCE);
+            pipeline.program = ProgramHandle(mi % 8);
+            driverApi.bindUniformBufferRange(PER_RENDERABLE, BufferObjectHandle(1), i * 256, 256);
+            driverApi.bindUniformBuffer(PER_MATERIAL_INSTANCE, BufferObjectHandle(2 + mi));
+            driverApi.bindSamplers(PER_MATERIAL_INSTANCE, SamplerGroupHandle(mi));
+            driverApi.draw(pipeline, RenderPrimitiveHandle(i));
+        }
+        driverApi.endRenderPass();
+
+        // terminate the slice, like CommandBufferQueue::flush()
+        new(buffer->allocate(sizeof(NoopCommand))) NoopCommand(nullptr);
+        CommandBufferQueue::Slice const slice{ buffer->getTail(), buffer->getHead() };
+        buffer->circularize();
+        return slice;
+    }
+
+public:
+    void SetUp(benchmark::State& state) override {
+        platform = DefaultPlatform::create(&backend);
+        driver = platform->createDriver(nullptr);
+        buffer = std::make_unique<CircularBuffer>(BUFFER_SIZE);
+        stream = std::make_unique<CommandStream>(*driver, *buffer);
+    }
+
+    void TearDown(benchmark::State&) override {
+        stream.reset();
+        buffer.reset();
+        driver->terminate();
+        delete driver;
+        DefaultPlatform::destroy(&platform);
+    }
+};
+
+// number of draw calls
+static void drawCounts(benchmark::internal::Benchmark* b) {
+    b->RangeMultiplier(4)->Range(256, 4096);
+}
+
+BENCHMARK_DEFINE_F(CommandStreamFixture, decode)(benchmark::State& state) {
+    size_t const drawCount = size_t(state.range(0));
+    CommandStreamDecoder decoder(driver->getDispatcher());
+    if (!decoder.isValid()) {
+        state.SkipWithError("the CommandStream can't be decoded in this build");
+        return;
+    }
+    // the recording isn't measured, so the performance counters aren't used here
+    for (auto _ : state) {
+        state.PauseTiming();
+        auto const slice = record(drawCount);
+        state.ResumeTiming();
+        decoder.decode(slice.begin, slice.end);
+    }
+    CommandStreamDecoder::Statistics const& stats = decoder.getStatistics();
+    state.SetItemsProcessed(state.iterations() * int64_t(drawCount * 4 + 2));
+    state.counters.insert({
+            { "elided", { double(stats.elided) / double(stats.commands),
+                    benchmark::Counter::kDefaults }},
+    });
+}
+
+BENCHMARK_DEFINE_F(CommandStreamFixture, execute)(benchmark::State& state) {
+    size_t const drawCount = size_t(state.range(0));
+    for (auto _ : state) {
+        state.PauseTiming();
+        auto const slice = record(drawCount);
+        state.ResumeTiming();
+        stream->execute(slice.begin);
+    }
+    state.SetItemsProcessed(state.iterations() * int64_t(drawCount * 4 + 2));
+}
+
+BENCHMARK_DEFINE_F(CommandStreamFixture, executeDecoded)(benchmark::State& state) {
+    // only the execution is measured, this is the work left to the driver thread
+    size_t const drawCount = size_t(state.range(0));
+    CommandStreamDecoder decoder(driver->getDispatcher());
+    if (!decoder.isValid()) {
+        state.SkipWithError("the CommandStream can't be decoded in this build");
+        return;
+    }
+    for (auto _ : state) {
+        state.PauseTiming();
+        auto const slice = record(drawCount);
+        decoder.decode(slice.begin, slice.end);
+        state.ResumeTiming();
+        stream->execute(slice.begin);
+    }
+    state.SetItemsProcessed(state.iterations() * int64_t(drawCount * 4 + 2));
+}
+
+BENCHMARK_REGISTER_F(CommandStreamFixture, decode)->Apply(drawCounts);
+BENCHMARK_REGISTER_F(CommandStreamFixture, execute)->Apply(drawCounts);
+BENCHMARK_REGISTER_F(CommandStreamFixture, executeDecoded)->Apply(drawCounts);
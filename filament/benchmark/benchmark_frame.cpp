@@ -0,0 +1,414 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "SyntheticScene.h"
+
+#include <filament/Engine.h>
+#include <filament/Renderer.h>
+#include <filament/SwapChain.h>
+
+#include <utils/memalign.h>
+#include <utils/Path.h>
+
+#include <getopt/getopt.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <new>
+#include <string>
+#include <vector>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+/*
+ * Measures the CPU cost of whole frames (Renderer::beginFrame, render and endFrame) with the
+ * noop backend, so that the results don't depend on a GPU or its driver.
+ */
+
+using namespace filament;
+
+// ------------------------------------------------------------------------------------------------
+// Allocation counting. This only sees operator new, which is what most of Filament uses, and
+// counts the allocations of all threads. The over-aligned variants are replaced as well, since
+// the default ones could otherwise end up in our operator delete.
+// ------------------------------------------------------------------------------------------------
+
+static std::atomic<size_t> g_allocationCount{ 0 };
+static std::atomic<size_t> g_allocationBytes{ 0 };
+
+static void countAllocation(size_t size) noexcept {
+    g_allocationCount.fetch_add(1, std::memory_order_relaxed);
+    g_allocationBytes.fetch_add(size, std::memory_order_relaxed);
+}
+
+[[noreturn]] static void outOfMemory() {
+#ifdef __EXCEPTIONS
+    throw std::bad_alloc();
+#endif
+    std::abort();
+}
+
+void* operator new(size_t size) {
+    countAllocation(size);
+    void* p = malloc(size ? size : 1);
+    if (!p) {
+        outOfMemory();
+    }
+    return p;
+}
+
+void* operator new[](size_t size) {
+    return operator new(size);
+}
+
+void* operator new(size_t size, std::nothrow_t const&) noexcept {
+    countAllocation(size);
+    return malloc(size ? size : 1);
+}
+
+void* operator new[](size_t size, std::nothrow_t const& tag) noexcept {
+    return operator new(size, tag);
+}
+
+void operator delete(void* p) noexcept {
+    free(p);
+}
+
+void operator delete[](void* p) noexcept {
+    free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    free(p);
+}
+
+void operator delete[](void* p, size_t) noexcept {
+    free(p);
+}
+
+void* operator new(size_t size, std::align_val_t align) {
+    countAllocation(size);
+    void* p = utils::aligned_alloc(size ? size : 1, size_t(align));
+    if (!p) {
+        outOfMemory();
+    }
+    return p;
+}
+
+void* operator new[](size_t size, std::align_val_t align) {
+    return operator new(size, align);
+}
+
+void* operator new(size_t size, std::align_val_t align, std::nothrow_t const&) noexcept {
+    countAllocation(size);
+    return utils::aligned_alloc(size ? size : 1, size_t(align));
+}
+
+void* operator new[](size_t size, std::align_val_t align, std::nothrow_t const& tag) noexcept {
+    return operator new(size, align, tag);
+}
+
+void operator delete(void* p, std::align_val_t) noexcept {
+    utils::aligned_free(p);
+}
+
+void operator delete[](void* p, std::align_val_t) noexcept {
+    utils::aligned_free(p);
+}
+
+void operator delete(void* p, size_t, std::align_val_t) noexcept {
+    utils::aligned_free(p);
+}
+
+void operator delete[](void* p, size_t, std::align_val_t) noexcept {
+    utils::aligned_free(p);
+}
+
+// ------------------------------------------------------------------------------------------------
+
+static std::vector<size_t> g_renderableCounts = { 1000 };
+static size_t g_lightCount = 16;
+static size_t g_frameCount = 300;
+static size_t g_warmupFrameCount = 30;
+static bool g_shadows = true;
+static bool g_postProcessing = true;
+static bool g_csv = false;
+
+static void printUsage(const char* name) {
+    std::string execName(utils::Path(name).getName());
+    std::string usage(
+            "BENCHMARK_FRAME measures the CPU cost of rendering frames of a synthetic scene\n"
+            "with the noop backend\n"
+            "Usage:\n"
+            "    BENCHMARK_FRAME [options]\n"
+            "\n"
+            "Options:\n"
+            "   --help, -h\n"
+            "       print this message\n\n"
+            "   --renderables=N[,N...], -n N[,N...]\n"
+            "       number of renderables, a comma-separated list runs one benchmark per count\n"
+            "       (default: 1000)\n\n"
+            "   --lights=M, -l M\n"
+            "       number of point lights, in addition to the sun (default: 16)\n\n"
+            "   --frames=K, -f K\n"
+            "       number of frames measured (default: 300)\n\n"
+            "   --warmup=K, -w K\n"
+            "       number of frames rendered before measuring (default: 30)\n\n"
+            "   --no-shadows\n"
+            "       disable shadows\n\n"
+            "   --no-post-processing\n"
+            "       disable post-processing\n\n"
+            "   --csv\n"
+            "       print the results as comma-separated values\n\n"
+    );
+
+    const std::string from("BENCHMARK_FRAME");
+    for (size_t pos = usage.find(from); pos != std::string::npos; pos = usage.find(from, pos)) {
+        usage.replace(pos, from.length(), execName);
+    }
+    printf("%s", usage.c_str());
+}
+
+static int handleArguments(int argc, char* argv[]) {
+    static constexpr const char* OPTSTR = "hn:l:f:w:";
+    static const struct option OPTIONS[] = {
+            { "help",                     no_argument, 0, 'h' },
+            { "renderables",        required_argument, 0, 'n' },
+            { "lights",             required_argument, 0, 'l' },
+            { "frames",             required_argument, 0, 'f' },
+            { "warmup",             required_argument, 0, 'w' },
+            { "no-shadows",               no_argument, 0, 's' },
+            { "no-post-processing",       no_argument, 0, 'p' },
+            { "csv",                      no_argument, 0, 'c' },
+            { 0, 0, 0, 0 }  // termination of the option list
+    };
+
+    int opt;
+    int optionIndex = 0;
+
+    while ((opt = getopt_long(argc, argv, OPTSTR, OPTIONS, &optionIndex)) >= 0) {
+        std::string arg(optarg ? optarg : "");
+        switch (opt) {
+            default:
+            case 'h':
+                printUsage(argv[0]);
+                exit(0);
+                // break;
+            case 'n': {
+                g_renderableCounts.clear();
+                size_t start = 0;
+                do {
+                    size_t const end = std::min(arg.find(',', start), arg.size());
+                    g_renderableCounts.push_back(std::stoul(arg.substr(start, end - start)));
+                    start = end + 1;
+                } while (start < arg.size());
+                break;
+            }
+            case 'l':
+                g_lightCount = std::stoul(arg);
+                break;
+            case 'f':
+                g_frameCount = std::max(size_t(1), size_t(std::stoul(arg)));
+                break;
+            case 'w':
+                g_warmupFrameCount = std::stoul(arg);
+                break;
+            case 's':
+                g_shadows = false;
+                break;
+            case 'p':
+                g_postProcessing = false;
+                break;
+            case 'c':
+                g_csv = true;
+                break;
+        }
+    }
+
+    return optind;
+}
+
+// ------------------------------------------------------------------------------------------------
+
+struct FrameSample {
+    float beginFrame;
+    float render;
+    float endFrame;
+    size_t allocationCount;
+    size_t allocationBytes;
+    Renderer::FrameStatistics stats;
+};
+
+struct Summary {
+    float mean;
+    float median;
+    float p95;
+};
+
+template<typename T>
+static Summary summarize(std::vector<FrameSample> const& samples, T getter) {
+    std::vector<float> values;
+    values.reserve(samples.size());
+    float sum = 0.0f;
+    for (FrameSample const& sample : samples) {
+        float const v = getter(sample);
+        values.push_back(v);
+        sum += v;
+    }
+    std::sort(values.begin(), values.end());
+    return {
+            sum / float(values.size()),
+            values[values.size() / 2],
+            values[std::min(values.size() - 1, (values.size() * 95) / 100)] };
+}
+
+static void printResults(size_t renderableCount, size_t skippedFrameCount,
+        std::vector<FrameSample> const& samples) {
+    struct Stage {
+        const char* name;
+        float (*getter)(FrameSample const&);
+    };
+    // the stages of FRenderer::render() come from the Renderer's frame statistics
+    static const Stage stages[] = {
+        { "frame",                 [](FrameSample const& s) {
+                return s.beginFrame + s.render + s.endFrame; }},
+        { "  beginFrame",          [](FrameSample const& s) { return s.beginFrame; }},
+        { "  render",              [](FrameSample const& s) { return s.render; }},
+        { "    prepare",           [](FrameSample const& s) { return s.stats.prepare; }},
+        { "    culling",           [](FrameSample const& s) { return s.stats.culling; }},
+        { "    froxelization",     [](FrameSample const& s) { return s.stats.froxelization; }},
+        { "    shadows",           [](FrameSample const& s) { return s.stats.shadows; }},
+        { "    commands",          [](FrameSample const& s) { return s.stats.commands; }},
+        { "    frameGraphCompile", [](FrameSample const& s) { return s.stats.frameGraphCompile; }},
+        { "    frameGraphExecute", [](FrameSample const& s) { return s.stats.frameGraphExecute; }},
+        { "  endFrame",            [](FrameSample const& s) { return s.endFrame; }},
+    };
+
+    Summary const allocations = summarize(samples,
+            [](FrameSample const& s) { return float(s.allocationCount); });
+    Summary const allocationBytes = summarize(samples,
+            [](FrameSample const& s) { return float(s.allocationBytes); });
+
+    if (g_csv) {
+        for (Stage const& stage : stages) {
+            Summary const r = summarize(samples, stage.getter);
+            const char* name = stage.name;
+            while (*name == ' ') name++;
+            printf("%zu,%zu,%s,%.4f,%.4f,%.4f\n",
+                    renderableCount, g_lightCount, name, r.mean, r.median, r.p95);
+        }
+        printf("%zu,%zu,allocations,%.1f,%.1f,%.1f\n", renderableCount, g_lightCount,
+                allocations.mean, allocations.median, allocations.p95);
+        printf("%zu,%zu,allocatedBytes,%.1f,%.1f,%.1f\n", renderableCount, g_lightCount,
+                allocationBytes.mean, allocationBytes.median, allocationBytes.p95);
+        return;
+    }
+
+    printf("renderables: %zu, lights: %zu, shadows: %s, post-processing: %s\n",
+            renderableCount, g_lightCount, g_shadows ? "on" : "off",
+            g_postProcessing ? "on" : "off");
+    printf("frames: %zu measured, %zu skipped\n", samples.size(), skippedFrameCount);
+    printf("%-24s %10s %10s %10s\n", "CPU time (ms)", "mean", "median", "p95");
+    for (Stage const& stage : stages) {
+        Summary const r = summarize(samples, stage.getter);
+        printf("%-24s %10.3f %10.3f %10.3f\n", stage.name, r.mean, r.median, r.p95);
+    }
+    printf("%-24s %10.1f %10.1f %10.1f\n", "allocations",
+            allocations.mean, allocations.median, allocations.p95);
+    printf("%-24s %10.0f %10.0f %10.0f\n", "allocated bytes",
+            allocationBytes.mean, allocationBytes.median, allocationBytes.p95);
+    printf("\n");
+}
+
+static void run(size_t renderableCount) {
+    using clock = std::chrono::steady_clock;
+    auto elapsed = [](clock::time_point start, clock::time_point end) {
+        return std::chrono::duration<float, std::milli>(end - start).count();
+    };
+
+    Engine* engine = Engine::create(Engine::Backend::NOOP);
+    SyntheticScene::Config config;
+    config.renderableCount = renderableCount;
+    config.lightCount = g_lightCount;
+    config.shadows = g_shadows;
+    config.postProcessing = g_postProcessing;
+
+    SwapChain* swapChain = engine->createSwapChain(config.width, config.height);
+    Renderer* renderer = engine->createRenderer();
+
+    std::vector<FrameSample> samples;
+    samples.reserve(g_frameCount);
+    size_t skippedFrameCount = 0;
+
+    {
+        SyntheticScene scene(*engine, config);
+        for (size_t i = 0, c = g_warmupFrameCount + g_frameCount; i < c; i++) {
+            scene.animate(float(i));
+
+            size_t const allocationCount = g_allocationCount.load(std::memory_order_relaxed);
+            size_t const allocationBytes = g_allocationBytes.load(std::memory_order_relaxed);
+
+            auto const t0 = clock::now();
+            if (!renderer->beginFrame(swapChain)) {
+                skippedFrameCount += (i >= g_warmupFrameCount) ? 1 : 0;
+                continue;
+            }
+            auto const t1 = clock::now();
+            renderer->render(scene.getView());
+            auto const t2 = clock::now();
+            renderer->endFrame();
+            auto const t3 = clock::now();
+
+            if (i >= g_warmupFrameCount) {
+                FrameSample sample{};
+                sample.beginFrame = elapsed(t0, t1);
+                sample.render = elapsed(t1, t2);
+                sample.endFrame = elapsed(t2, t3);
+                sample.allocationCount =
+                        g_allocationCount.load(std::memory_order_relaxed) - allocationCount;
+                sample.allocationBytes =
+                        g_allocationBytes.load(std::memory_order_relaxed) - allocationBytes;
+                if (Renderer::FrameStatistics const* stats = renderer->getFrameStatistics()) {
+                    sample.stats = *stats;
+                }
+                samples.push_back(sample);
+            }
+        }
+        engine->flushAndWait();
+    }
+
+    if (!samples.empty()) {
+        printResults(renderableCount, skippedFrameCount, samples);
+    }
+
+    engine->destroy(renderer);
+    engine->destroy(swapChain);
+    Engine::destroy(&engine);
+}
+
+int main(int argc, char* argv[]) {
+    handleArguments(argc, argv);
+
+    if (g_csv) {
+        printf("renderables,lights,stage,mean,median,p95\n");
+    }
+    for (size_t renderableCount : g_renderableCounts) {
+        run(renderableCount);
+    }
+    return 0;
+}
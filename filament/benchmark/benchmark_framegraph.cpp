@@ -0,0 +1,107 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "PerformanceCounters.h"
+
+#include <benchmark/benchmark.h>
+
+#include "ResourceAllocator.h"
+
+#include "fg2/FrameGraph.h"
+#include "fg2/FrameGraphCache.h"
+
+using namespace filament;
+using namespace backend;
+
+class NullResourceAllocator : public ResourceAllocatorInterface {
+public:
+    RenderTargetHandle createRenderTarget(const char*, TargetBufferFlags, uint32_t, uint32_t,
+            uint8_t, MRT, TargetBufferInfo, TargetBufferInfo) noexcept override {
+        return {};
+    }
+
+    void destroyRenderTarget(RenderTargetHandle) noexcept override {
+    }
+
+    TextureHandle createTexture(const char*, SamplerType, uint8_t, TextureFormat, uint8_t,
+            uint32_t, uint32_t, uint32_t, std::array<TextureSwizzle, 4>,
+            TextureUsage) noexcept override {
+        return {};
+    }
+
+    void destroyTexture(TextureHandle) noexcept override {
+    }
+};
+
+class FrameGraphFixture : public benchmark::Fixture {
+protected:
+    // roughly the size of the graph of a view with shadows and a few post-processing effects
+    static constexpr size_t PASS_COUNT = 32;
+
+    NullResourceAllocator resourceAllocator;
+
+    // Declares a chain of passes each sampling the output of the previous one, with a culled
+    // pass every few passes.
+    static void declare(FrameGraph& fg) {
+        struct PassData {
+            FrameGraphId<FrameGraphTexture> color;
+        };
+        FrameGraphId<FrameGraphTexture> input;
+        for (size_t i = 0; i < PASS_COUNT; i++) {
+            auto& pass = fg.addPass<PassData>("pass",
+                    [&](FrameGraph::Builder& builder, auto& data) {
+                        if (input) {
+                            builder.sample(input);
+                        }
+                        data.color = builder.create<FrameGraphTexture>("color",
+                                { .width = 1920u >> (i % 4), .height = 1080u >> (i % 4) });
+                        data.color = builder.declareRenderPass(data.color);
+                    },
+                    [](FrameGraphResources const&, auto const&, DriverApi&) {});
+            if (i % 8 != 7) {
+                input = pass->color;
+            }
+        }
+        fg.present(input);
+    }
+};
+
+BENCHMARK_F(FrameGraphFixture, compile)(benchmark::State& state) {
+    {
+        PerformanceCounters pc(state);
+        for (auto _ : state) {
+            FrameGraph fg(resourceAllocator);
+            declare(fg);
+            fg.compile();
+        }
+        pc.stop();
+        state.SetItemsProcessed(state.iterations() * PASS_COUNT);
+    }
+}
+
+BENCHMARK_F(FrameGraphFixture, compileCached)(benchmark::State& state) {
+    FrameGraphCache cache;
+    {
+        PerformanceCounters pc(state);
+        for (auto _ : state) {
+            FrameGraph fg(resourceAllocator, &cache);
+            declare(fg);
+            fg.compile();
+        }
+        pc.stop();
+        state.SetItemsProcessed(state.iterations() * PASS_COUNT);
+    }
+}
@@ -0,0 +1,141 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include "private/backend/HandleAllocator.h"
+
+#include <utils/SpscQueue.h>
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+// HandleAllocatorGL is only instantiated with the OpenGL backend
+#if defined(FILAMENT_SUPPORTS_OPENGL)
+
+using namespace filament;
+using namespace backend;
+
+/*
+ * Stresses the HandleAllocator the way the engine does: handles created by one thread (e.g. while
+ * streaming assets in) and destroyed by another (the driver thread), or created and destroyed by
+ * several threads at once. The arena is small, so that it has to grow during the benchmark.
+ * The argument is the number of handles alive at once.
+ */
+
+namespace {
+
+// the three size classes of HandleAllocatorGL
+struct SmallObject { uint32_t data[4]; };
+struct MediumObject { uint32_t data[16]; };
+struct LargeObject { uint32_t data[52]; };
+
+constexpr size_t ARENA_SIZE = 256u * 1024u;
+
+template<typename T>
+void touch(HandleAllocatorGL& allocator, Handle<T> const& handle) {
+    T* const p = allocator.handle_cast<T*>(handle);
+    p->data[0]++;
+    benchmark::DoNotOptimize(p);
+}
+
+template<typename T>
+void allocateAndFree(HandleAllocatorGL& allocator, std::vector<Handle<T>>& handles) {
+    for (auto& handle : handles) {
+        handle = allocator.allocateAndConstruct<T>();
+    }
+    for (auto& handle : handles) {
+        touch(allocator, handle);
+    }
+    for (auto& handle : handles) {
+        allocator.deallocate(handle);
+    }
+}
+
+} // anonymous namespace
+
+static void HandleAllocator_singleThread(benchmark::State& state) {
+    size_t const count = size_t(state.range(0));
+    HandleAllocatorGL allocator("Handles", ARENA_SIZE);
+    std::vector<Handle<SmallObject>> small(count);
+    std::vector<Handle<MediumObject>> medium(count);
+    std::vector<Handle<LargeObject>> large(count);
+    for (auto _ : state) {
+        allocateAndFree(allocator, small);
+        allocateAndFree(allocator, medium);
+        allocateAndFree(allocator, large);
+    }
+    state.SetItemsProcessed(state.iterations() * int64_t(count * 3));
+}
+
+static void HandleAllocator_producerConsumer(benchmark::State& state) {
+    // the consumer frees the handles in the order they were allocated
+    size_t const count = size_t(state.range(0));
+    HandleAllocatorGL allocator("Handles", ARENA_SIZE);
+    auto queue = std::make_unique<utils::SpscQueue<HandleBase::HandleId, 1024>>();
+    std::atomic<bool> done = { false };
+
+    std::thread consumer([&]() {
+        HandleBase::HandleId id;
+        while (!done.load(std::memory_order_relaxed) || !queue->empty()) {
+            if (queue->pop(id)) {
+                Handle<MediumObject> handle(id);
+                touch(allocator, handle);
+                allocator.deallocate(handle);
+            } else {
+                std::this_thread::yield();
+            }
+        }
+    });
+
+    for (auto _ : state) {
+        for (size_t i = 0; i < count; i++) {
+            Handle<MediumObject> handle = allocator.allocateAndConstruct<MediumObject>();
+            while (!queue->push(handle.getId())) {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    done.store(true, std::memory_order_relaxed);
+    consumer.join();
+    state.SetItemsProcessed(state.iterations() * int64_t(count));
+}
+
+static void HandleAllocator_multiThread(benchmark::State& state) {
+    // all the threads share the same allocator
+    static std::unique_ptr<HandleAllocatorGL> sAllocator;
+    if (state.thread_index == 0) {
+        sAllocator = std::make_unique<HandleAllocatorGL>("Handles", ARENA_SIZE);
+    }
+    size_t const count = size_t(state.range(0));
+    std::vector<Handle<MediumObject>> handles(count);
+    for (auto _ : state) {
+        allocateAndFree(*sAllocator, handles);
+    }
+    state.SetItemsProcessed(state.iterations() * int64_t(count));
+    if (state.thread_index == 0) {
+        sAllocator.reset();
+    }
+}
+
+BENCHMARK(HandleAllocator_singleThread)->RangeMultiplier(8)->Range(64, 32768);
+BENCHMARK(HandleAllocator_producerConsumer)->RangeMultiplier(8)->Range(64, 32768);
+BENCHMARK(HandleAllocator_multiThread)->Arg(1024)->ThreadRange(1, 4)->UseRealTime();
+
+#endif // FILAMENT_SUPPORTS_OPENGL
@@ -0,0 +1,245 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "PerformanceCounters.h"
+#include "SyntheticScene.h"
+
+#include <benchmark/benchmark.h>
+
+#include "Allocators.h"
+#include "RenderPass.h"
+
+#include "details/Camera.h"
+#include "details/Engine.h"
+#include "details/Scene.h"
+#include "details/View.h"
+
+#include <filament/Frustum.h>
+
+#include <utils/Allocator.h>
+
+#include <memory>
+
+using namespace filament;
+using namespace filament::math;
+
+/*
+ * Each benchmark runs a single stage of the preparation of a frame on a SyntheticScene, using
+ * the noop backend. The scene size is the benchmark argument, e.g.:
+ *     benchmark_filament --benchmark_filter='SceneFixture/culling/4096'
+ */
+class SceneFixture : public benchmark::Fixture {
+protected:
+    Engine* engine = nullptr;
+    std::unique_ptr<SyntheticScene> syntheticScene;
+    std::unique_ptr<ArenaScope> arena;
+    Renderer::FrameStatistics stats{};
+
+    FEngine& getEngine() const noexcept { return upcast(*engine); }
+    FView& getView() const noexcept { return upcast(*syntheticScene->getView()); }
+    FScene& getScene() const noexcept { return upcast(*syntheticScene->getScene()); }
+
+    void prepareView(ArenaScope& scope) noexcept {
+        FEngine& fengine = getEngine();
+        FView& view = getView();
+        view.prepare(fengine, fengine.getDriverApi(), scope, view.getViewport(), {}, stats);
+        fengine.flush();
+    }
+
+public:
+    void SetUp(benchmark::State& state) override {
+        engine = Engine::create(Engine::Backend::NOOP);
+        SyntheticScene::Config config;
+        config.renderableCount = size_t(state.range(0));
+        syntheticScene = std::make_unique<SyntheticScene>(*engine, config);
+
+        // Prepare the view once, so that the stages that depend on culling or on the lights
+        // have their inputs ready. The allocations made here must outlive the benchmark.
+        FEngine& fengine = getEngine();
+        FView& view = getView();
+        arena = std::make_unique<ArenaScope>(fengine.getPerRenderPassAllocator());
+        prepareView(*arena);
+        view.updatePrimitivesLod(fengine, view.getCameraInfo(),
+                getScene().getRenderableData(), view.getVisibleRenderables());
+        stats = {};
+    }
+
+    void TearDown(benchmark::State&) override {
+        arena.reset();
+        syntheticScene.reset();
+        Engine::destroy(&engine);
+    }
+};
+
+// scene sizes, in number of renderables
+static void sceneSizes(benchmark::internal::Benchmark* b) {
+    b->RangeMultiplier(4)->Range(256, 4096);
+}
+
+BENCHMARK_DEFINE_F(SceneFixture, transforms)(benchmark::State& state) {
+    // setting the root's transform updates the world transform of all the renderables
+    float time = 0;
+    {
+        PerformanceCounters pc(state);
+        for (auto _ : state) {
+            syntheticScene->animate(time);
+            time += 1.0f;
+        }
+        pc.stop();
+        state.SetItemsProcessed(state.iterations() * state.range(0));
+    }
+}
+
+BENCHMARK_DEFINE_F(SceneFixture, scenePrepare)(benchmark::State& state) {
+    FScene& scene = getScene();
+    {
+        PerformanceCounters pc(state);
+        for (auto _ : state) {
+            scene.prepare({}, false);
+        }
+        pc.stop();
+        state.SetItemsProcessed(state.iterations() * state.range(0));
+    }
+}
+
+BENCHMARK_DEFINE_F(SceneFixture, culling)(benchmark::State& state) {
+    FEngine& fengine = getEngine();
+    FCamera const& camera = upcast(*syntheticScene->getCamera());
+    Frustum const frustum{ mat4f{ camera.getCullingProjectionMatrix() * camera.getViewMatrix() }};
+    FScene::RenderableSoa& soa = getScene().getRenderableData();
+    {
+        PerformanceCounters pc(state);
+        for (auto _ : state) {
+            FView::cullRenderables(fengine.getJobSystem(), soa, frustum, VISIBLE_RENDERABLE_BIT);
+        }
+        pc.stop();
+        state.SetItemsProcessed(state.iterations() * state.range(0));
+    }
+}
+
+BENCHMARK_DEFINE_F(SceneFixture, uboUpload)(benchmark::State& state) {
+    FEngine& fengine = getEngine();
+    FScene& scene = getScene();
+    FView::Range const visible = getView().getVisibleRenderables();
+    FScene::RenderableUboShadow shadow;
+    shadow.resize(uint32_t(scene.getRenderableData().size()));
+    auto ubh = fengine.getDriverApi().createBufferObject(
+            uint32_t(shadow.capacity * sizeof(PerRenderableUib)),
+            backend::BufferObjectBinding::UNIFORM, backend::BufferUsage::DYNAMIC);
+    {
+        PerformanceCounters pc(state);
+        for (auto _ : state) {
+            // upload all the entries, as after a change of the camera or of the world origin
+            shadow.count = 0;
+            scene.updateUBOs(visible, ubh, shadow);
+            fengine.flush();
+        }
+        pc.stop();
+        state.SetItemsProcessed(state.iterations() * visible.size());
+    }
+    fengine.getDriverApi().destroyBufferObject(ubh);
+}
+
+BENCHMARK_DEFINE_F(SceneFixture, viewPrepare)(benchmark::State& state) {
+    {
+        PerformanceCounters pc(state);
+        for (auto _ : state) {
+            ArenaScope scope(getEngine().getPerRenderPassAllocator());
+            prepareView(scope);
+        }
+        pc.stop();
+        state.SetItemsProcessed(state.iterations() * state.range(0));
+    }
+    // break down the time spent in FView::prepare(), in milliseconds per iteration
+    state.counters.insert({
+            { "prepare",  { stats.prepare,  benchmark::Counter::kAvgIterations }},
+            { "culling",  { stats.culling,  benchmark::Counter::kAvgIterations }},
+            { "shadows",  { stats.shadows,  benchmark::Counter::kAvgIterations }},
+    });
+}
+
+BENCHMARK_DEFINE_F(SceneFixture, froxelization)(benchmark::State& state) {
+    FEngine& fengine = getEngine();
+    FView& view = getView();
+    {
+        PerformanceCounters pc(state);
+        for (auto _ : state) {
+            view.froxelize(fengine);
+        }
+        pc.stop();
+        state.SetItemsProcessed(state.iterations() * state.range(0));
+    }
+}
+
+BENCHMARK_DEFINE_F(SceneFixture, commands)(benchmark::State& state) {
+    FEngine& fengine = getEngine();
+    FView& view = getView();
+    FScene& scene = getScene();
+    void* const buffer = utils::aligned_alloc(FEngine::CONFIG_PER_FRAME_COMMANDS_SIZE, 64);
+    {
+        PerformanceCounters pc(state);
+        for (auto _ : state) {
+            RenderPass::Arena commandArena("Command Arena", { buffer,
+                    utils::pointermath::add(buffer, FEngine::CONFIG_PER_FRAME_COMMANDS_SIZE) });
+            RenderPass pass(fengine, commandArena);
+            pass.setCamera(view.getCameraInfo());
+            pass.setGeometry(scene.getRenderableData(), view.getVisibleRenderables(),
+                    scene.getRenderableUBO());
+            pass.appendCommands(RenderPass::COLOR);
+            pass.sortCommands();
+            benchmark::DoNotOptimize(pass.begin());
+        }
+        pc.stop();
+        state.SetItemsProcessed(state.iterations() * view.getVisibleRenderables().size());
+    }
+    utils::aligned_free(buffer);
+}
+
+BENCHMARK_DEFINE_F(SceneFixture, commandStream)(benchmark::State& state) {
+    FEngine& fengine = getEngine();
+    FView& view = getView();
+    FScene& scene = getScene();
+    void* const buffer = utils::aligned_alloc(FEngine::CONFIG_PER_FRAME_COMMANDS_SIZE, 64);
+    RenderPass::Arena commandArena("Command Arena", { buffer,
+            utils::pointermath::add(buffer, FEngine::CONFIG_PER_FRAME_COMMANDS_SIZE) });
+    RenderPass pass(fengine, commandArena);
+    pass.setCamera(view.getCameraInfo());
+    pass.setGeometry(scene.getRenderableData(), view.getVisibleRenderables(),
+            scene.getRenderableUBO());
+    pass.appendCommands(RenderPass::COLOR);
+    pass.sortCommands();
+    {
+        // this measures both the recording of the driver commands and their execution by the
+        // driver thread, as the latter eventually throttles the former
+        PerformanceCounters pc(state);
+        for (auto _ : state) {
+            pass.execute("Color Pass", {}, {});
+            fengine.flush();
+        }
+        pc.stop();
+        state.SetItemsProcessed(state.iterations() * (pass.end() - pass.begin()));
+    }
+    utils::aligned_free(buffer);
+}
+
+BENCHMARK_REGISTER_F(SceneFixture, transforms)->Apply(sceneSizes);
+BENCHMARK_REGISTER_F(SceneFixture, scenePrepare)->Apply(sceneSizes);
+BENCHMARK_REGISTER_F(SceneFixture, culling)->Apply(sceneSizes);
+BENCHMARK_REGISTER_F(SceneFixture, uboUpload)->Apply(sceneSizes);
+BENCHMARK_REGISTER_F(SceneFixture, viewPrepare)->Apply(sceneSizes);
+BENCHMARK_REGISTER_F(SceneFixture, froxelization)->Apply(sceneSizes);
+BENCHMARK_REGISTER_F(SceneFixture, commands)->Apply(sceneSizes);
+BENCHMARK_REGISTER_F(SceneFixture, commandStream)->Apply(sceneSizes);
@@ -281,6 +281,18 @@ public:
      */
     const math::mat3f& getRotation() const noexcept;
 
+    /**
+     * Replaces the reflections cubemap mipmap chain.
+     *
+     * The new texture is used starting with the next frame rendered, all the views using this
+     * IndirectLight switch to it at once. This allows swapping in a chain that was prefiltered
+     * incrementally over several frames, once it is complete.
+     *
+     * @param cubemap   A mip-mapped cubemap, see Builder::reflections(). Can be null.
+     *                  The previous texture is not destroyed.
+     */
+    void setReflections(Texture const* cubemap) noexcept;
+
     /**
      * Returns the associated reflection map, or null if it does not exist.
      */
@@ -28,6 +28,7 @@
 
 #include <math/vec4.h>
 
+#include <stddef.h>
 #include <stdint.h>
 
 namespace filament {
@@ -135,6 +136,46 @@ public:
         bool discard = true;
     };
 
+    /**
+     * FrameStatistics is a breakdown of the time spent rendering a frame, in milliseconds.
+     * CPU timings are summed over all the Views rendered during the frame.
+     *
+     * @see getFrameStatistics()
+     */
+    struct FrameStatistics {
+        //! Maximum number of passes recorded per frame, additional passes are ignored
+        static constexpr size_t MAX_PASS_COUNT = 64;
+
+        struct Pass {
+            const char* name;   //!< name of the pass, a string literal owned by Filament
+            float cpuTime;      //!< time spent issuing the commands of this pass
+        };
+
+        struct RenderPassCommands {
+            const char* name;           //!< name of the render pass, a string literal
+            uint32_t commandCount;      //!< number of draw commands
+            uint32_t driverCallCount;   //!< number of draw and bind calls issued to the backend
+            uint32_t elidedCallCount;   //!< number of redundant bind calls that were skipped
+        };
+
+        uint32_t frameId = 0;           //!< identifies the frame
+        float prepare = 0.0f;           //!< gathering the renderables and lights of the scenes
+        float culling = 0.0f;           //!< frustum culling of renderables and lights
+        float froxelization = 0.0f;     //!< assigning lights to froxels, in parallel to the rest
+        float shadows = 0.0f;           //!< shadow casters culling and shadow passes setup
+        float commands = 0.0f;          //!< generating and sorting draw commands
+        float frameGraphCompile = 0.0f; //!< compiling the frame graphs
+        float frameGraphExecute = 0.0f; //!< executing the frame graphs, i.e. all the passes
+        float gpuFrameTime = 0.0f;      //!< GPU time of the whole frame, 0 if not known yet
+        uint32_t passCount = 0;         //!< number of entries in passes
+        Pass passes[MAX_PASS_COUNT];    //!< frame graph passes, in order of execution
+        uint32_t renderPassCount = 0;   //!< number of entries in renderPasses
+        RenderPassCommands renderPasses[MAX_PASS_COUNT]; //!< render passes, in order of execution
+    };
+
+    //! Number of frames for which statistics are kept
+    static constexpr size_t FRAME_STATISTICS_HISTORY_SIZE = 16;
+
     /**
      * Information about the display this Renderer is associated to. This information is needed
      * to accurately compute dynamic-resolution scaling and for frame-pacing.
@@ -152,6 +193,17 @@ public:
      */
     void setClearOptions(const ClearOptions& options);
 
+    /**
+     * Returns the statistics of a recently completed frame. The GPU frame time is only known a
+     * few frames after the frame has ended, it is 0 until then.
+     *
+     * @param history 0 for the last completed frame, 1 for the one before, etc... up to
+     *                FRAME_STATISTICS_HISTORY_SIZE - 1.
+     * @return A pointer to the frame's statistics, valid until the next call to endFrame() or
+     *         renderStandaloneView(). nullptr if not enough frames have been rendered yet.
+     */
+    FrameStatistics const* getFrameStatistics(size_t history = 0) const noexcept;
+
     /**
      * Get the Engine that created this Renderer.
      *
@@ -509,6 +509,17 @@ int FEngine::loop() {
     // and loose its caches in the process.
     uint32_t id = std::thread::hardware_concurrency() - 1;
 
+#if FILAMENT_ENABLE_PIPELINED_DRIVER
+    // Decode the commands on their own thread, ahead of their execution on this one.
+    auto decoder = std::make_unique<CommandStreamDecoder>(mDriver->getDispatcher());
+    if (decoder->isValid()) {
+        mCommandStreamDecoder = std::move(decoder);
+        mDecoderThread = std::thread(&FEngine::decode, this);
+    } else {
+        slog.w << "Pipelined driver unavailable, commands will be executed serially" << io::endl;
+    }
+#endif
+
     while (true) {
         // looks like thread affinity needs to be reset regularly (on Android)
         JobSystem::setThreadAffinityById(id);
@@ -517,11 +528,39 @@ int FEngine::loop() {
         }
     }
 
+    if (mDecoderThread.joinable()) {
+        mDecoderThread.join();
+    }
+
     // terminate() is a synchronous API
     getDriverApi().terminate();
     return 0;
 }
 
+// Only used by the pipelined driver: decodes the command buffers and hands them over to the
+// driver thread, which executes them.
+void FEngine::decode() {
+    JobSystem::setThreadName("FEngine::decode");
+    JobSystem::setThreadPriority(JobSystem::Priority::DISPLAY);
+
+    while (true) {
+        // wait until we get command buffers to be decoded (or thread exit requested)
+        auto buffers = mCommandBufferQueue.waitForCommands();
+        if (UTILS_UNLIKELY(buffers.empty())) {
+            break;
+        }
+        for (auto& item : buffers) {
+            if (UTILS_LIKELY(item.begin)) {
+                mCommandStreamDecoder->decode(item.begin, item.end);
+                mDecodedCommandBufferQueue.push(item);
+            }
+        }
+    }
+
+    // all command buffers have been handed over, let the driver thread exit after them
+    mDecodedCommandBufferQueue.requestExit();
+}
+
 void FEngine::flushCommandBuffer(CommandBufferQueue& commandQueue) {
     getDriver().purge();
     commandQueue.flush();
@@ -843,6 +882,17 @@ void* FEngine::streamAlloc(size_t size, size_t alignment) noexcept {
 
 bool FEngine::execute() {
 
+    if (mCommandStreamDecoder) {
+        // wait until we get a decoded command buffer (or thread exit requested)
+        auto const item = mDecodedCommandBufferQueue.pop();
+        if (UTILS_UNLIKELY(!item.begin)) {
+            return false;
+        }
+        mCommandStream.execute(item.begin);
+        mCommandBufferQueue.releaseBuffer(item);
+        return true;
+    }
+
     // wait until we get command buffers to be executed (or thread exit requested)
     auto buffers = mCommandBufferQueue.waitForCommands();
     if (UTILS_UNLIKELY(buffers.empty())) {
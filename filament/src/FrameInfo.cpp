@@ -53,8 +53,10 @@ void FrameInfoManager::terminate(DriverApi& driver) noexcept {
 
 void FrameInfoManager::beginFrame(DriverApi& driver,Config const& config, uint32_t frameId) noexcept {
     driver.beginTimerQuery(mQueries[mIndex]);
+    mQueryFrameIds[mIndex] = frameId;
     uint64_t elapsed = 0;
     if (driver.getTimerQueryValue(mQueries[mLast], &elapsed)) {
+        mFrameTimeId = mQueryFrameIds[mLast];
         mLast = (mLast + 1) % POOL_COUNT;
         // conversion to our duration happens here
         mFrameTime = std::chrono::duration<uint64_t, std::nano>(elapsed);
@@ -74,6 +76,7 @@ void FrameInfoManager::update(Config const& config, FrameInfoManager::duration l
     // this is like doing { pop_back(); push_front(); }
     filament::move_backward(history.begin(), history.end() - 1, history.end());
     history[0].frameTime = lastFrameTime;
+    history[0].frameId = mFrameTimeId;
 
     mFrameTimeHistorySize = std::min(++mFrameTimeHistorySize, uint32_t(MAX_FRAMETIME_HISTORY));
     if (UTILS_UNLIKELY(mFrameTimeHistorySize < 3)) {
@@ -96,5 +99,53 @@ void FrameInfoManager::update(Config const& config, FrameInfoManager::duration l
     history[0].valid = true;
 }
 
+// ------------------------------------------------------------------------------------------------
+
+FrameStatisticsManager::FrameStatistics& FrameStatisticsManager::beginFrame(
+        uint32_t frameId) noexcept {
+    FrameStatistics& stats = mHistory[mCurrent];
+    stats = {};
+    stats.frameId = frameId;
+    return stats;
+}
+
+void FrameStatisticsManager::endFrame() noexcept {
+    mCurrent = (mCurrent + 1) % mHistory.size();
+    mCompletedCount = std::min(mCompletedCount + 1, uint32_t(HISTORY_SIZE));
+}
+
+void FrameStatisticsManager::addPass(const char* name, float cpuTime) noexcept {
+    FrameStatistics& stats = mHistory[mCurrent];
+    if (stats.passCount < FrameStatistics::MAX_PASS_COUNT) {
+        stats.passes[stats.passCount++] = { name, cpuTime };
+    }
+}
+
+void FrameStatisticsManager::addRenderPass(const char* name, uint32_t commandCount,
+        uint32_t driverCallCount, uint32_t elidedCallCount) noexcept {
+    FrameStatistics& stats = mHistory[mCurrent];
+    if (stats.renderPassCount < FrameStatistics::MAX_PASS_COUNT) {
+        stats.renderPasses[stats.renderPassCount++] =
+                { name, commandCount, driverCallCount, elidedCallCount };
+    }
+}
+
+void FrameStatisticsManager::setGpuFrameTime(uint32_t frameId, float gpuFrameTime) noexcept {
+    for (size_t i = 0; i < mCompletedCount; i++) {
+        FrameStatistics& stats = mHistory[(mCurrent + mHistory.size() - 1 - i) % mHistory.size()];
+        if (stats.frameId == frameId) {
+            stats.gpuFrameTime = gpuFrameTime;
+            break;
+        }
+    }
+}
+
+FrameStatisticsManager::FrameStatistics const* FrameStatisticsManager::getFrameStatistics(
+        size_t history) const noexcept {
+    if (history >= mCompletedCount) {
+        return nullptr;
+    }
+    return &mHistory[(mCurrent + mHistory.size() - 1 - history) % mHistory.size()];
+}
 
 } // namespace filament
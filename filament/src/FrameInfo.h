@@ -20,6 +20,8 @@
 #include "backend/Handle.h"
 #include <private/backend/DriverApi.h>
 
+#include <filament/Renderer.h>
+
 #include <array>
 #include <chrono>
 
@@ -32,6 +34,7 @@ struct FrameInfo {
     using duration = std::chrono::duration<float, std::milli>;
     duration frameTime{};            // frame period
     duration denoisedFrameTime{};    // frame period (median filter)
+    uint32_t frameId = 0;            // frame frameTime was measured for
     bool valid = false;
 };
 
@@ -68,7 +71,9 @@ public:
 private:
     void update(Config const& config, duration lastFrameTime) noexcept;
     backend::Handle<backend::HwTimerQuery> mQueries[POOL_COUNT];
+    uint32_t mQueryFrameIds[POOL_COUNT] = {};
     duration mFrameTime{};
+    uint32_t mFrameTimeId = 0;
     uint32_t mIndex = 0;
     uint32_t mLast = 0;
 
@@ -76,6 +81,52 @@ private:
     uint32_t mFrameTimeHistorySize = 0;
 };
 
+// Keeps the FrameStatistics of the last few frames
+class FrameStatisticsManager {
+public:
+    using FrameStatistics = Renderer::FrameStatistics;
+    static constexpr size_t HISTORY_SIZE = Renderer::FRAME_STATISTICS_HISTORY_SIZE;
+
+    // starts recording a new frame, and returns its statistics
+    FrameStatistics& beginFrame(uint32_t frameId) noexcept;
+
+    // the frame that's being recorded becomes the last completed frame
+    void endFrame() noexcept;
+
+    FrameStatistics& getCurrentFrame() noexcept { return mHistory[mCurrent]; }
+
+    // adds the timings of the passes of a FrameGraph to the current frame
+    void addPass(const char* name, float cpuTime) noexcept;
+
+    // adds the draw and bind calls of a RenderPass to the current frame
+    void addRenderPass(const char* name, uint32_t commandCount,
+            uint32_t driverCallCount, uint32_t elidedCallCount) noexcept;
+
+    // GPU timings are known a few frames late, so they're matched with the frame by id
+    void setGpuFrameTime(uint32_t frameId, float gpuFrameTime) noexcept;
+
+    FrameStatistics const* getFrameStatistics(size_t history) const noexcept;
+
+private:
+    // one more entry than the history, for the frame being recorded
+    std::array<FrameStatistics, HISTORY_SIZE + 1> mHistory;
+    uint32_t mCurrent = 0;
+    uint32_t mCompletedCount = 0;
+};
+
+// Adds the time spent in its scope, in milliseconds, to a FrameStatistics' field
+class ScopedCpuTimer {
+    using clock = std::chrono::steady_clock;
+public:
+    explicit ScopedCpuTimer(float& total) noexcept : mTotal(total), mStart(clock::now()) { }
+    ~ScopedCpuTimer() noexcept {
+        mTotal += std::chrono::duration<float, std::milli>(clock::now() - mStart).count();
+    }
+private:
+    float& mTotal;
+    clock::time_point mStart;
+};
+
 
 } // namespace filament
 
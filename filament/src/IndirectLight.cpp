@@ -200,6 +200,18 @@ void FIndirectLight::terminate(FEngine& engine) {
     }
 }
 
+void FIndirectLight::setReflections(FTexture const* cubemap) noexcept {
+    if (cubemap) {
+        if (!ASSERT_POSTCONDITION_NON_FATAL(
+                cubemap->getTarget() == Texture::Sampler::SAMPLER_CUBEMAP,
+                "reflection map must a cubemap")) {
+            return;
+        }
+    }
+    mReflectionsTexture = cubemap;
+    mLevelCount = cubemap ? cubemap->getLevels() : 0;
+}
+
 backend::Handle<backend::HwTexture> FIndirectLight::getReflectionHwHandle() const noexcept {
     return mReflectionsTexture ? mReflectionsTexture->getHwHandle() : backend::Handle<backend::HwTexture> {};
 }
@@ -288,6 +300,10 @@ const math::mat3f& IndirectLight::getRotation() const noexcept {
     return upcast(this)->getRotation();
 }
 
+void IndirectLight::setReflections(Texture const* cubemap) noexcept {
+    upcast(this)->setReflections(upcast(cubemap));
+}
+
 Texture const* IndirectLight::getReflectionsTexture() const noexcept {
     return upcast(this)->getReflectionsTexture();
 }
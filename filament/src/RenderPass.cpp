@@ -16,6 +16,7 @@
 
 #include "RenderPass.h"
 
+#include "FrameInfo.h"
 #include "RenderPrimitive.h"
 #include "ShadowMap.h"
 
@@ -25,11 +26,15 @@
 #include "details/Renderer.h"
 #include "details/View.h"
 
+#include "private/backend/BindingCache.h"
+
 #include <private/filament/UibStructs.h>
 
 #include <utils/JobSystem.h>
 #include <utils/Systrace.h>
 
+#include <algorithm>
+#include <iterator>
 #include <utility>
 
 using namespace utils;
@@ -514,16 +519,85 @@ void RenderPass::Executor::execute(const char* name,
     engine.flush();
 
     driver.beginRenderPass(renderTarget, params);
-    recordDriverCommands(driver, mBegin, mEnd, mRenderableSoa);
+    Statistics const stats = recordDriverCommands(driver, mBegin, mEnd, mRenderableSoa);
     driver.endRenderPass();
+
+    FrameStatisticsManager* const frameStatistics = engine.getFrameStatistics();
+    if (frameStatistics) {
+        frameStatistics->addRenderPass(name, stats.commandCount,
+                stats.driverCallCount, stats.elidedCallCount);
+    }
 }
 
+namespace {
+
+/*
+ * Keeps track of the uniform buffers and sampler groups bound while recording a pass, so that
+ * binding again what's already bound doesn't reach the driver.
+ */
+class BindingTracker {
+public:
+    explicit BindingTracker(DriverApi& driver) noexcept : mDriver(driver) { }
+
+    // Forgets all the bindings, must be called when commands could have been issued to the
+    // driver behind our back.
+    void reset() noexcept {
+        mBindings.reset();
+    }
+
+    void bindUniformBuffer(size_t index, Handle<HwBufferObject> handle) noexcept {
+        if (count(mBindings.bindUniformBuffer(index, handle.getId(),
+                0, BindingCache::WHOLE_BUFFER))) {
+            mDriver.bindUniformBuffer(index, handle);
+        }
+    }
+
+    void bindUniformBufferRange(size_t index, Handle<HwBufferObject> handle,
+            uint32_t offset, uint32_t size) noexcept {
+        if (count(mBindings.bindUniformBuffer(index, handle.getId(), offset, size))) {
+            mDriver.bindUniformBufferRange(index, handle, offset, size);
+        }
+    }
+
+    void bindSamplers(size_t index, Handle<HwSamplerGroup> handle) noexcept {
+        if (count(mBindings.bindSamplers(index, handle.getId()))) {
+            mDriver.bindSamplers(index, handle);
+        }
+    }
+
+    void draw(PipelineState const& pipeline, Handle<HwRenderPrimitive> rph) noexcept {
+        mDriver.draw(pipeline, rph);
+        mDriverCallCount++;
+    }
+
+    uint32_t getDriverCallCount() const noexcept { return mDriverCallCount; }
+    uint32_t getElidedCallCount() const noexcept { return mElidedCallCount; }
+
+private:
+    bool count(bool changed) noexcept {
+        if (UTILS_LIKELY(changed)) {
+            mDriverCallCount++;
+        } else {
+            mElidedCallCount++;
+        }
+        return changed;
+    }
+
+    DriverApi& mDriver;
+    BindingCache mBindings;
+    uint32_t mDriverCallCount = 0;
+    uint32_t mElidedCallCount = 0;
+};
+
+} // anonymous namespace
+
 UTILS_NOINLINE // no need to be inlined
-void RenderPass::Executor::recordDriverCommands(backend::DriverApi& driver,
+RenderPass::Statistics RenderPass::Executor::recordDriverCommands(backend::DriverApi& driver,
         const Command* first, const Command* last,
         FScene::RenderableSoa const& soa) const noexcept {
     SYSTRACE_CALL();
 
+    Statistics stats;
     if (first != last) {
         SYSTRACE_VALUE32("commandCount", last - first);
 
@@ -539,6 +613,11 @@ void RenderPass::Executor::recordDriverCommands(backend::DriverApi& driver,
         FMaterial const* UTILS_RESTRICT ma = nullptr;
         auto const& customCommands = mCustomCommands;
 
+        // The pipeline state and the primitive are arguments of draw(), so only the bindings
+        // can be redundant: e.g. all the primitives of a renderable share the same
+        // PER_RENDERABLE range, and material instances can share buffers across passes.
+        BindingTracker bindings(driver);
+
         first--;
         while (++first != last) {
             /*
@@ -548,6 +627,8 @@ void RenderPass::Executor::recordDriverCommands(backend::DriverApi& driver,
             if (UTILS_UNLIKELY((first->key & CUSTOM_MASK) != uint64_t(CustomCommand::PASS))) {
                 uint32_t index = (first->key & CUSTOM_INDEX_MASK) >> CUSTOM_INDEX_SHIFT;
                 customCommands[index]();
+                // custom commands can issue any driver call
+                bindings.reset();
                 continue;
             }
 
@@ -560,25 +641,38 @@ void RenderPass::Executor::recordDriverCommands(backend::DriverApi& driver,
                 ma = mi->getMaterial();
                 pipeline.scissor = mi->getScissor();
                 *pPipelinePolygonOffset = mi->getPolygonOffset();
-                mi->use(driver);
+                // same as mi->use(driver), but skips what's already bound
+                if (mi->getUniformBufferHandle()) {
+                    bindings.bindUniformBuffer(BindingPoints::PER_MATERIAL_INSTANCE,
+                            mi->getUniformBufferHandle());
+                }
+                if (mi->getSamplerGroupHandle()) {
+                    bindings.bindSamplers(BindingPoints::PER_MATERIAL_INSTANCE,
+                            mi->getSamplerGroupHandle());
+                }
             }
 
             pipeline.program = ma->getProgram(info.materialVariant.key);
-            size_t offset = info.index * sizeof(PerRenderableUib);
-            driver.bindUniformBufferRange(BindingPoints::PER_RENDERABLE,
+            uint32_t const offset = info.index * sizeof(PerRenderableUib);
+            bindings.bindUniformBufferRange(BindingPoints::PER_RENDERABLE,
                     uboHandle, offset, sizeof(PerRenderableUib));
 
             auto skinning = soaSkinning[info.index];
             if (UTILS_UNLIKELY(skinning.handle)) {
                 // note: we can't bind less than CONFIG_MAX_BONE_COUNT due to glsl limitations
-                driver.bindUniformBufferRange(BindingPoints::PER_RENDERABLE_BONES,
+                bindings.bindUniformBufferRange(BindingPoints::PER_RENDERABLE_BONES,
                         skinning.handle,
                         skinning.offset * sizeof(PerRenderableUibBone),
                         CONFIG_MAX_BONE_COUNT * sizeof(PerRenderableUibBone));
             }
-            driver.draw(pipeline, info.primitiveHandle);
+            bindings.draw(pipeline, info.primitiveHandle);
+            stats.commandCount++;
         }
+
+        stats.driverCallCount = bindings.getDriverCallCount();
+        stats.elidedCallCount = bindings.getElidedCallCount();
     }
+    return stats;
 }
 
 } // namespace filament
@@ -301,6 +301,13 @@ public:
         getExecutor().execute(name, renderTarget, params);
     }
 
+    // driver calls issued by an Executor
+    struct Statistics {
+        uint32_t commandCount = 0;      // draw commands executed
+        uint32_t driverCallCount = 0;   // draw and bind calls issued to the driver
+        uint32_t elidedCallCount = 0;   // bind calls skipped because the binding didn't change
+    };
+
     /*
      * Executor holds the range of commands to execute for a given pass
      */
@@ -328,7 +335,7 @@ public:
             assert_invariant(e <= pass->end());
         }
 
-        void recordDriverCommands(backend::DriverApi& driver,
+        Statistics recordDriverCommands(backend::DriverApi& driver,
                 const Command* first, const Command* last,
                 FScene::RenderableSoa const& soa) const noexcept;
 
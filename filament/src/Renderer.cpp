@@ -168,6 +168,7 @@ void FRenderer::renderStandaloneView(FView const* view) {
     if (UTILS_LIKELY(view->getScene())) {
         mPreviousRenderTargets.clear();
         mFrameId++;
+        mFrameStatistics.beginFrame(mFrameId);
 
         // ask the engine to do what it needs to (e.g. updates light buffer, materials...)
         FEngine& engine = getEngine();
@@ -179,6 +180,7 @@ void FRenderer::renderStandaloneView(FView const* view) {
         renderInternal(view);
 
         driver.endFrame(mFrameId);
+        mFrameStatistics.endFrame();
     }
 }
 
@@ -260,7 +262,9 @@ void FRenderer::renderJob(ArenaScope& arena, FView& view) {
         return;
     }
 
-    view.prepare(engine, driver, arena, svp, getShaderUserTime());
+    FrameStatisticsManager::FrameStatistics& stats = mFrameStatistics.getCurrentFrame();
+
+    view.prepare(engine, driver, arena, svp, getShaderUserTime(), stats);
 
     view.prepareUpscaler(scale);
 
@@ -268,7 +272,10 @@ void FRenderer::renderJob(ArenaScope& arena, FView& view) {
     JobSystem::Job* jobFroxelize = nullptr;
     if (view.hasDynamicLighting()) {
         jobFroxelize = js.runAndRetain(js.createJob(nullptr,
-                [&engine, &view](JobSystem&, JobSystem::Job*) { view.froxelize(engine); }));
+                [&engine, &view, &stats](JobSystem&, JobSystem::Job*) {
+                    ScopedCpuTimer timer(stats.froxelization);
+                    view.froxelize(engine);
+                }));
     }
 
     /*
@@ -301,7 +308,7 @@ void FRenderer::renderJob(ArenaScope& arena, FView& view) {
      * Frame graph
      */
 
-    FrameGraph fg(engine.getResourceAllocator());
+    FrameGraph fg(engine.getResourceAllocator(), &mFrameGraphCache);
 
     /*
      * Shadow pass
@@ -310,6 +317,7 @@ void FRenderer::renderJob(ArenaScope& arena, FView& view) {
     if (view.needsShadowMap()) {
         RenderPass shadowPass(pass);
         shadowPass.setRenderFlags(colorRenderFlags);
+        ScopedCpuTimer timer(stats.shadows);
         view.renderShadowMaps(fg, engine, driver, shadowPass);
     }
 
@@ -431,8 +439,11 @@ void FRenderer::renderJob(ArenaScope& arena, FView& view) {
     // TODO: ideally this should be a FrameGraph pass to participate to automatic culling
     RenderPass structurePass(pass);
     structurePass.setRenderFlags(structureRenderFlags);
-    structurePass.appendCommands(RenderPass::CommandTypeFlags::SSAO);
-    structurePass.sortCommands();
+    {
+        ScopedCpuTimer timer(stats.commands);
+        structurePass.appendCommands(RenderPass::CommandTypeFlags::SSAO);
+        structurePass.sortCommands();
+    }
 
     // TODO: the scaling should depends on all passes that need the structure pass
     ppm.structure(fg, structurePass, svp.width, svp.height, {
@@ -491,8 +502,11 @@ void FRenderer::renderJob(ArenaScope& arena, FView& view) {
 
     // TODO: ideally this should be a FrameGraph pass to participate to automatic culling
     pass.setRenderFlags(colorRenderFlags);
-    pass.appendCommands(RenderPass::COLOR);
-    pass.sortCommands();
+    {
+        ScopedCpuTimer timer(stats.commands);
+        pass.appendCommands(RenderPass::COLOR);
+        pass.sortCommands();
+    }
 
     FrameGraphTexture::Descriptor desc = {
             .width = config.svp.width,
@@ -665,11 +679,22 @@ void FRenderer::renderJob(ArenaScope& arena, FView& view) {
 
     fg.present(fgViewRenderTarget);
 
-    fg.compile();
+    {
+        ScopedCpuTimer timer(stats.frameGraphCompile);
+        fg.compile();
+    }
 
     //fg.export_graphviz(slog.d, view.getName());
 
-    fg.execute(driver);
+    {
+        ScopedCpuTimer timer(stats.frameGraphExecute);
+        engine.setFrameStatistics(&mFrameStatistics);
+        fg.execute(driver);
+        engine.setFrameStatistics(nullptr);
+    }
+    fg.forEachExecutedPass([this](const char* name, float cpuTime) {
+        mFrameStatistics.addPass(name, cpuTime);
+    });
 
     // save the current history entry and destroy the oldest entry
     view.commitFrameHistory(engine);
@@ -1065,6 +1090,13 @@ bool FRenderer::beginFrame(FSwapChain* swapChain, uint64_t vsyncSteadyClockTimeN
                 .historySize = mFrameRateOptions.history
         }, mFrameId);
 
+        // the GPU time of an earlier frame might have become available
+        mFrameStatistics.beginFrame(mFrameId);
+        FrameInfo const& info = mFrameInfoManager.getLastFrameInfo();
+        if (info.frameId) {
+            mFrameStatistics.setGpuFrameTime(info.frameId, info.frameTime.count());
+        }
+
         if (false && vsyncSteadyClockTimeNano) { // work in progress
             const size_t interval = mFrameRateOptions.interval; // user requested swap-interval;
             const steady_clock::duration refreshPeriod(uint64_t(1e9 / mDisplayInfo.refreshRate));
@@ -1137,6 +1169,7 @@ void FRenderer::endFrame() {
 
     mFrameInfoManager.endFrame(driver);
     mFrameSkipper.endFrame(driver);
+    mFrameStatistics.endFrame();
 
     if (mSwapChain) {
         mSwapChain->commit(driver);
@@ -1295,6 +1328,10 @@ void Renderer::setClearOptions(const ClearOptions& options) {
     upcast(this)->setClearOptions(options);
 }
 
+Renderer::FrameStatistics const* Renderer::getFrameStatistics(size_t history) const noexcept {
+    return upcast(this)->getFrameStatistics(history);
+}
+
 void Renderer::renderStandaloneView(View const* view) {
     upcast(this)->renderStandaloneView(upcast(view));
 }
@@ -22,6 +22,7 @@
 
 #include <utils/FixedCapacityVector.h>
 #include <utils/Log.h>
+#include <utils/algorithm.h>
 #include <utils/debug.h>
 
 #include <iterator>
@@ -83,6 +84,17 @@ size_t ResourceAllocator::TextureKey::getSize() const noexcept {
     return size;
 }
 
+uint32_t ResourceAllocator::getSizeClass(uint32_t size) noexcept {
+    // steps are 1/8th of the largest power of two not above size, which wastes at most 12.5%,
+    // but never less than 16 pixels.
+    if (size <= 16u) {
+        return 16u;
+    }
+    const uint32_t pot = 1u << (31u - utils::clz(size));
+    const uint32_t step = std::max(16u, pot / 8u);
+    return (size + step - 1u) & ~(step - 1u);
+}
+
 ResourceAllocator::ResourceAllocator(DriverApi& driverApi) noexcept
         : mBackend(driverApi) {
 }
@@ -123,11 +135,11 @@ backend::TextureHandle ResourceAllocator::createTexture(const char* name,
     // are heterogeneous. This merits further investigation.
 #if !defined(__EMSCRIPTEN__)
     if (!(usage & TextureUsage::SAMPLEABLE)) {
-        // If this texture is not going to be sampled, we can round its size up
-        // this helps prevent many reallocations for small size changes.
-        // We round to 16 pixels, which works for 720p btw.
-        width  = (width  + 15u) & ~15u;
-        height = (height + 15u) & ~15u;
+        // If this texture is not going to be sampled, we can round its size up to a size class,
+        // this helps prevent many reallocations for small size changes, e.g. when the dynamic
+        // resolution scale changes.
+        width  = getSizeClass(width);
+        height = getSizeClass(height);
     }
 #endif
 
@@ -150,7 +162,9 @@ backend::TextureHandle ResourceAllocator::createTexture(const char* name,
             handle = it->second.handle;
             mCacheSize -= it->second.size;
             textureCache.erase(it);
+            mCacheHits++;
         } else {
+            mCacheMisses++;
             // we don't, allocate a new texture and populate the in-use list
             if (swizzle == defaultSwizzle) {
                 handle = mBackend.createTexture(
@@ -251,10 +265,22 @@ void ResourceAllocator::gc() noexcept {
     //if (mAge % 60 == 0) dump();
 }
 
+ResourceAllocator::Stats ResourceAllocator::getStats() const noexcept {
+    Stats stats;
+    stats.hits = mCacheHits;
+    stats.misses = mCacheMisses;
+    stats.evictions = mCacheEvictions;
+    stats.cachedCount = mTextureCache.size();
+    stats.cachedBytes = mCacheSize;
+    return stats;
+}
+
 UTILS_NOINLINE
 void ResourceAllocator::dump(bool brief) const noexcept {
-    slog.d << "# entries=" << mTextureCache.size() << ", sz=" << mCacheSize / float(1u << 20u)
-           << " MiB" << io::endl;
+    const Stats stats = getStats();
+    slog.d << "# entries=" << stats.cachedCount << ", sz=" << stats.cachedBytes / float(1u << 20u)
+           << " MiB, hit rate=" << stats.getHitRate() << ", evictions=" << stats.evictions
+           << io::endl;
     if (!brief) {
         for (auto const& it : mTextureCache) {
             auto w = it.first.width;
@@ -271,6 +297,7 @@ ResourceAllocator::CacheContainer::iterator ResourceAllocator::purge(
     //slog.d << "purging " << pos->second.handle.getId() << ", age=" << pos->second.age << io::endl;
     mBackend.destroyTexture(pos->second.handle);
     mCacheSize -= pos->second.size;
+    mCacheEvictions++;
     return mTextureCache.erase(pos);
 }
 
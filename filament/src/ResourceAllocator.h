@@ -88,6 +88,24 @@ public:
 
     void gc() noexcept;
 
+    struct Stats {
+        size_t hits = 0;            // textures taken from the cache
+        size_t misses = 0;          // textures that had to be allocated
+        size_t evictions = 0;       // cached textures that were destroyed
+        size_t cachedCount = 0;     // textures currently in the cache
+        size_t cachedBytes = 0;     // estimated memory used by the cache
+
+        float getHitRate() const noexcept {
+            return hits + misses ? float(hits) / float(hits + misses) : 0.0f;
+        }
+    };
+
+    Stats getStats() const noexcept;
+
+    // Rounds a dimension of a texture that is never sampled up to one of 8 steps per power of two,
+    // so that small size changes, e.g. with dynamic resolution, map to the same cached texture.
+    static uint32_t getSizeClass(uint32_t size) noexcept;
+
 private:
     // TODO: these should be settings of the engine
     static constexpr size_t CACHE_CAPACITY = 64u << 20u;   // 64 MiB
@@ -121,18 +139,18 @@ private:
 
         friend size_t hash_value(TextureKey const& k) {
             size_t seed = 0;
-            utils::hash::combine_fast(seed, k.target);
-            utils::hash::combine_fast(seed, k.levels);
-            utils::hash::combine_fast(seed, k.format);
-            utils::hash::combine_fast(seed, k.samples);
-            utils::hash::combine_fast(seed, k.width);
-            utils::hash::combine_fast(seed, k.height);
-            utils::hash::combine_fast(seed, k.depth);
-            utils::hash::combine_fast(seed, k.usage);
-            utils::hash::combine_fast(seed, k.swizzle[0]);
-            utils::hash::combine_fast(seed, k.swizzle[1]);
-            utils::hash::combine_fast(seed, k.swizzle[2]);
-            utils::hash::combine_fast(seed, k.swizzle[3]);
+            utils::hash::combine(seed, k.target);
+            utils::hash::combine(seed, k.levels);
+            utils::hash::combine(seed, k.format);
+            utils::hash::combine(seed, k.samples);
+            utils::hash::combine(seed, k.width);
+            utils::hash::combine(seed, k.height);
+            utils::hash::combine(seed, k.depth);
+            utils::hash::combine(seed, k.usage);
+            utils::hash::combine(seed, k.swizzle[0]);
+            utils::hash::combine(seed, k.swizzle[1]);
+            utils::hash::combine(seed, k.swizzle[2]);
+            utils::hash::combine(seed, k.swizzle[3]);
             return seed;
         }
     };
@@ -194,6 +212,9 @@ private:
     AssociativeContainer<backend::TextureHandle, TextureKey> mInUseTextures;
     size_t mAge = 0;
     uint32_t mCacheSize = 0;
+    size_t mCacheHits = 0;
+    size_t mCacheMisses = 0;
+    size_t mCacheEvictions = 0;
     static constexpr bool mEnabled = true;
 };
 
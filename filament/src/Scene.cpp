@@ -27,12 +27,15 @@
 
 #include <utils/compiler.h>
 #include <utils/EntityManager.h>
+#include <utils/JobSystem.h>
 #include <utils/Range.h>
 #include <utils/Systrace.h>
 #include <utils/Zip2Iterator.h>
 
 #include <algorithm>
 
+#include <string.h>
+
 using namespace filament::math;
 using namespace utils;
 
@@ -196,89 +199,150 @@ void FScene::prepare(const mat4& worldOriginTransform, bool shadowReceiversAreCa
     }
 }
 
-void FScene::updateUBOs(utils::Range<uint32_t> visibleRenderables, backend::Handle<backend::HwBufferObject> renderableUbh) noexcept {
+Range<uint32_t> FScene::updateUBOs(utils::Range<uint32_t> visibleRenderables,
+        backend::Handle<backend::HwBufferObject> renderableUbh,
+        RenderableUboShadow& shadow) noexcept {
+    SYSTRACE_CALL();
+
     FEngine::DriverApi& driver = mEngine.getDriverApi();
     FRenderableManager& rcm = mEngine.getRenderableManager();
+    auto& sceneData = mRenderableData;
 
-    const size_t size = visibleRenderables.size() * sizeof(PerRenderableUib);
+    assert_invariant(visibleRenderables.last <= shadow.capacity);
 
-    // allocate space into the command stream directly
-    void* const buffer = driver.allocate(size);
+    // First, update the CPU-side copy of the UBO and flag the entries that have changed. Entries
+    // past the ones that were previously uploaded are always considered changed.
+    const uint32_t validCount = shadow.count;
+    auto work = [&sceneData, &rcm, &shadow, validCount](uint32_t startIndex, uint32_t indexCount) {
+        for (uint32_t i = startIndex, e = startIndex + indexCount; i < e; i++) {
+            mat4f const& model = sceneData.elementAt<WORLD_TRANSFORM>(i);
+            FRenderableManager::Visibility visibility = sceneData.elementAt<VISIBILITY_STATE>(i);
+            auto ri = sceneData.elementAt<RENDERABLE_INSTANCE>(i);
 
-    bool hasContactShadows = false;
-    auto& sceneData = mRenderableData;
-    for (uint32_t i : visibleRenderables) {
-        mat4f const& model = sceneData.elementAt<WORLD_TRANSFORM>(i);
-        FRenderableManager::Visibility visibility = sceneData.elementAt<VISIBILITY_STATE>(i);
-        auto ri = sceneData.elementAt<RENDERABLE_INSTANCE>(i);
-
-        const size_t offset = i * sizeof(PerRenderableUib);
-
-        UniformBuffer::setUniform(buffer,
-                offset + offsetof(PerRenderableUib, worldFromModelMatrix), model);
-
-        // Using mat3f::getTransformForNormals handles non-uniform scaling, but DOESN'T guarantee that
-        // the transformed normals will have unit-length, therefore they need to be normalized
-        // in the shader (that's already the case anyways, since normalization is needed after
-        // interpolation).
-        //
-        // We pre-scale normals by the inverse of the largest scale factor to avoid
-        // large post-transform magnitudes in the shader, especially in the fragment shader, where
-        // we use medium precision.
-        //
-        // Note: if the model matrix is known to be a rigid-transform, we could just use it directly.
-
-        mat3f m = mat3f::getTransformForNormals(model.upperLeft());
-        m *= mat3f(1.0f / std::sqrt(max(float3{length2(m[0]), length2(m[1]), length2(m[2])})));
-
-        // The shading normal must be flipped for mirror transformations.
-        // Basically we're shading the other side of the polygon and therefore need to negate the
-        // normal, similar to what we already do to support double-sided lighting.
-        if (visibility.reversedWindingOrder) {
-            m = -m;
-        }
+            void* const entry = &shadow.entries[i];
+            bool dirty = i >= validCount;
+
+            auto update = [entry, &dirty](size_t offset, auto const& v) {
+                if (dirty || memcmp(static_cast<char*>(entry) + offset, &v, sizeof(v))) {
+                    UniformBuffer::setUniform(entry, offset, v);
+                    dirty = true;
+                }
+            };
+
+            // The normal matrix only depends on the model matrix (the winding order is derived
+            // from it), so it only needs to be recomputed when the latter changes, which is
+            // rarely the case for most renderables.
+            if (dirty || memcmp(static_cast<char*>(entry) +
+                    offsetof(PerRenderableUib, worldFromModelMatrix), &model, sizeof(model))) {
+                UniformBuffer::setUniform(entry,
+                        offsetof(PerRenderableUib, worldFromModelMatrix), model);
+
+                // Using mat3f::getTransformForNormals handles non-uniform scaling, but DOESN'T
+                // guarantee that the transformed normals will have unit-length, therefore they
+                // need to be normalized in the shader (that's already the case anyways, since
+                // normalization is needed after interpolation).
+                //
+                // We pre-scale normals by the inverse of the largest scale factor to avoid
+                // large post-transform magnitudes in the shader, especially in the fragment
+                // shader, where we use medium precision.
+                //
+                // Note: if the model matrix is known to be a rigid-transform, we could just use
+                // it directly.
+
+                mat3f m = mat3f::getTransformForNormals(model.upperLeft());
+                m *= mat3f(1.0f / std::sqrt(max(float3{
+                        length2(m[0]), length2(m[1]), length2(m[2]) })));
+
+                // The shading normal must be flipped for mirror transformations.
+                // Basically we're shading the other side of the polygon and therefore need to
+                // negate the normal, similar to what we already do to support double-sided
+                // lighting.
+                if (visibility.reversedWindingOrder) {
+                    m = -m;
+                }
 
-        UniformBuffer::setUniform(buffer,
-                offset + offsetof(PerRenderableUib, worldFromModelNormalMatrix), m);
+                UniformBuffer::setUniform(entry,
+                        offsetof(PerRenderableUib, worldFromModelNormalMatrix), m);
+                dirty = true;
+            }
 
-        // Note that we cast bool to uint32_t. Booleans are byte-sized in C++, but we need to
-        // initialize all 32 bits in the UBO field.
+            // Note that we cast bool to uint32_t. Booleans are byte-sized in C++, but we need to
+            // initialize all 32 bits in the UBO field.
 
-        hasContactShadows = hasContactShadows || visibility.screenSpaceContactShadows;
+            update(offsetof(PerRenderableUib, flags),
+                    PerRenderableUib::packFlags(
+                            visibility.skinning,
+                            visibility.morphing,
+                            visibility.screenSpaceContactShadows));
 
-        UniformBuffer::setUniform(buffer,
-                offset + offsetof(PerRenderableUib, flags),
-                PerRenderableUib::packFlags(
-                        visibility.skinning,
-                        visibility.morphing,
-                        visibility.screenSpaceContactShadows));
+            update(offsetof(PerRenderableUib, morphWeights),
+                    sceneData.elementAt<MORPH_WEIGHTS>(i));
 
-        UniformBuffer::setUniform(buffer,
-                offset + offsetof(PerRenderableUib, morphWeights),
-                sceneData.elementAt<MORPH_WEIGHTS>(i));
+            update(offsetof(PerRenderableUib, channels),
+                    (uint32_t)sceneData.elementAt<CHANNELS>(i));
 
-        UniformBuffer::setUniform(buffer,
-                offset + offsetof(PerRenderableUib, channels),
-                (uint32_t)sceneData.elementAt<CHANNELS>(i));
+            update(offsetof(PerRenderableUib, objectId),
+                    rcm.getEntity(ri).getId()); // we could also store the entity in sceneData
 
-        UniformBuffer::setUniform(buffer,
-                offset + offsetof(PerRenderableUib, objectId),
-                rcm.getEntity(ri).getId()); // we could also store the entity in sceneData
+            // TODO: We need to find a better way to provide the scale information per object
+            update(offsetof(PerRenderableUib, userData),
+                    sceneData.elementAt<USER_DATA>(i));
 
-        // TODO: We need to find a better way to provide the scale information per object
-        UniformBuffer::setUniform(buffer,
-                offset + offsetof(PerRenderableUib, userData),
-                sceneData.elementAt<USER_DATA>(i));
+            shadow.dirty[i] = dirty;
+        }
+    };
+
+    if (visibleRenderables.size() <= JOBS_PARALLEL_FOR_UBOS_COUNT) {
+        work(visibleRenderables.first, visibleRenderables.size());
+    } else {
+        JobSystem& js = mEngine.getJobSystem();
+        auto* job = jobs::parallel_for(js, nullptr,
+                visibleRenderables.first, (uint32_t)visibleRenderables.size(),
+                std::cref(work), jobs::CountSplitter<JOBS_PARALLEL_FOR_UBOS_COUNT, 4>());
+        js.runAndWait(job);
+    }
+
+    // Then, upload the changed entries. They're coalesced into a single range, because issuing
+    // several glBufferSubData() on the same buffer during a frame can be very slow with some
+    // drivers. The clean entries in between are uploaded too, which is no worse than the full
+    // update we'd do otherwise.
+    bool hasContactShadows = false;
+    uint32_t first = visibleRenderables.last;
+    uint32_t last = visibleRenderables.first;
+    for (uint32_t i : visibleRenderables) {
+        hasContactShadows = hasContactShadows ||
+                sceneData.elementAt<VISIBILITY_STATE>(i).screenSpaceContactShadows;
+        if (shadow.dirty[i]) {
+            first = std::min(first, i);
+            last = i + 1;
+        }
+    }
+
+    Range<uint32_t> uploaded{};
+    if (first < last) {
+        const size_t size = (last - first) * sizeof(PerRenderableUib);
+        void* const buffer = driver.allocate(size);
+        memcpy(buffer, &shadow.entries[first], size);
+        driver.updateBufferObject(renderableUbh, { buffer, size },
+                uint32_t(first * sizeof(PerRenderableUib)));
+        uploaded = { first, last };
+
+        // The entries that match the UBO can only grow by what we've just uploaded, and only if
+        // that's contiguous with them.
+        if (first <= validCount) {
+            shadow.count = std::max(validCount, last);
+        }
     }
 
     // TODO: handle static objects separately
     mHasContactShadows = hasContactShadows;
     mRenderableViewUbh = renderableUbh;
-    driver.updateBufferObject(renderableUbh, { buffer, size }, 0);
 
     if (mSkybox) {
         mSkybox->commit(driver);
     }
+
+    return uploaded;
 }
 
 void FScene::terminate(FEngine& engine) {
@@ -407,7 +407,8 @@ void FView::prepareLighting(FEngine& engine, FEngine::DriverApi& driver, ArenaSc
 }
 
 void FView::prepare(FEngine& engine, DriverApi& driver, ArenaScope& arena,
-        filament::Viewport const& viewport, float4 const& userTime) noexcept {
+        filament::Viewport const& viewport, float4 const& userTime,
+        Renderer::FrameStatistics& stats) noexcept {
     JobSystem& js = engine.getJobSystem();
 
     /*
@@ -457,7 +458,10 @@ void FView::prepare(FEngine& engine, DriverApi& driver, ArenaScope& arena,
      * Gather all information needed to render this scene. Apply the world origin to all
      * objects in the scene.
      */
-    scene->prepare(worldOriginScene, hasVsm());
+    {
+        ScopedCpuTimer timer(stats.prepare);
+        scene->prepare(worldOriginScene, hasVsm());
+    }
 
     /*
      * Light culling: runs in parallel with Renderable culling (below)
@@ -485,19 +489,25 @@ void FView::prepare(FEngine& engine, DriverApi& driver, ArenaScope& arena,
          * (this will set the VISIBLE_RENDERABLE bit)
          */
 
-        prepareVisibleRenderables(js, mCullingFrustum, renderableData);
+        {
+            ScopedCpuTimer timer(stats.culling);
+            prepareVisibleRenderables(js, mCullingFrustum, renderableData);
 
+            // prepareShadowing relies on prepareVisibleLights().
+            if (prepareVisibleLightsJob) {
+                js.waitAndRelease(prepareVisibleLightsJob);
+            }
+        }
 
         /*
          * Shadowing: compute the shadow camera and cull shadow casters
          * (this will set the VISIBLE_DIR_SHADOW_CASTER bit and VISIBLE_SPOT_SHADOW_CASTER bits)
          */
 
-        // prepareShadowing relies on prepareVisibleLights().
-        if (prepareVisibleLightsJob) {
-            js.waitAndRelease(prepareVisibleLightsJob);
+        {
+            ScopedCpuTimer timer(stats.shadows);
+            prepareShadowing(engine, driver, renderableData, scene->getLightData());
         }
-        prepareShadowing(engine, driver, renderableData, scene->getLightData());
 
         /*
          * Partition the SoA so that renderables are partitioned w.r.t their visibility into the
@@ -551,13 +561,15 @@ void FView::prepare(FEngine& engine, DriverApi& driver, ArenaScope& arena,
                 const size_t count = std::max(size_t(16u), (4u * merged.size() + 2u) / 3u);
                 mRenderableUBOSize = uint32_t(count * sizeof(PerRenderableUib));
                 driver.destroyBufferObject(mRenderableUbh);
+                // this is updated in place, only where renderables have changed
                 mRenderableUbh = driver.createBufferObject(mRenderableUBOSize,
-                        BufferObjectBinding::UNIFORM, BufferUsage::STREAM);
+                        BufferObjectBinding::UNIFORM, BufferUsage::DYNAMIC);
+                mRenderableUboShadow.resize(uint32_t(count));
             } else {
                 // TODO: should we shrink the underlying UBO at some point?
             }
             assert_invariant(mRenderableUbh);
-            scene->updateUBOs(merged, mRenderableUbh);
+            scene->updateUBOs(merged, mRenderableUbh, mRenderableUboShadow);
         }
     }
 
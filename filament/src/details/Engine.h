@@ -40,6 +40,8 @@
 
 #include "private/backend/CommandBufferQueue.h"
 #include "private/backend/CommandStream.h"
+#include "private/backend/CommandStreamDecoder.h"
+#include "private/backend/DecodedCommandBufferQueue.h"
 #include "private/backend/DriverApi.h"
 
 #include <private/filament/EngineEnums.h>
@@ -96,6 +98,7 @@ class FSwapChain;
 class FView;
 
 class DFG;
+class FrameStatisticsManager;
 class ResourceAllocator;
 
 /*
@@ -154,6 +157,13 @@ public:
     // we'll simply have to use separate Areas (for instance).
     LinearAllocatorArena& getPerRenderPassAllocator() noexcept { return mPerRenderPassAllocator; }
 
+    // Statistics of the frame being rendered, used to record the RenderPasses. This is only
+    // set by the Renderer while it executes its FrameGraph.
+    FrameStatisticsManager* getFrameStatistics() const noexcept { return mFrameStatistics; }
+    void setFrameStatistics(FrameStatisticsManager* frameStatistics) noexcept {
+        mFrameStatistics = frameStatistics;
+    }
+
     // Material IDs...
     uint32_t getMaterialId() const noexcept { return mMaterialId++; }
 
@@ -339,6 +349,7 @@ private:
     void shutdown();
 
     int loop();
+    void decode();
     void flushCommandBuffer(backend::CommandBufferQueue& commandBufferQueue);
 
     template<typename T, typename L>
@@ -366,6 +377,7 @@ private:
     FLightManager mLightManager;
     FCameraManager mCameraManager;
     ResourceAllocator* mResourceAllocator = nullptr;
+    FrameStatisticsManager* mFrameStatistics = nullptr;
 
     ResourceList<FBufferObject> mBufferObjects{ "BufferObject" };
     ResourceList<FRenderer> mRenderers{ "Renderer" };
@@ -393,6 +405,10 @@ private:
 
     std::thread mDriverThread;
     backend::CommandBufferQueue mCommandBufferQueue;
+    // only used by the pipelined driver, see FEngine::decode()
+    std::thread mDecoderThread;
+    std::unique_ptr<backend::CommandStreamDecoder> mCommandStreamDecoder;
+    backend::DecodedCommandBufferQueue mDecodedCommandBufferQueue;
     DriverApi mCommandStream;
     uint32_t mFlushCounter = 0;
 
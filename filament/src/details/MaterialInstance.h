@@ -64,6 +64,14 @@ public:
 
     FMaterial const* getMaterial() const noexcept { return mMaterial; }
 
+    backend::Handle<backend::HwBufferObject> getUniformBufferHandle() const noexcept {
+        return mUbHandle;
+    }
+
+    backend::Handle<backend::HwSamplerGroup> getSamplerGroupHandle() const noexcept {
+        return mSbHandle;
+    }
+
     uint64_t getSortingKey() const noexcept { return mMaterialSortingKey; }
 
     UniformBuffer const& getUniformBuffer() const noexcept { return mUniforms; }
@@ -29,6 +29,7 @@
 
 #include "private/backend/DriverApiForward.h"
 
+#include <fg2/FrameGraphCache.h>
 #include <fg2/FrameGraphId.h>
 #include <fg2/FrameGraphTexture.h>
 
@@ -128,6 +129,10 @@ public:
         mClearOptions = options;
     }
 
+    FrameStatistics const* getFrameStatistics(size_t history) const noexcept {
+        return mFrameStatistics.getFrameStatistics(history);
+    }
+
 private:
     friend class Renderer;
     using Command = RenderPass::Command;
@@ -190,11 +195,13 @@ private:
     // keep a reference to our engine
     FEngine& mEngine;
     FrameSkipper mFrameSkipper;
+    FrameGraphCache mFrameGraphCache;
     backend::Handle<backend::HwRenderTarget> mRenderTarget;
     FSwapChain* mSwapChain = nullptr;
     size_t mCommandsHighWatermark = 0;
     uint32_t mFrameId = 0;
     FrameInfoManager mFrameInfoManager;
+    FrameStatisticsManager mFrameStatistics;
     backend::TextureFormat mHdrTranslucent{};
     backend::TextureFormat mHdrQualityMedium{};
     backend::TextureFormat mHdrQualityHigh{};
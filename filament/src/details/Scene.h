@@ -29,6 +29,8 @@
 #include <filament/Box.h>
 #include <filament/Scene.h>
 
+#include <private/filament/UibStructs.h>
+
 #include <utils/compiler.h>
 #include <utils/Entity.h>
 #include <utils/Slice.h>
@@ -36,6 +38,8 @@
 #include <utils/Range.h>
 #include <utils/debug.h>
 
+#include <memory>
+
 #include <stddef.h>
 
 #include <tsl/robin_set.h>
@@ -189,11 +193,36 @@ public:
     LightSoa const& getLightData() const noexcept { return mLightData; }
     LightSoa& getLightData() noexcept { return mLightData; }
 
-    void updateUBOs(utils::Range<uint32_t> visibleRenderables, backend::Handle<backend::HwBufferObject> renderableUbh) noexcept;
+    /*
+     * CPU-side copy of a per-renderable UBO, which allows updateUBOs() to only upload the
+     * entries that changed since the previous update. This is owned by the View, along with the
+     * UBO itself.
+     */
+    struct RenderableUboShadow {
+        std::unique_ptr<PerRenderableUib[]> entries;
+        std::unique_ptr<bool[]> dirty;
+        uint32_t capacity = 0;  // number of allocated entries
+        uint32_t count = 0;     // number of leading entries known to match the UBO
+
+        void resize(uint32_t newCapacity) noexcept {
+            entries.reset(new PerRenderableUib[newCapacity]());
+            dirty.reset(new bool[newCapacity]());
+            capacity = newCapacity;
+            count = 0;
+        }
+    };
+
+    // Returns the range of entries that was uploaded, which is empty if nothing changed.
+    utils::Range<uint32_t> updateUBOs(utils::Range<uint32_t> visibleRenderables,
+            backend::Handle<backend::HwBufferObject> renderableUbh,
+            RenderableUboShadow& shadow) noexcept;
 
     bool hasContactShadows() const noexcept;
 
 private:
+    // minimum number of renderables per job when updating the UBO shadow in parallel
+    static constexpr size_t JOBS_PARALLEL_FOR_UBOS_COUNT = 512;
+
     static inline void computeLightRanges(math::float2* zrange,
             CameraInfo const& camera, const math::float4* spheres, size_t count) noexcept;
 
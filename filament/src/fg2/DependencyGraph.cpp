@@ -26,6 +26,7 @@ DependencyGraph::DependencyGraph() noexcept {
     // Some reasonable defaults size for our vectors
     mNodes.reserve(8);
     mEdges.reserve(16);
+    mLinks.reserve(32);
 }
 
 DependencyGraph::~DependencyGraph() noexcept = default;
@@ -60,6 +61,13 @@ void DependencyGraph::link(DependencyGraph::Edge* edge) noexcept {
         edges.reserve(edges.capacity() * 2);
     }
     edges.push_back(edge);
+
+    LinkContainer& links = mLinks;
+    if (UTILS_UNLIKELY(links.capacity() < links.size() + 2)) {
+        links.reserve(links.capacity() * 2);
+    }
+    links.push_back(edge->from);
+    links.push_back(edge->to);
 }
 
 DependencyGraph::EdgeContainer const& DependencyGraph::getEdges() const noexcept {
@@ -134,9 +142,22 @@ void DependencyGraph::cull() noexcept {
     }
 }
 
+void DependencyGraph::getRefCounts(uint32_t* refCounts) const noexcept {
+    for (Node const* const pNode : mNodes) {
+        *refCounts++ = pNode->mRefCount;
+    }
+}
+
+void DependencyGraph::setRefCounts(uint32_t const* refCounts) noexcept {
+    for (Node* const pNode : mNodes) {
+        pNode->mRefCount = *refCounts++;
+    }
+}
+
 void DependencyGraph::clear() noexcept {
     mEdges.clear();
     mNodes.clear();
+    mLinks.clear();
 }
 
 void DependencyGraph::export_graphviz(utils::io::ostream& out, char const* name) {
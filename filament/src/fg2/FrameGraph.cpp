@@ -27,6 +27,9 @@
 #include <utils/Panic.h>
 #include <utils/Systrace.h>
 
+#include <algorithm>
+#include <chrono>
+
 namespace filament {
 
 inline FrameGraph::Builder::Builder(FrameGraph& fg, PassNode* passNode) noexcept
@@ -59,8 +62,9 @@ FrameGraphId<FrameGraphTexture> FrameGraph::Builder::declareRenderPass(
 
 // ------------------------------------------------------------------------------------------------
 
-FrameGraph::FrameGraph(ResourceAllocatorInterface& resourceAllocator)
+FrameGraph::FrameGraph(ResourceAllocatorInterface& resourceAllocator, FrameGraphCache* cache)
         : mResourceAllocator(resourceAllocator),
+          mCache(cache),
           mArena("FrameGraph Arena", 131072),
           mResourceSlots(mArena),
           mResources(mArena),
@@ -106,8 +110,38 @@ FrameGraph& FrameGraph::compile() noexcept {
 
     DependencyGraph& dependencyGraph = mGraph;
 
-    // first we cull unreachable nodes
-    dependencyGraph.cull();
+    /*
+     * Culling and resource registration only depend on the structure of the graph, if we've
+     * seen this structure before we just replay the results.
+     */
+    FrameGraphCache::Entry* cached = nullptr;
+    FrameGraphCache::Entry* recorded = nullptr;
+    if (mCache) {
+        // the edges are recorded by the DependencyGraph as they're added, so only the passes
+        // need to be listed here
+        std::vector<uint32_t>& passes = mCache->mPasses;
+        passes.clear();
+        for (PassNode const* pPassNode : mPassNodes) {
+            passes.push_back((pPassNode->getId() << 1u) | uint32_t(pPassNode->isTarget()));
+        }
+        const uint32_t nodeCount = dependencyGraph.getNodes().size();
+        auto const& links = dependencyGraph.getLinks();
+        cached = mCache->find(nodeCount, passes, links.data(), links.size());
+        if (!cached) {
+            recorded = &mCache->insert(nodeCount, passes, links.data(), links.size());
+        }
+    }
+
+    if (cached) {
+        dependencyGraph.setRefCounts(cached->refCounts.data());
+    } else {
+        // first we cull unreachable nodes
+        dependencyGraph.cull();
+        if (recorded) {
+            recorded->refCounts.resize(dependencyGraph.getNodes().size());
+            dependencyGraph.getRefCounts(recorded->refCounts.data());
+        }
+    }
 
     /*
      * update the reference counter of the resource themselves and
@@ -119,6 +153,7 @@ FrameGraph& FrameGraph::compile() noexcept {
         return !pPassNode->isCulled();
     });
 
+    uint32_t index = 0;
     auto first = mPassNodes.begin();
     const auto activePassNodesEnd = mActivePassNodesEnd;
     while (first != activePassNodesEnd) {
@@ -126,24 +161,48 @@ FrameGraph& FrameGraph::compile() noexcept {
         first++;
         assert_invariant(!passNode->isCulled());
 
+        if (cached) {
+            // this avoids scanning all the edges of the graph for each pass
+            auto const& registrations = cached->registrations;
+            const uint32_t begin = index ? cached->registrationsEnd[index - 1] : 0;
+            const uint32_t end = cached->registrationsEnd[index];
+            for (uint32_t i = begin; i < end; i++) {
+                auto pNode = static_cast<ResourceNode*>(
+                        dependencyGraph.getNode(registrations[i]));
+                passNode->registerResource(pNode->resourceHandle);
+            }
+        } else {
+            auto const& reads = dependencyGraph.getIncomingEdges(passNode);
+            for (auto const& edge : reads) {
+                // all incoming edges should be valid by construction
+                assert_invariant(dependencyGraph.isEdgeValid(edge));
+                auto pNode = static_cast<ResourceNode*>(dependencyGraph.getNode(edge->from));
+                passNode->registerResource(pNode->resourceHandle);
+                if (recorded) {
+                    recorded->registrations.push_back(edge->from);
+                }
+            }
 
-        auto const& reads = dependencyGraph.getIncomingEdges(passNode);
-        for (auto const& edge : reads) {
-            // all incoming edges should be valid by construction
-            assert_invariant(dependencyGraph.isEdgeValid(edge));
-            auto pNode = static_cast<ResourceNode*>(dependencyGraph.getNode(edge->from));
-            passNode->registerResource(pNode->resourceHandle);
-        }
+            auto const& writes = dependencyGraph.getOutgoingEdges(passNode);
+            for (auto const& edge : writes) {
+                // an outgoing edge might be invalid if the node it points to has been culled
+                // but, because we are not culled and we're a pass, we add a reference to
+                // the resource we are writing to.
+                auto pNode = static_cast<ResourceNode*>(dependencyGraph.getNode(edge->to));
+                passNode->registerResource(pNode->resourceHandle);
+                if (recorded) {
+                    recorded->registrations.push_back(edge->to);
+                }
+            }
 
-        auto const& writes = dependencyGraph.getOutgoingEdges(passNode);
-        for (auto const& edge : writes) {
-            // an outgoing edge might be invalid if the node it points to has been culled
-            // but, because we are not culled and we're a pass, we add a reference to
-            // the resource we are writing to.
-            auto pNode = static_cast<ResourceNode*>(dependencyGraph.getNode(edge->to));
-            passNode->registerResource(pNode->resourceHandle);
+            if (recorded) {
+                recorded->registrationsEnd.push_back(recorded->registrations.size());
+            }
         }
+        index++;
 
+        // this depends on the resource descriptors, which can change without the structure
+        // changing, so it's never cached.
         passNode->resolve();
     }
 
@@ -205,7 +264,10 @@ void FrameGraph::execute(backend::DriverApi& driver) noexcept {
 
         // call execute
         FrameGraphResources resources(*this, *node);
+        const auto start = std::chrono::steady_clock::now();
         node->execute(resources, driver);
+        node->cpuTime = std::chrono::duration<float, std::milli>(
+                std::chrono::steady_clock::now() - start).count();
 
         // destroy concrete resources
         for (VirtualResource* resource : node->destroy) {
@@ -220,6 +282,12 @@ void FrameGraph::execute(backend::DriverApi& driver) noexcept {
     driver.popGroupMarker();
 }
 
+void FrameGraph::forEachExecutedPass(std::function<void(const char*, float)> const& f) const {
+    for (auto it = mPassNodes.begin(); it != mActivePassNodesEnd; ++it) {
+        f((*it)->getName(), (*it)->cpuTime);
+    }
+}
+
 void FrameGraph::addPresentPass(std::function<void(FrameGraph::Builder&)> setup) noexcept {
     PresentPassNode* node = mArena.make<PresentPassNode>(*this);
     mPassNodes.push_back(node);
@@ -20,6 +20,7 @@
 #include "Allocators.h"
 
 #include "fg2/Blackboard.h"
+#include "fg2/FrameGraphCache.h"
 #include "fg2/FrameGraphId.h"
 #include "fg2/FrameGraphPass.h"
 #include "fg2/FrameGraphRenderPass.h"
@@ -207,7 +208,14 @@ public:
 
     // --------------------------------------------------------------------------------------------
 
-    explicit FrameGraph(ResourceAllocatorInterface& resourceAllocator);
+    /**
+     * @param resourceAllocator allocator of the concrete resources
+     * @param cache             optional cache of compiled graphs, shared with the FrameGraphs
+     *                          of previous frames. When given, compile() reuses the schedule of
+     *                          a structurally identical graph instead of computing it again.
+     */
+    explicit FrameGraph(ResourceAllocatorInterface& resourceAllocator,
+            FrameGraphCache* cache = nullptr);
     FrameGraph(FrameGraph const&) = delete;
     FrameGraph& operator=(FrameGraph const&) = delete;
     ~FrameGraph() noexcept;
@@ -367,6 +375,12 @@ public:
     //! export a graphviz view of the graph
     void export_graphviz(utils::io::ostream& out, const char* name = nullptr);
 
+    /**
+     * Calls f(name, cpuTime) for each pass run by execute(), in order of execution. cpuTime is
+     * the time spent in the pass, in milliseconds, including the creation of its render targets.
+     */
+    void forEachExecutedPass(std::function<void(const char*, float)> const& f) const;
+
 private:
     friend class FrameGraphResources;
     friend class PassNode;
@@ -453,6 +467,7 @@ private:
 
     Blackboard mBlackboard;
     ResourceAllocatorInterface& mResourceAllocator;
+    FrameGraphCache* const mCache;
     LinearAllocatorArena mArena;
     DependencyGraph mGraph;
 
@@ -0,0 +1,68 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "fg2/FrameGraphCache.h"
+
+#include <algorithm>
+
+namespace filament {
+
+FrameGraphCache::FrameGraphCache() noexcept = default;
+
+FrameGraphCache::~FrameGraphCache() noexcept = default;
+
+FrameGraphCache::Entry* FrameGraphCache::find(uint32_t nodeCount,
+        std::vector<uint32_t> const& passes, uint32_t const* links, size_t linkCount) noexcept {
+    mTime++;
+    for (Entry& entry : mEntries) {
+        if (entry.valid && entry.nodeCount == nodeCount && entry.passes == passes &&
+                entry.links.size() == linkCount &&
+                std::equal(entry.links.begin(), entry.links.end(), links)) {
+            entry.lastUsed = mTime;
+            mHitCount++;
+            return &entry;
+        }
+    }
+    mMissCount++;
+    return nullptr;
+}
+
+FrameGraphCache::Entry& FrameGraphCache::insert(uint32_t nodeCount,
+        std::vector<uint32_t> const& passes, uint32_t const* links, size_t linkCount) noexcept {
+    Entry* victim = &mEntries[0];
+    for (Entry& entry : mEntries) {
+        if (!entry.valid) {
+            victim = &entry;
+            break;
+        }
+        if (entry.lastUsed < victim->lastUsed) {
+            victim = &entry;
+        }
+    }
+    // the vectors are assigned or cleared rather than reallocated, so their storage is reused
+    Entry& entry = *victim;
+    entry.nodeCount = nodeCount;
+    entry.passes.assign(passes.begin(), passes.end());
+    entry.links.assign(links, links + linkCount);
+    entry.lastUsed = mTime;
+    entry.valid = true;
+    entry.refCounts.clear();
+    entry.registrations.clear();
+    entry.registrationsEnd.clear();
+    return entry;
+}
+
+} // namespace filament
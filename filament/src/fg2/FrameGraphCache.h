@@ -0,0 +1,92 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TNT_FILAMENT_FG2_FRAMEGRAPHCACHE_H
+#define TNT_FILAMENT_FG2_FRAMEGRAPHCACHE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+namespace filament {
+
+/*
+ * A FrameGraphCache outlives the FrameGraphs it's given to and keeps the results of
+ * FrameGraph::compile() that only depend on the shape of the graph, i.e. its passes, the
+ * targets among them and the edges between nodes. When a FrameGraph has the same shape as one
+ * compiled earlier, culling and the computation of resource lifetimes are skipped.
+ *
+ * The shape is compared exactly, but it's cheap to gather: the edges are recorded by the
+ * DependencyGraph as they're added, only the passes are listed by compile().
+ *
+ * The cache keeps a few entries, so that several views each rendering a different graph
+ * every frame don't evict each other.
+ */
+class FrameGraphCache {
+public:
+    FrameGraphCache() noexcept;
+    ~FrameGraphCache() noexcept;
+
+    FrameGraphCache(FrameGraphCache const&) = delete;
+    FrameGraphCache& operator=(FrameGraphCache const&) = delete;
+
+    // number of FrameGraph::compile() that reused a cached entry, or that didn't
+    size_t getHitCount() const noexcept { return mHitCount; }
+    size_t getMissCount() const noexcept { return mMissCount; }
+
+private:
+    friend class FrameGraph;
+
+    static constexpr size_t ENTRY_COUNT = 4;
+
+    struct Entry {
+        // the shape of the graph: its node count, the id of each pass shifted left by one with
+        // the lowest bit set for targets, and the ids of the nodes of each edge
+        uint32_t nodeCount = 0;
+        std::vector<uint32_t> passes;
+        std::vector<uint32_t> links;
+        uint32_t lastUsed = 0;
+        bool valid = false;
+
+        // reference count of each DependencyGraph node after culling
+        std::vector<uint32_t> refCounts;
+
+        // ids of the ResourceNodes registered by each active pass, in order. The registrations of
+        // the i-th active pass end at registrationsEnd[i].
+        std::vector<uint32_t> registrations;
+        std::vector<uint32_t> registrationsEnd;
+    };
+
+    // returns the entry matching this shape exactly, or nullptr
+    Entry* find(uint32_t nodeCount, std::vector<uint32_t> const& passes,
+            uint32_t const* links, size_t linkCount) noexcept;
+
+    // returns an invalidated entry to record a new shape in, recycling the least recently used
+    Entry& insert(uint32_t nodeCount, std::vector<uint32_t> const& passes,
+            uint32_t const* links, size_t linkCount) noexcept;
+
+    Entry mEntries[ENTRY_COUNT];
+    // the passes of the graph being compiled, kept here so their storage is reused every frame
+    std::vector<uint32_t> mPasses;
+    uint32_t mTime = 0;
+    size_t mHitCount = 0;
+    size_t mMissCount = 0;
+};
+
+} // namespace filament
+
+#endif // TNT_FILAMENT_FG2_FRAMEGRAPHCACHE_H
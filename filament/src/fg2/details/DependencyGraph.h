@@ -129,6 +129,7 @@ public:
 
     using EdgeContainer = utils::FixedCapacityVector<Edge*, std::allocator<Edge*>, false>;
     using NodeContainer = utils::FixedCapacityVector<Node*, std::allocator<Node*>, false>;
+    using LinkContainer = utils::FixedCapacityVector<NodeID, std::allocator<NodeID>, false>;
 
     /**
      * Removes all edges and nodes from the graph.
@@ -142,6 +143,13 @@ public:
     /** return the list of all nodes */
     NodeContainer const& getNodes() const noexcept;
 
+    /**
+     * Returns the ids of the two nodes of each edge (from, then to), in the same order as
+     * getEdges(). This is recorded as edges are added, so that the shapes of two graphs can be
+     * compared without walking their edges.
+     */
+    LinkContainer const& getLinks() const noexcept { return mLinks; }
+
     /**
      * Returns the list of incoming edges to a node
      * @param node the node to consider
@@ -163,6 +171,18 @@ public:
     //! cull unreferenced nodes. Links ARE NOT removed, only reference counts are updated.
     void cull() noexcept;
 
+    /**
+     * Saves the reference counts of all nodes, which must hold getNodes().size() entries.
+     * Valid only after cull() is called.
+     */
+    void getRefCounts(uint32_t* refCounts) const noexcept;
+
+    /**
+     * Restores reference counts saved with getRefCounts(). This is equivalent to cull() if the
+     * graph has the same nodes, targets and edges as the one they were saved from.
+     */
+    void setRefCounts(uint32_t const* refCounts) noexcept;
+
     /**
      * Return whether an edge is valid, that is if both ends are connected to nodes
      * that are not culled. Valid only after cull() is called.
@@ -183,6 +203,7 @@ private:
     static bool isAcyclicInternal(DependencyGraph& graph) noexcept;
     NodeContainer mNodes;
     EdgeContainer mEdges;
+    LinkContainer mLinks;
 };
 
 inline DependencyGraph::Edge::Edge(DependencyGraph& graph,
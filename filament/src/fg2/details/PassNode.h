@@ -60,6 +60,7 @@ public:
 
     Vector<VirtualResource*> devirtualize;         // resources we need to create before executing
     Vector<VirtualResource*> destroy;              // resources we need to destroy after executing
+    float cpuTime = 0.0f;                          // time spent in execute(), in milliseconds
 };
 
 class RenderPassNode : public PassNode {
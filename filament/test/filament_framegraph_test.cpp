@@ -23,6 +23,7 @@
 #include "private/backend/CommandStream.h"
 
 #include "fg2/FrameGraph.h"
+#include "fg2/FrameGraphCache.h"
 #include "fg2/FrameGraphResources.h"
 #include "fg2/details/DependencyGraph.h"
 
@@ -117,6 +118,34 @@ TEST(DependencyGraphTest, Simple) {
     for (auto n : nodes) { delete n; }
 }
 
+TEST(DependencyGraphTest, Links) {
+    DependencyGraph graph;
+    Node* n0 = new Node(graph, "node 0");
+    Node* n1 = new Node(graph, "node 1");
+    Node* n2 = new Node(graph, "node 2");
+
+    new DependencyGraph::Edge(graph, n1, n2);
+    new DependencyGraph::Edge(graph, n0, n1);
+    new DependencyGraph::Edge(graph, n0, n2);
+
+    // links are recorded as (from, to) pairs, in the order edges are added
+    auto const& links = graph.getLinks();
+    ASSERT_EQ(links.size(), 6);
+    EXPECT_EQ(links[0], n1->getId());
+    EXPECT_EQ(links[1], n2->getId());
+    EXPECT_EQ(links[2], n0->getId());
+    EXPECT_EQ(links[3], n1->getId());
+    EXPECT_EQ(links[4], n0->getId());
+    EXPECT_EQ(links[5], n2->getId());
+
+    auto edges = graph.getEdges();
+    auto nodes = graph.getNodes();
+    graph.clear();
+    EXPECT_TRUE(graph.getLinks().empty());
+    for (auto e : edges) { delete e; }
+    for (auto n : nodes) { delete n; }
+}
+
 TEST(DependencyGraphTest, Culling1) {
     DependencyGraph graph;
     Node* n0 = new Node(graph, "node 0");
@@ -840,6 +869,226 @@ TEST_F(FrameGraphTest, SubResourcesRead) {
     fg.execute(driverApi);
 }
 
+TEST_F(FrameGraphTest, TransientTextureReuse) {
+    // A transient texture destroyed after its last pass goes back to the ResourceAllocator's
+    // cache, so a later texture with the same descriptor and usage gets it back.
+    backend::Handle<backend::HwTexture> firstColor;
+
+    struct FirstPassData {
+        FrameGraphId<FrameGraphTexture> color;
+    };
+    auto& firstPass = fg.addPass<FirstPassData>("First pass",
+            [&](FrameGraph::Builder& builder, auto& data) {
+                data.color = builder.create<FrameGraphTexture>("First color", {.width=16, .height=32});
+                data.color = builder.declareRenderPass(data.color);
+            },
+            [&firstColor](FrameGraphResources const& resources, auto const& data, backend::DriverApi& driver) {
+                firstColor = resources.get(data.color).handle;
+            });
+
+    struct SecondPassData {
+        FrameGraphId<FrameGraphTexture> input;
+        FrameGraphId<FrameGraphTexture> depth;
+    };
+    auto& secondPass = fg.addPass<SecondPassData>("Second pass",
+            [&](FrameGraph::Builder& builder, auto& data) {
+                data.input = builder.sample(firstPass->color);
+                data.depth = builder.create<FrameGraphTexture>("Depth",
+                        {.width=16, .height=32, .format=TextureFormat::DEPTH32F});
+                data.depth = builder.write(data.depth, FrameGraphTexture::Usage::DEPTH_ATTACHMENT);
+                builder.declareRenderPass("Depth target", { .attachments = { .depth = data.depth }});
+            },
+            [=](FrameGraphResources const& resources, auto const& data, backend::DriverApi& driver) {
+            });
+
+    struct ThirdPassData {
+        FrameGraphId<FrameGraphTexture> input;
+        FrameGraphId<FrameGraphTexture> color;
+    };
+    auto& thirdPass = fg.addPass<ThirdPassData>("Third pass",
+            [&](FrameGraph::Builder& builder, auto& data) {
+                data.input = builder.sample(secondPass->depth);
+                data.color = builder.create<FrameGraphTexture>("Unsampled color", {.width=16, .height=32});
+                data.color = builder.declareRenderPass(data.color);
+                builder.sideEffect();
+            },
+            [&firstColor](FrameGraphResources const& resources, auto const& data, backend::DriverApi& driver) {
+                // "Unsampled color" has the same descriptor as "First color" but not the same usage,
+                // so it can't reuse its texture.
+                EXPECT_FALSE(any(resources.getUsage(data.color) & FrameGraphTexture::Usage::SAMPLEABLE));
+                EXPECT_NE(resources.get(data.color).handle, firstColor);
+            });
+
+    struct FourthPassData {
+        FrameGraphId<FrameGraphTexture> color;
+    };
+    auto& fourthPass = fg.addPass<FourthPassData>("Fourth pass",
+            [&](FrameGraph::Builder& builder, auto& data) {
+                data.color = builder.create<FrameGraphTexture>("Second color", {.width=16, .height=32});
+                data.color = builder.declareRenderPass(data.color);
+            },
+            [&firstColor](FrameGraphResources const& resources, auto const& data, backend::DriverApi& driver) {
+                // "Second color" is created and used exactly like "First color", so it gets
+                // its texture from the cache.
+                EXPECT_EQ(resources.get(data.color).handle, firstColor);
+            });
+
+    auto& fifthPass = fg.addPass<FourthPassData>("Fifth pass",
+            [&](FrameGraph::Builder& builder, auto& data) {
+                data.color = builder.sample(fourthPass->color);
+                builder.sideEffect();
+            },
+            [=](FrameGraphResources const& resources, auto const& data, backend::DriverApi& driver) {
+            });
+
+    EXPECT_TRUE(fg.isAcyclic());
+
+    fg.compile();
+
+    EXPECT_FALSE(fg.isCulled(thirdPass));
+    EXPECT_FALSE(fg.isCulled(fifthPass));
+
+    fg.execute(driverApi);
+    EXPECT_TRUE(firstColor);
+}
+
+TEST_F(FrameGraphTest, CompileCache) {
+    FrameGraphCache cache;
+
+    auto build = [&](FrameGraph& fg, uint32_t width) {
+        struct PassData {
+            FrameGraphId<FrameGraphTexture> color;
+        };
+        auto& renderPass = fg.addPass<PassData>("Render pass",
+                [&](FrameGraph::Builder& builder, auto& data) {
+                    data.color = builder.create<FrameGraphTexture>("Color", {.width=width, .height=32});
+                    data.color = builder.declareRenderPass(data.color);
+                },
+                [=](FrameGraphResources const& resources, auto const& data, backend::DriverApi& driver) {
+                    EXPECT_EQ(resources.getDescriptor(data.color).width, width);
+                    EXPECT_TRUE(any(resources.getUsage(data.color) & FrameGraphTexture::Usage::SAMPLEABLE));
+                });
+
+        auto& culledPass = fg.addPass<PassData>("Culled pass",
+                [&](FrameGraph::Builder& builder, auto& data) {
+                    data.color = builder.create<FrameGraphTexture>("Unused", {.width=width, .height=32});
+                    data.color = builder.declareRenderPass(data.color);
+                },
+                [=](FrameGraphResources const& resources, auto const& data, backend::DriverApi& driver) {
+                    EXPECT_TRUE(false);
+                });
+
+        bool executed = false;
+        auto& postProcessPass = fg.addPass<PassData>("Post process pass",
+                [&](FrameGraph::Builder& builder, auto& data) {
+                    builder.sample(renderPass->color);
+                    data.color = builder.create<FrameGraphTexture>("Output", {.width=width, .height=32});
+                    data.color = builder.declareRenderPass(data.color);
+                    builder.sideEffect();
+                },
+                [&executed](FrameGraphResources const& resources, auto const& data, backend::DriverApi& driver) {
+                    executed = true;
+                });
+
+        fg.compile();
+        EXPECT_FALSE(fg.isCulled(renderPass));
+        EXPECT_TRUE(fg.isCulled(culledPass));
+        EXPECT_FALSE(fg.isCulled(postProcessPass));
+        fg.execute(driverApi);
+        EXPECT_TRUE(executed);
+    };
+
+    {
+        FrameGraph fg{ resourceAllocator, &cache };
+        build(fg, 16);
+        EXPECT_EQ(cache.getHitCount(), 0);
+        EXPECT_EQ(cache.getMissCount(), 1);
+    }
+    {
+        // same structure with different descriptors: the schedule is reused
+        FrameGraph fg{ resourceAllocator, &cache };
+        build(fg, 64);
+        EXPECT_EQ(cache.getHitCount(), 1);
+        EXPECT_EQ(cache.getMissCount(), 1);
+    }
+}
+
+TEST_F(FrameGraphTest, CompileCacheStructure) {
+    FrameGraphCache cache;
+
+    // both graphs have the same passes, resources and number of edges, only the texture sampled
+    // by the second pass differs.
+    auto build = [&](FrameGraph& fg, bool sampleFirst) {
+        struct RenderPassData {
+            FrameGraphId<FrameGraphTexture> first;
+            FrameGraphId<FrameGraphTexture> second;
+        };
+        auto& renderPass = fg.addPass<RenderPassData>("Render pass",
+                [&](FrameGraph::Builder& builder, auto& data) {
+                    data.first = builder.create<FrameGraphTexture>("First", {.width=16, .height=32});
+                    data.second = builder.create<FrameGraphTexture>("Second", {.width=16, .height=32});
+                    data.first = builder.write(data.first, FrameGraphTexture::Usage::COLOR_ATTACHMENT);
+                    data.second = builder.write(data.second, FrameGraphTexture::Usage::COLOR_ATTACHMENT);
+                },
+                [=](FrameGraphResources const& resources, auto const& data, backend::DriverApi& driver) {
+                    EXPECT_EQ(any(resources.getUsage(data.first) & FrameGraphTexture::Usage::SAMPLEABLE), sampleFirst);
+                    EXPECT_EQ(any(resources.getUsage(data.second) & FrameGraphTexture::Usage::SAMPLEABLE), !sampleFirst);
+                });
+
+        struct PostProcessPassData {
+            FrameGraphId<FrameGraphTexture> output;
+        };
+        fg.addPass<PostProcessPassData>("Post process pass",
+                [&](FrameGraph::Builder& builder, auto& data) {
+                    builder.sample(sampleFirst ? renderPass->first : renderPass->second);
+                    data.output = builder.create<FrameGraphTexture>("Output", {.width=16, .height=32});
+                    data.output = builder.declareRenderPass(data.output);
+                    builder.sideEffect();
+                },
+                [](FrameGraphResources const& resources, auto const& data, backend::DriverApi& driver) {
+                });
+
+        fg.compile();
+        fg.execute(driverApi);
+    };
+
+    {
+        FrameGraph fg{ resourceAllocator, &cache };
+        build(fg, true);
+        EXPECT_EQ(cache.getHitCount(), 0);
+        EXPECT_EQ(cache.getMissCount(), 1);
+    }
+    {
+        FrameGraph fg{ resourceAllocator, &cache };
+        build(fg, false);
+        EXPECT_EQ(cache.getHitCount(), 0);
+        EXPECT_EQ(cache.getMissCount(), 2);
+    }
+    {
+        // both structures are kept
+        FrameGraph fg{ resourceAllocator, &cache };
+        build(fg, true);
+        EXPECT_EQ(cache.getHitCount(), 1);
+        EXPECT_EQ(cache.getMissCount(), 2);
+    }
+}
+
+TEST(ResourceAllocatorTest, SizeClasses) {
+    EXPECT_EQ(ResourceAllocator::getSizeClass(1), 16);
+    EXPECT_EQ(ResourceAllocator::getSizeClass(16), 16);
+    EXPECT_EQ(ResourceAllocator::getSizeClass(17), 32);
+    EXPECT_EQ(ResourceAllocator::getSizeClass(1920), 1920);
+    EXPECT_EQ(ResourceAllocator::getSizeClass(1080), 1152);
+    // small changes of resolution map to the same size class
+    EXPECT_EQ(ResourceAllocator::getSizeClass(1800), ResourceAllocator::getSizeClass(1850));
+    for (uint32_t size = 1; size < 4096; size++) {
+        const uint32_t sizeClass = ResourceAllocator::getSizeClass(size);
+        EXPECT_GE(sizeClass, size);
+        // never more than 12.5% larger, or than rounding to 16 pixels
+        EXPECT_LE(sizeClass, std::max((size + 15u) & ~15u, size + size / 8u));
+    }
+}
+
 TEST_F(FrameGraphTest, SubResourcesWriteRead) {
 
     struct UpstreamPassData {
@@ -39,8 +39,10 @@
 #include "Allocators.h"
 #include "details/Material.h"
 #include "details/Camera.h"
+#include "FrameInfo.h"
 #include "Froxelizer.h"
 #include "details/Engine.h"
+#include "details/Scene.h"
 #include "components/RenderableManager.h"
 #include "components/TransformManager.h"
 #include "UniformBuffer.h"
@@ -727,6 +729,171 @@ TEST(FilamentTest, FroxelData) {
     Engine::destroy((Engine **)&engine);
 }
 
+TEST(FilamentTest, RenderableUboDirtyRange) {
+    using namespace filament;
+
+    FEngine* engine = FEngine::create(Engine::Backend::NOOP);
+    FScene* scene = upcast(engine->createScene());
+    FTransformManager& tcm = engine->getTransformManager();
+    FEngine::DriverApi& driver = engine->getDriverApi();
+
+    constexpr uint32_t COUNT = 8;
+    Entity entities[COUNT];
+    engine->getEntityManager().create(COUNT, entities);
+    for (Entity e : entities) {
+        RenderableManager::Builder(1)
+                .boundingBox({{ 0, 0, 0 }, { 1, 1, 1 }})
+                .build(*engine, e);
+        scene->addEntity(e);
+    }
+
+    FScene::RenderableUboShadow shadow;
+    shadow.resize(16);
+    auto ubh = driver.createBufferObject(shadow.capacity * sizeof(PerRenderableUib),
+            backend::BufferObjectBinding::UNIFORM, backend::BufferUsage::DYNAMIC);
+
+    // returns the index of an entity in the scene, which is also its index in the UBO
+    auto indexOf = [scene, engine](Entity e) {
+        auto const& sceneData = scene->getRenderableData();
+        auto ri = engine->getRenderableManager().getInstance(e);
+        for (uint32_t i = 0; i < sceneData.size(); i++) {
+            if (sceneData.elementAt<FScene::RENDERABLE_INSTANCE>(i) == ri) {
+                return i;
+            }
+        }
+        return COUNT;
+    };
+
+    const Range<uint32_t> all{ 0, COUNT };
+
+    // the first update uploads everything
+    scene->prepare({}, false);
+    Range<uint32_t> uploaded = scene->updateUBOs(all, ubh, shadow);
+    EXPECT_EQ(uploaded.first, 0u);
+    EXPECT_EQ(uploaded.last, COUNT);
+    EXPECT_EQ(shadow.count, COUNT);
+
+    // nothing changed, nothing is uploaded
+    scene->prepare({}, false);
+    uploaded = scene->updateUBOs(all, ubh, shadow);
+    EXPECT_TRUE(uploaded.empty());
+    EXPECT_EQ(shadow.count, COUNT);
+
+    // two renderables moved, a single range covering both of them is uploaded
+    const mat4f transform = mat4f::translation(float3{ 1, 2, 3 });
+    tcm.setTransform(tcm.getInstance(entities[2]), transform);
+    tcm.setTransform(tcm.getInstance(entities[5]), transform);
+    scene->prepare({}, false);
+    const uint32_t i2 = indexOf(entities[2]);
+    const uint32_t i5 = indexOf(entities[5]);
+    ASSERT_LT(i2, COUNT);
+    ASSERT_LT(i5, COUNT);
+    uploaded = scene->updateUBOs(all, ubh, shadow);
+    EXPECT_EQ(uploaded.first, std::min(i2, i5));
+    EXPECT_EQ(uploaded.last, std::max(i2, i5) + 1);
+    for (uint32_t i : all) {
+        EXPECT_EQ(shadow.dirty[i], i == i2 || i == i5);
+    }
+    EXPECT_EQ(shadow.entries[i2].worldFromModelMatrix, transform);
+    EXPECT_EQ(shadow.count, COUNT);
+
+    // after a reallocation, the entries that were never uploaded are always uploaded, and the
+    // ones known to match the UBO only grow from the start
+    shadow.resize(16);
+    scene->prepare({}, false);
+    uploaded = scene->updateUBOs({ 4, COUNT }, ubh, shadow);
+    EXPECT_EQ(uploaded.first, 4u);
+    EXPECT_EQ(uploaded.last, COUNT);
+    EXPECT_EQ(shadow.count, 0u);
+
+    uploaded = scene->updateUBOs({ 0, 4 }, ubh, shadow);
+    EXPECT_EQ(uploaded.first, 0u);
+    EXPECT_EQ(uploaded.last, 4u);
+    EXPECT_EQ(shadow.count, 4u);
+
+    uploaded = scene->updateUBOs(all, ubh, shadow);
+    EXPECT_EQ(uploaded.first, 4u);
+    EXPECT_EQ(uploaded.last, COUNT);
+    EXPECT_EQ(shadow.count, COUNT);
+
+    driver.destroyBufferObject(ubh);
+    for (Entity e : entities) {
+        engine->destroy(e);
+    }
+    engine->getEntityManager().destroy(COUNT, entities);
+    engine->destroy(scene);
+    Engine::destroy((Engine **)&engine);
+}
+
+TEST(FilamentTest, FrameStatisticsHistory) {
+    constexpr size_t HISTORY_SIZE = FrameStatisticsManager::HISTORY_SIZE;
+    FrameStatisticsManager manager;
+    EXPECT_EQ(manager.getFrameStatistics(0), nullptr);
+
+    // wraps around the ring buffer a few times
+    for (uint32_t frameId = 1; frameId <= HISTORY_SIZE * 2 + 3; frameId++) {
+        const size_t completed = std::min(size_t(frameId - 1), HISTORY_SIZE);
+
+        // the frame being recorded isn't part of the history
+        FrameStatisticsManager::FrameStatistics& stats = manager.beginFrame(frameId);
+        stats.prepare = float(frameId);
+        manager.addPass("pass", float(frameId));
+        EXPECT_EQ(manager.getFrameStatistics(completed), nullptr);
+        manager.endFrame();
+
+        // the history holds the last completed frames, most recent first
+        const size_t count = std::min(size_t(frameId), HISTORY_SIZE);
+        for (size_t history = 0; history < count; history++) {
+            const uint32_t expectedId = uint32_t(frameId - history);
+            auto const* s = manager.getFrameStatistics(history);
+            ASSERT_NE(s, nullptr);
+            EXPECT_EQ(s->frameId, expectedId);
+            EXPECT_EQ(s->prepare, float(expectedId));
+            // an entry is reset when it's reused
+            ASSERT_EQ(s->passCount, 1u);
+            EXPECT_EQ(s->passes[0].cpuTime, float(expectedId));
+        }
+        EXPECT_EQ(manager.getFrameStatistics(count), nullptr);
+    }
+}
+
+TEST(FilamentTest, FrameStatisticsLateGpuTime) {
+    constexpr size_t HISTORY_SIZE = FrameStatisticsManager::HISTORY_SIZE;
+    FrameStatisticsManager manager;
+
+    // GPU times are known a few frames later, after more frames have been recorded
+    for (uint32_t frameId = 1; frameId <= 5; frameId++) {
+        manager.beginFrame(frameId);
+        manager.endFrame();
+    }
+    manager.beginFrame(6);
+    manager.setGpuFrameTime(3, 3.5f);
+    manager.endFrame();
+
+    // frame 1 is the oldest frame in the history...
+    for (uint32_t frameId = 7; frameId <= HISTORY_SIZE; frameId++) {
+        manager.beginFrame(frameId);
+        manager.endFrame();
+    }
+    manager.setGpuFrameTime(1, 1.5f);
+    auto const* oldest = manager.getFrameStatistics(HISTORY_SIZE - 1);
+    ASSERT_NE(oldest, nullptr);
+    EXPECT_EQ(oldest->frameId, 1u);
+    EXPECT_EQ(oldest->gpuFrameTime, 1.5f);
+
+    // ...and isn't anymore, so its GPU time is dropped
+    manager.beginFrame(HISTORY_SIZE + 1);
+    manager.endFrame();
+    manager.setGpuFrameTime(1, 2.5f);
+
+    for (size_t history = 0; history < HISTORY_SIZE; history++) {
+        auto const* s = manager.getFrameStatistics(history);
+        ASSERT_NE(s, nullptr);
+        EXPECT_EQ(s->frameId, uint32_t(HISTORY_SIZE + 1 - history));
+        EXPECT_EQ(s->gpuFrameTime, s->frameId == 3 ? 3.5f : 0.0f);
+    }
+}
+
 TEST(FilamentTest, Bones) {
 
     struct Shader {
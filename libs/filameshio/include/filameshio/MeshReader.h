@@ -78,9 +78,19 @@ public:
     };
 
     struct Mesh {
+        static constexpr size_t MAX_LOD_COUNT = 4;
+
         utils::Entity renderable;
         filament::VertexBuffer* vertexBuffer = nullptr;
         filament::IndexBuffer* indexBuffer = nullptr;
+
+        /**
+         * One renderable per level of detail, from the most detailed to the least detailed. The
+         * first one is the same as renderable. All levels share the same vertex and index buffers,
+         * and the additional renderables must be destroyed by the client as well.
+         */
+        utils::Entity lods[MAX_LOD_COUNT];
+        uint32_t lodCount = 0;
     };
 
     /**
@@ -88,7 +98,9 @@ public:
      * can be used to provide named materials. If a material found in the filamesh
      * file cannot be matched to a material in the registry, a default material is
      * used instead. The default material can be overridden by adding a material
-     * named "DefaultMaterial" to the registry.
+     * named "DefaultMaterial" to the registry. The file contents are handed to the
+     * vertex and index buffers without intermediate copies, and are released once
+     * they have been consumed.
      */
     static Mesh loadMeshFromFile(filament::Engine* engine,
             const utils::Path& path,
@@ -25,7 +25,10 @@ using Box = filament::Box;
 
 static const char MAGICID[] { 'F', 'I', 'L', 'A', 'M', 'E', 'S', 'H' };
 
-static const uint32_t VERSION = 1;
+static const uint32_t VERSION = 2;
+
+// Maximum number of levels of detail, including the full-detail level.
+static const uint32_t MAX_LOD_COUNT = 4;
 
 enum IndexType : uint32_t {
     UI32 = 0,
@@ -36,6 +39,7 @@ enum Flags : uint32_t {
     INTERLEAVED         = 1 << 0,
     TEXCOORD_SNORM16    = 1 << 1,
     COMPRESSION         = 1 << 2,
+    LODS                = 1 << 3,
 };
 
 // Each of these fields specifies a number of bytes within the compressed data. This is ignored
@@ -19,7 +19,6 @@
 
 #include <filament/Box.h>
 #include <filament/Engine.h>
-#include <filament/Fence.h>
 #include <filament/IndexBuffer.h>
 #include <filament/Material.h>
 #include <filament/MaterialInstance.h>
@@ -32,10 +31,10 @@
 #include <utils/Log.h>
 #include <utils/Path.h>
 
-#include <string>
-#include <vector>
+#include <atomic>
 #include <map>
 #include <string>
+#include <vector>
 
 #include <fcntl.h>
 #if !defined(WIN32)
@@ -50,6 +49,8 @@ using namespace filament::math;
 
 #define DEFAULT_MATERIAL "DefaultMaterial"
 
+static_assert(MeshReader::Mesh::MAX_LOD_COUNT == MAX_LOD_COUNT, "LOD count mismatch");
+
 //------------------------------------------------------------------------------
 //-------------------------Begin Material Registry------------------------------
 //------------------------------------------------------------------------------
@@ -157,6 +158,27 @@ static size_t fileSize(int fd) {
     return filesize;
 }
 
+static uint32_t readUint32(const uint8_t* p) {
+    uint32_t value;
+    memcpy(&value, p, sizeof(uint32_t));
+    return value;
+}
+
+// The file contents are handed to the vertex and index buffers without copies, this keeps the
+// file alive until both buffers have been consumed.
+struct FileData {
+    void* data;
+    std::atomic<uint32_t> references;
+};
+
+static void releaseFileData(void*, size_t, void* user) {
+    FileData* file = (FileData*) user;
+    if (file->references.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        free(file->data);
+        delete file;
+    }
+}
+
 namespace filamesh {
 
 MeshReader::Mesh MeshReader::loadMeshFromFile(filament::Engine* engine, const utils::Path& path,
@@ -165,21 +187,23 @@ MeshReader::Mesh MeshReader::loadMeshFromFile(filament::Engine* engine, const ut
     Mesh mesh;
 
     int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return mesh;
+    }
 
     size_t size = fileSize(fd);
     char* data = (char*) malloc(size);
-    read(fd, data, size);
-
-    if (data) {
-        char *p = data;
-        char *magic = p;
-        p += sizeof(MAGICID);
 
-        if (!strncmp(MAGICID, magic, 8)) {
-            mesh = loadMeshFromBuffer(engine, data, nullptr, nullptr, materials);
+    if (data && size_t(read(fd, data, size)) == size && size >= sizeof(MAGICID) &&
+            !strncmp(MAGICID, data, sizeof(MAGICID))) {
+        // On success, loadMeshFromBuffer releases the vertex data and the index data separately.
+        FileData* file = new FileData{ data, { 2 } };
+        mesh = loadMeshFromBuffer(engine, data, releaseFileData, file, materials);
+        if (!mesh.renderable) {
+            free(data);
+            delete file;
         }
-
-        Fence::waitAndDestroy(engine->createFence());
+    } else {
         free(data);
     }
     close(fd);
@@ -205,113 +229,87 @@ MeshReader::Mesh MeshReader::loadMeshFromBuffer(filament::Engine* engine,
     }
     p += 8;
 
-    Header* header = (Header*) p;
+    // The header and the parts are copied out, because the buffer can be released as soon as the
+    // vertex and index data have been handed to the engine (or decoded), before the renderables
+    // are built.
+    Header header;
+    memcpy(&header, p, sizeof(Header));
     p += sizeof(Header);
 
     uint8_t const* vertexData = p;
-    p += header->vertexSize;
+    p += header.vertexSize;
 
     uint8_t const* indices = p;
-    p += header->indexSize;
+    p += header.indexSize;
 
-    Part* parts = (Part*) p;
-    p += header->parts * sizeof(Part);
+    std::vector<Part> parts(header.parts);
+    memcpy(parts.data(), p, parts.size() * sizeof(Part));
+    p += header.parts * sizeof(Part);
 
-    uint32_t materialCount = (uint32_t) *p;
+    uint32_t materialCount = readUint32(p);
     p += sizeof(uint32_t);
 
     std::vector<std::string> partsMaterial(materialCount);
     for (size_t i = 0; i < materialCount; i++) {
-        uint32_t nameLength = (uint32_t) *p;
+        uint32_t nameLength = readUint32(p);
         p += sizeof(uint32_t);
         partsMaterial[i] = (const char*) p;
         p += nameLength + 1; // null terminated
     }
 
-    Mesh mesh;
-
-    mesh.indexBuffer = IndexBuffer::Builder()
-            .indexCount(header->indexCount)
-            .bufferType(header->indexType == UI16 ? IndexBuffer::IndexType::USHORT
-                    : IndexBuffer::IndexType::UINT)
-            .build(*engine);
+    // The parts of the levels of detail after the first follow the materials.
+    uint32_t lodCount = 1;
+    std::vector<Part> lodParts;
+    if (header.flags & LODS) {
+        lodCount = readUint32(p);
+        p += sizeof(uint32_t);
+        if (lodCount == 0 || lodCount > MAX_LOD_COUNT) {
+            utils::slog.e << "Invalid number of levels of detail (" << lodCount << ")."
+                    << utils::io::endl;
+            return {};
+        }
+        lodParts.resize((lodCount - 1) * header.parts);
+        memcpy(lodParts.data(), p, lodParts.size() * sizeof(Part));
+    }
 
-    // If the index buffer is compressed, then decode the indices into a temporary buffer.
-    // The user callback can be called immediately afterwards because the source data does not get
-    // passed to the GPU.
-    const size_t indicesSize = header->indexSize;
-    if (header->flags & COMPRESSION) {
-        size_t indexSize = header->indexType == UI16 ? sizeof(uint16_t) : sizeof(uint32_t);
-        size_t indexCount = header->indexCount;
-        size_t uncompressedSize = indexSize * indexCount;
-        void* uncompressed = malloc(uncompressedSize);
-        int err = meshopt_decodeIndexBuffer(uncompressed, indexCount, indexSize, indices,
+    constexpr uint32_t uintmax = std::numeric_limits<uint32_t>::max();
+    const bool hasUV1 = header.offsetUV1 != uintmax && header.strideUV1 != uintmax;
+
+    // If the mesh is compressed, then decode the indices and vertices into buffers that are handed
+    // to the engine as is. Decoding happens before creating any object so that a failure leaves
+    // the source data untouched.
+    const size_t indicesSize = header.indexSize;
+    const size_t verticesSize = header.vertexSize;
+    void* decodedIndices = nullptr;
+    void* decodedVertices = nullptr;
+    size_t decodedIndicesSize = 0;
+    size_t decodedVerticesSize = 0;
+    if (header.flags & COMPRESSION) {
+        size_t indexSize = header.indexType == UI16 ? sizeof(uint16_t) : sizeof(uint32_t);
+        size_t indexCount = header.indexCount;
+        decodedIndicesSize = indexSize * indexCount;
+        decodedIndices = malloc(decodedIndicesSize);
+        int err = meshopt_decodeIndexBuffer(decodedIndices, indexCount, indexSize, indices,
                 indicesSize);
         if (err) {
             utils::slog.e << "Unable to decode index buffer." << utils::io::endl;
+            free(decodedIndices);
             return {};
         }
-        if (destructor) {
-            destructor((void*) indices, indicesSize, user);
-        }
-        auto freecb = [](void* buffer, size_t size, void* user) { free(buffer); };
-        mesh.indexBuffer->setBuffer(*engine,
-                IndexBuffer::BufferDescriptor(uncompressed, uncompressedSize, freecb, nullptr));
-    } else {
-        mesh.indexBuffer->setBuffer(*engine,
-                IndexBuffer::BufferDescriptor(indices, indicesSize, destructor, user));
-    }
 
-    VertexBuffer::Builder vbb;
-    vbb.vertexCount(header->vertexCount)
-            .bufferCount(1)
-            .normalized(VertexAttribute::COLOR)
-            .normalized(VertexAttribute::TANGENTS);
-
-    VertexBuffer::AttributeType uvtype = (header->flags & TEXCOORD_SNORM16) ?
-            VertexBuffer::AttributeType::SHORT2 : VertexBuffer::AttributeType::HALF2;
-
-    vbb
-            .attribute(VertexAttribute::POSITION, 0, VertexBuffer::AttributeType::HALF4,
-                        header->offsetPosition, uint8_t(header->stridePosition))
-            .attribute(VertexAttribute::TANGENTS, 0, VertexBuffer::AttributeType::SHORT4,
-                        header->offsetTangents, uint8_t(header->strideTangents))
-            .attribute(VertexAttribute::COLOR, 0, VertexBuffer::AttributeType::UBYTE4,
-                        header->offsetColor, uint8_t(header->strideColor))
-            .attribute(VertexAttribute::UV0, 0, uvtype,
-                        header->offsetUV0, uint8_t(header->strideUV0))
-            .normalized(VertexAttribute::UV0, header->flags & TEXCOORD_SNORM16);
-
-    constexpr uint32_t uintmax = std::numeric_limits<uint32_t>::max();
-    const bool hasUV1 = header->offsetUV1 != uintmax && header->strideUV1 != uintmax;
-
-    if (hasUV1) {
-        vbb
-            .attribute(VertexAttribute::UV1, 0, VertexBuffer::AttributeType::HALF2,
-                    header->offsetUV1, uint8_t(header->strideUV1))
-            .normalized(VertexAttribute::UV1);
-    }
-
-    mesh.vertexBuffer = vbb.build(*engine);
-
-    // If the vertex buffer is compressed, then decode the vertices into a temporary buffer.
-    // The user callback can be called immediately afterwards because the source data does not get
-    // passed to the GPU.
-    const size_t verticesSize = header->vertexSize;
-    if (header->flags & COMPRESSION) {
         size_t vertexSize = sizeof(half4) + sizeof(short4) + sizeof(ubyte4) + sizeof(ushort2) +
                 (hasUV1 ? sizeof(ushort2) : 0);
-        size_t vertexCount = header->vertexCount;
-        size_t uncompressedSize = vertexSize * vertexCount;
-        void* uncompressed = malloc(uncompressedSize);
+        size_t vertexCount = header.vertexCount;
+        decodedVerticesSize = vertexSize * vertexCount;
+        decodedVertices = malloc(decodedVerticesSize);
         const uint8_t* srcdata = vertexData + sizeof(CompressionHeader);
-        int err = 0;
-        if (header->flags & INTERLEAVED) {
-            err |= meshopt_decodeVertexBuffer(uncompressed, vertexCount, vertexSize, srcdata,
-                    vertexSize);
+        err = 0;
+        if (header.flags & INTERLEAVED) {
+            err |= meshopt_decodeVertexBuffer(decodedVertices, vertexCount, vertexSize, srcdata,
+                    verticesSize - sizeof(CompressionHeader));
         } else {
             const CompressionHeader* sizes = (CompressionHeader*) vertexData;
-            uint8_t* dstdata = (uint8_t*) uncompressed;
+            uint8_t* dstdata = (uint8_t*) decodedVertices;
             auto decode = meshopt_decodeVertexBuffer;
 
             err |= decode(dstdata, vertexCount, sizeof(half4), srcdata, sizes->positions);
@@ -336,50 +334,115 @@ MeshReader::Mesh MeshReader::loadMeshFromBuffer(filament::Engine* engine,
         }
         if (err) {
             utils::slog.e << "Unable to decode vertex buffer." << utils::io::endl;
+            free(decodedIndices);
+            free(decodedVertices);
             return {};
         }
+    }
+
+    Mesh mesh;
+
+    mesh.indexBuffer = IndexBuffer::Builder()
+            .indexCount(header.indexCount)
+            .bufferType(header.indexType == UI16 ? IndexBuffer::IndexType::USHORT
+                    : IndexBuffer::IndexType::UINT)
+            .build(*engine);
+
+    // The user callback can be called immediately after decoding because the source data does not
+    // get passed to the GPU.
+    auto freecb = [](void* buffer, size_t size, void* user) { free(buffer); };
+    if (decodedIndices) {
+        if (destructor) {
+            destructor((void*) indices, indicesSize, user);
+        }
+        mesh.indexBuffer->setBuffer(*engine,
+                IndexBuffer::BufferDescriptor(decodedIndices, decodedIndicesSize, freecb, nullptr));
+    } else {
+        mesh.indexBuffer->setBuffer(*engine,
+                IndexBuffer::BufferDescriptor(indices, indicesSize, destructor, user));
+    }
+
+    VertexBuffer::Builder vbb;
+    vbb.vertexCount(header.vertexCount)
+            .bufferCount(1)
+            .normalized(VertexAttribute::COLOR)
+            .normalized(VertexAttribute::TANGENTS);
+
+    VertexBuffer::AttributeType uvtype = (header.flags & TEXCOORD_SNORM16) ?
+            VertexBuffer::AttributeType::SHORT2 : VertexBuffer::AttributeType::HALF2;
+
+    vbb
+            .attribute(VertexAttribute::POSITION, 0, VertexBuffer::AttributeType::HALF4,
+                        header.offsetPosition, uint8_t(header.stridePosition))
+            .attribute(VertexAttribute::TANGENTS, 0, VertexBuffer::AttributeType::SHORT4,
+                        header.offsetTangents, uint8_t(header.strideTangents))
+            .attribute(VertexAttribute::COLOR, 0, VertexBuffer::AttributeType::UBYTE4,
+                        header.offsetColor, uint8_t(header.strideColor))
+            .attribute(VertexAttribute::UV0, 0, uvtype,
+                        header.offsetUV0, uint8_t(header.strideUV0))
+            .normalized(VertexAttribute::UV0, header.flags & TEXCOORD_SNORM16);
+
+    if (hasUV1) {
+        vbb
+            .attribute(VertexAttribute::UV1, 0, VertexBuffer::AttributeType::HALF2,
+                    header.offsetUV1, uint8_t(header.strideUV1))
+            .normalized(VertexAttribute::UV1);
+    }
+
+    mesh.vertexBuffer = vbb.build(*engine);
+
+    if (decodedVertices) {
         if (destructor) {
             destructor((void*) vertexData, verticesSize, user);
         }
-        auto freecb = [](void* buffer, size_t size, void* user) { free(buffer); };
         mesh.vertexBuffer->setBufferAt(*engine, 0,
-                IndexBuffer::BufferDescriptor(uncompressed, uncompressedSize, freecb, nullptr));
+                VertexBuffer::BufferDescriptor(decodedVertices, decodedVerticesSize, freecb,
+                        nullptr));
     } else {
         mesh.vertexBuffer->setBufferAt(*engine, 0,
                 VertexBuffer::BufferDescriptor(vertexData, verticesSize, destructor, user));
     }
 
-    mesh.renderable = utils::EntityManager::get().create();
-
-    RenderableManager::Builder builder(header->parts);
-    builder.boundingBox(header->aabb);
-
+    // Each level of detail is a separate renderable sharing the vertex and index buffers.
     const auto defaultmi = materials.getMaterialInstance(utils::CString(DEFAULT_MATERIAL));
-    for (size_t i = 0; i < header->parts; i++) {
-        builder.geometry(i, RenderableManager::PrimitiveType::TRIANGLES,
-                mesh.vertexBuffer, mesh.indexBuffer, parts[i].offset,
-                parts[i].minIndex, parts[i].maxIndex, parts[i].indexCount);
-
-        // It may happen that there are more parts than materials
-        // therefore we have to use Part::material instead of i.
-        uint32_t materialIndex = parts[i].material;
-        if (materialIndex >= partsMaterial.size()) {
-            utils::slog.e << "Material index (" << materialIndex << ") of mesh part ("
-                    << i << ") is out of bounds (" << partsMaterial.size() << ")" << utils::io::endl;
-            continue;
-        }
+    for (uint32_t lod = 0; lod < lodCount; lod++) {
+        const Part* lodPart =
+                lod == 0 ? parts.data() : lodParts.data() + (lod - 1) * header.parts;
+
+        RenderableManager::Builder builder(header.parts);
+        builder.boundingBox(header.aabb);
+
+        for (size_t i = 0; i < header.parts; i++) {
+            builder.geometry(i, RenderableManager::PrimitiveType::TRIANGLES,
+                    mesh.vertexBuffer, mesh.indexBuffer, lodPart[i].offset,
+                    lodPart[i].minIndex, lodPart[i].maxIndex, lodPart[i].indexCount);
+
+            // It may happen that there are more parts than materials
+            // therefore we have to use Part::material instead of i.
+            uint32_t materialIndex = lodPart[i].material;
+            if (materialIndex >= partsMaterial.size()) {
+                utils::slog.e << "Material index (" << materialIndex << ") of mesh part ("
+                        << i << ") is out of bounds (" << partsMaterial.size() << ")"
+                        << utils::io::endl;
+                continue;
+            }
 
-        const utils::CString materialName(
-                partsMaterial[materialIndex].c_str(), partsMaterial[materialIndex].size());
-        const auto mat = materials.getMaterialInstance(materialName);
-        if (mat == nullptr) {
-            builder.material(i, defaultmi);
-            materials.registerMaterialInstance(materialName, defaultmi);
-        } else {
-            builder.material(i, mat);
+            const utils::CString materialName(
+                    partsMaterial[materialIndex].c_str(), partsMaterial[materialIndex].size());
+            const auto mat = materials.getMaterialInstance(materialName);
+            if (mat == nullptr) {
+                builder.material(i, defaultmi);
+                materials.registerMaterialInstance(materialName, defaultmi);
+            } else {
+                builder.material(i, mat);
+            }
         }
+
+        mesh.lods[lod] = utils::EntityManager::get().create();
+        builder.build(*engine, mesh.lods[lod]);
     }
-    builder.build(*engine, mesh.renderable);
+    mesh.renderable = mesh.lods[0];
+    mesh.lodCount = lodCount;
 
     return mesh;
 }
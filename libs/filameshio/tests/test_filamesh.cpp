@@ -27,9 +27,17 @@
 #include <math/quat.h>
 #include <math/vec3.h>
 
+#include <utils/Path.h>
+
 #include <gtest/gtest.h>
 
+#include <meshoptimizer.h>
+
+#include <fstream>
 #include <sstream>
+#include <vector>
+
+#include <stdio.h>
 
 using namespace filament;
 using namespace filamesh;
@@ -216,6 +224,148 @@ TEST_F(FilameshTest, Interleaved) {
     engine->destroy(mi);
 }
 
+TEST_F(FilameshTest, LevelsOfDetail) {
+    // Serialize a single-triangle mesh with a second level of detail that uses its own indices.
+    static const uint16_t lodIndices[] = { 0, 1, 2, 2, 1, 0 };
+    const Header header {
+        .version = VERSION,
+        .parts = 1,
+        .aabb = unitBox,
+        .flags = LODS,
+        .offsetTangents = sizeof(positions),
+        .offsetColor = sizeof(positions) + sizeof(tangents),
+        .offsetUV0 = sizeof(positions) + sizeof(tangents) + sizeof(colors),
+        .strideUV1 = maxint,
+        .vertexCount = vertexCount,
+        .vertexSize = sizeof(positions) + sizeof(tangents) + sizeof(colors) + sizeof(uv0),
+        .indexType = IndexType::UI16,
+        .indexCount = 6,
+        .indexSize = sizeof(lodIndices)
+    };
+    const uint32_t nmats = 1;
+    const string matname = "DefaultMaterial";
+    const uint32_t matnamelength = matname.size();
+    const uint32_t nlods = 2;
+    Part lodParts[1] = { parts[0] };
+    lodParts[0].offset = 3;
+
+    stringstream stream(ios_base::out);
+    write(stream, MAGICID, sizeof(MAGICID));
+    write(stream, &header, sizeof(header));
+    write(stream, positions, sizeof(positions));
+    write(stream, tangents, sizeof(tangents));
+    write(stream, colors, sizeof(colors));
+    write(stream, uv0, sizeof(uv0));
+    write(stream, lodIndices, sizeof(lodIndices));
+    write(stream, parts, sizeof(parts));
+    write(stream, &nmats, sizeof(nmats));
+    write(stream, &matnamelength, sizeof(matnamelength));
+    write(stream, matname.c_str(), matnamelength + 1);
+    write(stream, &nlods, sizeof(nlods));
+    write(stream, lodParts, sizeof(lodParts));
+
+    MaterialInstance* mi = engine->getDefaultMaterial()->createInstance();
+    const string buffer = stream.str();
+    auto mesh = MeshReader::loadMeshFromBuffer(engine, buffer.data(), nullptr, nullptr, mi);
+    ASSERT_EQ(mesh.lodCount, 2);
+    EXPECT_EQ(mesh.lods[0], mesh.renderable);
+
+    auto& rm = engine->getRenderableManager();
+    for (uint32_t lod = 0; lod < mesh.lodCount; lod++) {
+        auto inst = rm.getInstance(mesh.lods[lod]);
+        EXPECT_EQ(rm.getPrimitiveCount(inst), 1);
+        engine->destroy(mesh.lods[lod]);
+    }
+    engine->destroy(mi);
+}
+
+TEST_F(FilameshTest, CompressedFileWithLevelsOfDetail) {
+    // Write a compressed single-triangle mesh with a second level of detail to a file, so that
+    // loadMeshFromFile() hands the file's buffer to the engine and releases it after decoding.
+    static const uint16_t lodIndices[] = { 0, 1, 2, 2, 1, 0 };
+    CompressionHeader cheader{};
+    std::vector<uint8_t> compressedVertices(
+            meshopt_encodeVertexBufferBound(vertexCount, sizeof(half4)) * 4);
+    uint8_t* cptr = compressedVertices.data();
+    uint8_t* const cend = compressedVertices.data() + compressedVertices.size();
+    cheader.positions = meshopt_encodeVertexBuffer(cptr, cend - cptr, positions, vertexCount,
+            sizeof(half4));
+    cptr += cheader.positions;
+    cheader.tangents = meshopt_encodeVertexBuffer(cptr, cend - cptr, tangents, vertexCount,
+            sizeof(short4));
+    cptr += cheader.tangents;
+    cheader.colors = meshopt_encodeVertexBuffer(cptr, cend - cptr, colors, vertexCount,
+            sizeof(ubyte4));
+    cptr += cheader.colors;
+    cheader.uv0 = meshopt_encodeVertexBuffer(cptr, cend - cptr, uv0, vertexCount,
+            sizeof(half2));
+    cptr += cheader.uv0;
+    compressedVertices.resize(cptr - compressedVertices.data());
+
+    std::vector<uint8_t> compressedIndices(meshopt_encodeIndexBufferBound(6, vertexCount));
+    compressedIndices.resize(meshopt_encodeIndexBuffer(compressedIndices.data(),
+            compressedIndices.size(), lodIndices, 6));
+    ASSERT_GT(compressedIndices.size(), 0);
+
+    const Header header {
+        .version = VERSION,
+        .parts = 1,
+        .aabb = unitBox,
+        .flags = COMPRESSION | LODS,
+        .offsetTangents = sizeof(positions),
+        .offsetColor = sizeof(positions) + sizeof(tangents),
+        .offsetUV0 = sizeof(positions) + sizeof(tangents) + sizeof(colors),
+        .offsetUV1 = maxint,
+        .strideUV1 = maxint,
+        .vertexCount = vertexCount,
+        .vertexSize = uint32_t(sizeof(cheader) + compressedVertices.size()),
+        .indexType = IndexType::UI16,
+        .indexCount = 6,
+        .indexSize = uint32_t(compressedIndices.size())
+    };
+    const uint32_t nmats = 1;
+    const string matname = "DefaultMaterial";
+    const uint32_t matnamelength = matname.size();
+    const uint32_t nlods = 2;
+    Part lodParts[1] = { parts[0] };
+    lodParts[0].offset = 3;
+
+    const utils::Path path = utils::Path::getTemporaryDirectory() + "test_filamesh_lods.filamesh";
+    {
+        ofstream out(path.c_str(), ios::binary);
+        write(out, MAGICID, sizeof(MAGICID));
+        write(out, &header, sizeof(header));
+        write(out, &cheader, sizeof(cheader));
+        write(out, compressedVertices.data(), compressedVertices.size());
+        write(out, compressedIndices.data(), compressedIndices.size());
+        write(out, parts, sizeof(parts));
+        write(out, &nmats, sizeof(nmats));
+        write(out, &matnamelength, sizeof(matnamelength));
+        write(out, matname.c_str(), matnamelength + 1);
+        write(out, &nlods, sizeof(nlods));
+        write(out, lodParts, sizeof(lodParts));
+        ASSERT_TRUE(out.good());
+    }
+
+    MaterialInstance* mi = engine->getDefaultMaterial()->createInstance();
+    MeshReader::MaterialRegistry registry;
+    registry.registerMaterialInstance(utils::CString("DefaultMaterial"), mi);
+    auto mesh = MeshReader::loadMeshFromFile(engine, path, registry);
+    remove(path.c_str());
+    ASSERT_TRUE(mesh.renderable);
+    ASSERT_EQ(mesh.lodCount, 2);
+
+    auto& rm = engine->getRenderableManager();
+    for (uint32_t lod = 0; lod < mesh.lodCount; lod++) {
+        auto inst = rm.getInstance(mesh.lods[lod]);
+        EXPECT_EQ(rm.getPrimitiveCount(inst), 1);
+        engine->destroy(mesh.lods[lod]);
+    }
+    engine->destroy(mesh.vertexBuffer);
+    engine->destroy(mesh.indexBuffer);
+    engine->destroy(mi);
+}
+
 int main(int argc, char** argv) {
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
@@ -0,0 +1,169 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TNT_GEOMETRY_MESHWELDER_H
+#define TNT_GEOMETRY_MESHWELDER_H
+
+#include <math/vec3.h>
+
+#include <utils/compiler.h>
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace filament {
+namespace geometry {
+
+struct MeshWelderBuilderImpl;
+struct MeshWelderImpl;
+
+/**
+ * The mesh welder merges the vertices of an indexed triangle mesh whose attributes are all
+ * identical, and drops the vertices that are not referenced by any triangle. Optionally, it also
+ * reorders triangles and vertices so that the mesh renders faster.
+ *
+ * Clients provide pointers into their own data, which is synchronously consumed during build().
+ * The welder does not produce vertex data, instead remap() copies each attribute of the input
+ * vertices to the welded vertices.
+ *
+ * Usage Example:
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * using filament::geometry::MeshWelder;
+ *
+ * MeshWelder* welder = MeshWelder::Builder()
+ *     .vertexCount(vertexCount)
+ *     .positions(positions)
+ *     .attribute(normals, sizeof(float3))
+ *     .attribute(uvs, sizeof(float2))
+ *     .triangleCount(triangleCount)
+ *     .triangles(triangles)
+ *     .optimizeVertexCache(true)
+ *     .build();
+ *
+ * std::vector<float3> weldedPositions(welder->getVertexCount());
+ * welder->remap(weldedPositions.data(), positions, sizeof(float3));
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ */
+class UTILS_PUBLIC MeshWelder {
+public:
+
+    //! Maximum number of attributes, including positions.
+    static constexpr size_t MAX_ATTRIBUTE_COUNT = 8;
+
+    /**
+     * The Builder is used to construct an immutable mesh welder.
+     */
+    class Builder {
+    public:
+        Builder() noexcept;
+        ~Builder() noexcept;
+        Builder(Builder&& that) noexcept;
+        Builder& operator=(Builder&& that) noexcept;
+
+        /**
+         * This attribute is required.
+         */
+        Builder& vertexCount(size_t vertexCount) noexcept;
+
+        /**
+         * Adds an attribute of "size" bytes per vertex. Vertices are merged only if all their
+         * attributes are bitwise identical.
+         */
+        Builder& attribute(const void* data, size_t size, size_t stride = 0) noexcept;
+
+        /**
+         * Positions are an attribute like the others, but are also required to reduce overdraw.
+         */
+        Builder& positions(const filament::math::float3*, size_t stride = 0) noexcept;
+
+        Builder& triangleCount(size_t triangleCount) noexcept;
+        Builder& triangles(const filament::math::uint3*) noexcept;
+        Builder& triangles(const filament::math::ushort3*) noexcept;
+
+        /**
+         * Reorders triangles to reduce the number of vertex shader invocations, then reorders
+         * vertices in the order they are first referenced to improve fetch locality.
+         * Disabled by default.
+         */
+        Builder& optimizeVertexCache(bool enabled) noexcept;
+
+        /**
+         * Additionally reorders clusters of triangles to reduce overdraw. The threshold is how much
+         * the vertex cache efficiency can degrade, e.g. 1.05 allows a 5% degradation. This
+         * requires positions and vertex cache optimization. 0 disables it, which is the default.
+         */
+        Builder& optimizeOverdraw(float threshold) noexcept;
+
+        /**
+         * Welds the mesh or returns null if the submitted data is incomplete.
+         */
+        MeshWelder* build();
+
+    private:
+        MeshWelderBuilderImpl* mImpl;
+        Builder(const Builder&) = delete;
+        Builder& operator=(const Builder&) = delete;
+    };
+
+    ~MeshWelder() noexcept;
+    MeshWelder(MeshWelder&& that) noexcept;
+    MeshWelder& operator=(MeshWelder&& that) noexcept;
+
+    /**
+     * Returns the number of vertices after welding.
+     */
+    size_t getVertexCount() const noexcept;
+
+    /**
+     * Returns the triangle count, which is the same as the input triangle count.
+     */
+    size_t getTriangleCount() const noexcept;
+
+    /**
+     * Writes the triangles referencing the welded vertices. The 16-bit version requires the
+     * welded vertex count to be 65536 or less.
+     * @{
+     */
+    void getTriangles(filament::math::uint3* out) const noexcept;
+    void getTriangles(filament::math::ushort3* out) const noexcept;
+    /**
+     * @}
+     */
+
+    /**
+     * Returns, for each welded vertex, the index of the input vertex it comes from.
+     */
+    const uint32_t* getSourceVertices() const noexcept;
+
+    /**
+     * Copies an attribute of "size" bytes per vertex from the input vertices to the welded
+     * vertices. Strides are in bytes, 0 means tightly packed.
+     */
+    void remap(void* out, const void* in, size_t size,
+            size_t inStride = 0, size_t outStride = 0) const noexcept;
+
+private:
+    MeshWelder(MeshWelderImpl*) noexcept;
+    MeshWelder(const MeshWelder&) = delete;
+    MeshWelder& operator=(const MeshWelder&) = delete;
+    MeshWelderImpl* mImpl;
+    friend struct MeshWelderBuilderImpl;
+};
+
+} // namespace geometry
+} // namespace filament
+
+#endif // TNT_GEOMETRY_MESHWELDER_H
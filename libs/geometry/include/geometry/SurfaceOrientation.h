@@ -23,6 +23,10 @@
 
 #include <utils/compiler.h>
 
+namespace utils {
+class JobSystem;
+} // namespace utils
+
 namespace filament {
 
 /**
@@ -61,7 +65,8 @@ public:
      *
      * Currently, mikktspace is not supported because it requires re-indexing the mesh. Instead
      * we use the method described by Eric Lengyel in "Foundations of Game Engine Development"
-     * (Volume 2, Chapter 7).
+     * (Volume 2, Chapter 7). Welding the mesh first with MeshWelder produces smoother tangents
+     * across duplicated vertices.
      */
     class Builder {
     public:
@@ -89,6 +94,12 @@ public:
          */
         SurfaceOrientation* build();
 
+        /**
+         * Same as build(), but spreads the work over the given JobSystem. The results are
+         * identical. The calling thread must be known to the JobSystem, e.g. via adopt().
+         */
+        SurfaceOrientation* build(utils::JobSystem& js);
+
     private:
         OrientationBuilderImpl* mImpl;
         Builder(const Builder&) = delete;
@@ -0,0 +1,307 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <geometry/MeshWelder.h>
+
+#include <utils/Panic.h>
+#include <utils/debug.h>
+
+#include <meshoptimizer.h>
+
+#include <string.h>
+
+#include <vector>
+
+namespace filament {
+namespace geometry {
+
+using namespace filament::math;
+using std::vector;
+using Builder = MeshWelder::Builder;
+
+struct Attribute {
+    const uint8_t* data;
+    size_t size;
+    size_t stride;
+};
+
+struct MeshWelderBuilderImpl {
+    size_t vertexCount = 0;
+    size_t triangleCount = 0;
+    const uint3* triangles32 = nullptr;
+    const ushort3* triangles16 = nullptr;
+    const float3* positions = nullptr;
+    size_t positionStride = 0;
+    Attribute attributes[MeshWelder::MAX_ATTRIBUTE_COUNT];
+    size_t attributeCount = 0;
+    bool vertexCache = false;
+    float overdrawThreshold = 0.0f;
+    MeshWelder* weld();
+};
+
+struct MeshWelderImpl {
+    vector<uint32_t> indices;
+    vector<uint32_t> sources;
+};
+
+Builder::Builder() noexcept : mImpl(new MeshWelderBuilderImpl) {}
+
+Builder::~Builder() noexcept { delete mImpl; }
+
+Builder::Builder(Builder&& that) noexcept {
+    std::swap(mImpl, that.mImpl);
+}
+
+Builder& Builder::operator=(Builder&& that) noexcept {
+    std::swap(mImpl, that.mImpl);
+    return *this;
+}
+
+Builder& Builder::vertexCount(size_t vertexCount) noexcept {
+    mImpl->vertexCount = vertexCount;
+    return *this;
+}
+
+Builder& Builder::attribute(const void* data, size_t size, size_t stride) noexcept {
+    if (!ASSERT_PRECONDITION_NON_FATAL(mImpl->attributeCount < MeshWelder::MAX_ATTRIBUTE_COUNT,
+            "Too many attributes.")) {
+        return *this;
+    }
+    mImpl->attributes[mImpl->attributeCount++] = { (const uint8_t*) data, size,
+            stride ? stride : size };
+    return *this;
+}
+
+Builder& Builder::positions(const float3* positions, size_t stride) noexcept {
+    mImpl->positions = positions;
+    mImpl->positionStride = stride ? stride : sizeof(float3);
+    return attribute(positions, sizeof(float3), stride);
+}
+
+Builder& Builder::triangleCount(size_t triangleCount) noexcept {
+    mImpl->triangleCount = triangleCount;
+    return *this;
+}
+
+Builder& Builder::triangles(const uint3* triangles) noexcept {
+    mImpl->triangles32 = triangles;
+    return *this;
+}
+
+Builder& Builder::triangles(const ushort3* triangles) noexcept {
+    mImpl->triangles16 = triangles;
+    return *this;
+}
+
+Builder& Builder::optimizeVertexCache(bool enabled) noexcept {
+    mImpl->vertexCache = enabled;
+    return *this;
+}
+
+Builder& Builder::optimizeOverdraw(float threshold) noexcept {
+    mImpl->overdrawThreshold = threshold;
+    return *this;
+}
+
+MeshWelder* Builder::build() {
+    if (!ASSERT_PRECONDITION_NON_FATAL(mImpl->vertexCount > 0, "Vertex count must be non-zero.")) {
+        return nullptr;
+    }
+    if (!ASSERT_PRECONDITION_NON_FATAL(mImpl->attributeCount > 0,
+            "At least one attribute is required.")) {
+        return nullptr;
+    }
+    if (!ASSERT_PRECONDITION_NON_FATAL(mImpl->triangles16 || mImpl->triangles32,
+            "Triangles are required.")) {
+        return nullptr;
+    }
+    if (!ASSERT_PRECONDITION_NON_FATAL(!mImpl->triangles16 || !mImpl->triangles32,
+            "Choose 16 or 32-bit indices, not both.")) {
+        return nullptr;
+    }
+    if (!ASSERT_PRECONDITION_NON_FATAL(mImpl->triangleCount > 0, "Triangle count is required.")) {
+        return nullptr;
+    }
+    if (mImpl->overdrawThreshold > 0.0f) {
+        if (!ASSERT_PRECONDITION_NON_FATAL(mImpl->positions && mImpl->vertexCache,
+                "Overdraw optimization requires positions and vertex cache optimization.")) {
+            return nullptr;
+        }
+    }
+    return mImpl->weld();
+}
+
+MeshWelder* MeshWelderBuilderImpl::weld() {
+    const size_t indexCount = triangleCount * 3;
+    vector<uint32_t> indices(indexCount);
+    if (triangles16) {
+        const uint16_t* in = &triangles16[0].x;
+        std::copy(in, in + indexCount, indices.begin());
+    } else {
+        const uint32_t* in = &triangles32[0].x;
+        std::copy(in, in + indexCount, indices.begin());
+    }
+
+    const size_t vertexSize = [this]() {
+        size_t size = 0;
+        for (size_t a = 0; a < attributeCount; ++a) {
+            size += attributes[a].size;
+        }
+        return size;
+    }();
+
+    // Gathers all attributes of the given vertex into a contiguous key.
+    auto gather = [this](uint8_t* key, uint32_t vertex) {
+        for (size_t a = 0; a < attributeCount; ++a) {
+            const Attribute& attrib = attributes[a];
+            memcpy(key, attrib.data + vertex * attrib.stride, attrib.size);
+            key += attrib.size;
+        }
+    };
+
+    // FNV-1a, which is fast enough for the short keys we deal with here.
+    auto hash = [vertexSize](const uint8_t* key) {
+        uint32_t h = 2166136261u;
+        for (size_t i = 0; i < vertexSize; ++i) {
+            h = (h ^ key[i]) * 16777619u;
+        }
+        return h;
+    };
+
+    // Only referenced vertices are welded, the others are dropped.
+    constexpr uint32_t UNUSED = ~0u;
+    vector<uint32_t> remap(vertexCount, UNUSED);
+    for (uint32_t index : indices) {
+        ASSERT_PRECONDITION(index < vertexCount, "Index out of range.");
+        remap[index] = 0;
+    }
+
+    // Open addressing hash table of output vertices, the keys of which are stored contiguously.
+    size_t tableSize = 1;
+    while (tableSize < vertexCount * 2) {
+        tableSize *= 2;
+    }
+    vector<uint32_t> table(tableSize, UNUSED);
+    vector<uint8_t> keys;
+    vector<uint32_t> sources;
+    keys.reserve(vertexCount * vertexSize);
+    sources.reserve(vertexCount);
+
+    for (uint32_t vertex = 0; vertex < vertexCount; ++vertex) {
+        if (remap[vertex] == UNUSED) {
+            continue;
+        }
+        const uint32_t welded = (uint32_t) sources.size();
+        keys.resize(keys.size() + vertexSize);
+        uint8_t* key = keys.data() + welded * vertexSize;
+        gather(key, vertex);
+        size_t slot = hash(key) & (tableSize - 1);
+        while (table[slot] != UNUSED &&
+                memcmp(keys.data() + table[slot] * vertexSize, key, vertexSize) != 0) {
+            slot = (slot + 1) & (tableSize - 1);
+        }
+        if (table[slot] == UNUSED) {
+            table[slot] = welded;
+            sources.push_back(vertex);
+            remap[vertex] = welded;
+        } else {
+            keys.resize(keys.size() - vertexSize);
+            remap[vertex] = table[slot];
+        }
+    }
+
+    for (uint32_t& index : indices) {
+        index = remap[index];
+    }
+
+    if (vertexCache) {
+        const size_t weldedCount = sources.size();
+        meshopt_optimizeVertexCache(indices.data(), indices.data(), indexCount, weldedCount);
+
+        if (overdrawThreshold > 0.0f) {
+            vector<float3> compact(weldedCount);
+            const uint8_t* in = (const uint8_t*) positions;
+            for (size_t i = 0; i < weldedCount; ++i) {
+                compact[i] = *(const float3*) (in + sources[i] * positionStride);
+            }
+            meshopt_optimizeOverdraw(indices.data(), indices.data(), indexCount,
+                    &compact[0].x, weldedCount, sizeof(float3), overdrawThreshold);
+        }
+
+        // Renumber vertices in order of first use, which improves fetch locality.
+        vector<uint32_t> fetch(weldedCount);
+        meshopt_optimizeVertexFetchRemap(fetch.data(), indices.data(), indexCount, weldedCount);
+        for (uint32_t& index : indices) {
+            index = fetch[index];
+        }
+        vector<uint32_t> reordered(weldedCount);
+        for (size_t i = 0; i < weldedCount; ++i) {
+            reordered[fetch[i]] = sources[i];
+        }
+        sources.swap(reordered);
+    }
+
+    return new MeshWelder(new MeshWelderImpl({ std::move(indices), std::move(sources) }));
+}
+
+MeshWelder::MeshWelder(MeshWelderImpl* impl) noexcept : mImpl(impl) {}
+
+MeshWelder::~MeshWelder() noexcept { delete mImpl; }
+
+MeshWelder::MeshWelder(MeshWelder&& that) noexcept {
+    std::swap(mImpl, that.mImpl);
+}
+
+MeshWelder& MeshWelder::operator=(MeshWelder&& that) noexcept {
+    std::swap(mImpl, that.mImpl);
+    return *this;
+}
+
+size_t MeshWelder::getVertexCount() const noexcept {
+    return mImpl->sources.size();
+}
+
+size_t MeshWelder::getTriangleCount() const noexcept {
+    return mImpl->indices.size() / 3;
+}
+
+void MeshWelder::getTriangles(uint3* out) const noexcept {
+    std::copy(mImpl->indices.begin(), mImpl->indices.end(), &out[0].x);
+}
+
+void MeshWelder::getTriangles(ushort3* out) const noexcept {
+    assert_invariant(mImpl->sources.size() <= 65536);
+    std::copy(mImpl->indices.begin(), mImpl->indices.end(), &out[0].x);
+}
+
+const uint32_t* MeshWelder::getSourceVertices() const noexcept {
+    return mImpl->sources.data();
+}
+
+void MeshWelder::remap(void* out, const void* in, size_t size, size_t inStride,
+        size_t outStride) const noexcept {
+    inStride = inStride ? inStride : size;
+    outStride = outStride ? outStride : size;
+    const uint8_t* src = (const uint8_t*) in;
+    uint8_t* dst = (uint8_t*) out;
+    for (uint32_t source : mImpl->sources) {
+        memcpy(dst, src + source * inStride, size);
+        dst += outStride;
+    }
+}
+
+} // namespace geometry
+} // namespace filament
@@ -16,12 +16,14 @@
 
 #include <geometry/SurfaceOrientation.h>
 
+#include <utils/JobSystem.h>
 #include <utils/Panic.h>
 #include <utils/debug.h>
 
 #include <math/mat3.h>
 #include <math/norm.h>
 
+#include <functional>
 #include <vector>
 
 namespace filament {
@@ -30,6 +32,7 @@ namespace geometry {
 using namespace filament::math;
 using std::vector;
 using Builder = SurfaceOrientation::Builder;
+using utils::JobSystem;
 
 struct OrientationBuilderImpl {
     size_t vertexCount = 0;
@@ -44,6 +47,7 @@ struct OrientationBuilderImpl {
     size_t uvStride = 0;
     size_t positionStride = 0;
     size_t triangleCount = 0;
+    JobSystem* js = nullptr;
     SurfaceOrientation* buildWithNormalsOnly();
     SurfaceOrientation* buildWithSuppliedTangents();
     SurfaceOrientation* buildWithUvs();
@@ -142,6 +146,29 @@ SurfaceOrientation* Builder::build() {
     return mImpl->buildWithUvs();
 }
 
+SurfaceOrientation* Builder::build(JobSystem& js) {
+    mImpl->js = &js;
+    SurfaceOrientation* const result = build();
+    mImpl->js = nullptr;
+    return result;
+}
+
+// Calls func(begin, end) over sub-ranges of [0, count), concurrently if a JobSystem is provided.
+template<typename F>
+static void forEachRange(JobSystem* js, size_t count, F const& func) {
+    constexpr size_t BATCH_SIZE = 4096;
+    if (js == nullptr || count < BATCH_SIZE * 2) {
+        func(size_t(0), count);
+        return;
+    }
+    auto task = [&func](uint32_t start, uint32_t c) {
+        func(size_t(start), size_t(start + c));
+    };
+    JobSystem::Job* job = utils::jobs::parallel_for(*js, nullptr, 0, uint32_t(count),
+            std::cref(task), utils::jobs::CountSplitter<BATCH_SIZE, 5>());
+    js->runAndWait(job);
+}
+
 static float3 randomPerp(const float3& n) {
     float3 perp = cross(n, float3{1, 0, 0});
     float sqrlen = dot(perp, perp);
@@ -155,16 +182,17 @@ static float3 randomPerp(const float3& n) {
 SurfaceOrientation* OrientationBuilderImpl::buildWithNormalsOnly() {
     vector<quatf> quats(vertexCount);
 
-    const float3* normal = this->normals;
+    const uint8_t* normals = (const uint8_t*) this->normals;
     size_t nstride = this->normalStride ? this->normalStride : sizeof(float3);
 
-    for (size_t qindex = 0; qindex < vertexCount; ++qindex) {
-        float3 n = *normal;
-        float3 b = randomPerp(n);
-        float3 t = cross(n, b);
-        quats[qindex] = mat3f::packTangentFrame({t, b, n});
-        normal = (const float3*) (((const uint8_t*) normal) + nstride);
-    }
+    forEachRange(js, vertexCount, [&](size_t begin, size_t end) {
+        for (size_t qindex = begin; qindex < end; ++qindex) {
+            float3 n = *(const float3*) (normals + qindex * nstride);
+            float3 b = randomPerp(n);
+            float3 t = cross(n, b);
+            quats[qindex] = mat3f::packTangentFrame({t, b, n});
+        }
+    });
 
     return new SurfaceOrientation(new OrientationImpl( { std::move(quats) } ));
 }
@@ -172,29 +200,28 @@ SurfaceOrientation* OrientationBuilderImpl::buildWithNormalsOnly() {
 SurfaceOrientation* OrientationBuilderImpl::buildWithSuppliedTangents() {
     vector<quatf> quats(vertexCount);
 
-    const float3* normal = this->normals;
+    const uint8_t* normals = (const uint8_t*) this->normals;
     size_t nstride = this->normalStride ? this->normalStride : sizeof(float3);
 
-    const float3* tanvec = (const float3*) this->tangents;
-    const float* tandir = &this->tangents->w;
+    const uint8_t* tangents = (const uint8_t*) this->tangents;
     size_t tstride = this->tangentStride ? this->tangentStride : sizeof(float4);
 
-    for (size_t qindex = 0; qindex < vertexCount; ++qindex) {
-        float3 n = *normal;
-        float3 t = *tanvec;
-        float3 b = *tandir > 0 ? cross(t, n) : cross(n, t);
-
-        // Some assets do not provide perfectly orthogonal tangents and normals, so we adjust the
-        // tangent to enforce orthonormality. We would rather honor the exact normal vector than
-        // the exact tangent vector since the latter is only used for bump mapping and anisotropic
-        // lighting.
-        t = *tandir > 0 ? cross(n, b) : cross(b, n);
-
-        quats[qindex] = mat3f::packTangentFrame({t, b, n});
-        normal = (const float3*) (((const uint8_t*) normal) + nstride);
-        tanvec = (const float3*) (((const uint8_t*) tanvec) + tstride);
-        tandir = (const float*) (((const uint8_t*) tandir) + tstride);
-    }
+    forEachRange(js, vertexCount, [&](size_t begin, size_t end) {
+        for (size_t qindex = begin; qindex < end; ++qindex) {
+            float3 n = *(const float3*) (normals + qindex * nstride);
+            float4 tangent = *(const float4*) (tangents + qindex * tstride);
+            float3 t = tangent.xyz;
+            float3 b = tangent.w > 0 ? cross(t, n) : cross(n, t);
+
+            // Some assets do not provide perfectly orthogonal tangents and normals, so we adjust
+            // the tangent to enforce orthonormality. We would rather honor the exact normal vector
+            // than the exact tangent vector since the latter is only used for bump mapping and
+            // anisotropic lighting.
+            t = tangent.w > 0 ? cross(n, b) : cross(b, n);
+
+            quats[qindex] = mat3f::packTangentFrame({t, b, n});
+        }
+    });
 
     return new SurfaceOrientation(new OrientationImpl( { std::move(quats) } ));
 }
@@ -205,8 +232,8 @@ SurfaceOrientation* OrientationBuilderImpl::buildWithSuppliedTangents() {
 // http://www.terathon.com/code/tangent.html
 //
 // We considered mikktspace (which thankfully has a zlib-style license) but it would require
-// re-indexing (i.e. welding) and is therefore a bit heavyweight. Note that the welding could be
-// done via meshoptimizer.
+// re-indexing (i.e. welding) and is therefore a bit heavyweight. Clients that need smooth tangents
+// across duplicated vertices can weld the mesh beforehand with MeshWelder.
 //
 SurfaceOrientation* OrientationBuilderImpl::buildWithUvs() {
     if (!ASSERT_PRECONDITION_NON_FATAL(this->normalStride == 0, "Non-zero normal stride not yet supported.")) {
@@ -221,12 +248,8 @@ SurfaceOrientation* OrientationBuilderImpl::buildWithUvs() {
     if (!ASSERT_PRECONDITION_NON_FATAL(this->positionStride == 0, "Non-zero positions stride not yet supported.")) {
         return nullptr;
     }
-    vector<float3> tan1(vertexCount);
-    vector<float3> tan2(vertexCount);
-    memset(tan1.data(), 0, sizeof(float3) * vertexCount);
-    memset(tan2.data(), 0, sizeof(float3) * vertexCount);
-    for (size_t a = 0; a < triangleCount; ++a) {
-        uint3 tri = triangles16 ? uint3(triangles16[a]) : triangles32[a];
+    // Computes the tangent and bitangent directions of a triangle.
+    auto triangleDirections = [this](uint3 tri, float3& sdir, float3& tdir) {
         assert_invariant(tri.x < vertexCount && tri.y < vertexCount && tri.z < vertexCount);
         const float3& v1 = positions[tri.x];
         const float3& v2 = positions[tri.y];
@@ -245,7 +268,6 @@ SurfaceOrientation* OrientationBuilderImpl::buildWithUvs() {
         float t1 = w2.y - w1.y;
         float t2 = w3.y - w1.y;
         float d = s1 * t2 - s2 * t1;
-        float3 sdir, tdir;
         // In general we can't guarantee smooth tangents when the UV's are non-smooth, but let's at
         // least avoid divide-by-zero and fall back to normals-only method.
         if (d == 0.0) {
@@ -259,29 +281,90 @@ SurfaceOrientation* OrientationBuilderImpl::buildWithUvs() {
             sdir *= r;
             tdir *= r;
         }
-        tan1[tri.x] += sdir;
-        tan1[tri.y] += sdir;
-        tan1[tri.z] += sdir;
-        tan2[tri.x] += tdir;
-        tan2[tri.y] += tdir;
-        tan2[tri.z] += tdir;
+    };
+
+    auto getTriangle = [this](size_t a) {
+        return triangles16 ? uint3(triangles16[a]) : triangles32[a];
+    };
+
+    vector<float3> tan1(vertexCount);
+    vector<float3> tan2(vertexCount);
+    if (js == nullptr) {
+        memset(tan1.data(), 0, sizeof(float3) * vertexCount);
+        memset(tan2.data(), 0, sizeof(float3) * vertexCount);
+        for (size_t a = 0; a < triangleCount; ++a) {
+            const uint3 tri = getTriangle(a);
+            float3 sdir, tdir;
+            triangleDirections(tri, sdir, tdir);
+            tan1[tri.x] += sdir;
+            tan1[tri.y] += sdir;
+            tan1[tri.z] += sdir;
+            tan2[tri.x] += tdir;
+            tan2[tri.y] += tdir;
+            tan2[tri.z] += tdir;
+        }
+    } else {
+        // Scattering the triangle directions into the vertices can't be done concurrently, so
+        // instead each vertex gathers the directions of its triangles. The triangles of a vertex
+        // are visited in the same order as above, which yields identical sums.
+        vector<float3> sdirs(triangleCount);
+        vector<float3> tdirs(triangleCount);
+        forEachRange(js, triangleCount, [&](size_t begin, size_t end) {
+            for (size_t a = begin; a < end; ++a) {
+                triangleDirections(getTriangle(a), sdirs[a], tdirs[a]);
+            }
+        });
+
+        vector<uint32_t> offsets(vertexCount + 1, 0);
+        for (size_t a = 0; a < triangleCount; ++a) {
+            const uint3 tri = getTriangle(a);
+            offsets[tri.x + 1]++;
+            offsets[tri.y + 1]++;
+            offsets[tri.z + 1]++;
+        }
+        for (size_t v = 0; v < vertexCount; ++v) {
+            offsets[v + 1] += offsets[v];
+        }
+        vector<uint32_t> adjacency(triangleCount * 3);
+        vector<uint32_t> cursors(offsets.begin(), offsets.end() - 1);
+        for (size_t a = 0; a < triangleCount; ++a) {
+            const uint3 tri = getTriangle(a);
+            adjacency[cursors[tri.x]++] = uint32_t(a);
+            adjacency[cursors[tri.y]++] = uint32_t(a);
+            adjacency[cursors[tri.z]++] = uint32_t(a);
+        }
+
+        forEachRange(js, vertexCount, [&](size_t begin, size_t end) {
+            for (size_t v = begin; v < end; ++v) {
+                float3 t1 = 0;
+                float3 t2 = 0;
+                for (uint32_t i = offsets[v], e = offsets[v + 1]; i < e; ++i) {
+                    t1 += sdirs[adjacency[i]];
+                    t2 += tdirs[adjacency[i]];
+                }
+                tan1[v] = t1;
+                tan2[v] = t2;
+            }
+        });
     }
 
     vector<quatf> quats(vertexCount);
-    for (size_t a = 0; a < vertexCount; a++) {
-        const float3& n = normals[a];
-        const float3& t1 = tan1[a];
-        const float3& t2 = tan2[a];
+    forEachRange(js, vertexCount, [&](size_t begin, size_t end) {
+        for (size_t a = begin; a < end; a++) {
+            const float3& n = normals[a];
+            const float3& t1 = tan1[a];
+            const float3& t2 = tan2[a];
 
-        // Gram-Schmidt orthogonalize
-        float3 t = normalize(t1 - n * dot(n, t1));
+            // Gram-Schmidt orthogonalize
+            float3 t = normalize(t1 - n * dot(n, t1));
 
-        // Calculate handedness
-        float w = (dot(cross(n, t1), t2) < 0.0f) ? -1.0f : 1.0f;
+            // Calculate handedness
+            float w = (dot(cross(n, t1), t2) < 0.0f) ? -1.0f : 1.0f;
 
-        float3 b = w < 0 ? cross(t, n) : cross(n, t);
-        quats[a] = mat3f::packTangentFrame({t, b, n});
-    }
+            float3 b = w < 0 ? cross(t, n) : cross(n, t);
+            quats[a] = mat3f::packTangentFrame({t, b, n});
+        }
+    });
     return new SurfaceOrientation(new OrientationImpl( { std::move(quats) } ));
 }
 
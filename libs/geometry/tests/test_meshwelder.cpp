@@ -0,0 +1,146 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <geometry/MeshWelder.h>
+
+#include <math/vec2.h>
+#include <math/vec3.h>
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+using namespace filament::math;
+using filament::geometry::MeshWelder;
+
+class MeshWelderTest : public testing::Test {};
+
+// A quad made of two triangles that do not share vertices, plus an unreferenced vertex.
+static const float3 positions[7] = {
+    {0, 0, 0}, {1, 0, 0}, {1, 1, 0},
+    {0, 0, 0}, {1, 1, 0}, {0, 1, 0},
+    {5, 5, 5},
+};
+
+static const uint3 triangles[2] = {
+    {0, 1, 2},
+    {3, 4, 5},
+};
+
+TEST_F(MeshWelderTest, MergesIdenticalVertices) {
+    MeshWelder* welder = MeshWelder::Builder()
+            .vertexCount(7)
+            .positions(positions)
+            .triangleCount(2)
+            .triangles(triangles)
+            .build();
+    ASSERT_NE(welder, nullptr);
+    EXPECT_EQ(welder->getVertexCount(), 4);
+    EXPECT_EQ(welder->getTriangleCount(), 2);
+
+    std::vector<float3> welded(welder->getVertexCount());
+    welder->remap(welded.data(), positions, sizeof(float3));
+
+    uint3 result[2];
+    welder->getTriangles(result);
+    for (size_t t = 0; t < 2; ++t) {
+        for (size_t c = 0; c < 3; ++c) {
+            EXPECT_EQ(welded[result[t][c]], positions[triangles[t][c]]);
+        }
+    }
+    delete welder;
+}
+
+TEST_F(MeshWelderTest, KeepsSeams) {
+    // The two triangles share positions but not uvs along the diagonal.
+    const float2 uvs[7] = {
+        {0, 0}, {1, 0}, {1, 1},
+        {0, 0}, {0.5, 1}, {0, 1},
+        {0, 0},
+    };
+    MeshWelder* welder = MeshWelder::Builder()
+            .vertexCount(7)
+            .positions(positions)
+            .attribute(uvs, sizeof(float2))
+            .triangleCount(2)
+            .triangles(triangles)
+            .build();
+    ASSERT_NE(welder, nullptr);
+    EXPECT_EQ(welder->getVertexCount(), 5);
+    delete welder;
+}
+
+TEST_F(MeshWelderTest, Optimize) {
+    // A grid of quads with unshared vertices, which welds into (N + 1)^2 vertices.
+    constexpr uint32_t N = 16;
+    std::vector<float3> verts;
+    std::vector<ushort3> tris;
+    for (uint32_t y = 0; y < N; ++y) {
+        for (uint32_t x = 0; x < N; ++x) {
+            const uint16_t base = uint16_t(verts.size());
+            verts.push_back({x, y, 0});
+            verts.push_back({x + 1, y, 0});
+            verts.push_back({x + 1, y + 1, 0});
+            verts.push_back({x, y + 1, 0});
+            tris.push_back({base, base + 1, base + 2});
+            tris.push_back({base, base + 2, base + 3});
+        }
+    }
+
+    MeshWelder* welder = MeshWelder::Builder()
+            .vertexCount(verts.size())
+            .positions(verts.data())
+            .triangleCount(tris.size())
+            .triangles(tris.data())
+            .optimizeVertexCache(true)
+            .optimizeOverdraw(1.05f)
+            .build();
+    ASSERT_NE(welder, nullptr);
+    EXPECT_EQ(welder->getVertexCount(), (N + 1) * (N + 1));
+
+    std::vector<float3> welded(welder->getVertexCount());
+    welder->remap(welded.data(), verts.data(), sizeof(float3));
+
+    std::vector<ushort3> result(welder->getTriangleCount());
+    welder->getTriangles(result.data());
+
+    // Vertices are renumbered in order of first use.
+    uint32_t next = 0;
+    for (const ushort3& tri : result) {
+        for (size_t c = 0; c < 3; ++c) {
+            EXPECT_LE(tri[c], next);
+            if (tri[c] == next) {
+                ++next;
+            }
+        }
+    }
+    EXPECT_EQ(next, welder->getVertexCount());
+
+    // Every triangle of the input is still present, possibly reordered.
+    float area = 0;
+    for (const ushort3& tri : result) {
+        const float3 e1 = welded[tri.y] - welded[tri.x];
+        const float3 e2 = welded[tri.z] - welded[tri.x];
+        area += length(cross(e1, e2)) * 0.5f;
+    }
+    EXPECT_FLOAT_EQ(area, float(N * N));
+    delete welder;
+}
+
+int main(int argc, char** argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -24,6 +24,8 @@
 #include <gltfio/FilamentInstance.h>
 #include <gltfio/MaterialProvider.h>
 
+#include <backend/BufferDescriptor.h>
+
 #include <utils/compiler.h>
 
 namespace utils {
@@ -154,6 +156,32 @@ public:
      */
     FilamentAsset* createAssetFromBinary(const uint8_t* bytes, uint32_t nbytes);
 
+    /**
+     * Takes ownership of the contents of a GLB glTF 2.0 file and returns a bundle of Filament
+     * objects. Returns null on failure.
+     *
+     * Unlike the pointer-based variant, this does not make a copy of the GLB blob. Vertex and index
+     * buffers are uploaded directly from the given memory, and the descriptor's callback is invoked
+     * once the asset no longer needs it, i.e. after all GPU uploads have completed and the source
+     * data has been released. The callback is invoked immediately if parsing fails.
+     *
+     * The memory must be writable because ResourceLoader may modify some buffers in place (e.g.
+     * to normalize skinning weights).
+     */
+    FilamentAsset* createAssetFromBinary(filament::backend::BufferDescriptor&& glb);
+
+    /**
+     * Loads a GLB glTF 2.0 file from the filesystem and returns a bundle of Filament objects.
+     * Returns null on failure.
+     *
+     * On platforms that support it, the file is memory-mapped rather than read into the heap and
+     * the mapping is released after the last GPU upload has completed. This keeps the peak
+     * resident memory close to a single copy of the vertex data, even for very large scenes.
+     *
+     * This is not supported on platforms without a traditional filesystem (Android, iOS, WebGL).
+     */
+    FilamentAsset* createAssetFromBinaryFile(const char* path);
+
     /**
      * Consumes the contents of a glTF 2.0 file and produces a primary asset with one or more
      * instances. The primary asset has ownership over the instances.
@@ -24,6 +24,7 @@
 #include <utils/compiler.h>
 
 namespace filament {
+    class Camera;
     class Engine;
 }
 
@@ -52,6 +53,17 @@ struct ResourceConfiguration {
     //! If true, computes the bounding boxes of all \c POSITION attibutes. Well formed glTF files
     //! do not need this, but it is useful for robustness.
     bool recomputeBoundingBoxes;
+
+    //! If true, keeps a copy of the processed vertex and index data of each loaded asset, so that
+    //! it can be serialized with ResourceLoader::bakeResources(). This increases memory usage and
+    //! is typically only enabled by offline tools or on first launch.
+    bool recordBakedResources = false;
+
+    //! Maximum number of texel bytes that each call to ResourceLoader::asyncUpdateLoad() uploads
+    //! to the GPU, or 0 for no limit. When non-zero, large textures are first displayed with a
+    //! low resolution proxy, and their renderables become ready as soon as the proxy is uploaded.
+    //! At least one texture is uploaded per call, regardless of its size.
+    uint32_t asyncUploadBudget = 0;
 };
 
 /**
@@ -102,6 +114,33 @@ public:
      */
     void evictResourceData();
 
+    /**
+     * Supplies a snapshot that was previously produced by #bakeResources for the asset that is
+     * about to be loaded.
+     *
+     * If the snapshot matches the asset, the next call to #loadResources or #asyncBeginLoad
+     * uploads vertex and index data directly from the snapshot and skips Draco and meshopt
+     * decompression, data conversion, sparse accessors, skinning weight normalization, tangent
+     * generation and bounding box computation. Textures and animation data are still loaded from
+     * the glTF resources. Snapshots for a different glTF file or an incompatible version of
+     * gltfio are ignored.
+     *
+     * Snapshots are matched against the glTF JSON only, so clients must discard their snapshots
+     * when the binary resources of an asset change.
+     *
+     * The snapshot is not copied; its callback is invoked once all uploads have completed.
+     */
+    void addBakedResources(BufferDescriptor&& snapshot);
+
+    /**
+     * Serializes the vertex and index data (in their final GPU layout) and the bounding boxes of
+     * the most recently loaded asset, for use with #addBakedResources in a subsequent session.
+     *
+     * Returns an empty descriptor if ResourceConfiguration::recordBakedResources was not enabled
+     * or no asset has been loaded. The returned descriptor owns its memory.
+     */
+    BufferDescriptor bakeResources();
+
     /**
      * Loads resources for the given asset from the filesystem or data cache and "finalizes" the
      * asset by transforming the vertex data format if necessary, decoding image files, supplying
@@ -139,6 +178,15 @@ public:
      */
     void asyncUpdateLoad();
 
+    /**
+     * Updates an asynchronous load, prioritizing the textures that cover the largest portion of
+     * the screen from the point of view of the given camera.
+     *
+     * This is only useful in conjunction with ResourceConfiguration::asyncUploadBudget, since
+     * all decoded textures are uploaded in a single call otherwise.
+     */
+    void asyncUpdateLoad(const filament::Camera& camera);
+
     /**
      * Cancels pending decoder jobs, frees all CPU-side texel data, and flushes the Engine.
      *
@@ -149,6 +197,7 @@ public:
 
 private:
     bool loadResources(FFilamentAsset* asset, bool async);
+    bool loadBakedResources(FFilamentAsset* asset);
     void applySparseData(FFilamentAsset* asset) const;
     void normalizeSkinningWeights(FFilamentAsset* asset) const;
     void updateBoundingBoxes(FFilamentAsset* asset) const;
@@ -45,6 +45,8 @@ using namespace utils;
 
 namespace gltfio {
 
+const uint8_t* computeBufferViewData(const cgltf_buffer_view* view);
+
 using TimeValues = map<float, size_t>;
 using SourceValues = vector<float>;
 using BoneVector = vector<filament::math::mat4f>;
@@ -84,9 +86,8 @@ struct AnimatorImpl {
 static void createSampler(const cgltf_animation_sampler& src, Sampler& dst) {
     // Copy the time values into a red-black tree.
     const cgltf_accessor* timelineAccessor = src.input;
-    const uint8_t* timelineBlob = (const uint8_t*) timelineAccessor->buffer_view->buffer->data;
-    const float* timelineFloats = (const float*) (timelineBlob + timelineAccessor->offset +
-            timelineAccessor->buffer_view->offset);
+    const uint8_t* timelineBlob = computeBufferViewData(timelineAccessor->buffer_view);
+    const float* timelineFloats = (const float*) (timelineBlob + timelineAccessor->offset);
     for (size_t i = 0, len = timelineAccessor->count; i < len; ++i) {
         dst.times[timelineFloats[i]] = i;
     }
@@ -18,6 +18,7 @@
 #include <gltfio/AssetLoader.h>
 #include <gltfio/MaterialProvider.h>
 
+#include "BakedResources.h"
 #include "FFilamentAsset.h"
 #include "GltfEnums.h"
 
@@ -53,10 +54,30 @@
 #include "math.h"
 #include "upcast.h"
 
+#include <stdio.h>
+
+#if defined(__EMSCRIPTEN__) || defined(ANDROID) || defined(IOS)
+#define USE_FILESYSTEM 0
+#else
+#define USE_FILESYSTEM 1
+#endif
+
+#if USE_FILESYSTEM && !defined(WIN32)
+#define USE_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#define USE_MMAP 0
+#endif
+
 using namespace filament;
 using namespace filament::math;
 using namespace utils;
 
+using filament::backend::BufferDescriptor;
+
 namespace gltfio {
 
 void importSkins(const cgltf_data* gltf, const NodeMap& nodeMap, SkinVector& dstSkins);
@@ -74,8 +95,16 @@ uint32_t computeBindingSize(const cgltf_accessor* accessor) {
     return uint32_t(accessor->stride * (accessor->count - 1) + element_size);
 }
 
-uint32_t computeBindingOffset(const cgltf_accessor* accessor) {
-    return uint32_t(accessor->offset + accessor->buffer_view->offset);
+// Gets a pointer to the contents of the given buffer view, or null if its buffer has not been
+// loaded yet. Buffer views can hold their own data when it has been produced by an extension (e.g.
+// EXT_meshopt_compression), in which case the view's offset into its buffer does not apply.
+const uint8_t* computeBufferViewData(const cgltf_buffer_view* view) {
+    return cgltf_buffer_view_data(view);
+}
+
+// Gets a pointer to the first element of the given accessor.
+const uint8_t* computeBindingData(const cgltf_accessor* accessor) {
+    return computeBufferViewData(accessor->buffer_view) + accessor->offset;
 }
 
 static const char* getNodeName(const cgltf_node* node, const char* defaultNodeName) {
@@ -98,6 +127,8 @@ struct FAssetLoader : public AssetLoader {
 
     FFilamentAsset* createAssetFromJson(const uint8_t* bytes, uint32_t nbytes);
     FFilamentAsset* createAssetFromBinary(const uint8_t* bytes, uint32_t nbytes);
+    FFilamentAsset* createAssetFromBinary(BufferDescriptor&& glb);
+    FFilamentAsset* createAssetFromBinaryFile(const char* path);
     FFilamentAsset* createInstancedAsset(const uint8_t* bytes, uint32_t numBytes,
         FilamentInstance** instances, size_t numInstances);
     FilamentInstance* createInstance(FFilamentAsset* primary);
@@ -179,24 +210,82 @@ FFilamentAsset* FAssetLoader::createAssetFromBinary(const uint8_t* bytes, uint32
     // to the GPU. To achieve this we create a copy of the source blob and stash it inside the
     // asset, asking cgltf to parse the copy. This allows us to free it at the correct time (i.e.
     // after all GPU uploads have completed). Although it incurs a copy, the added safety of this
-    // API seems worthwhile.
-    utils::FixedCapacityVector<uint8_t> glbdata(byteCount);
-    std::copy_n(bytes, byteCount, glbdata.data());
+    // API seems worthwhile. Clients that wish to avoid the copy can use the BufferDescriptor or
+    // file-based variants instead.
+    void* glbdata = malloc(byteCount);
+    std::copy_n(bytes, byteCount, (uint8_t*) glbdata);
+    return createAssetFromBinary(BufferDescriptor(glbdata, byteCount, FREE_CALLBACK));
+}
+
+FFilamentAsset* FAssetLoader::createAssetFromBinary(BufferDescriptor&& glb) {
+    // Take ownership right away, this ensures that the callback is invoked if parsing fails.
+    BufferDescriptor glbdata(std::move(glb));
 
     cgltf_options options { cgltf_file_type_glb };
     cgltf_data* sourceAsset;
-    cgltf_result result = cgltf_parse(&options, glbdata.data(), byteCount, &sourceAsset);
+    cgltf_result result = cgltf_parse(&options, glbdata.buffer, glbdata.size, &sourceAsset);
     if (result != cgltf_result_success) {
         slog.e << "Unable to parse glb file." << io::endl;
         return nullptr;
     }
     createAsset(sourceAsset, 0);
     if (mResult) {
-        glbdata.swap(mResult->mSourceAsset->glbData);
+        mResult->mSourceAsset->glbData = std::move(glbdata);
     }
     return mResult;
 }
 
+FFilamentAsset* FAssetLoader::createAssetFromBinaryFile(const char* path) {
+#if USE_MMAP
+    const int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        slog.e << "Unable to open " << path << io::endl;
+        return nullptr;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+        slog.e << "Unable to stat " << path << io::endl;
+        close(fd);
+        return nullptr;
+    }
+
+    // The mapping is private and writable so that ResourceLoader can patch buffers in place (e.g.
+    // skinning weights); only the pages that are actually written to incur a copy. Vertex and
+    // index data are uploaded straight from the mapping, which is released by the
+    // BufferDescriptor callback when the last reference to the source asset goes away.
+    const size_t size = size_t(st.st_size);
+    void* data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        slog.e << "Unable to map " << path << io::endl;
+        return nullptr;
+    }
+    return createAssetFromBinary(BufferDescriptor(data, size,
+            [](void* buffer, size_t nbytes, void*) { munmap(buffer, nbytes); }));
+#elif USE_FILESYSTEM
+    FILE* file = fopen(path, "rb");
+    if (!file) {
+        slog.e << "Unable to open " << path << io::endl;
+        return nullptr;
+    }
+    fseek(file, 0, SEEK_END);
+    const long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    void* data = size > 0 ? malloc(size) : nullptr;
+    const bool success = data && fread(data, 1, size, file) == size_t(size);
+    fclose(file);
+    if (!success) {
+        slog.e << "Unable to read " << path << io::endl;
+        free(data);
+        return nullptr;
+    }
+    return createAssetFromBinary(BufferDescriptor(data, size_t(size), FREE_CALLBACK));
+#else
+    slog.e << "File-based loading is not supported on this platform." << io::endl;
+    return nullptr;
+#endif
+}
+
 FFilamentAsset* FAssetLoader::createInstancedAsset(const uint8_t* bytes, uint32_t byteCount,
         FilamentInstance** instances, size_t numInstances) {
     ASSERT_PRECONDITION(numInstances > 0, "Instance count must be 1 or more.");
@@ -208,18 +297,19 @@ FFilamentAsset* FAssetLoader::createInstancedAsset(const uint8_t* bytes, uint32_
     // Clients can free up their source blob immediately, but cgltf has pointers into the data that
     // need to stay valid. Therefore we create a copy of the source blob and stash it inside the
     // asset.
-    utils::FixedCapacityVector<uint8_t> glbdata(byteCount);
-    std::copy_n(bytes, byteCount, glbdata.data());
+    void* copy = malloc(byteCount);
+    std::copy_n(bytes, byteCount, (uint8_t*) copy);
+    BufferDescriptor glbdata(copy, byteCount, FREE_CALLBACK);
 
     cgltf_data* sourceAsset;
-    cgltf_result result = cgltf_parse(&options, glbdata.data(), byteCount, &sourceAsset);
+    cgltf_result result = cgltf_parse(&options, glbdata.buffer, byteCount, &sourceAsset);
     if (result != cgltf_result_success) {
         slog.e << "Unable to parse glTF file." << io::endl;
         return nullptr;
     }
     createAsset(sourceAsset, numInstances);
     if (mResult) {
-        glbdata.swap(mResult->mSourceAsset->glbData);
+        mResult->mSourceAsset->glbData = std::move(glbdata);
         std::copy_n(mResult->mInstances.data(), numInstances, instances);
     }
     return mResult;
@@ -268,6 +358,10 @@ void FAssetLoader::createAsset(const cgltf_data* srcAsset, size_t numInstances)
     mResult = new FFilamentAsset(mEngine, mNameManager, &mEntityManager, srcAsset);
     mDummyBufferObject = nullptr;
 
+    // The JSON is hashed now because clients are allowed to free their source blob before loading
+    // resources, at which point the cgltf hierarchy might no longer have a valid JSON pointer.
+    mResult->mSourceHash = BakedResources::computeSourceHash(srcAsset->json, srcAsset->json_size);
+
     // If there is no default scene specified, then the default is the first one.
     // It is not an error for a glTF file to have zero scenes.
     const cgltf_scene* scene = srcAsset->scene ? srcAsset->scene : srcAsset->scenes;
@@ -653,17 +747,20 @@ bool FAssetLoader::createPrimitive(const cgltf_primitive* inPrim, Primitive* out
         vertexCount = accessor->count;
 
         // The positions accessor is required to have min/max properties, use them to expand
-        // the bounding box for this primitive.
+        // the bounding box for this primitive. For normalized (quantized) positions, min/max are
+        // expressed in the integer domain.
         if (atype == cgltf_attribute_type_position) {
+            const float scale = accessor->normalized ?
+                    1.0f / getNormalizationScale(accessor->component_type) : 1.0f;
             const float* minp = &accessor->min[0];
             const float* maxp = &accessor->max[0];
-            outPrim->aabb.min = min(outPrim->aabb.min, float3(minp[0], minp[1], minp[2]));
-            outPrim->aabb.max = max(outPrim->aabb.max, float3(maxp[0], maxp[1], maxp[2]));
+            outPrim->aabb.min = min(outPrim->aabb.min, float3(minp[0], minp[1], minp[2]) * scale);
+            outPrim->aabb.max = max(outPrim->aabb.max, float3(maxp[0], maxp[1], maxp[2]) * scale);
         }
 
         VertexBuffer::AttributeType fatype;
         VertexBuffer::AttributeType actualType;
-        if (!getElementType(accessor->type, accessor->component_type, &fatype, &actualType)) {
+        if (!getElementType(accessor, atype, &fatype, &actualType)) {
             slog.e << "Unsupported accessor type in " << name << io::endl;
             return false;
         }
@@ -1280,6 +1377,14 @@ FilamentAsset* AssetLoader::createAssetFromBinary(uint8_t const* bytes, uint32_t
     return upcast(this)->createAssetFromBinary(bytes, nbytes);
 }
 
+FilamentAsset* AssetLoader::createAssetFromBinary(BufferDescriptor&& glb) {
+    return upcast(this)->createAssetFromBinary(std::move(glb));
+}
+
+FilamentAsset* AssetLoader::createAssetFromBinaryFile(const char* path) {
+    return upcast(this)->createAssetFromBinaryFile(path);
+}
+
 FilamentAsset* AssetLoader::createInstancedAsset(const uint8_t* bytes, uint32_t numBytes,
         FilamentInstance** instances, size_t numInstances) {
     return upcast(this)->createInstancedAsset(bytes, numBytes, instances, numInstances);
@@ -0,0 +1,105 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "BakedResources.h"
+
+#include <string.h>
+
+using namespace filament;
+using namespace utils;
+
+namespace gltfio {
+
+uint64_t BakedResources::computeSourceHash(const char* json, size_t size) noexcept {
+    // 64-bit FNV-1a, the JSON chunk is small enough that this is negligible.
+    uint64_t hash = 0xcbf29ce484222325ull;
+    for (size_t i = 0; i < size; i++) {
+        hash ^= uint8_t(json[i]);
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+void BakedResources::setSlotData(size_t slot, const void* data, size_t size) {
+    auto& dst = mSlots[slot];
+    dst.resize(size);
+    memcpy(dst.data(), data, size);
+}
+
+void BakedResources::addBounds(uint32_t node, const Aabb& bounds) {
+    mBounds.push_back({ node,
+            { bounds.min.x, bounds.min.y, bounds.min.z },
+            { bounds.max.x, bounds.max.y, bounds.max.z }});
+}
+
+FixedCapacityVector<uint8_t> BakedResources::serialize(uint64_t sourceHash) const {
+    const size_t tableSize = sizeof(Header) + mSlots.size() * sizeof(SlotEntry) +
+            mBounds.size() * sizeof(BoundsEntry);
+
+    size_t totalSize = tableSize;
+    for (const auto& slot : mSlots) {
+        totalSize += (slot.size() + 3) & ~size_t(3);
+    }
+
+    FixedCapacityVector<uint8_t> result(totalSize);
+    uint8_t* const blob = result.data();
+
+    Header header = { MAGIC, VERSION, sourceHash, uint32_t(mSlots.size()),
+            uint32_t(mBounds.size()) };
+    memcpy(blob, &header, sizeof(header));
+
+    uint8_t* entries = blob + sizeof(Header);
+    size_t offset = tableSize;
+    for (size_t i = 0, n = mSlots.size(); i < n; i++) {
+        const auto& slot = mSlots[i];
+        const SlotEntry entry = { offset, slot.size() };
+        memcpy(entries + i * sizeof(SlotEntry), &entry, sizeof(entry));
+        if (!slot.empty()) {
+            memcpy(blob + offset, slot.data(), slot.size());
+        }
+        offset += (slot.size() + 3) & ~size_t(3);
+    }
+
+    memcpy(entries + mSlots.size() * sizeof(SlotEntry), mBounds.data(),
+            mBounds.size() * sizeof(BoundsEntry));
+    return result;
+}
+
+bool BakedResources::validate(const uint8_t* blob, size_t size, uint64_t sourceHash,
+        size_t slotCount) noexcept {
+    if (!blob || size < sizeof(Header)) {
+        return false;
+    }
+    const Header header = getHeader(blob);
+    if (header.magic != MAGIC || header.version != VERSION ||
+            header.sourceHash != sourceHash || header.slotCount != slotCount) {
+        return false;
+    }
+    const size_t tableSize = sizeof(Header) + size_t(header.slotCount) * sizeof(SlotEntry) +
+            size_t(header.boundsCount) * sizeof(BoundsEntry);
+    if (size < tableSize) {
+        return false;
+    }
+    for (size_t i = 0; i < slotCount; i++) {
+        const SlotEntry entry = getSlot(blob, i);
+        if (entry.offset > size || entry.size > size - entry.offset) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace gltfio
@@ -0,0 +1,115 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef GLTFIO_BAKEDRESOURCES_H
+#define GLTFIO_BAKEDRESOURCES_H
+
+#include <filament/Box.h>
+
+#include <utils/FixedCapacityVector.h>
+
+#include <vector>
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+namespace gltfio {
+
+// Snapshot of the CPU-side work performed by ResourceLoader for a given asset, i.e. the contents
+// of every vertex and index buffer in its final GPU layout (decompressed, converted, and with
+// generated tangents) along with recomputed bounding boxes.
+//
+// Buffer contents are indexed by their position in FFilamentAsset::mBufferSlots, which is
+// deterministic for a given glTF file. Bounding boxes are indexed by glTF node. The snapshot is
+// tagged with a hash of the glTF JSON so that stale snapshots can be rejected.
+//
+// Binary layout (little endian, all offsets relative to the start of the blob):
+//     Header
+//     SlotEntry[slotCount]
+//     BoundsEntry[boundsCount]
+//     slot data, each blob aligned to 4 bytes
+class BakedResources {
+public:
+    static constexpr uint32_t MAGIC = 0x4b42544cu; // "LTBK"
+    static constexpr uint32_t VERSION = 1;
+    static constexpr uint32_t ASSET_BOUNDS = 0xffffffffu;
+
+    struct Header {
+        uint32_t magic;
+        uint32_t version;
+        uint64_t sourceHash;
+        uint32_t slotCount;
+        uint32_t boundsCount;
+    };
+
+    struct SlotEntry {
+        uint64_t offset;
+        uint64_t size;  // zero if the slot has no baked data
+    };
+
+    struct BoundsEntry {
+        uint32_t node;  // index of the glTF node, or ASSET_BOUNDS
+        float min[3];
+        float max[3];
+    };
+
+    // Computes the hash that identifies the source glTF.
+    static uint64_t computeSourceHash(const char* json, size_t size) noexcept;
+
+    // Recording ----------------------------------------------------------------------------------
+
+    explicit BakedResources(size_t slotCount) : mSlots(slotCount) {}
+
+    void setSlotData(size_t slot, const void* data, size_t size);
+    void addBounds(uint32_t node, const filament::Aabb& bounds);
+    utils::FixedCapacityVector<uint8_t> serialize(uint64_t sourceHash) const;
+
+    // Playback -----------------------------------------------------------------------------------
+
+    // Validates a serialized snapshot against the expected source hash and slot count. On success,
+    // the accessors below can be used to read the blob, which is not copied. The blob doesn't need
+    // to be aligned, so its tables are read by copy.
+    static bool validate(const uint8_t* blob, size_t size, uint64_t sourceHash,
+            size_t slotCount) noexcept;
+
+    static Header getHeader(const uint8_t* blob) noexcept {
+        Header header;
+        memcpy(&header, blob, sizeof(header));
+        return header;
+    }
+
+    static SlotEntry getSlot(const uint8_t* blob, size_t index) noexcept {
+        SlotEntry entry;
+        memcpy(&entry, blob + sizeof(Header) + index * sizeof(SlotEntry), sizeof(entry));
+        return entry;
+    }
+
+    static BoundsEntry getBounds(const uint8_t* blob, size_t index) noexcept {
+        const size_t offset = sizeof(Header) + getHeader(blob).slotCount * sizeof(SlotEntry);
+        BoundsEntry entry;
+        memcpy(&entry, blob + offset + index * sizeof(BoundsEntry), sizeof(entry));
+        return entry;
+    }
+
+private:
+    std::vector<std::vector<uint8_t>> mSlots;
+    std::vector<BoundsEntry> mBounds;
+};
+
+} // namespace gltfio
+
+#endif // GLTFIO_BAKEDRESOURCES_H
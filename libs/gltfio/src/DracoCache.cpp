@@ -20,16 +20,13 @@
 #include <draco/compression/decode.h>
 #endif
 
-#include <utils/Log.h>
-
 #include <memory>
+#include <string>
 #include <vector>
 
 using std::unique_ptr;
 using std::vector;
 
-using namespace utils;
-
 namespace gltfio {
 
 DracoMesh* DracoCache::findOrCreateMesh(const cgltf_buffer_view* key) {
@@ -44,6 +41,16 @@ DracoMesh* DracoCache::findOrCreateMesh(const cgltf_buffer_view* key) {
     return mesh;
 }
 
+DracoMesh* DracoCache::findMesh(const cgltf_buffer_view* key) const {
+    auto iter = mCache.find(key);
+    return iter != mCache.end() ? iter->second.get() : nullptr;
+}
+
+void DracoCache::insertMesh(const cgltf_buffer_view* key, DracoMesh* mesh) {
+    assert(mCache.find(key) == mCache.end());
+    mCache.emplace(key, mesh);
+}
+
 DracoMesh::DracoMesh(struct DracoMeshDetails* details) : mDetails(details) {}
 
 #if GLTFIO_DRACO_SUPPORTED
@@ -117,7 +124,7 @@ DracoMesh* DracoMesh::decode(const uint8_t* data, size_t dataSize) {
     return new DracoMesh(new DracoMeshDetails { std::move(meshStatus).value() });
 }
 
-bool DracoMesh::getFaceIndices(cgltf_accessor* target) const {
+bool DracoMesh::getFaceIndices(cgltf_accessor* target, std::string* error) const {
     // Return early if we've already decompressed this data.
     if (target->buffer_view) {
         return true;
@@ -129,8 +136,8 @@ bool DracoMesh::getFaceIndices(cgltf_accessor* target) const {
     // It would be tricky to be robust against a mismatch; see the class comment for DracoMesh.
     uint32_t count = mesh->num_faces() * 3;
     if (target->count != count) {
-        slog.e << "The glTF accessor wants " << target->count << " indices, "
-               << "but the decoded Draco mesh has " <<  count << " indices." << io::endl;
+        *error = "The glTF accessor wants " + std::to_string(target->count) + " indices, "
+                "but the decoded Draco mesh has " + std::to_string(count) + " indices.";
         return false;
     }
 
@@ -148,13 +155,14 @@ bool DracoMesh::getFaceIndices(cgltf_accessor* target) const {
         case cgltf_component_type_r_32u: convertFaces<uint32_t>(target, mesh); break;
         case cgltf_component_type_r_8u: convertFaces<uint8_t>(target, mesh); break;
         default:
-            slog.e << "Unexpected component type for Draco indices." << io::endl;
+            *error = "Unexpected component type for Draco indices.";
             return false;
     }
     return true;
 }
 
-bool DracoMesh::getVertexAttributes(uint32_t attributeId, cgltf_accessor* target) const {
+bool DracoMesh::getVertexAttributes(uint32_t attributeId, cgltf_accessor* target,
+        std::string* error) const {
     // Return early if we've already decompressed this data.
     if (target->buffer_view) {
         return true;
@@ -164,7 +172,7 @@ bool DracoMesh::getVertexAttributes(uint32_t attributeId, cgltf_accessor* target
     draco::Mesh* mesh = mDetails->mesh.get();
     const draco::PointAttribute* attr = mesh->GetAttributeByUniqueId(attributeId);
     if (!attr) {
-        slog.e << "Unknown Draco point attribute." << io::endl;
+        *error = "Unknown Draco point attribute.";
         return false;
     }
 
@@ -174,8 +182,8 @@ bool DracoMesh::getVertexAttributes(uint32_t attributeId, cgltf_accessor* target
     // DracoMesh.
     uint32_t count = mesh->num_points();
     if (target->count != count) {
-        slog.e << "The glTF accessor wants " << target->count << " vertices, "
-               << "but the decoded Draco mesh has " <<  count << " vertices." << io::endl;
+        *error = "The glTF accessor wants " + std::to_string(target->count) + " vertices, "
+                "but the decoded Draco mesh has " + std::to_string(count) + " vertices.";
 
         // It is tempting to degrade gracefully by processing only the lesser of the two
         // counts, but doing so would lead to invalid indices in the index buffer.
@@ -199,8 +207,8 @@ bool DracoMesh::getVertexAttributes(uint32_t attributeId, cgltf_accessor* target
 	    case cgltf_component_type_r_32u: convertAttribs<uint32_t>(target, attr, count); break;
 	    case cgltf_component_type_r_32f: convertAttribs<float>(target, attr, count); break;
         default:
-            slog.e << "Unexpected component type for Draco vertices." << io::endl;
-            break;
+            *error = "Unexpected component type for Draco vertices.";
+            return false;
     }
 
     return true;
@@ -212,11 +220,12 @@ DracoMesh::~DracoMesh() {}
 struct DracoMeshDetails {};
 DracoMesh* DracoMesh::decode(const uint8_t* data, size_t dataSize) { return nullptr; }
 
-bool DracoMesh::getFaceIndices(cgltf_accessor* target) const {
+bool DracoMesh::getFaceIndices(cgltf_accessor* target, std::string* error) const {
     return false;
 }
 
-bool DracoMesh::getVertexAttributes(uint32_t attributeId, cgltf_accessor* target) const {
+bool DracoMesh::getVertexAttributes(uint32_t attributeId, cgltf_accessor* target,
+        std::string* error) const {
     return false;
 }
 
@@ -22,6 +22,7 @@
 #include <tsl/robin_map.h>
 
 #include <memory>
+#include <string>
 
 #ifndef GLTFIO_DRACO_SUPPORTED
 #define GLTFIO_DRACO_SUPPORTED 0
@@ -35,9 +36,14 @@ class DracoMesh;
 //
 // The cache key is the buffer view that holds the compressed data. This allows the loader to
 // avoid duplicated work when a single Draco mesh is referenced from multiple primitives.
+//
+// Lookups and insertions are not thread safe. To decode several meshes concurrently, clients can
+// call DracoMesh::decode() from jobs and insert the results from a single thread afterwards.
 class DracoCache {
 public:
     DracoMesh* findOrCreateMesh(const cgltf_buffer_view* key);
+    DracoMesh* findMesh(const cgltf_buffer_view* key) const;
+    void insertMesh(const cgltf_buffer_view* key, DracoMesh* mesh); // takes ownership
 private:
     tsl::robin_map<const cgltf_buffer_view*, std::unique_ptr<DracoMesh>> mCache;
 };
@@ -55,11 +61,15 @@ private:
 // our Draco decoder relies on the accessor fields being 100% correct. If we had to be robust
 // against faulty accessor information, we would need to replace the VertexBuffer object that was
 // created in the AssetLoader, which would be a messy process.
+//
+// The accessors are filled from JobSystem jobs, so getFaceIndices() and getVertexAttributes() don't
+// log. They return false on failure, and describe the problem in the given error string.
 class DracoMesh {
 public:
     static DracoMesh* decode(const uint8_t* compressedData, size_t compressedSize);
-    bool getFaceIndices(cgltf_accessor* destination) const;
-    bool getVertexAttributes(uint32_t attributeId, cgltf_accessor* destination) const;
+    bool getFaceIndices(cgltf_accessor* destination, std::string* error) const;
+    bool getVertexAttributes(uint32_t attributeId, cgltf_accessor* destination,
+            std::string* error) const;
     ~DracoMesh();
 private:
     DracoMesh(struct DracoMeshDetails* details);
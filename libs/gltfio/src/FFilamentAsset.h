@@ -28,6 +28,8 @@
 #include <filament/TransformManager.h>
 #include <filament/VertexBuffer.h>
 
+#include <backend/BufferDescriptor.h>
+
 #include <gltfio/MaterialProvider.h>
 
 #include <math/mat4.h>
@@ -245,6 +247,7 @@ struct FFilamentAsset : public FilamentAsset {
     Animator* mAnimator = nullptr;
     Wireframe* mWireframe = nullptr;
     bool mResourcesLoaded = false;
+    uint64_t mSourceHash = 0; // identifies the glTF JSON, used to validate baked resources
     DependencyGraph mDependencyGraph;
     tsl::htrie_map<char, std::vector<utils::Entity>> mNameToEntity;
     tsl::robin_map<utils::Entity, utils::CString> mNodeExtras;
@@ -256,11 +259,13 @@ struct FFilamentAsset : public FilamentAsset {
 
     // Encapsulates reference-counted source data, which includes the cgltf hierachy
     // and potentially also includes buffer data that can be uploaded to the GPU.
+    // The GLB blob is held by a BufferDescriptor, which is either a private heap copy or memory
+    // owned by the client (e.g. a file mapping). Its callback fires after the hierarchy is freed.
     struct SourceAsset {
         ~SourceAsset() { cgltf_free(hierarchy); }
         cgltf_data* hierarchy;
         DracoCache dracoCache;
-        utils::FixedCapacityVector<uint8_t> glbData;
+        filament::backend::BufferDescriptor glbData;
     };
 
     // We used shared ownership for the raw cgltf data in order to permit ResourceLoader to
@@ -266,4 +266,63 @@ inline bool requiresConversion(cgltf_type type, cgltf_component_type ctype) {
     return supported && permitted != actual;
 }
 
+// KHR_mesh_quantization allows 3-component 8-bit and 16-bit positions, which Filament cannot consume
+// as-is. However the extension requires each element to be aligned to 4 bytes, so the data can be
+// declared as a 4-component attribute instead of being expanded to floats. The padding ends up in
+// the w component, which is ignored for object-space positions. Any dequantization scale and offset
+// lives in the node transform, so it is naturally applied by the renderable's transform.
+inline bool isPaddedQuantizedPosition(const cgltf_accessor* accessor, cgltf_attribute_type atype) {
+    if (atype != cgltf_attribute_type_position || accessor->type != cgltf_type_vec3 ||
+            accessor->is_sparse || !accessor->buffer_view) {
+        return false;
+    }
+    cgltf_size componentSize;
+    switch (accessor->component_type) {
+        case cgltf_component_type_r_8:
+        case cgltf_component_type_r_8u:
+            componentSize = 1;
+            break;
+        case cgltf_component_type_r_16:
+        case cgltf_component_type_r_16u:
+            componentSize = 2;
+            break;
+        default:
+            return false;
+    }
+    // The padding of the last element must also lie within the buffer view.
+    return accessor->stride >= 4 * componentSize &&
+            accessor->offset + accessor->stride * accessor->count <= accessor->buffer_view->size;
+}
+
+// Variant of getElementType that takes advantage of padded quantized positions.
+inline bool getElementType(const cgltf_accessor* accessor, cgltf_attribute_type atype,
+        filament::VertexBuffer::AttributeType* permitType,
+        filament::VertexBuffer::AttributeType* actualType) {
+    using AttributeType = filament::VertexBuffer::AttributeType;
+    if (isPaddedQuantizedPosition(accessor, atype)) {
+        switch (accessor->component_type) {
+            case cgltf_component_type_r_8: *permitType = AttributeType::BYTE4; break;
+            case cgltf_component_type_r_8u: *permitType = AttributeType::UBYTE4; break;
+            case cgltf_component_type_r_16: *permitType = AttributeType::SHORT4; break;
+            default: *permitType = AttributeType::USHORT4; break;
+        }
+        *actualType = *permitType;
+        return true;
+    }
+    return getElementType(accessor->type, accessor->component_type, permitType, actualType);
+}
+
+// Returns the normalization divisor for the given integer component type, or 1 for floats. This is
+// used to bring the min / max of normalized accessors (which are stored as raw integer values) into
+// the same space as the data consumed by the vertex shader.
+inline float getNormalizationScale(cgltf_component_type ctype) {
+    switch (ctype) {
+        case cgltf_component_type_r_8: return 127.0f;
+        case cgltf_component_type_r_8u: return 255.0f;
+        case cgltf_component_type_r_16: return 32767.0f;
+        case cgltf_component_type_r_16u: return 65535.0f;
+        default: return 1.0f;
+    }
+}
+
 #endif // GLTFIO_GLTFENUMS_H
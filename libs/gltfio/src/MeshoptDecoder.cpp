@@ -0,0 +1,191 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "MeshoptDecoder.h"
+
+#include <utils/JobSystem.h>
+#include <utils/Log.h>
+#include <utils/Systrace.h>
+
+#include <meshoptimizer.h>
+
+#include <vector>
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+using namespace utils;
+
+namespace gltfio {
+
+// The filters below are the scalar versions of the reference decoders in meshoptimizer's
+// vertexfilter.cpp, which is not part of the version of meshoptimizer that we ship.
+
+template<typename T>
+static void decodeFilterOct(T* data, size_t count) {
+    const float max = float((1 << (sizeof(T) * 8 - 1)) - 1);
+    for (size_t i = 0; i < 4 * count; i += 4) {
+        float x = float(data[i + 0]);
+        float y = float(data[i + 1]);
+        float z = float(data[i + 2]) - fabsf(x) - fabsf(y);
+
+        // Fix up octahedral coordinates for z < 0.
+        const float t = (z >= 0.0f) ? 0.0f : z;
+        x += (x >= 0.0f) ? t : -t;
+        y += (y >= 0.0f) ? t : -t;
+
+        // Compute the normal length and scale, then convert back to integers with rounding.
+        const float l = sqrtf(x * x + y * y + z * z);
+        const float s = max / l;
+        data[i + 0] = T(int(x * s + (x >= 0.0f ? 0.5f : -0.5f)));
+        data[i + 1] = T(int(y * s + (y >= 0.0f ? 0.5f : -0.5f)));
+        data[i + 2] = T(int(z * s + (z >= 0.0f ? 0.5f : -0.5f)));
+    }
+}
+
+static void decodeFilterQuat(int16_t* data, size_t count) {
+    const float scale = 1.0f / sqrtf(2.0f);
+    for (size_t i = 0; i < 4 * count; i += 4) {
+        // Recover the scale from the high bits of the last component.
+        const int sf = data[i + 3] | 3;
+        const float ss = scale / float(sf);
+
+        const float x = float(data[i + 0]) * ss;
+        const float y = float(data[i + 1]) * ss;
+        const float z = float(data[i + 2]) * ss;
+
+        // Reconstruct w, clamping to zero to avoid NaNs due to precision errors.
+        const float ww = 1.0f - x * x - y * y - z * z;
+        const float w = sqrtf(ww >= 0.0f ? ww : 0.0f);
+
+        const int xf = int(x * 32767.0f + (x >= 0.0f ? 0.5f : -0.5f));
+        const int yf = int(y * 32767.0f + (y >= 0.0f ? 0.5f : -0.5f));
+        const int zf = int(z * 32767.0f + (z >= 0.0f ? 0.5f : -0.5f));
+        const int wf = int(w * 32767.0f + 0.5f);
+
+        // The output order is dictated by the index of the largest component.
+        const int qc = data[i + 3] & 3;
+        data[i + ((qc + 1) & 3)] = int16_t(xf);
+        data[i + ((qc + 2) & 3)] = int16_t(yf);
+        data[i + ((qc + 3) & 3)] = int16_t(zf);
+        data[i + ((qc + 0) & 3)] = int16_t(wf);
+    }
+}
+
+static void decodeFilterExp(uint32_t* data, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        // The lower 24 bits hold a signed mantissa and the upper 8 bits a signed exponent.
+        const uint32_t v = data[i];
+        const int32_t m = int32_t(v << 8) >> 8;
+        const int32_t e = int32_t(v) >> 24;
+
+        // This is equivalent to ldexp(float(m), e).
+        uint32_t bits = uint32_t(e + 127) << 23;
+        float f;
+        memcpy(&f, &bits, sizeof(f));
+        f *= float(m);
+        memcpy(&data[i], &f, sizeof(f));
+    }
+}
+
+// Returns an error message, or nullptr on success. This runs on JobSystem worker threads, so it
+// must not log; the caller reports the errors once all the jobs have completed.
+static const char* decodeBufferView(cgltf_buffer_view* view) {
+    const cgltf_meshopt_compression& mc = view->meshopt_compression;
+    const uint8_t* source = (const uint8_t*) mc.buffer->data;
+    if (!source) {
+        return "Compressed buffer for meshopt has not been loaded.";
+    }
+    source += mc.offset;
+
+    // This is freed by cgltf_free.
+    void* result = malloc(mc.count * mc.stride);
+    if (!result) {
+        return "Unable to allocate memory for meshopt decompression.";
+    }
+
+    int error = 1;
+    switch (mc.mode) {
+        case cgltf_meshopt_compression_mode_attributes:
+            error = meshopt_decodeVertexBuffer(result, mc.count, mc.stride, source, mc.size);
+            break;
+        case cgltf_meshopt_compression_mode_triangles:
+            error = meshopt_decodeIndexBuffer(result, mc.count, mc.stride, source, mc.size);
+            break;
+        case cgltf_meshopt_compression_mode_indices:
+            error = meshopt_decodeIndexSequence(result, mc.count, mc.stride, source, mc.size);
+            break;
+        default:
+            free(result);
+            return "Unsupported meshopt compression mode.";
+    }
+    if (error != 0) {
+        free(result);
+        return "Malformed meshopt compressed data.";
+    }
+    switch (mc.filter) {
+        case cgltf_meshopt_compression_filter_none:
+            break;
+        case cgltf_meshopt_compression_filter_octahedral:
+            if (mc.stride == 4) {
+                decodeFilterOct((int8_t*) result, mc.count);
+            } else {
+                decodeFilterOct((int16_t*) result, mc.count);
+            }
+            break;
+        case cgltf_meshopt_compression_filter_quaternion:
+            decodeFilterQuat((int16_t*) result, mc.count);
+            break;
+        case cgltf_meshopt_compression_filter_exponential:
+            decodeFilterExp((uint32_t*) result, mc.count * mc.stride / 4);
+            break;
+    }
+
+    view->data = result;
+    return nullptr;
+}
+
+bool decodeMeshoptCompression(cgltf_data* gltf, JobSystem& js) {
+    SYSTRACE_CALL();
+    // Each job writes its own slot, the errors are logged from this thread after the jobs are done.
+    std::vector<const char*> errors(gltf->buffer_views_count, nullptr);
+    JobSystem::Job* parent = js.createJob();
+    for (cgltf_size i = 0, len = gltf->buffer_views_count; i < len; ++i) {
+        cgltf_buffer_view* view = &gltf->buffer_views[i];
+        if (!view->has_meshopt_compression || view->data) {
+            continue;
+        }
+        const char** error = &errors[i];
+        js.run(jobs::createJob(js, parent, [view, error] {
+            *error = decodeBufferView(view);
+        }));
+    }
+    js.runAndWait(parent);
+    bool success = true;
+    for (cgltf_size i = 0, len = errors.size(); i < len; ++i) {
+        if (errors[i]) {
+            slog.e << "Buffer view " << i << ": " << errors[i] << io::endl;
+            success = false;
+        }
+    }
+    if (!success) {
+        slog.e << "Unable to decode meshopt compressed data." << io::endl;
+    }
+    return success;
+}
+
+} // namespace gltfio
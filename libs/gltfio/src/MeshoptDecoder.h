@@ -0,0 +1,42 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef GLTFIO_MESHOPT_DECODER_H
+#define GLTFIO_MESHOPT_DECODER_H
+
+#include <cgltf.h>
+
+namespace utils {
+class JobSystem;
+}
+
+namespace gltfio {
+
+// Decompresses all buffer views that use EXT_meshopt_compression, using one job per buffer view.
+//
+// The decompressed data is stored in cgltf_buffer_view::data, which cgltf consults before the
+// view's buffer and frees in cgltf_free. This must be called after the compressed buffers have
+// been loaded, and before any vertex data is consumed.
+//
+// The "attributes", "triangles" and "indices" modes are supported, as well as the octahedral,
+// quaternion and exponential filters. Index data can use version 0 or 1 of the index codec.
+// Errors are logged once all the jobs have completed. Returns false if any buffer view could not
+// be decoded.
+bool decodeMeshoptCompression(cgltf_data* gltf, utils::JobSystem& js);
+
+} // namespace gltfio
+
+#endif // GLTFIO_MESHOPT_DECODER_H
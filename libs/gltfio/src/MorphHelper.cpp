@@ -32,7 +32,8 @@ static constexpr uint8_t kUnused = 0xff;
 namespace gltfio {
 
 uint32_t computeBindingSize(const cgltf_accessor* accessor);
-uint32_t computeBindingOffset(const cgltf_accessor* accessor);
+const uint8_t* computeBufferViewData(const cgltf_buffer_view* view);
+const uint8_t* computeBindingData(const cgltf_accessor* accessor);
 
 static const auto FREE_CALLBACK = [](void* mem, size_t, void*) { free(mem); };
 
@@ -199,9 +200,8 @@ void MorphHelper::addPrimitive(cgltf_mesh const* mesh, int primitiveIndex, Table
 
                 // This should always be non-null, but don't crash if the glTF is malformed.
                 if (accessor->buffer_view) {
-                    auto bufferData = (const uint8_t*) accessor->buffer_view->buffer->data;
-                    assert_invariant(bufferData);
-                    const uint8_t* data = computeBindingOffset(accessor) + bufferData;
+                    assert_invariant(computeBufferViewData(accessor->buffer_view));
+                    const uint8_t* data = computeBindingData(accessor);
                     const uint32_t size = computeBindingSize(accessor);
 
                     // This creates a copy because we don't know when the user will free the cgltf
@@ -17,12 +17,16 @@
 #include <gltfio/ResourceLoader.h>
 #include <gltfio/Image.h>
 
+#include "BakedResources.h"
 #include "GltfEnums.h"
 #include "FFilamentAsset.h"
+#include "MeshoptDecoder.h"
 #include "TangentsJob.h"
+#include "TextureStreaming.h"
 #include "upcast.h"
 
 #include <filament/BufferObject.h>
+#include <filament/Camera.h>
 #include <filament/Engine.h>
 #include <filament/IndexBuffer.h>
 #include <filament/MaterialInstance.h>
@@ -43,7 +47,10 @@
 
 #include <tsl/robin_map.h>
 
+#include <algorithm>
+#include <memory>
 #include <string>
+#include <vector>
 
 #if defined(__EMSCRIPTEN__) || defined(ANDROID) || defined(IOS)
 #define USE_FILESYSTEM 0
@@ -61,6 +68,9 @@ using filament::geometry::ComponentType;
 
 static const auto FREE_CALLBACK = [](void* mem, size_t, void*) { free(mem); };
 
+// Maximum dimension of the placeholder textures that are used while streaming.
+static constexpr int PROXY_TEXTURE_SIZE = 64;
+
 namespace {
     struct TextureCacheEntry {
         Texture* texture;
@@ -71,6 +81,11 @@ namespace {
         int numComponents;
         bool srgb;
         bool completed;
+
+        // The following fields are used by texture streaming, see asyncUploadBudget.
+        std::vector<gltfio::TextureSlot> slots;
+        Texture* proxy;
+        float priority;
     };
 
     using BufferTextureCache = tsl::robin_map<const void*, std::unique_ptr<TextureCacheEntry>>;
@@ -86,13 +101,24 @@ struct ResourceLoader::Impl {
         mEngine = config.engine;
         mNormalizeSkinningWeights = config.normalizeSkinningWeights;
         mRecomputeBoundingBoxes = config.recomputeBoundingBoxes;
+        mRecordBakedResources = config.recordBakedResources;
+        mUploadBudget = config.asyncUploadBudget;
     }
 
     Engine* mEngine;
     bool mNormalizeSkinningWeights;
     bool mRecomputeBoundingBoxes;
+    bool mRecordBakedResources;
+    uint32_t mUploadBudget;
     std::string mGltfPath;
 
+    // Snapshot supplied with addBakedResources(), shared with in-flight uploads.
+    std::shared_ptr<BufferDescriptor> mBakedSnapshot;
+
+    // Processed buffer data of the most recently loaded asset, see bakeResources().
+    std::unique_ptr<BakedResources> mRecording;
+    uint64_t mRecordingHash = 0;
+
     // User-provided resource data with URI string keys, populated with addResourceData().
     // This is used on platforms without traditional file systems, such as Android, iOS, and WebGL.
     UriDataCache mUriDataCache;
@@ -108,19 +134,46 @@ struct ResourceLoader::Impl {
     JobSystem::Job* mDecoderRootJob = nullptr;
     FFilamentAsset* mCurrentAsset = nullptr;
 
-    void computeTangents(FFilamentAsset* asset);
+    // Renderables that use each material instance, used to prioritize textures while streaming.
+    tsl::robin_map<MaterialInstance*, std::vector<Entity>> mMaterialEntities;
+
+    // Transient results of the per-primitive job graph (see processPrimitives), which are
+    // consumed on the main thread after all jobs have completed.
+    struct SparseJob {
+        BufferSlot slot;
+        size_t slotIndex;
+        cgltf_size numBytes;
+        float* generated;
+    };
+    std::vector<TangentsJob::Params> mTangentsJobs;
+    std::vector<SparseJob> mSparseJobs;
+    tsl::robin_map<const cgltf_primitive*, Aabb> mPrimitiveBounds;
+
+    void processPrimitives(FFilamentAsset* asset);
+    void uploadTangents(FFilamentAsset* asset);
+    void recordSlot(size_t slotIndex, const void* data, size_t size) {
+        if (mRecording) {
+            mRecording->setSlotData(slotIndex, data, size);
+        }
+    }
     bool createTextures(bool async);
     void cancelTextureDecoding();
     void addTextureCacheEntry(const TextureSlot& tb);
     void bindTextureToMaterial(const TextureSlot& tb);
     void decodeSingleTexture();
     void uploadPendingTextures();
+    void streamPendingTextures(const Camera* camera);
+    void uploadTexture(TextureCacheEntry* entry);
+    void uploadProxyTexture(TextureCacheEntry* entry);
+    void computeTexturePriorities(const std::vector<TextureCacheEntry*>& entries,
+            const Camera& camera);
     void releasePendingTextures();
     ~Impl();
 };
 
 uint32_t computeBindingSize(const cgltf_accessor* accessor);
-uint32_t computeBindingOffset(const cgltf_accessor* accessor);
+const uint8_t* computeBufferViewData(const cgltf_buffer_view* view);
+const uint8_t* computeBindingData(const cgltf_accessor* accessor);
 
 // This little struct holds a shared_ptr that wraps cgltf_data (and, potentially, glb data) while
 // uploading vertex buffer data to the GPU.
@@ -137,6 +190,13 @@ static void uploadCallback(void* buffer, size_t size, void* user) {
     delete event;
 }
 
+// Uploads that read from a baked snapshot hold a reference to it until they complete.
+using BakedSnapshot = std::shared_ptr<ResourceLoader::BufferDescriptor>;
+
+static void bakedUploadCallback(void* buffer, size_t size, void* user) {
+    delete (BakedSnapshot*) user;
+}
+
 void importSkins(const cgltf_data* gltf, const NodeMap& nodeMap, SkinVector& dstSkins) {
     dstSkins.resize(gltf->skins_count);
     for (cgltf_size i = 0, len = gltf->nodes_count; i < len; ++i) {
@@ -174,12 +234,12 @@ void importSkins(const cgltf_data* gltf, const NodeMap& nodeMap, SkinVector& dst
         dstSkin.inverseBindMatrices.resize(srcSkin.joints_count);
         if (srcMatrices) {
             auto dstMatrices = (uint8_t*) dstSkin.inverseBindMatrices.data();
-            uint8_t* bytes = (uint8_t*) srcMatrices->buffer_view->buffer->data;
+            const uint8_t* bytes = computeBufferViewData(srcMatrices->buffer_view);
             if (!bytes) {
                 slog.w << "Empty animation buffer, have resources been loaded yet?" << io::endl;
                 continue;
             }
-            auto srcBuffer = (void*) (bytes + srcMatrices->offset + srcMatrices->buffer_view->offset);
+            auto srcBuffer = (const void*) (bytes + srcMatrices->offset);
             memcpy(dstMatrices, srcBuffer, srcSkin.joints_count * sizeof(mat4f));
         }
     }
@@ -213,13 +273,16 @@ static void convertToFloats(float* dest, const cgltf_accessor* accessor) {
         .componentCount = dim,
         .inputStrideBytes = uint32_t(accessor->stride)
     });
-    auto bufferData = (const uint8_t*) accessor->buffer_view->buffer->data;
-    const uint8_t* source = computeBindingOffset(accessor) + bufferData;
+    const uint8_t* source = computeBindingData(accessor);
     transcode(dest, source, accessor->count);
 }
 
-static void decodeDracoMeshes(FFilamentAsset* asset) {
-    DracoCache* dracoCache = &asset->mSourceAsset->dracoCache;
+// Copies the decompressed data of the given Draco mesh into the accessors of the given primitive,
+// converting the data type if necessary. Returns false if an error occurs. This runs on JobSystem
+// worker threads, so it must not log; the caller reports the errors and warnings once all the jobs
+// have completed.
+static bool decodeDracoPrimitive(FFilamentAsset* asset, const cgltf_primitive* prim,
+        const DracoMesh* mesh, std::string* error, std::vector<std::string>* warnings) {
 
     // For a given primitive and attribute, find the corresponding accessor.
     auto findAccessor = [](const cgltf_primitive* prim, cgltf_attribute_type type, cgltf_int idx) {
@@ -232,55 +295,59 @@ static void decodeDracoMeshes(FFilamentAsset* asset) {
         return (cgltf_accessor*) nullptr;
     };
 
-    // Go through every primitive and check if it has a Draco mesh.
-    for (auto& pair : asset->mPrimitives) {
-        const cgltf_primitive* prim = pair.first;
-        if (!prim->has_draco_mesh_compression) {
-            continue;
-        }
+    if (!mesh) {
+        *error = "Cannot decompress mesh, Draco decoding error.";
+        return false;
+    }
 
-        const cgltf_draco_mesh_compression& draco = prim->draco_mesh_compression;
+    const cgltf_draco_mesh_compression& draco = prim->draco_mesh_compression;
 
-        // If an error occurs, we can simply set the primitive's associated VertexBuffer to null.
-        // This does not cause a leak because it is a weak reference.
-        auto& vertexBuffer = pair.second;
+    // Copy over the decompressed data, converting the data type if necessary.
+    if (prim->indices && !mesh->getFaceIndices(prim->indices, error)) {
+        return false;
+    }
 
-        // Check if we have already decoded this mesh.
-        DracoMesh* mesh = dracoCache->findOrCreateMesh(draco.buffer_view);
-        if (!mesh) {
-            slog.e << "Cannot decompress mesh, Draco decoding error." << io::endl;
-            vertexBuffer = nullptr;
+    // Go through each attribute in the decompressed mesh.
+    for (cgltf_size i = 0; i < draco.attributes_count; i++) {
+
+        // In cgltf, each Draco attribute's data pointer is an attribute id, not an accessor.
+        const uint32_t id = draco.attributes[i].data - asset->mSourceAsset->hierarchy->accessors;
+
+        // Find the destination accessor; this contains the desired component type, etc.
+        const cgltf_attribute_type type = draco.attributes[i].type;
+        const cgltf_int index = draco.attributes[i].index;
+        cgltf_accessor* accessor = findAccessor(prim, type, index);
+        if (!accessor) {
+            warnings->push_back("Cannot find matching accessor for Draco id " + std::to_string(id));
             continue;
         }
 
         // Copy over the decompressed data, converting the data type if necessary.
-        if (prim->indices && !mesh->getFaceIndices(prim->indices)) {
-            vertexBuffer = nullptr;
-            continue;
+        if (!mesh->getVertexAttributes(id, accessor, error)) {
+            return false;
         }
+    }
+    return true;
+}
 
-        // Go through each attribute in the decompressed mesh.
-        for (cgltf_size i = 0; i < draco.attributes_count; i++) {
-
-            // In cgltf, each Draco attribute's data pointer is an attribute id, not an accessor.
-            const uint32_t id = draco.attributes[i].data - asset->mSourceAsset->hierarchy->accessors;
-
-            // Find the destination accessor; this contains the desired component type, etc.
-            const cgltf_attribute_type type = draco.attributes[i].type;
-            const cgltf_int index = draco.attributes[i].index;
-            cgltf_accessor* accessor = findAccessor(prim, type, index);
-            if (!accessor) {
-                slog.w << "Cannot find matching accessor for Draco id " << id << io::endl;
-                continue;
-            }
-
-            // Copy over the decompressed data, converting the data type if necessary.
-            if (!mesh->getVertexAttributes(id, accessor)) {
-                vertexBuffer = nullptr;
-                break;
+static void computeBoundingBox(const cgltf_primitive* prim, Aabb* result) {
+    Aabb aabb;
+    for (cgltf_size slot = 0; slot < prim->attributes_count; slot++) {
+        const cgltf_attribute& attr = prim->attributes[slot];
+        const cgltf_accessor* accessor = attr.data;
+        const size_t dim = cgltf_num_components(accessor->type);
+        if (attr.type == cgltf_attribute_type_position && dim >= 3) {
+            std::vector<float> unpacked(accessor->count * dim);
+            cgltf_accessor_unpack_floats(accessor, unpacked.data(), unpacked.size());
+            for (cgltf_size i = 0, j = 0, n = accessor->count; i < n; ++i, j += dim) {
+                float3 pt(unpacked[j + 0], unpacked[j + 1], unpacked[j + 2]);
+                aabb.min = min(aabb.min, pt);
+                aabb.max = max(aabb.max, pt);
             }
+            break;
         }
     }
+    *result = aabb;
 }
 
 // Parses a data URI and returns a blob that gets malloc'd in cgltf, which the caller must free.
@@ -343,6 +410,20 @@ void ResourceLoader::evictResourceData() {
     pImpl->mUriDataCache.clear();
 }
 
+void ResourceLoader::addBakedResources(BufferDescriptor&& snapshot) {
+    pImpl->mBakedSnapshot = std::make_shared<BufferDescriptor>(std::move(snapshot));
+}
+
+ResourceLoader::BufferDescriptor ResourceLoader::bakeResources() {
+    if (!pImpl->mRecording) {
+        return {};
+    }
+    FixedCapacityVector<uint8_t> blob = pImpl->mRecording->serialize(pImpl->mRecordingHash);
+    void* data = malloc(blob.size());
+    memcpy(data, blob.data(), blob.size());
+    return BufferDescriptor(data, blob.size(), FREE_CALLBACK);
+}
+
 bool ResourceLoader::loadResources(FilamentAsset* asset) {
     FFilamentAsset* fasset = upcast(asset);
     return loadResources(fasset, false);
@@ -436,14 +517,36 @@ bool ResourceLoader::loadResources(FFilamentAsset* asset, bool async) {
     }
     #endif
 
-    // Decompress Draco meshes early on, which allows us to exploit subsequent processing such as
-    // tangent generation.
-    decodeDracoMeshes(asset);
+    Engine& engine = *pImpl->mEngine;
+
+    pImpl->mRecording.reset();
+    if (pImpl->mRecordBakedResources) {
+        pImpl->mRecording = std::make_unique<BakedResources>(asset->mBufferSlots.size());
+        pImpl->mRecordingHash = asset->mSourceHash;
+    }
+
+    // Decompress buffer views that use EXT_meshopt_compression. This is done up front on the
+    // JobSystem since compressed views can be shared by any number of accessors. Note that this
+    // is required even with a baked snapshot, because animations and skins read from these views.
+    if (!decodeMeshoptCompression((cgltf_data*) gltf, engine.getJobSystem())) {
+        return false;
+    }
+
+    // If a matching snapshot was supplied, upload vertex and index buffers straight from it.
+    const bool baked = pImpl->mBakedSnapshot && loadBakedResources(asset);
+    pImpl->mBakedSnapshot.reset();
+
+    // Decompress Draco meshes, apply sparse data, generate tangents and compute bounding boxes on
+    // the JobSystem. This needs to happen before uploading buffers, since Draco decoding populates
+    // the accessors of compressed primitives.
+    if (!baked) {
+        pImpl->processPrimitives(asset);
+    }
 
     // Normalize skinning weights, then "import" each skin into the asset by building a mapping of
     // skins to their affected entities.
     if (gltf->skins_count > 0) {
-        if (pImpl->mNormalizeSkinningWeights) {
+        if (pImpl->mNormalizeSkinningWeights && !baked) {
             normalizeSkinningWeights(asset);
         }
         if (!asset->isInstanced()) {
@@ -457,33 +560,45 @@ bool ResourceLoader::loadResources(FFilamentAsset* asset, bool async) {
         }
     }
 
-    if (pImpl->mRecomputeBoundingBoxes) {
+    if (pImpl->mRecomputeBoundingBoxes && !baked) {
         updateBoundingBoxes(asset);
     }
 
-    Engine& engine = *pImpl->mEngine;
-
     // Upload VertexBuffer and IndexBuffer data to the GPU.
-    for (auto slot : asset->mBufferSlots) {
+    for (size_t index = 0, n = baked ? 0 : asset->mBufferSlots.size(); index < n; ++index) {
+        const BufferSlot& slot = asset->mBufferSlots[index];
         const cgltf_accessor* accessor = slot.accessor;
         if (!accessor->buffer_view) {
             continue;
         }
-        auto bufferData = (const uint8_t*) accessor->buffer_view->buffer->data;
-        const uint8_t* data = computeBindingOffset(accessor) + bufferData;
+        const uint8_t* data = computeBindingData(accessor);
         const uint32_t size = computeBindingSize(accessor);
         if (slot.vertexBuffer) {
+            if (!slot.morphTarget && isPaddedQuantizedPosition(accessor, slot.attribute)) {
+                // Upload the padding of the last element too, since it is declared as a
+                // 4-component attribute.
+                const uint32_t paddedSize = uint32_t(accessor->stride * accessor->count);
+                pImpl->recordSlot(index, data, paddedSize);
+                BufferObject* bo = BufferObject::Builder().size(paddedSize).build(engine);
+                asset->mBufferObjects.push_back(bo);
+                bo->setBuffer(engine, BufferDescriptor(data, paddedSize,
+                        uploadCallback, uploadUserdata(asset)));
+                slot.vertexBuffer->setBufferObjectAt(engine, slot.bufferIndex, bo);
+                continue;
+            }
             if (requiresConversion(accessor->type, accessor->component_type)) {
                 const size_t dim = cgltf_num_components(accessor->type);
                 const size_t floatsSize = accessor->count * sizeof(float) * dim;
                 float* floatsData = (float*) malloc(floatsSize);
                 convertToFloats(floatsData, accessor);
+                pImpl->recordSlot(index, floatsData, floatsSize);
                 BufferObject* bo = BufferObject::Builder().size(floatsSize).build(engine);
                 asset->mBufferObjects.push_back(bo);
                 bo->setBuffer(engine, BufferDescriptor(floatsData, floatsSize, FREE_CALLBACK));
                 slot.vertexBuffer->setBufferObjectAt(engine, slot.bufferIndex, bo);
                 continue;
             }
+            pImpl->recordSlot(index, data, size);
             BufferObject* bo = BufferObject::Builder().size(size).build(engine);
             asset->mBufferObjects.push_back(bo);
             bo->setBuffer(engine, BufferDescriptor(data, size,
@@ -496,20 +611,22 @@ bool ResourceLoader::loadResources(FFilamentAsset* asset, bool async) {
             const size_t size16 = size * 2;
             uint16_t* data16 = (uint16_t*) malloc(size16);
             convertBytesToShorts(data16, data, size);
+            pImpl->recordSlot(index, data16, size16);
             IndexBuffer::BufferDescriptor bd(data16, size16, FREE_CALLBACK);
             slot.indexBuffer->setBuffer(engine, std::move(bd));
             continue;
         }
+        pImpl->recordSlot(index, data, size);
         IndexBuffer::BufferDescriptor bd(data, size, uploadCallback, uploadUserdata(asset));
         slot.indexBuffer->setBuffer(engine, std::move(bd));
     }
 
-    // Apply sparse data modifications to base arrays, then upload the result.
+    // Upload the sparse data modifications that were applied to base arrays.
     applySparseData(asset);
 
-    // Compute surface orientation quaternions if necessary. This is similar to sparse data in that
-    // we need to generate the contents of a GPU buffer by processing one or more CPU buffer(s).
-    pImpl->computeTangents(asset);
+    // Upload the surface orientation quaternions that were generated. This is similar to sparse
+    // data in that the contents of the GPU buffer were produced from one or more CPU buffer(s).
+    pImpl->uploadTangents(asset);
 
     // Non-textured renderables are now considered ready, so notify the dependency graph.
     asset->mDependencyGraph.finalize();
@@ -539,7 +656,22 @@ void ResourceLoader::asyncUpdateLoad() {
     if (!UTILS_HAS_THREADING) {
         pImpl->decodeSingleTexture();
     }
-    pImpl->uploadPendingTextures();
+    if (pImpl->mUploadBudget) {
+        pImpl->streamPendingTextures(nullptr);
+    } else {
+        pImpl->uploadPendingTextures();
+    }
+}
+
+void ResourceLoader::asyncUpdateLoad(const Camera& camera) {
+    if (!UTILS_HAS_THREADING) {
+        pImpl->decodeSingleTexture();
+    }
+    if (pImpl->mUploadBudget) {
+        pImpl->streamPendingTextures(&camera);
+    } else {
+        pImpl->uploadPendingTextures();
+    }
 }
 
 void ResourceLoader::Impl::decodeSingleTexture() {
@@ -587,23 +719,155 @@ void ResourceLoader::Impl::decodeSingleTexture() {
     }
 }
 
+void ResourceLoader::Impl::uploadTexture(TextureCacheEntry* entry) {
+    Engine& engine = *mEngine;
+    Texture* texture = entry->texture;
+    Texture::PixelBufferDescriptor pbd(entry->texels.load(),
+            texture->getWidth() * texture->getHeight() * 4,
+            Texture::Format::RGBA, Texture::Type::UBYTE, FREE_CALLBACK);
+    texture->setImage(engine, 0, std::move(pbd));
+    texture->generateMipmaps(engine);
+    entry->completed = true;
+    mNumDecoderTasksFinished++;
+
+    // If a proxy is bound, swap in the real texture. Its renderables are already marked as ready.
+    if (entry->proxy) {
+        for (const TextureSlot& slot : entry->slots) {
+            slot.materialInstance->setParameter(slot.materialParameter, texture, slot.sampler);
+        }
+        auto& textures = mCurrentAsset->mTextures;
+        textures.erase(std::find(textures.begin(), textures.end(), entry->proxy));
+        engine.destroy(entry->proxy);
+        entry->proxy = nullptr;
+        return;
+    }
+    mCurrentAsset->mDependencyGraph.markAsReady(texture);
+}
+
 void ResourceLoader::Impl::uploadPendingTextures() {
-    auto upload = [this](TextureCacheEntry* entry, Engine& engine) {
-        Texture* texture = entry->texture;
-        uint8_t* texels = entry->texels;
-        if (texture && texels && !entry->completed) {
-            Texture::PixelBufferDescriptor pbd(texels,
-                    texture->getWidth() * texture->getHeight() * 4,
-                    Texture::Format::RGBA, Texture::Type::UBYTE, FREE_CALLBACK);
-            texture->setImage(engine, 0, std::move(pbd));
-            texture->generateMipmaps(engine);
-            entry->completed = true;
-            mNumDecoderTasksFinished++;
-            mCurrentAsset->mDependencyGraph.markAsReady(texture);
+    auto upload = [this](TextureCacheEntry* entry) {
+        if (entry->texture && entry->texels && !entry->completed) {
+            uploadTexture(entry);
         }
     };
-    for (auto& pair : mBufferTextureCache) upload(pair.second.get(), *mEngine);
-    for (auto& pair : mUriTextureCache) upload(pair.second.get(), *mEngine);
+    for (auto& pair : mBufferTextureCache) upload(pair.second.get());
+    for (auto& pair : mUriTextureCache) upload(pair.second.get());
+}
+
+// Creates a downsampled copy of a decoded texture and binds it to the material instances in place
+// of the real texture, which lets renderables be displayed before the full resolution texels have
+// been uploaded. Each texel in the proxy is the average of the 2x2 source texels at its center,
+// which is cheap enough to do on the main thread regardless of the size of the source image.
+void ResourceLoader::Impl::uploadProxyTexture(TextureCacheEntry* entry) {
+    Engine& engine = *mEngine;
+    const int width = entry->texture->getWidth();
+    const int height = entry->texture->getHeight();
+    int factor = 2;
+    while (std::max(width, height) > PROXY_TEXTURE_SIZE * factor) {
+        factor *= 2;
+    }
+    const int proxyWidth = std::max(1, width / factor);
+    const int proxyHeight = std::max(1, height / factor);
+    const uint8_t* src = entry->texels;
+    uint8_t* dst = (uint8_t*) malloc(proxyWidth * proxyHeight * 4);
+    for (int y = 0; y < proxyHeight; y++) {
+        const int y0 = std::min(y * factor + factor / 2 - 1, height - 1);
+        const int y1 = std::min(y0 + 1, height - 1);
+        for (int x = 0; x < proxyWidth; x++) {
+            const int x0 = std::min(x * factor + factor / 2 - 1, width - 1);
+            const int x1 = std::min(x0 + 1, width - 1);
+            uint8_t* texel = dst + (y * proxyWidth + x) * 4;
+            for (int c = 0; c < 4; c++) {
+                const int sum = src[(y0 * width + x0) * 4 + c] + src[(y0 * width + x1) * 4 + c] +
+                        src[(y1 * width + x0) * 4 + c] + src[(y1 * width + x1) * 4 + c];
+                texel[c] = uint8_t((sum + 2) / 4);
+            }
+        }
+    }
+
+    entry->proxy = Texture::Builder()
+            .width(proxyWidth)
+            .height(proxyHeight)
+            .levels(0xff)
+            .format(entry->texture->getFormat())
+            .build(engine);
+    mCurrentAsset->takeOwnership(entry->proxy);
+    entry->proxy->setImage(engine, 0, Texture::PixelBufferDescriptor(dst,
+            proxyWidth * proxyHeight * 4, Texture::Format::RGBA, Texture::Type::UBYTE,
+            FREE_CALLBACK));
+    entry->proxy->generateMipmaps(engine);
+
+    for (const TextureSlot& slot : entry->slots) {
+        slot.materialInstance->setParameter(slot.materialParameter, entry->proxy, slot.sampler);
+    }
+    mCurrentAsset->mDependencyGraph.markAsReady(entry->texture);
+}
+
+// Estimates the screen coverage of each texture as the largest projected radius of the bounding
+// spheres of the visible renderables that use it.
+void ResourceLoader::Impl::computeTexturePriorities(
+        const std::vector<TextureCacheEntry*>& entries, const Camera& camera) {
+    auto& rm = mEngine->getRenderableManager();
+    auto& tm = mEngine->getTransformManager();
+    const ScreenCoverage coverage(camera);
+
+    auto computeCoverage = [&](Entity entity) {
+        auto renderable = rm.getInstance(entity);
+        if (!renderable) {
+            return 0.0f;
+        }
+        const Box box = rm.getAxisAlignedBoundingBox(renderable);
+        auto transformable = tm.getInstance(entity);
+        const mat4f worldTransform = transformable ? tm.getWorldTransform(transformable) : mat4f();
+        Aabb aabb;
+        aabb.min = box.getMin();
+        aabb.max = box.getMax();
+        return coverage.compute(aabb.transform(worldTransform));
+    };
+
+    for (TextureCacheEntry* entry : entries) {
+        for (const TextureSlot& slot : entry->slots) {
+            auto iter = mMaterialEntities.find(slot.materialInstance);
+            if (iter == mMaterialEntities.end()) {
+                continue;
+            }
+            for (Entity entity : iter->second) {
+                entry->priority = std::max(entry->priority, computeCoverage(entity));
+            }
+        }
+    }
+}
+
+// Uploads decoded textures within the per-update budget. Every decoded texture that is large
+// enough gets a proxy right away, then full resolution textures are uploaded in order of
+// decreasing screen coverage when a camera is provided, or in decoding order otherwise.
+void ResourceLoader::Impl::streamPendingTextures(const Camera* camera) {
+    std::vector<TextureCacheEntry*> pending;
+    auto gather = [this, &pending](TextureCacheEntry* entry) {
+        if (!entry->texture || !entry->texels || entry->completed) {
+            return;
+        }
+        const Texture* texture = entry->texture;
+        entry->priority = 0.0f;
+        if (entry->proxy) {
+            pending.push_back(entry);
+        } else if (std::max(texture->getWidth(), texture->getHeight()) <= PROXY_TEXTURE_SIZE) {
+            uploadTexture(entry);
+        } else {
+            uploadProxyTexture(entry);
+            pending.push_back(entry);
+        }
+    };
+    for (auto& pair : mBufferTextureCache) gather(pair.second.get());
+    for (auto& pair : mUriTextureCache) gather(pair.second.get());
+
+    if (camera) {
+        computeTexturePriorities(pending, *camera);
+    }
+    const size_t count = selectTextureUploads(pending, mUploadBudget);
+    for (size_t i = 0; i < count; i++) {
+        uploadTexture(pending[i]);
+    }
 }
 
 void ResourceLoader::Impl::releasePendingTextures() {
@@ -706,6 +970,7 @@ void ResourceLoader::Impl::bindTextureToMaterial(const TextureSlot& tb) {
             auto& entry = iter->second;
             if (entry.get() && entry->texture) {
                 asset->bindTexture(tb, entry->texture);
+                entry->slots.push_back(tb);
             }
         }
         return;
@@ -716,6 +981,7 @@ void ResourceLoader::Impl::bindTextureToMaterial(const TextureSlot& tb) {
         auto& entry = iter->second;
         if (entry.get() && entry->texture) {
             asset->bindTexture(tb, entry->texture);
+            entry->slots.push_back(tb);
         }
     }
 }
@@ -729,6 +995,7 @@ void ResourceLoader::Impl::cancelTextureDecoding() {
     releasePendingTextures();
     mBufferTextureCache.clear();
     mUriTextureCache.clear();
+    mMaterialEntities.clear();
     mCurrentAsset = nullptr;
     mNumDecoderTasksFinished = 0;
     mNumDecoderTasks = 0;
@@ -780,6 +1047,21 @@ bool ResourceLoader::Impl::createTextures(bool async) {
         bindTextureToMaterial(slot);
     }
 
+    // When streaming, gather the renderables that use each material instance.
+    mMaterialEntities.clear();
+    if (async && mUploadBudget) {
+        auto& rm = mEngine->getRenderableManager();
+        for (Entity entity : asset->mEntities) {
+            auto renderable = rm.getInstance(entity);
+            if (!renderable) {
+                continue;
+            }
+            for (size_t i = 0, n = rm.getPrimitiveCount(renderable); i < n; i++) {
+                mMaterialEntities[rm.getMaterialInstanceAt(renderable, i)].push_back(entity);
+            }
+        }
+    }
+
     // Before creating jobs for PNG / JPEG decoding, we might need to return early. On single
     // threaded systems, it is usually fine to create jobs because the job system will simply
     // execute serially. However if the client requests async behavior, then we need to wait
@@ -853,7 +1135,12 @@ bool ResourceLoader::Impl::createTextures(bool async) {
     return true;
 }
 
-void ResourceLoader::Impl::computeTangents(FFilamentAsset* asset) {
+// Builds and runs a job graph that performs all CPU-side processing of vertex data. Each Draco
+// mesh is decoded in its own job, which then kicks off the dependent work (tangent generation and
+// bounding box computation) for its primitives. Uncompressed primitives start this work right
+// away, and sparse accessors are unpacked concurrently. As a result, the load time for large
+// assets scales with the number of cores rather than with the number of primitives.
+void ResourceLoader::Impl::processPrimitives(FFilamentAsset* asset) {
     SYSTRACE_CALL();
 
     const cgltf_accessor* kGenerateTangents = &asset->mGenerateTangents;
@@ -875,7 +1162,7 @@ void ResourceLoader::Impl::computeTangents(FFilamentAsset* asset) {
 
     // Create a job description for each triangle-based primitive.
     using Params = TangentsJob::Params;
-    std::vector<Params> jobParams;
+    mTangentsJobs.clear();
     for (auto pair : asset->mPrimitives) {
         if (UTILS_UNLIKELY(pair.first->type != cgltf_primitive_type_triangles)) {
             continue;
@@ -883,28 +1170,166 @@ void ResourceLoader::Impl::computeTangents(FFilamentAsset* asset) {
         VertexBuffer* vb = pair.second;
         auto iter = baseTangents.find(vb);
         if (iter != baseTangents.end()) {
-            jobParams.emplace_back(Params {{ pair.first }, {vb, iter->second }});
+            mTangentsJobs.emplace_back(Params {{ pair.first }, {vb, iter->second }});
         }
         for (int morphTarget = 0; morphTarget < 4; morphTarget++) {
             const auto& tangents = morphTangents[morphTarget];
             auto iter = tangents.find(vb);
             if (iter != tangents.end()) {
-                jobParams.emplace_back(Params {{ pair.first, morphTarget }, {vb, iter->second }});
+                mTangentsJobs.emplace_back(Params {{ pair.first, morphTarget }, {vb, iter->second }});
             }
         }
     }
 
-    // Kick off jobs for computing tangent frames.
+    // Index the job descriptions by primitive and reserve a bounding box for each primitive. None
+    // of these containers are modified while jobs are running, so jobs can safely read them and
+    // write into their own elements.
+    tsl::robin_map<const cgltf_primitive*, std::vector<Params*>> primitiveTangents;
+    for (Params& params : mTangentsJobs) {
+        primitiveTangents[params.in.prim].push_back(&params);
+    }
+    mPrimitiveBounds.clear();
+    if (mRecomputeBoundingBoxes) {
+        for (auto pair : asset->mPrimitives) {
+            mPrimitiveBounds[pair.first] = {};
+        }
+    }
+
+    // Collect sparse accessors, whose data gets unpacked into a new buffer.
+    mSparseJobs.clear();
+    for (size_t index = 0, n = asset->mBufferSlots.size(); index < n; ++index) {
+        const BufferSlot& slot = asset->mBufferSlots[index];
+        const cgltf_accessor* accessor = slot.accessor;
+        if (accessor->is_sparse) {
+            cgltf_size numFloats = accessor->count * cgltf_num_components(accessor->type);
+            mSparseJobs.push_back({ slot, index, sizeof(float) * numFloats, nullptr });
+        }
+    }
+
+    // Group Draco primitives by their compressed buffer view, since several primitives can
+    // reference the same Draco mesh. Each group is decoded by a single job.
+    struct DracoGroup {
+        DracoMesh* mesh;
+        bool cached;
+        std::vector<std::pair<const cgltf_primitive*, VertexBuffer**>> primitives;
+        // written by the group's job, and logged from this thread after the jobs are done
+        std::vector<std::string> errors;
+        std::vector<std::string> warnings;
+    };
+    DracoCache* dracoCache = &asset->mSourceAsset->dracoCache;
+    tsl::robin_map<const cgltf_buffer_view*, DracoGroup> dracoGroups;
+    std::vector<const cgltf_primitive*> readyPrimitives;
+    for (auto& pair : asset->mPrimitives) {
+        const cgltf_primitive* prim = pair.first;
+        if (!prim->has_draco_mesh_compression) {
+            readyPrimitives.push_back(prim);
+            continue;
+        }
+        const cgltf_buffer_view* view = prim->draco_mesh_compression.buffer_view;
+        DracoGroup& group = dracoGroups[view];
+        if (group.primitives.empty()) {
+            group.mesh = dracoCache->findMesh(view);
+            group.cached = group.mesh != nullptr;
+        }
+        group.primitives.emplace_back(prim, &pair.second);
+    }
+
     JobSystem* js = &mEngine->getJobSystem();
     JobSystem::Job* parent = js->createJob();
-    for (Params& params : jobParams) {
-        Params* pptr = &params;
-        js->run(jobs::createJob(*js, parent, [pptr] { TangentsJob::run(pptr); }));
+
+    // Kicks off the work for a primitive whose vertex data is available. This may be called from
+    // within a Draco job, in which case the new jobs are also children of the root job.
+    auto runPrimitiveJobs = [js, parent, &primitiveTangents, this](const cgltf_primitive* prim) {
+        if (auto iter = primitiveTangents.find(prim); iter != primitiveTangents.end()) {
+            for (Params* pptr : iter->second) {
+                js->run(jobs::createJob(*js, parent, [pptr] { TangentsJob::run(pptr); }));
+            }
+        }
+        if (auto iter = mPrimitiveBounds.find(prim); iter != mPrimitiveBounds.end()) {
+            Aabb* result = &iter.value();
+            js->run(jobs::createJob(*js, parent, [prim, result] {
+                computeBoundingBox(prim, result);
+            }));
+        }
+    };
+
+    for (auto iter = dracoGroups.begin(); iter != dracoGroups.end(); ++iter) {
+        const cgltf_buffer_view* view = iter->first;
+        DracoGroup* group = &iter.value();
+        js->run(jobs::createJob(*js, parent, [asset, view, group, &runPrimitiveJobs] {
+            if (!group->mesh) {
+                assert(view->buffer && view->buffer->data);
+                const uint8_t* compressedData = view->offset + (const uint8_t*) view->buffer->data;
+                group->mesh = DracoMesh::decode(compressedData, view->size);
+            }
+            for (auto [prim, vertexBuffer] : group->primitives) {
+                // If an error occurs, we can simply set the primitive's associated VertexBuffer to
+                // null. This does not cause a leak because it is a weak reference.
+                std::string error;
+                if (!decodeDracoPrimitive(asset, prim, group->mesh, &error, &group->warnings)) {
+                    group->errors.push_back(std::move(error));
+                    *vertexBuffer = nullptr;
+                    continue;
+                }
+                runPrimitiveJobs(prim);
+            }
+        }));
     }
+
+    for (const cgltf_primitive* prim : readyPrimitives) {
+        runPrimitiveJobs(prim);
+    }
+
+    for (SparseJob& job : mSparseJobs) {
+        SparseJob* jptr = &job;
+        js->run(jobs::createJob(*js, parent, [jptr] {
+            const cgltf_accessor* accessor = jptr->slot.accessor;
+            jptr->generated = (float*) malloc(jptr->numBytes);
+            cgltf_accessor_unpack_floats(accessor, jptr->generated,
+                    jptr->numBytes / sizeof(float));
+        }));
+    }
+
     js->runAndWait(parent);
 
-    // Finally, upload quaternions to the GPU from the main thread.
-    for (Params& params : jobParams) {
+    // Report the problems found by the Draco jobs, and hand the decoded meshes over to the cache,
+    // which owns the decompressed vertex data.
+    for (auto& pair : dracoGroups) {
+        const DracoGroup& group = pair.second;
+        for (std::string const& warning : group.warnings) {
+            slog.w << warning << io::endl;
+        }
+        for (std::string const& error : group.errors) {
+            slog.e << error << io::endl;
+        }
+        if (group.mesh && !group.cached) {
+            dracoCache->insertMesh(pair.first, group.mesh);
+        }
+    }
+}
+
+void ResourceLoader::Impl::uploadTangents(FFilamentAsset* asset) {
+    // When recording, find the buffer slot that corresponds to each tangents job.
+    tsl::robin_map<VertexBuffer*, tsl::robin_map<uint8_t, size_t>> slotIndices;
+    if (mRecording) {
+        for (size_t index = 0, n = asset->mBufferSlots.size(); index < n; ++index) {
+            const BufferSlot& slot = asset->mBufferSlots[index];
+            if (slot.vertexBuffer) {
+                slotIndices[slot.vertexBuffer][slot.bufferIndex] = index;
+            }
+        }
+    }
+
+    // Upload quaternions to the GPU from the main thread.
+    for (TangentsJob::Params& params : mTangentsJobs) {
+        // Skip primitives that have no vertices or that could not be decoded.
+        if (!params.out.results) {
+            continue;
+        }
+        if (mRecording) {
+            recordSlot(slotIndices[params.context.vb][params.context.slot], params.out.results,
+                    params.out.vertexCount * sizeof(short4));
+        }
         BufferObject* bo = BufferObject::Builder()
                 .size(params.out.vertexCount * sizeof(short4)).build(*mEngine);
         asset->mBufferObjects.push_back(bo);
@@ -912,6 +1337,7 @@ void ResourceLoader::Impl::computeTangents(FFilamentAsset* asset) {
                 params.out.results, bo->getByteCount(), FREE_CALLBACK));
         params.context.vb->setBufferObjectAt(*mEngine, params.context.slot, bo);
     }
+    mTangentsJobs.clear();
 }
 
 ResourceLoader::Impl::~Impl() {
@@ -921,20 +1347,16 @@ ResourceLoader::Impl::~Impl() {
 }
 
 void ResourceLoader::applySparseData(FFilamentAsset* asset) const {
-    for (auto slot : asset->mBufferSlots) {
-        const cgltf_accessor* accessor = slot.accessor;
-        if (!accessor->is_sparse) {
-            continue;
-        }
-        cgltf_size numFloats = accessor->count * cgltf_num_components(accessor->type);
-        cgltf_size numBytes = sizeof(float) * numFloats;
-        float* generated = (float*) malloc(numBytes);
-        cgltf_accessor_unpack_floats(accessor, generated, numFloats);
-        BufferObject* bo = BufferObject::Builder().size(numBytes).build(*asset->mEngine);
+    // The sparse data has already been unpacked into float arrays by processPrimitives.
+    for (const Impl::SparseJob& job : pImpl->mSparseJobs) {
+        pImpl->recordSlot(job.slotIndex, job.generated, job.numBytes);
+        BufferObject* bo = BufferObject::Builder().size(job.numBytes).build(*asset->mEngine);
         asset->mBufferObjects.push_back(bo);
-        bo->setBuffer(*pImpl->mEngine, BufferDescriptor(generated, numBytes, FREE_CALLBACK));
-        slot.vertexBuffer->setBufferObjectAt(*pImpl->mEngine, slot.bufferIndex, bo);
+        bo->setBuffer(*pImpl->mEngine, BufferDescriptor(job.generated, job.numBytes,
+                FREE_CALLBACK));
+        job.slot.vertexBuffer->setBufferObjectAt(*pImpl->mEngine, job.slot.bufferIndex, bo);
     }
+    pImpl->mSparseJobs.clear();
 }
 
 void ResourceLoader::normalizeSkinningWeights(FFilamentAsset* asset) const {
@@ -943,8 +1365,8 @@ void ResourceLoader::normalizeSkinningWeights(FFilamentAsset* asset) const {
             slog.w << "Cannot normalize weights, unsupported attribute type." << io::endl;
             return;
         }
-        uint8_t* bytes = (uint8_t*) data->buffer_view->buffer->data;
-        bytes += data->offset + data->buffer_view->offset;
+        uint8_t* bytes = (uint8_t*) computeBufferViewData(data->buffer_view);
+        bytes += data->offset;
         for (cgltf_size i = 0, n = data->count; i < n; ++i, bytes += data->stride) {
             float4* weights = (float4*) bytes;
             const float sum = weights->x + weights->y + weights->z + weights->w;
@@ -974,6 +1396,7 @@ void ResourceLoader::updateBoundingBoxes(FFilamentAsset* asset) const {
     auto& rm = pImpl->mEngine->getRenderableManager();
     auto& tm = pImpl->mEngine->getTransformManager();
     NodeMap& nodeMap = asset->isInstanced() ? asset->mInstances[0]->nodeMap : asset->mNodeMap;
+    const cgltf_data* gltf = asset->mSourceAsset->hierarchy;
 
     // The purpose of the root node is to give the client a place for custom transforms.
     // Since it is not part of the source model, it should be ignored when computing the
@@ -985,52 +1408,10 @@ void ResourceLoader::updateBoundingBoxes(FFilamentAsset* asset) const {
         tm.setParent(tm.getInstance(e), 0);
     }
 
-    auto computeBoundingBox = [](const cgltf_primitive* prim, Aabb* result) {
-        Aabb aabb;
-        for (cgltf_size slot = 0; slot < prim->attributes_count; slot++) {
-            const cgltf_attribute& attr = prim->attributes[slot];
-            const cgltf_accessor* accessor = attr.data;
-            const size_t dim = cgltf_num_components(accessor->type);
-            if (attr.type == cgltf_attribute_type_position && dim >= 3) {
-                std::vector<float> unpacked(accessor->count * dim);
-                cgltf_accessor_unpack_floats(accessor, unpacked.data(), unpacked.size());
-                for (cgltf_size i = 0, j = 0, n = accessor->count; i < n; ++i, j += dim) {
-                    float3 pt(unpacked[j + 0], unpacked[j + 1], unpacked[j + 2]);
-                    aabb.min = min(aabb.min, pt);
-                    aabb.max = max(aabb.max, pt);
-                }
-                break;
-            }
-        }
-        *result = aabb;
-    };
-
-    // Collect all mesh primitives that we wish to find bounds for.
-    std::vector<cgltf_primitive const*> prims;
-    for (auto iter : nodeMap) {
-        const cgltf_mesh* mesh = iter.first->mesh;
-        if (mesh) {
-            for (cgltf_size index = 0, nprims = mesh->primitives_count; index < nprims; ++index) {
-                prims.push_back(&mesh->primitives[index]);
-            }
-        }
-    }
-
-    // Kick off a bounding box job for every primitive.
-    std::vector<Aabb> bounds(prims.size());
-    JobSystem* js = &pImpl->mEngine->getJobSystem();
-    JobSystem::Job* parent = js->createJob();
-    for (size_t i = 0; i < prims.size(); ++i) {
-        cgltf_primitive const* prim = prims[i];
-        Aabb* result = &bounds[i];
-        js->run(jobs::createJob(*js, parent, [prim, result, computeBoundingBox] {
-            computeBoundingBox(prim, result);
-        }));
-    }
-    js->runAndWait(parent);
-
-    // Compute the asset-level bounding box.
-    size_t primIndex = 0;
+    // Compute the asset-level bounding box. The bounds of individual primitives have already been
+    // computed by processPrimitives, which reserves an entry for every primitive of the asset. The
+    // entry of a primitive whose Draco data could not be decoded stays empty, since it has no
+    // vertices to draw.
     Aabb assetBounds;
     for (auto iter : nodeMap) {
         const cgltf_mesh* mesh = iter.first->mesh;
@@ -1038,12 +1419,16 @@ void ResourceLoader::updateBoundingBoxes(FFilamentAsset* asset) const {
             // Find the object-space bounds for the renderable by unioning the bounds of each prim.
             Aabb aabb;
             for (cgltf_size index = 0, nprims = mesh->primitives_count; index < nprims; ++index) {
-                Aabb primBounds = bounds[primIndex++];
+                const cgltf_primitive* prim = &mesh->primitives[index];
+                const Aabb& primBounds = pImpl->mPrimitiveBounds[prim];
                 aabb.min = min(aabb.min, primBounds.min);
                 aabb.max = max(aabb.max, primBounds.max);
             }
             auto renderable = rm.getInstance(iter.second);
             rm.setAxisAlignedBoundingBox(renderable, Box().set(aabb.min, aabb.max));
+            if (pImpl->mRecording) {
+                pImpl->mRecording->addBounds(uint32_t(iter.first - gltf->nodes), aabb);
+            }
 
             // Transform this bounding box, then update the asset-level bounding box.
             auto transformable = tm.getInstance(iter.second);
@@ -1058,7 +1443,72 @@ void ResourceLoader::updateBoundingBoxes(FFilamentAsset* asset) const {
         tm.setParent(tm.getInstance(e), root);
     }
 
+    pImpl->mPrimitiveBounds.clear();
     asset->mBoundingBox = assetBounds;
+    if (pImpl->mRecording) {
+        pImpl->mRecording->addBounds(BakedResources::ASSET_BOUNDS, assetBounds);
+    }
+}
+
+bool ResourceLoader::loadBakedResources(FFilamentAsset* asset) {
+    SYSTRACE_CALL();
+    const BakedSnapshot& snapshot = pImpl->mBakedSnapshot;
+    const uint8_t* blob = (const uint8_t*) snapshot->buffer;
+    if (!BakedResources::validate(blob, snapshot->size, asset->mSourceHash,
+            asset->mBufferSlots.size())) {
+        slog.w << "Ignoring baked resources that do not match the asset." << io::endl;
+        return false;
+    }
+
+    Engine& engine = *pImpl->mEngine;
+    for (size_t index = 0, n = asset->mBufferSlots.size(); index < n; ++index) {
+        const BufferSlot& slot = asset->mBufferSlots[index];
+        const BakedResources::SlotEntry entry = BakedResources::getSlot(blob, index);
+        const uint32_t size = uint32_t(entry.size);
+        const uint8_t* data = blob + entry.offset;
+        if (size == 0) {
+            continue;
+        }
+        pImpl->recordSlot(index, data, size);
+        if (slot.vertexBuffer) {
+            BufferObject* bo = BufferObject::Builder().size(size).build(engine);
+            asset->mBufferObjects.push_back(bo);
+            bo->setBuffer(engine, BufferDescriptor(data, size,
+                    bakedUploadCallback, new BakedSnapshot(snapshot)));
+            slot.vertexBuffer->setBufferObjectAt(engine, slot.bufferIndex, bo);
+            continue;
+        }
+        assert(slot.indexBuffer);
+        slot.indexBuffer->setBuffer(engine, IndexBuffer::BufferDescriptor(data, size,
+                bakedUploadCallback, new BakedSnapshot(snapshot)));
+    }
+
+    auto& rm = engine.getRenderableManager();
+    const cgltf_data* gltf = asset->mSourceAsset->hierarchy;
+    const NodeMap& nodeMap = asset->isInstanced() ?
+            asset->mInstances[0]->nodeMap : asset->mNodeMap;
+    for (size_t i = 0, n = BakedResources::getHeader(blob).boundsCount; i < n; ++i) {
+        const BakedResources::BoundsEntry bounds = BakedResources::getBounds(blob, i);
+        Aabb aabb;
+        aabb.min = float3(bounds.min[0], bounds.min[1], bounds.min[2]);
+        aabb.max = float3(bounds.max[0], bounds.max[1], bounds.max[2]);
+        if (pImpl->mRecording) {
+            pImpl->mRecording->addBounds(bounds.node, aabb);
+        }
+        if (bounds.node == BakedResources::ASSET_BOUNDS) {
+            asset->mBoundingBox = aabb;
+            continue;
+        }
+        if (bounds.node >= gltf->nodes_count) {
+            continue;
+        }
+        auto iter = nodeMap.find(&gltf->nodes[bounds.node]);
+        if (iter != nodeMap.end()) {
+            auto renderable = rm.getInstance(iter->second);
+            rm.setAxisAlignedBoundingBox(renderable, Box().set(aabb.min, aabb.max));
+        }
+    }
+    return true;
 }
 
 } // namespace gltfio
@@ -0,0 +1,43 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "TextureStreaming.h"
+
+#include <filament/Camera.h>
+
+#include <math/vec4.h>
+
+using namespace filament;
+using namespace filament::math;
+
+namespace gltfio {
+
+ScreenCoverage::ScreenCoverage(const Camera& camera) :
+        mFrustum(camera.getFrustum()),
+        mEye(camera.getPosition()),
+        mFocal(float(camera.getProjectionMatrix()[1][1])) {
+}
+
+float ScreenCoverage::compute(const Aabb& bounds) const noexcept {
+    const float3 center = (bounds.min + bounds.max) * 0.5f;
+    const float radius = length(bounds.max - bounds.min) * 0.5f;
+    if (!mFrustum.intersects(float4(center, radius))) {
+        return 0.0f;
+    }
+    return mFocal * radius / std::max(length(center - mEye), 1e-3f);
+}
+
+} // namespace gltfio
@@ -0,0 +1,73 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef GLTFIO_TEXTURESTREAMING_H
+#define GLTFIO_TEXTURESTREAMING_H
+
+#include <filament/Box.h>
+#include <filament/Frustum.h>
+
+#include <math/vec3.h>
+
+#include <algorithm>
+#include <vector>
+
+#include <stddef.h>
+
+namespace filament { class Camera; }
+
+namespace gltfio {
+
+// Estimates the screen coverage of world space bounding boxes from the point of view of a camera,
+// which is used to decide which textures to upload first while streaming. The coverage is the
+// projected radius of the bounding sphere of the box, or zero if it is outside of the frustum.
+class ScreenCoverage {
+public:
+    explicit ScreenCoverage(const filament::Camera& camera);
+
+    float compute(const filament::Aabb& bounds) const noexcept;
+
+private:
+    filament::Frustum mFrustum;
+    filament::math::float3 mEye;
+    float mFocal;
+};
+
+// Sorts the textures that are waiting for their full resolution upload by decreasing priority,
+// keeping the decoding order of textures with the same priority, and returns how many of the
+// first ones can be uploaded within the budget. At least one texture is selected, regardless of
+// its size. Each entry must provide its RGBA8 dimensions (width and height) and its priority.
+template<typename Entry>
+size_t selectTextureUploads(std::vector<Entry*>& pending, size_t budget) {
+    std::stable_sort(pending.begin(), pending.end(), [](const Entry* a, const Entry* b) {
+        return a->priority > b->priority;
+    });
+    size_t uploadedBytes = 0;
+    size_t count = 0;
+    for (const Entry* entry : pending) {
+        const size_t size = size_t(entry->width) * size_t(entry->height) * 4;
+        if (count > 0 && uploadedBytes + size > budget) {
+            break;
+        }
+        uploadedBytes += size;
+        count++;
+    }
+    return count;
+}
+
+} // namespace gltfio
+
+#endif // GLTFIO_TEXTURESTREAMING_H
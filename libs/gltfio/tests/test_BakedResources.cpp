@@ -0,0 +1,295 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "BakedResources.h"
+
+#include <filament/Engine.h>
+
+#include <gltfio/AssetLoader.h>
+#include <gltfio/FilamentAsset.h>
+#include <gltfio/MaterialProvider.h>
+#include <gltfio/ResourceLoader.h>
+
+#include <gtest/gtest.h>
+
+#include <stddef.h>
+#include <string.h>
+
+#include <deque>
+#include <string>
+#include <vector>
+
+using namespace filament;
+using namespace gltfio;
+using namespace utils;
+
+using BufferDescriptor = ResourceLoader::BufferDescriptor;
+
+// A single triangle spanning [0,0,0] to [1,2,3], with 16-bit indices.
+static const char* TRIANGLE_GLTF = R"({
+    "asset": { "version": "2.0" },
+    "scene": 0,
+    "scenes": [ { "nodes": [0] } ],
+    "nodes": [ { "mesh": 0 } ],
+    "meshes": [ { "primitives": [ { "attributes": { "POSITION": 0 }, "indices": 1 } ] } ],
+    "buffers": [ {
+        "byteLength": 44,
+        "uri": "data:application/octet-stream;base64,AAAAAAAAAAAAAAAAAACAPwAAAAAAAAAAAAAAAAAAAEAAAEBAAAABAAIAAAA="
+    } ],
+    "bufferViews": [
+        { "buffer": 0, "byteOffset": 0, "byteLength": 36 },
+        { "buffer": 0, "byteOffset": 36, "byteLength": 6 }
+    ],
+    "accessors": [
+        { "bufferView": 0, "componentType": 5126, "count": 3, "type": "VEC3",
+          "min": [0, 0, 0], "max": [1, 2, 3] },
+        { "bufferView": 1, "componentType": 5123, "count": 3, "type": "SCALAR" }
+    ]
+})";
+
+static const uint64_t SOURCE_HASH = 0x0123456789abcdefull;
+
+static std::vector<uint8_t> toVector(const FixedCapacityVector<uint8_t>& blob) {
+    return std::vector<uint8_t>(blob.begin(), blob.end());
+}
+
+// Patches the offset of the given slot in a serialized snapshot.
+static void setSlotOffset(std::vector<uint8_t>& blob, size_t index, uint64_t offset) {
+    const size_t position = sizeof(BakedResources::Header) +
+            index * sizeof(BakedResources::SlotEntry);
+    memcpy(blob.data() + position + offsetof(BakedResources::SlotEntry, offset),
+            &offset, sizeof(offset));
+}
+
+static std::vector<uint8_t> createSnapshot() {
+    const uint8_t positions[12] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11 };
+    const uint8_t indices[6] = { 0, 0, 1, 0, 2, 0 };
+    BakedResources recording(3);
+    recording.setSlotData(0, positions, sizeof(positions));
+    recording.setSlotData(2, indices, sizeof(indices));
+    recording.addBounds(0, Aabb{{ -1, -2, -3 }, { 1, 2, 3 }});
+    recording.addBounds(BakedResources::ASSET_BOUNDS, Aabb{{ -4, -5, -6 }, { 4, 5, 6 }});
+    return toVector(recording.serialize(SOURCE_HASH));
+}
+
+TEST(BakedResourcesTest, RoundTrip) {
+    const std::vector<uint8_t> snapshot = createSnapshot();
+
+    // Read the snapshot at an odd address, since clients don't need to align it.
+    std::vector<uint8_t> storage(snapshot.size() + 1);
+    memcpy(storage.data() + 1, snapshot.data(), snapshot.size());
+    const uint8_t* blob = storage.data() + 1;
+
+    ASSERT_TRUE(BakedResources::validate(blob, snapshot.size(), SOURCE_HASH, 3));
+
+    const BakedResources::Header header = BakedResources::getHeader(blob);
+    EXPECT_EQ(header.slotCount, 3u);
+    EXPECT_EQ(header.boundsCount, 2u);
+
+    const BakedResources::SlotEntry positions = BakedResources::getSlot(blob, 0);
+    ASSERT_EQ(positions.size, 12u);
+    for (uint8_t i = 0; i < 12; i++) {
+        EXPECT_EQ(blob[positions.offset + i], i);
+    }
+    EXPECT_EQ(BakedResources::getSlot(blob, 1).size, 0u);
+    const BakedResources::SlotEntry indices = BakedResources::getSlot(blob, 2);
+    ASSERT_EQ(indices.size, 6u);
+    EXPECT_EQ(blob[indices.offset + 2], 1);
+    EXPECT_EQ(blob[indices.offset + 4], 2);
+
+    const BakedResources::BoundsEntry node = BakedResources::getBounds(blob, 0);
+    EXPECT_EQ(node.node, 0u);
+    EXPECT_EQ(node.min[2], -3.0f);
+    EXPECT_EQ(node.max[1], 2.0f);
+    const BakedResources::BoundsEntry asset = BakedResources::getBounds(blob, 1);
+    EXPECT_EQ(asset.node, BakedResources::ASSET_BOUNDS);
+    EXPECT_EQ(asset.min[0], -4.0f);
+    EXPECT_EQ(asset.max[2], 6.0f);
+}
+
+TEST(BakedResourcesTest, RejectsTruncatedSnapshots) {
+    const std::vector<uint8_t> snapshot = createSnapshot();
+    EXPECT_FALSE(BakedResources::validate(nullptr, snapshot.size(), SOURCE_HASH, 3));
+
+    // Only the padding that follows the last slot can be dropped.
+    const BakedResources::SlotEntry last = BakedResources::getSlot(snapshot.data(), 2);
+    const size_t end = size_t(last.offset + last.size);
+    ASSERT_LE(end, snapshot.size());
+    EXPECT_TRUE(BakedResources::validate(snapshot.data(), end, SOURCE_HASH, 3));
+    for (size_t size = 0; size < end; size++) {
+        EXPECT_FALSE(BakedResources::validate(snapshot.data(), size, SOURCE_HASH, 3)) << size;
+    }
+}
+
+TEST(BakedResourcesTest, RejectsMismatchedSnapshots) {
+    std::vector<uint8_t> snapshot = createSnapshot();
+    EXPECT_FALSE(BakedResources::validate(snapshot.data(), snapshot.size(), SOURCE_HASH + 1, 3));
+    EXPECT_FALSE(BakedResources::validate(snapshot.data(), snapshot.size(), SOURCE_HASH, 2));
+    EXPECT_FALSE(BakedResources::validate(snapshot.data(), snapshot.size(), SOURCE_HASH, 4));
+
+    const uint32_t version = BakedResources::VERSION + 1;
+    memcpy(snapshot.data() + offsetof(BakedResources::Header, version), &version, sizeof(version));
+    EXPECT_FALSE(BakedResources::validate(snapshot.data(), snapshot.size(), SOURCE_HASH, 3));
+
+    snapshot = createSnapshot();
+    snapshot[0] ^= 0xff;
+    EXPECT_FALSE(BakedResources::validate(snapshot.data(), snapshot.size(), SOURCE_HASH, 3));
+}
+
+TEST(BakedResourcesTest, RejectsOutOfRangeSlots) {
+    std::vector<uint8_t> snapshot = createSnapshot();
+    const BakedResources::SlotEntry indices = BakedResources::getSlot(snapshot.data(), 2);
+
+    // The data would end past the snapshot.
+    setSlotOffset(snapshot, 2, snapshot.size() - indices.size + 1);
+    EXPECT_FALSE(BakedResources::validate(snapshot.data(), snapshot.size(), SOURCE_HASH, 3));
+
+    // The offset would wrap around when added to the size.
+    setSlotOffset(snapshot, 2, ~uint64_t(0));
+    EXPECT_FALSE(BakedResources::validate(snapshot.data(), snapshot.size(), SOURCE_HASH, 3));
+
+    setSlotOffset(snapshot, 2, snapshot.size() - indices.size);
+    EXPECT_TRUE(BakedResources::validate(snapshot.data(), snapshot.size(), SOURCE_HASH, 3));
+}
+
+class BakedResourcesLoadTest : public testing::Test {
+protected:
+    void SetUp() override {
+        mEngine = Engine::create(Engine::Backend::NOOP);
+        ASSERT_NE(mEngine, nullptr);
+        mMaterials = createUbershaderLoader(mEngine);
+        mAssetLoader = AssetLoader::create({ mEngine, mMaterials });
+    }
+
+    void TearDown() override {
+        for (FilamentAsset* asset : mAssets) {
+            mAssetLoader->destroyAsset(asset);
+        }
+        AssetLoader::destroy(&mAssetLoader);
+        mMaterials->destroyMaterials();
+        delete mMaterials;
+        Engine::destroy(&mEngine);
+    }
+
+    FilamentAsset* createAsset(const std::string& json) {
+        FilamentAsset* asset = mAssetLoader->createAssetFromJson(
+                (const uint8_t*) json.data(), uint32_t(json.size()));
+        if (asset) {
+            mAssets.push_back(asset);
+        }
+        return asset;
+    }
+
+    // Loads the triangle, optionally from the given snapshot, and returns its bounding box.
+    Aabb load(const std::vector<uint8_t>* snapshot, std::vector<uint8_t>* baked = nullptr,
+            const std::string& json = TRIANGLE_GLTF) {
+        FilamentAsset* asset = createAsset(json);
+        EXPECT_NE(asset, nullptr);
+        if (!asset) {
+            return {};
+        }
+        ResourceLoader loader({ mEngine, nullptr, false, true, baked != nullptr });
+        if (snapshot) {
+            // The snapshot is uploaded without a copy, it must outlive the Engine's flush.
+            mSnapshots.push_back(*snapshot);
+            loader.addBakedResources(BufferDescriptor(mSnapshots.back().data(),
+                    mSnapshots.back().size()));
+        }
+        EXPECT_TRUE(loader.loadResources(asset));
+        if (baked) {
+            BufferDescriptor result = loader.bakeResources();
+            const uint8_t* data = (const uint8_t*) result.buffer;
+            baked->assign(data, data + result.size);
+        }
+        mEngine->flushAndWait();
+        return asset->getBoundingBox();
+    }
+
+    // Replaces the asset bounds of a serialized snapshot.
+    static void setAssetBounds(std::vector<uint8_t>& blob, const Aabb& aabb) {
+        const BakedResources::Header header = BakedResources::getHeader(blob.data());
+        for (size_t i = 0; i < header.boundsCount; i++) {
+            BakedResources::BoundsEntry entry = BakedResources::getBounds(blob.data(), i);
+            if (entry.node == BakedResources::ASSET_BOUNDS) {
+                memcpy(entry.min, &aabb.min, sizeof(entry.min));
+                memcpy(entry.max, &aabb.max, sizeof(entry.max));
+                const size_t offset = sizeof(BakedResources::Header) +
+                        header.slotCount * sizeof(BakedResources::SlotEntry) +
+                        i * sizeof(BakedResources::BoundsEntry);
+                memcpy(blob.data() + offset, &entry, sizeof(entry));
+            }
+        }
+    }
+
+    static void expectBounds(const Aabb& actual, const Aabb& expected) {
+        EXPECT_EQ(actual.min.x, expected.min.x);
+        EXPECT_EQ(actual.min.y, expected.min.y);
+        EXPECT_EQ(actual.min.z, expected.min.z);
+        EXPECT_EQ(actual.max.x, expected.max.x);
+        EXPECT_EQ(actual.max.y, expected.max.y);
+        EXPECT_EQ(actual.max.z, expected.max.z);
+    }
+
+    Engine* mEngine = nullptr;
+    MaterialProvider* mMaterials = nullptr;
+    AssetLoader* mAssetLoader = nullptr;
+    std::vector<FilamentAsset*> mAssets;
+    std::deque<std::vector<uint8_t>> mSnapshots;
+};
+
+TEST_F(BakedResourcesLoadTest, BakeAndReload) {
+    const Aabb computed = {{ 0, 0, 0 }, { 1, 2, 3 }};
+    std::vector<uint8_t> snapshot;
+    expectBounds(load(nullptr, &snapshot), computed);
+    ASSERT_FALSE(snapshot.empty());
+
+    // Alter the baked bounds to tell them apart from the ones computed by ResourceLoader.
+    const Aabb baked = {{ -1, -1, -1 }, { 5, 6, 7 }};
+    setAssetBounds(snapshot, baked);
+
+    // Playback records the snapshot again, so it can be re-baked as is.
+    std::vector<uint8_t> rebaked;
+    expectBounds(load(&snapshot, &rebaked), baked);
+    EXPECT_EQ(rebaked, snapshot);
+}
+
+TEST_F(BakedResourcesLoadTest, IgnoresInvalidSnapshots) {
+    const Aabb computed = {{ 0, 0, 0 }, { 1, 2, 3 }};
+    std::vector<uint8_t> snapshot;
+    load(nullptr, &snapshot);
+    ASSERT_FALSE(snapshot.empty());
+    setAssetBounds(snapshot, {{ -1, -1, -1 }, { 5, 6, 7 }});
+
+    // Each of these must fall back to processing the glTF resources.
+    std::vector<uint8_t> truncated(snapshot.begin(), snapshot.end() - 1);
+    expectBounds(load(&truncated), computed);
+
+    std::vector<uint8_t> outOfRange = snapshot;
+    const BakedResources::Header header = BakedResources::getHeader(outOfRange.data());
+    for (size_t i = 0; i < header.slotCount; i++) {
+        if (BakedResources::getSlot(outOfRange.data(), i).size) {
+            setSlotOffset(outOfRange, i, outOfRange.size());
+        }
+    }
+    expectBounds(load(&outOfRange), computed);
+
+    // Any change to the JSON changes its hash.
+    std::string json = TRIANGLE_GLTF;
+    json.insert(json.find('{') + 1, " ");
+    expectBounds(load(&snapshot, nullptr, json), computed);
+
+    expectBounds(load(&snapshot), {{ -1, -1, -1 }, { 5, 6, 7 }});
+}
@@ -0,0 +1,222 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "FFilamentAsset.h"
+#include "TextureStreaming.h"
+
+#include <filament/Camera.h>
+#include <filament/Engine.h>
+#include <filament/Texture.h>
+
+#include <gltfio/AssetLoader.h>
+#include <gltfio/FilamentAsset.h>
+#include <gltfio/MaterialProvider.h>
+#include <gltfio/ResourceLoader.h>
+
+#include <utils/EntityManager.h>
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace filament;
+using namespace filament::math;
+using namespace gltfio;
+using namespace utils;
+
+// Two textured triangles, each with its own 128x128 PNG texture.
+static const char* TEXTURED_GLTF = R"({
+    "asset": { "version": "2.0" },
+    "scene": 0,
+    "scenes": [ { "nodes": [0, 1] } ],
+    "nodes": [ { "mesh": 0 }, { "mesh": 1, "translation": [0, 0, -10] } ],
+    "meshes": [
+        { "primitives": [ { "attributes": { "POSITION": 0, "TEXCOORD_0": 1 }, "indices": 2,
+                            "material": 0 } ] },
+        { "primitives": [ { "attributes": { "POSITION": 0, "TEXCOORD_0": 1 }, "indices": 2,
+                            "material": 1 } ] }
+    ],
+    "materials": [
+        { "pbrMetallicRoughness": { "baseColorTexture": { "index": 0 } } },
+        { "pbrMetallicRoughness": { "baseColorTexture": { "index": 1 } } }
+    ],
+    "textures": [ { "source": 0 }, { "source": 1 } ],
+    "images": [
+        { "uri": "data:image/png;base64,iVBORw0KGgoAAAANSUhEUgAAAIAAAACACAYAAADDPmHLAAAA7klEQVR42u3SMQ0AAAjAsPk3DTZI6DEDS5sa/S0TADACAAEgAASAABAAAkAACAABIAAEgAAQAAJAAAgAASAABIAAEAACQAAIAAEgAASAABAAAkAACAABIAAEgAAQAAJAAAgAASAABIAAEAACQAAIAAEgAASAABAAAkAACAABIAAEgAAQAAJAAAgAASAABIAAEAACQAAIAAEgAASAABAAAkAACAABIAAEAAAmAGAEAAJAAAgAASAABIAAEAACQAAIAAEgAASAABAAAkAACAABIAAEgAAQAAJAAAgAASAABIAAEAACQAAIAAEgAASAbrRW0YdyUv8SrQAAAABJRU5ErkJggg==" },
+        { "uri": "data:image/png;base64,iVBORw0KGgoAAAANSUhEUgAAAIAAAACACAYAAADDPmHLAAAA7ElEQVR42u3SMQ0AAAzDsPIn3dGoNB8mECVJy2ciGAADYAAMgAEwAAbAABgAA2AADIABMAAGwAAYAANgAAyAATAABsAAGAADYAAMgAEwAAbAABgAA2AADIABMAAGwAAYAANgAAyAATAABsAAGAADYAAMgAEwAAbAABgAA2AADIABMAAGwAAYAANgAAyAATAABsAAGAADYAAMgAEwAAbAABgAA2AADIABEMEAGAADYAAMgAEwAAbAABgAA2AADIABMAAGwAAYAANgAAyAATAABsAAGAADYAAMgAEwAAbAABgAA2AADIABMAAGYMIBz1GHcutvvBIAAAAASUVORK5CYII=" }
+    ],
+    "buffers": [ {
+        "byteLength": 68,
+        "uri": "data:application/octet-stream;base64,AAAAAAAAAAAAAAAAAACAPwAAAAAAAAAAAAAAAAAAAEAAAEBAAAAAAAAAAAAAAIA/AAAAAAAAAAAAAIA/AAABAAIAAAA="
+    } ],
+    "bufferViews": [
+        { "buffer": 0, "byteOffset": 0, "byteLength": 36 },
+        { "buffer": 0, "byteOffset": 36, "byteLength": 24 },
+        { "buffer": 0, "byteOffset": 60, "byteLength": 6 }
+    ],
+    "accessors": [
+        { "bufferView": 0, "componentType": 5126, "count": 3, "type": "VEC3",
+          "min": [0, 0, 0], "max": [1, 2, 3] },
+        { "bufferView": 1, "componentType": 5126, "count": 3, "type": "VEC2" },
+        { "bufferView": 2, "componentType": 5123, "count": 3, "type": "SCALAR" }
+    ]
+})";
+
+static constexpr int TEXTURE_COUNT = 2;
+static constexpr int TEXTURE_SIZE = 128;
+
+struct PendingTexture {
+    int width;
+    int height;
+    float priority;
+};
+
+static std::vector<PendingTexture*> pointers(std::vector<PendingTexture>& textures) {
+    std::vector<PendingTexture*> result;
+    for (PendingTexture& texture : textures) {
+        result.push_back(&texture);
+    }
+    return result;
+}
+
+TEST(TextureStreamingTest, BudgetLimitsUploads) {
+    // 16 KiB each.
+    std::vector<PendingTexture> textures = {{ 64, 64, 0 }, { 64, 64, 0 }, { 64, 64, 0 }};
+    std::vector<PendingTexture*> pending = pointers(textures);
+
+    EXPECT_EQ(selectTextureUploads(pending, 16384), 1u);
+    EXPECT_EQ(selectTextureUploads(pending, 40000), 2u);
+    EXPECT_EQ(selectTextureUploads(pending, 49152), 3u);
+
+    // At least one texture is uploaded, even when it exceeds the budget.
+    EXPECT_EQ(selectTextureUploads(pending, 1), 1u);
+
+    // The budget is not exceeded to upload smaller textures that come later.
+    textures = {{ 64, 64, 0 }, { 128, 128, 0 }, { 1, 1, 0 }};
+    pending = pointers(textures);
+    EXPECT_EQ(selectTextureUploads(pending, 40000), 1u);
+}
+
+TEST(TextureStreamingTest, PriorityChangesUploadOrder) {
+    std::vector<PendingTexture> textures = {{ 64, 64, 0 }, { 64, 64, 0 }, { 64, 64, 0 }};
+    std::vector<PendingTexture*> pending = pointers(textures);
+
+    // Without priorities, textures are uploaded in decoding order.
+    ASSERT_EQ(selectTextureUploads(pending, 1), 1u);
+    EXPECT_EQ(pending[0], &textures[0]);
+    EXPECT_EQ(pending[1], &textures[1]);
+    EXPECT_EQ(pending[2], &textures[2]);
+
+    textures[2].priority = 0.5f;
+    textures[1].priority = 0.25f;
+    pending = pointers(textures);
+    ASSERT_EQ(selectTextureUploads(pending, 1), 1u);
+    EXPECT_EQ(pending[0], &textures[2]);
+    EXPECT_EQ(pending[1], &textures[1]);
+    EXPECT_EQ(pending[2], &textures[0]);
+}
+
+class TextureStreamingLoadTest : public testing::Test {
+protected:
+    void SetUp() override {
+        mEngine = Engine::create(Engine::Backend::NOOP);
+        ASSERT_NE(mEngine, nullptr);
+        mMaterials = createUbershaderLoader(mEngine);
+        mAssetLoader = AssetLoader::create({ mEngine, mMaterials });
+    }
+
+    void TearDown() override {
+        AssetLoader::destroy(&mAssetLoader);
+        mMaterials->destroyMaterials();
+        delete mMaterials;
+        Engine::destroy(&mEngine);
+    }
+
+    FilamentAsset* createAsset() {
+        const std::string json = TEXTURED_GLTF;
+        return mAssetLoader->createAssetFromJson((const uint8_t*) json.data(),
+                uint32_t(json.size()));
+    }
+
+    Engine* mEngine = nullptr;
+    MaterialProvider* mMaterials = nullptr;
+    AssetLoader* mAssetLoader = nullptr;
+};
+
+TEST_F(TextureStreamingLoadTest, ScreenCoverage) {
+    Entity entity = EntityManager::get().create();
+    Camera* camera = mEngine->createCamera(entity);
+    camera->setProjection(45.0, 1.0, 0.1, 100.0);
+    camera->lookAt({ 0, 0, 5 }, { 0, 0, 0 }, { 0, 1, 0 });
+
+    const ScreenCoverage coverage(*camera);
+    const float nearCoverage = coverage.compute({{ -1, -1, -1 }, { 1, 1, 1 }});
+    const float farCoverage = coverage.compute({{ -1, -1, -41 }, { 1, 1, -39 }});
+    const float behindCoverage = coverage.compute({{ -1, -1, 19 }, { 1, 1, 21 }});
+    EXPECT_GT(nearCoverage, farCoverage);
+    EXPECT_GT(farCoverage, 0.0f);
+    EXPECT_EQ(behindCoverage, 0.0f);
+
+    // A texture used by a box close to the camera is uploaded before one that's far away, even
+    // when it was decoded last.
+    std::vector<PendingTexture> textures = {
+            { 64, 64, farCoverage }, { 64, 64, 0.0f }, { 64, 64, nearCoverage }};
+    std::vector<PendingTexture*> pending = pointers(textures);
+    ASSERT_EQ(selectTextureUploads(pending, 1), 1u);
+    EXPECT_EQ(pending[0], &textures[2]);
+    EXPECT_EQ(pending[1], &textures[0]);
+
+    mEngine->destroyCameraComponent(entity);
+    EntityManager::get().destroy(entity);
+}
+
+TEST_F(TextureStreamingLoadTest, ProxiesAreReplaced) {
+    FilamentAsset* asset = createAsset();
+    ASSERT_NE(asset, nullptr);
+    FFilamentAsset* fasset = upcast(asset);
+
+    ResourceConfiguration config = { mEngine, nullptr, false, false };
+    config.asyncUploadBudget = 1;
+    ResourceLoader loader(config);
+    ASSERT_TRUE(loader.asyncBeginLoad(asset));
+
+    // Textures are decoded on the JobSystem, so the number of updates it takes to upload them
+    // varies. The budget only ever allows a single full resolution upload per update.
+    float progress = loader.asyncGetLoadProgress();
+    for (int i = 0; i < 100000 && progress < 1.0f; i++) {
+        loader.asyncUpdateLoad();
+        const float current = loader.asyncGetLoadProgress();
+        EXPECT_LE(current - progress, 1.0f / TEXTURE_COUNT + 1e-6f);
+        progress = current;
+        std::this_thread::yield();
+    }
+    ASSERT_EQ(progress, 1.0f);
+
+    // Each proxy has been destroyed and replaced by its full resolution texture.
+    ASSERT_EQ(fasset->mTextures.size(), size_t(TEXTURE_COUNT));
+    for (const Texture* texture : fasset->mTextures) {
+        EXPECT_EQ(texture->getWidth(), size_t(TEXTURE_SIZE));
+        EXPECT_EQ(texture->getHeight(), size_t(TEXTURE_SIZE));
+    }
+
+    Entity renderables[TEXTURE_COUNT + 1];
+    EXPECT_EQ(asset->popRenderables(renderables, TEXTURE_COUNT + 1), size_t(TEXTURE_COUNT));
+
+    mEngine->flushAndWait();
+    mAssetLoader->destroyAsset(asset);
+}
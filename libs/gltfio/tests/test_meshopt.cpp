@@ -0,0 +1,201 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "MeshoptDecoder.h"
+
+#include <utils/JobSystem.h>
+
+#include <gtest/gtest.h>
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <string>
+
+using namespace gltfio;
+
+// A 4x4 grid of vertices stored the way gltfpack writes EXT_meshopt_compression assets: the
+// compressed data lives in buffer 0, and buffer 1 is a fallback buffer without a uri.
+//
+//  - positions: float3, "ATTRIBUTES" mode
+//  - normals: byte4 normalized, "ATTRIBUTES" mode with the "OCTAHEDRAL" filter
+//  - texcoords: float2, "ATTRIBUTES" mode with the "EXPONENTIAL" filter
+//  - a triangle list: ushort, "TRIANGLES" mode, encoded with version 1 of the index codec
+//  - a line list: uint, "INDICES" mode
+static const char* MESHOPT_GLTF =
+    R"({"asset":{"version":"2.0"},)"
+    R"("extensionsUsed":["EXT_meshopt_compression","KHR_mesh_quantization"],)"
+    R"("extensionsRequired":["EXT_meshopt_compression","KHR_mesh_quantization"],)"
+    R"("buffers":[{"byteLength":292,"uri":"data:application/octet-stream;base64,)"
+    "oAAAAwD//4B///+Af///gH///4ABOPj4+H5/fn9+f34AAAEAwMDA//+AAQDAgAB+AAABAA88AP////8BADMz"
+    "AH59fn0AAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAKADAEBAQL9AQEC/QEBAv0BAQAEAwMDAICAg"
+    "AAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAA4OB/f6ABKurq6gUFBQAAAAEAgICAAAAAAAAAAAAAAAAA"
+    "AAAAAAAAAAAAAAAAAAAAAAAA/gAAAP7h/h4QDhAOjh4UDhMOjh4TDhMODwgAdodWZ3iphmWJaJgBaQAAAAAA"
+    "0QAEAAQABAQEAAQABAQEAAQABAQEAAQABDowKjAqMCowAAAAAAAAAA=="
+    R"("},)"
+    R"({"byteLength":624,"extensions":{"EXT_meshopt_compression":{"fallback":true}}}],)"
+    R"("bufferViews":[)"
+    R"({"buffer":1,"byteOffset":0,"byteLength":192,"byteStride":12,)"
+    R"("extensions":{"EXT_meshopt_compression":{"buffer":0,"byteOffset":0,"byteLength":100,)"
+    R"("byteStride":12,"count":16,"mode":"ATTRIBUTES"}}},)"
+    R"({"buffer":1,"byteOffset":192,"byteLength":64,"byteStride":4,)"
+    R"("extensions":{"EXT_meshopt_compression":{"buffer":0,"byteOffset":100,"byteLength":60,)"
+    R"("byteStride":4,"count":16,"mode":"ATTRIBUTES","filter":"OCTAHEDRAL"}}},)"
+    R"({"buffer":1,"byteOffset":256,"byteLength":128,"byteStride":8,)"
+    R"("extensions":{"EXT_meshopt_compression":{"buffer":0,"byteOffset":160,"byteLength":52,)"
+    R"("byteStride":8,"count":16,"mode":"ATTRIBUTES","filter":"EXPONENTIAL"}}},)"
+    R"({"buffer":1,"byteOffset":384,"byteLength":108,)"
+    R"("extensions":{"EXT_meshopt_compression":{"buffer":0,"byteOffset":212,"byteLength":37,)"
+    R"("byteStride":2,"count":54,"mode":"TRIANGLES"}}},)"
+    R"({"buffer":1,"byteOffset":496,"byteLength":128,)"
+    R"("extensions":{"EXT_meshopt_compression":{"buffer":0,"byteOffset":252,"byteLength":37,)"
+    R"("byteStride":4,"count":32,"mode":"INDICES"}}}],)"
+    R"("accessors":[)"
+    R"({"bufferView":0,"componentType":5126,"count":16,"type":"VEC3",)"
+    R"("min":[0,0,0],"max":[3,3,1]},)"
+    R"({"bufferView":1,"componentType":5120,"normalized":true,"count":16,"type":"VEC3"},)"
+    R"({"bufferView":2,"componentType":5126,"count":16,"type":"VEC2"},)"
+    R"({"bufferView":3,"componentType":5123,"count":54,"type":"SCALAR"},)"
+    R"({"bufferView":4,"componentType":5125,"count":32,"type":"SCALAR"}],)"
+    R"("meshes":[{"primitives":[)"
+    R"({"attributes":{"POSITION":0,"NORMAL":1,"TEXCOORD_0":2},"indices":3},)"
+    R"({"attributes":{"POSITION":0},"indices":4,"mode":1}]}]})";
+
+static constexpr int GRID_SIZE = 4;
+
+class MeshoptTest : public testing::Test {
+protected:
+    void SetUp() override {
+        mJobSystem.adopt();
+        load(MESHOPT_GLTF);
+    }
+
+    void TearDown() override {
+        cgltf_free(mData);
+        mJobSystem.emancipate();
+    }
+
+    void load(std::string const& json) {
+        cgltf_free(mData);
+        mData = nullptr;
+        cgltf_options options = {};
+        ASSERT_EQ(cgltf_parse(&options, json.data(), json.size(), &mData), cgltf_result_success);
+        ASSERT_EQ(cgltf_load_buffers(&options, mData, nullptr), cgltf_result_success);
+    }
+
+    utils::JobSystem mJobSystem;
+    cgltf_data* mData = nullptr;
+};
+
+TEST_F(MeshoptTest, DecodesAttributes) {
+    ASSERT_TRUE(decodeMeshoptCompression(mData, mJobSystem));
+    for (cgltf_size i = 0; i < mData->buffer_views_count; ++i) {
+        EXPECT_NE(mData->buffer_views[i].data, nullptr);
+    }
+
+    const cgltf_accessor* positions = &mData->accessors[0];
+    const cgltf_accessor* normals = &mData->accessors[1];
+    const cgltf_accessor* texcoords = &mData->accessors[2];
+    for (int y = 0; y < GRID_SIZE; ++y) {
+        for (int x = 0; x < GRID_SIZE; ++x) {
+            const cgltf_size v = y * GRID_SIZE + x;
+
+            float p[3];
+            ASSERT_TRUE(cgltf_accessor_read_float(positions, v, p, 3));
+            EXPECT_EQ(p[0], float(x));
+            EXPECT_EQ(p[1], float(y));
+            EXPECT_EQ(p[2], float((x * y) % 3) * 0.5f);
+
+            // The octahedral encoding stores x, y and a scale of 127 in z.
+            const float ox = float((x - 1) * 32);
+            const float oy = float((y - 2) * 16);
+            const float oz = 127.0f - fabsf(ox) - fabsf(oy);
+            const float l = sqrtf(ox * ox + oy * oy + oz * oz);
+            float n[3];
+            ASSERT_TRUE(cgltf_accessor_read_float(normals, v, n, 3));
+            EXPECT_NEAR(n[0], ox / l, 1.0f / 127.0f);
+            EXPECT_NEAR(n[1], oy / l, 1.0f / 127.0f);
+            EXPECT_NEAR(n[2], oz / l, 1.0f / 127.0f);
+
+            // The exponential encoding is exact for multiples of 1/4.
+            float uv[2];
+            ASSERT_TRUE(cgltf_accessor_read_float(texcoords, v, uv, 2));
+            EXPECT_EQ(uv[0], float(x) * 0.25f);
+            EXPECT_EQ(uv[1], float(y) * 0.25f);
+        }
+    }
+}
+
+TEST_F(MeshoptTest, DecodesTriangles) {
+    ASSERT_TRUE(decodeMeshoptCompression(mData, mJobSystem));
+    const cgltf_accessor* triangles = &mData->accessors[3];
+
+    // The index codec preserves the triangles and their winding, but not their first vertex.
+    cgltf_size t = 0;
+    for (int y = 0; y < GRID_SIZE - 1; ++y) {
+        for (int x = 0; x < GRID_SIZE - 1; ++x) {
+            const cgltf_size a = y * GRID_SIZE + x;
+            const cgltf_size b = a + 1;
+            const cgltf_size c = a + GRID_SIZE;
+            const cgltf_size d = c + 1;
+            const cgltf_size expected[2][3] = { { a, b, c }, { c, b, d } };
+            for (auto const& tri : expected) {
+                const cgltf_size i0 = cgltf_accessor_read_index(triangles, t * 3 + 0);
+                const cgltf_size i1 = cgltf_accessor_read_index(triangles, t * 3 + 1);
+                const cgltf_size i2 = cgltf_accessor_read_index(triangles, t * 3 + 2);
+                bool found = false;
+                for (int r = 0; r < 3; ++r) {
+                    found |= i0 == tri[r] && i1 == tri[(r + 1) % 3] && i2 == tri[(r + 2) % 3];
+                }
+                EXPECT_TRUE(found) << "triangle " << t;
+                t++;
+            }
+        }
+    }
+}
+
+TEST_F(MeshoptTest, DecodesIndexSequence) {
+    ASSERT_TRUE(decodeMeshoptCompression(mData, mJobSystem));
+    const cgltf_accessor* lines = &mData->accessors[4];
+
+    // Index sequences are decoded verbatim.
+    cgltf_size i = 0;
+    for (int y = 0; y < GRID_SIZE; ++y) {
+        for (int x = 0; x < GRID_SIZE - 1; ++x) {
+            EXPECT_EQ(cgltf_accessor_read_index(lines, i++), cgltf_size(y * GRID_SIZE + x));
+            EXPECT_EQ(cgltf_accessor_read_index(lines, i++), cgltf_size(y * GRID_SIZE + x + 1));
+        }
+    }
+    for (int x = 0; x < GRID_SIZE; ++x) {
+        EXPECT_EQ(cgltf_accessor_read_index(lines, i++), cgltf_size(x));
+        const cgltf_size bottom = (GRID_SIZE - 1) * GRID_SIZE + x;
+        EXPECT_EQ(cgltf_accessor_read_index(lines, i++), bottom);
+    }
+}
+
+TEST_F(MeshoptTest, RejectsMalformedData) {
+    // Truncating the compressed streams makes all of them invalid, without reading out of bounds.
+    std::string json(MESHOPT_GLTF);
+    const std::string from = R"("byteLength":37)";
+    for (size_t pos = json.find(from); pos != std::string::npos; pos = json.find(from, pos)) {
+        json.replace(pos, from.size(), R"("byteLength":20)");
+    }
+    load(json);
+    EXPECT_FALSE(decodeMeshoptCompression(mData, mJobSystem));
+    EXPECT_EQ(mData->buffer_views[3].data, nullptr);
+    EXPECT_EQ(mData->buffer_views[4].data, nullptr);
+}
@@ -0,0 +1,130 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <ibl/Cubemap.h>
+#include <ibl/CubemapIBL.h>
+#include <ibl/CubemapSH.h>
+#include <ibl/CubemapUtils.h>
+#include <ibl/Image.h>
+
+#include <utils/JobSystem.h>
+
+#include <math/scalar.h>
+
+#include <cmath>
+#include <vector>
+
+using namespace filament::math;
+using namespace filament::ibl;
+
+static constexpr size_t SOURCE_DIM = 1024;
+static constexpr size_t NUM_OUTPUT_LEVELS = 7;
+static constexpr size_t NUM_SAMPLES = 1024;
+
+namespace {
+
+// A 1024x1024 cubemap and its mipmap chain, shared by all benchmarks.
+struct Environment {
+    utils::JobSystem js;
+    std::vector<Image> images;
+    std::vector<Cubemap> levels;
+
+    Environment() {
+        js.adopt();
+        Image image;
+        Cubemap base = CubemapUtils::create(image, SOURCE_DIM);
+        CubemapUtils::generateUVGrid(js, base, 16, 16);
+        base.makeSeamless();
+        images.push_back(std::move(image));
+        levels.push_back(std::move(base));
+        for (size_t dim = SOURCE_DIM >> 1u; dim >= 1; dim >>= 1u) {
+            Image temp;
+            Cubemap dst = CubemapUtils::create(temp, dim);
+            CubemapUtils::downsampleCubemapLevelBoxFilter(js, dst, levels.back());
+            dst.makeSeamless();
+            images.push_back(std::move(temp));
+            levels.push_back(std::move(dst));
+        }
+    }
+
+    ~Environment() {
+        js.emancipate();
+    }
+};
+
+// see cmgen's lodToPerceptualRoughness()
+float lodToPerceptualRoughness(float lod) noexcept {
+    const float a = 2.0f;
+    const float b = -1.0f;
+    return (lod != 0)
+            ? saturate((std::sqrt(a * a + 4.0f * b * lod) - a) / (2.0f * b))
+            : 0.0f;
+}
+
+Environment& getEnvironment() {
+    static Environment environment;
+    return environment;
+}
+
+} // anonymous namespace
+
+// Prefilters the environment into a 1024 to 16 roughness chain, one benchmark per output level, the
+// same way cmgen does. The first argument is the output level, the second is the quality in percent.
+static void BM_roughnessFilter(benchmark::State& state) {
+    Environment& env = getEnvironment();
+    const size_t level = size_t(state.range(0));
+    const float quality = float(state.range(1)) / 100.0f;
+
+    // see cmgen's iblRoughnessPrefilter()
+    const float lod = saturate(float(level) / float(NUM_OUTPUT_LEVELS - 1));
+    const float perceptualRoughness = lodToPerceptualRoughness(lod);
+    const float roughness = perceptualRoughness * perceptualRoughness;
+    const size_t numSamples = NUM_SAMPLES << (level >= 2 ? level - 1 : 0);
+    const size_t dim = SOURCE_DIM >> level;
+
+    Image image;
+    Cubemap dst = CubemapUtils::create(image, dim);
+    for (auto _ : state) {
+        CubemapIBL::roughnessFilter(env.js, dst, env.levels, roughness, numSamples,
+                float3{ 1, 1, 1 }, true, quality);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(int64_t(state.iterations() * dim * dim * 6));
+}
+
+static void levelsAndQualities(benchmark::internal::Benchmark* b) {
+    for (int level = 0; level < int(NUM_OUTPUT_LEVELS); level++) {
+        b->Args({ level, 100 });
+        b->Args({ level, 25 });
+    }
+}
+
+BENCHMARK(BM_roughnessFilter)->Apply(levelsAndQualities)->Unit(benchmark::kMillisecond);
+
+// Projects a cubemap of 1024 >> level on 3 bands of spherical harmonics.
+static void BM_computeSH3Bands(benchmark::State& state) {
+    Environment& env = getEnvironment();
+    const Cubemap& cm = env.levels[size_t(state.range(0))];
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(CubemapSH::computeSH3Bands(env.js, cm, true));
+    }
+    const size_t dim = cm.getDimensions();
+    state.SetItemsProcessed(int64_t(state.iterations() * dim * dim * 6));
+}
+
+BENCHMARK(BM_computeSH3Bands)->DenseRange(0, 4, 2)->Unit(benchmark::kMillisecond);
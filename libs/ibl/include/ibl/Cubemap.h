@@ -136,6 +136,10 @@ public:
     //! returns the face and texture coordinates of the given direction
     static Address getAddressFor(const filament::math::float3& direction);
 
+    //! samples two cubemaps at a given address and lerps the result by a given lerp factor
+    static Texel trilinearFilterAt(const Cubemap& c0, const Cubemap& c1, float lerp,
+            const Address& address);
+
 private:
     size_t mDimensions = 0;
     float mScale = 1;
@@ -63,6 +63,23 @@ public:
             float linearRoughness, size_t maxNumSamples, math::float3 mirror, bool prefilter,
             Progress updater = nullptr, void* userdata = nullptr);
 
+    /**
+     * Same as above, with a quality / speed tradeoff. A quality below 1 scales down the number
+     * of samples, and when prefiltering, increases the LOD bias by the same factor so that
+     * fewer, blurrier samples still cover the lobe without introducing noise.
+     *
+     * @param quality           in ]0, 1], 1 being the same as the overloads above
+     */
+    static void roughnessFilter(
+            utils::JobSystem& js, Cubemap& dst, const utils::Slice<Cubemap>& levels,
+            float linearRoughness, size_t maxNumSamples, math::float3 mirror, bool prefilter,
+            float quality, Progress updater = nullptr, void* userdata = nullptr);
+
+    static void roughnessFilter(
+            utils::JobSystem& js, Cubemap& dst, const std::vector<Cubemap>& levels,
+            float linearRoughness, size_t maxNumSamples, math::float3 mirror, bool prefilter,
+            float quality, Progress updater = nullptr, void* userdata = nullptr);
+
     //! Computes the "DFG" term of the "split-sum" approximation and stores it in a 2D image
     static void DFG(utils::JobSystem& js, Image& dst, bool multiscatter, bool cloth);
 
@@ -47,6 +47,14 @@ public:
     static std::unique_ptr<math::float3[]> computeSH(
             utils::JobSystem& js, const Cubemap& cm, size_t numBands, bool irradiance);
 
+    /**
+     * Same as computeSH() with 3 bands, which it is used for. Solid angles and directions are
+     * looked up in tables shared by all cubemaps of the same dimensions and computed only once,
+     * which makes this suitable for re-projecting light probes repeatedly at runtime.
+     */
+    static std::unique_ptr<math::float3[]> computeSH3Bands(
+            utils::JobSystem& js, const Cubemap& cm, bool irradiance);
+
     /**
      * Render given spherical harmonics into a cubemap
      */
@@ -101,6 +109,8 @@ private:
 
     static void computeShBasis(float* SHb, size_t numBands, const math::float3& s);
 
+    static void scaleSH(math::float3* sh, size_t numBands, bool irradiance);
+
     static float Kml(ssize_t m, size_t l);
 
     static std::vector<float> Ki(size_t numBands);
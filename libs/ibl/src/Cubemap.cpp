@@ -203,15 +203,24 @@ Cubemap::Texel Cubemap::filterAtCenter(const Image& image, size_t x0, size_t y0)
 Cubemap::Texel Cubemap::trilinearFilterAt(const Cubemap& l0, const Cubemap& l1, float lerp,
         const float3& L)
 {
-    Cubemap::Address addr(getAddressFor(L));
+    return trilinearFilterAt(l0, l1, lerp, getAddressFor(L));
+}
+
+Cubemap::Texel Cubemap::trilinearFilterAt(const Cubemap& l0, const Cubemap& l1, float lerp,
+        const Address& addr)
+{
     const Image& i0 = l0.getImageForFace(addr.face);
-    const Image& i1 = l1.getImageForFace(addr.face);
     float x0 = std::min(addr.s * l0.mDimensions, l0.mUpperBound);
     float y0 = std::min(addr.t * l0.mDimensions, l0.mUpperBound);
-    float x1 = std::min(addr.s * l1.mDimensions, l1.mUpperBound);
-    float y1 = std::min(addr.t * l1.mDimensions, l1.mUpperBound);
     float3 c0 = filterAt(i0, x0, y0);
-    c0 += lerp * (filterAt(i1, x1, y1) - c0);
+    if (lerp != 0) {
+        // the second level doesn't contribute otherwise, this is always the case when
+        // prefiltering is disabled or past the last level.
+        const Image& i1 = l1.getImageForFace(addr.face);
+        float x1 = std::min(addr.s * l1.mDimensions, l1.mUpperBound);
+        float y1 = std::min(addr.t * l1.mDimensions, l1.mUpperBound);
+        c0 += lerp * (filterAt(i1, x1, y1) - c0);
+    }
     return c0;
 }
 
@@ -304,8 +304,58 @@ void CubemapIBL::roughnessFilter(
 void CubemapIBL::roughnessFilter(
         utils::JobSystem& js, Cubemap& dst, const utils::Slice<Cubemap>& levels,
         float linearRoughness, size_t maxNumSamples, math::float3 mirror, bool prefilter,
-        Progress updater, void* userdata)
+        Progress updater, void* userdata) {
+    roughnessFilter(js, dst, levels, linearRoughness, maxNumSamples, mirror, prefilter, 1.0f,
+            updater, userdata);
+}
+
+UTILS_ALWAYS_INLINE
+void CubemapIBL::roughnessFilter(
+        utils::JobSystem& js, Cubemap& dst, const std::vector<Cubemap>& levels,
+        float linearRoughness, size_t maxNumSamples, math::float3 mirror, bool prefilter,
+        float quality, Progress updater, void* userdata) {
+    roughnessFilter(js, dst, { levels.data(), uint32_t(levels.size()) },
+            linearRoughness, maxNumSamples, mirror, prefilter, quality, updater, userdata);
+}
+
+/*
+ * Computes the face and texture coordinates of a batch of directions given in SoA form. This is
+ * the same computation as Cubemap::getAddressFor(), but written without branches so that it can
+ * be vectorized.
+ */
+template<size_t N>
+static void getAddressesFor(float const* UTILS_RESTRICT x, float const* UTILS_RESTRICT y,
+        float const* UTILS_RESTRICT z, uint8_t* UTILS_RESTRICT face,
+        float* UTILS_RESTRICT s, float* UTILS_RESTRICT t) {
+    for (size_t i = 0; i < N; i++) {
+        const float rx = std::abs(x[i]);
+        const float ry = std::abs(y[i]);
+        const float rz = std::abs(z[i]);
+        const bool isX = rx >= ry && rx >= rz;
+        const bool isY = !isX && ry >= rx && ry >= rz;
+        const bool positive = isX ? x[i] >= 0 : (isY ? y[i] >= 0 : z[i] >= 0);
+        const float ma = 1.0f / (isX ? rx : (isY ? ry : rz));
+        //  PX: -z, -y   NX:  z, -y
+        //  PY:  x,  z   NY:  x, -z
+        //  PZ:  x, -y   NZ: -x, -y
+        const float sc = isX ? (positive ? -z[i] : z[i]) : (isY || positive ? x[i] : -x[i]);
+        const float tc = isY ? (positive ? z[i] : -z[i]) : -y[i];
+        face[i] = uint8_t((isX ? 0 : (isY ? 2 : 4)) + (positive ? 0 : 1));
+        s[i] = (sc * ma + 1.0f) * 0.5f;
+        t[i] = (tc * ma + 1.0f) * 0.5f;
+    }
+}
+
+void CubemapIBL::roughnessFilter(
+        utils::JobSystem& js, Cubemap& dst, const utils::Slice<Cubemap>& levels,
+        float linearRoughness, size_t maxNumSamples, math::float3 mirror, bool prefilter,
+        float quality, Progress updater, void* userdata)
 {
+    // Lowering the quality reduces the number of samples and increases the LOD bias of the
+    // prefiltered importance sampling accordingly, i.e. each sample covers a larger solid angle.
+    quality = clamp(quality, 0.0f, 1.0f);
+    maxNumSamples = std::max(size_t(1), size_t(float(maxNumSamples) * quality));
+
     const float numSamples = maxNumSamples;
     const float inumSamples = 1.0f / numSamples;
     const size_t maxLevel = levels.size()-1;
@@ -389,7 +439,7 @@ void CubemapIBL::roughnessFilter(
             const float pdf = DistributionGGX(NoH, linearRoughness) / 4;
 
             // K is a LOD bias that allows a bit of overlapping between samples
-            constexpr float K = 4;
+            const float K = 4 / std::max(quality, 1.0f / 64.0f);
             const float omegaS = 1 / (numSamples * pdf);
             const float l = float(log4(omegaS) - log4(omegaP) + log4(K));
             const float mipLevel = prefilter ? clamp(float(l), 0.0f, maxLevelf) : 0.0f;
@@ -422,6 +472,12 @@ void CubemapIBL::roughnessFilter(
         std::uniform_real_distribution<float> distribution{ -F_PI, F_PI };
     };
 
+    // Texels are processed in batches, so that each entry of the cache is loaded once per batch
+    // and all per-texel math (rotating the sample into the texel's frame and computing its
+    // address in the cubemap) is done on arrays, which the compiler can vectorize. Only the
+    // texel fetches remain scalar.
+    constexpr size_t BATCH_SIZE = 8;
+
     auto scanline = [&](State& state, size_t y,
             Cubemap::Face f, Cubemap::Texel* data, size_t dim) {
         if (UTILS_UNLIKELY(updater)) {
@@ -430,28 +486,58 @@ void CubemapIBL::roughnessFilter(
         }
         mat3 R;
         const size_t numSamples = cache.size();
-        for (size_t x = 0; x < dim; ++x, ++data) {
-            const float2 p(Cubemap::center(x, y));
-            const float3 N(dst.getDirectionFor(f, p.x, p.y) * mirror);
-
-            // center the cone around the normal (handle case of normal close to up)
-            const float3 up = std::abs(N.z) < 0.999 ? float3(0, 0, 1) : float3(1, 0, 0);
-            R[0] = normalize(cross(up, N));
-            R[1] = cross(N, R[0]);
-            R[2] = N;
+        for (size_t x0 = 0; x0 < dim; x0 += BATCH_SIZE) {
+            const size_t count = std::min(BATCH_SIZE, dim - x0);
+
+            // the columns of each texel's rotation, in SoA form
+            float R0x[BATCH_SIZE], R0y[BATCH_SIZE], R0z[BATCH_SIZE];
+            float R1x[BATCH_SIZE], R1y[BATCH_SIZE], R1z[BATCH_SIZE];
+            float R2x[BATCH_SIZE], R2y[BATCH_SIZE], R2z[BATCH_SIZE];
+            for (size_t i = 0; i < BATCH_SIZE; i++) {
+                // the tail of the last batch repeats the last texel, its results are discarded
+                const size_t x = x0 + std::min(i, count - 1);
+                const float2 p(Cubemap::center(x, y));
+                const float3 N(dst.getDirectionFor(f, p.x, p.y) * mirror);
+
+                // center the cone around the normal (handle case of normal close to up)
+                const float3 up = std::abs(N.z) < 0.999 ? float3(0, 0, 1) : float3(1, 0, 0);
+                R[0] = normalize(cross(up, N));
+                R[1] = cross(N, R[0]);
+                R[2] = N;
+
+                if (i < count) {
+                    R *= mat3f::rotation(state.distribution(state.gen), float3{0,0,1});
+                }
 
-            R *= mat3f::rotation(state.distribution(state.gen), float3{0,0,1});
+                R0x[i] = R[0].x; R0y[i] = R[0].y; R0z[i] = R[0].z;
+                R1x[i] = R[1].x; R1y[i] = R[1].y; R1z[i] = R[1].z;
+                R2x[i] = R[2].x; R2y[i] = R[2].y; R2z[i] = R[2].z;
+            }
 
-            float3 Li = 0;
+            float3 Li[BATCH_SIZE] = {};
             for (size_t sample = 0; sample < numSamples; sample++) {
                 const CacheEntry& e = cache[sample];
-                const float3 L(R * e.L);
+                float Lx[BATCH_SIZE], Ly[BATCH_SIZE], Lz[BATCH_SIZE];
+                for (size_t i = 0; i < BATCH_SIZE; i++) {
+                    Lx[i] = R0x[i] * e.L.x + R1x[i] * e.L.y + R2x[i] * e.L.z;
+                    Ly[i] = R0y[i] * e.L.x + R1y[i] * e.L.y + R2y[i] * e.L.z;
+                    Lz[i] = R0z[i] * e.L.x + R1z[i] * e.L.y + R2z[i] * e.L.z;
+                }
+                uint8_t face[BATCH_SIZE];
+                float s[BATCH_SIZE], t[BATCH_SIZE];
+                getAddressesFor<BATCH_SIZE>(Lx, Ly, Lz, face, s, t);
+
                 const Cubemap& cmBase = levels[e.l0];
                 const Cubemap& next = levels[e.l1];
-                const float3 c0 = Cubemap::trilinearFilterAt(cmBase, next, e.lerp, L);
-                Li += c0 * e.brdf_NoL;
+                for (size_t i = 0; i < count; i++) {
+                    const Cubemap::Address address{ Cubemap::Face(face[i]), s[i], t[i] };
+                    const float3 c0 = Cubemap::trilinearFilterAt(cmBase, next, e.lerp, address);
+                    Li[i] += c0 * e.brdf_NoL;
+                }
+            }
+            for (size_t i = 0; i < count; i++) {
+                Cubemap::writeAt(data + x0 + i, Cubemap::Texel(Li[i]));
             }
-            Cubemap::writeAt(data, Cubemap::Texel(Li));
         }
     };
 
@@ -26,9 +26,14 @@
 
 #include <math/mat4.h>
 
+#include <algorithm>
 #include <array>
 #include <limits>
 #include <iomanip>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
 
 using namespace filament::math;
 using namespace utils;
@@ -508,6 +513,9 @@ void CubemapSH::windowSH(std::unique_ptr<float3[]>& sh, size_t numBands, float c
 }
 
 std::unique_ptr<float3[]> CubemapSH::computeSH(JobSystem& js, const Cubemap& cm, size_t numBands, bool irradiance) {
+    if (numBands == 3) {
+        return computeSH3Bands(js, cm, irradiance);
+    }
 
     const size_t numCoefs = numBands * numBands;
     std::unique_ptr<float3[]> SH(new float3[numCoefs]{});
@@ -552,6 +560,13 @@ std::unique_ptr<float3[]> CubemapSH::computeSH(JobSystem& js, const Cubemap& cm,
         }
     }, prototype);
 
+    scaleSH(SH.get(), numBands, irradiance);
+    return SH;
+}
+
+void CubemapSH::scaleSH(float3* SH, size_t numBands, bool irradiance) {
+    const size_t numCoefs = numBands * numBands;
+
     // precompute the scaling factor K
     std::vector<float> K = Ki(numBands);
 
@@ -571,6 +586,135 @@ std::unique_ptr<float3[]> CubemapSH::computeSH(JobSystem& js, const Cubemap& cm,
     for (size_t i = 0; i < numCoefs; i++) {
         SH[i] *= K[i];
     }
+}
+
+/*
+ * Per-texel solid angle and direction of a cubemap face of a given dimension. The directions of
+ * all 6 faces are signed permutations of the same (cx, cy, 1) / length vector, so a single table
+ * serves all of them.
+ */
+struct SH3BandsTable {
+    explicit SH3BandsTable(size_t dim)
+            : solidAngle(dim * dim), cx(dim * dim), cy(dim * dim), one(dim * dim) {
+        const float scale = 2.0f / float(dim);
+        for (size_t y = 0, i = 0; y < dim; y++) {
+            for (size_t x = 0; x < dim; x++, i++) {
+                // this must match Cubemap::getDirectionFor()
+                const float u = (x + 0.5f) * scale - 1;
+                const float v = 1 - (y + 0.5f) * scale;
+                const float il = 1 / std::sqrt(u * u + v * v + 1);
+                solidAngle[i] = CubemapUtils::solidAngle(dim, x, y);
+                cx[i] = u * il;
+                cy[i] = v * il;
+                one[i] = il;
+            }
+        }
+    }
+    std::vector<float> solidAngle;
+    std::vector<float> cx;
+    std::vector<float> cy;
+    std::vector<float> one;
+};
+
+/*
+ * A table takes 16 bytes per texel of a face, so only the tables of the few most recently used
+ * dimensions are kept: light probes are typically re-projected at one or two sizes. A table
+ * evicted while in use stays alive until the projection using it completes.
+ */
+static std::shared_ptr<const SH3BandsTable> getSH3BandsTable(size_t dim) {
+    constexpr size_t MAX_TABLE_COUNT = 4;
+    static std::mutex sLock;
+    // most recently used first
+    static std::vector<std::pair<size_t, std::shared_ptr<const SH3BandsTable>>> sTables;
+    std::lock_guard<std::mutex> guard(sLock);
+    auto pos = std::find_if(sTables.begin(), sTables.end(),
+            [dim](auto const& entry) { return entry.first == dim; });
+    if (pos != sTables.end()) {
+        std::rotate(sTables.begin(), pos, pos + 1);
+    } else {
+        if (sTables.size() == MAX_TABLE_COUNT) {
+            sTables.pop_back();
+        }
+        sTables.emplace(sTables.begin(), dim, std::make_shared<const SH3BandsTable>(dim));
+    }
+    return sTables.front().second;
+}
+
+std::unique_ptr<float3[]> CubemapSH::computeSH3Bands(JobSystem& js, const Cubemap& cm,
+        bool irradiance) {
+    constexpr size_t numCoefs = 9;
+    std::unique_ptr<float3[]> SH(new float3[numCoefs]{});
+
+    const std::shared_ptr<const SH3BandsTable> table = getSH3BandsTable(cm.getDimensions());
+
+    struct State {
+        float r[numCoefs] = {};
+        float g[numCoefs] = {};
+        float b[numCoefs] = {};
+    } prototype;
+
+    CubemapUtils::process<State>(const_cast<Cubemap&>(cm), js,
+            [&](State& state, size_t y, Cubemap::Face f, Cubemap::Texel const* data, size_t dim) {
+        const size_t offset = y * dim;
+        float const* UTILS_RESTRICT w = table->solidAngle.data() + offset;
+        float const* cx = table->cx.data() + offset;
+        float const* cy = table->cy.data() + offset;
+        float const* one = table->one.data() + offset;
+
+        // see Cubemap::getDirectionFor()
+        float const* UTILS_RESTRICT X = nullptr;
+        float const* UTILS_RESTRICT Y = nullptr;
+        float const* UTILS_RESTRICT Z = nullptr;
+        float sx = 1, sy = 1, sz = 1;
+        switch (f) {
+            case Cubemap::Face::PX: X = one; Y = cy;  Z = cx;  sz = -1;          break;
+            case Cubemap::Face::NX: X = one; Y = cy;  Z = cx;  sx = -1;          break;
+            case Cubemap::Face::PY: X = cx;  Y = one; Z = cy;  sz = -1;          break;
+            case Cubemap::Face::NY: X = cx;  Y = one; Z = cy;  sy = -1;          break;
+            case Cubemap::Face::PZ: X = cx;  Y = cy;  Z = one;                   break;
+            case Cubemap::Face::NZ: X = cx;  Y = cy;  Z = one; sx = -1; sz = -1; break;
+        }
+
+        // The basis below is the same as computeShBasis() for 3 bands, written out so that the
+        // loop has no dependencies across texels and vectorizes.
+        float r[numCoefs] = {};
+        float g[numCoefs] = {};
+        float b[numCoefs] = {};
+        for (size_t x = 0; x < dim; x++) {
+            const float3 c = data[x] * w[x];
+            const float dx = sx * X[x];
+            const float dy = sy * Y[x];
+            const float dz = sz * Z[x];
+            const float SHb[numCoefs] = {
+                    1.0f,
+                    -dy,
+                    dz,
+                    -dx,
+                    6.0f * dx * dy,
+                    -3.0f * dy * dz,
+                    1.5f * dz * dz - 0.5f,
+                    -3.0f * dx * dz,
+                    3.0f * (dx * dx - dy * dy)
+            };
+            for (size_t i = 0; i < numCoefs; i++) {
+                r[i] += c.r * SHb[i];
+                g[i] += c.g * SHb[i];
+                b[i] += c.b * SHb[i];
+            }
+        }
+        for (size_t i = 0; i < numCoefs; i++) {
+            state.r[i] += r[i];
+            state.g[i] += g[i];
+            state.b[i] += b[i];
+        }
+    },
+    [&](State& state) {
+        for (size_t i = 0; i < numCoefs; i++) {
+            SH[i] += float3{ state.r[i], state.g[i], state.b[i] };
+        }
+    }, prototype);
+
+    scaleSH(SH.get(), 3, irradiance);
     return SH;
 }
 
@@ -0,0 +1,110 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <ibl/Cubemap.h>
+#include <ibl/CubemapSH.h>
+#include <ibl/CubemapUtils.h>
+#include <ibl/Image.h>
+
+#include <utils/JobSystem.h>
+
+#include <math/vec3.h>
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+
+using namespace filament::math;
+using namespace filament::ibl;
+
+class IblTest : public testing::Test {
+protected:
+    void SetUp() override { js.adopt(); }
+    void TearDown() override { js.emancipate(); }
+
+    // An environment with a different color in every direction, so that none of the SH
+    // coefficients vanish.
+    static Cubemap createEnvironment(Image& image, size_t dim) {
+        Cubemap cm = CubemapUtils::create(image, dim);
+        for (size_t f = 0; f < 6; f++) {
+            const Cubemap::Face face = Cubemap::Face(f);
+            Image& faceImage = cm.getImageForFace(face);
+            for (size_t y = 0; y < dim; y++) {
+                for (size_t x = 0; x < dim; x++) {
+                    const float3 d = cm.getDirectionFor(face, x, y);
+                    const float3 color = {
+                            1.0f + d.x + 0.5f * d.y * d.z,
+                            1.0f + d.y * d.y - 0.25f * d.x * d.z + d.x * d.x * d.x,
+                            std::exp(2.0f * d.z) + 0.75f * d.x * d.y };
+                    Cubemap::writeAt(faceImage.getPixelRef(x, y), color);
+                }
+            }
+        }
+        return cm;
+    }
+
+    utils::JobSystem js;
+};
+
+TEST_F(IblTest, SH3BandsMatchesGenericProjection) {
+    for (size_t dim : { 1, 7, 32, 64 }) {
+        Image image;
+        Cubemap cm = createEnvironment(image, dim);
+        for (bool irradiance : { false, true }) {
+            // The coefficients of the first 3 bands don't depend on how many bands are computed,
+            // and computeSH() only uses the generic projection with more than 3 bands.
+            std::unique_ptr<float3[]> const expected = CubemapSH::computeSH(js, cm, 4, irradiance);
+            std::unique_ptr<float3[]> const actual = CubemapSH::computeSH3Bands(js, cm, irradiance);
+            std::unique_ptr<float3[]> const dispatched =
+                    CubemapSH::computeSH(js, cm, 3, irradiance);
+            for (size_t i = 0; i < 9; i++) {
+                for (size_t c = 0; c < 3; c++) {
+                    const float tolerance = 1e-4f * std::max(1.0f, std::abs(expected[i][c]));
+                    EXPECT_NEAR(actual[i][c], expected[i][c], tolerance)
+                            << "dim " << dim << ", irradiance " << irradiance
+                            << ", coefficient " << i << ", channel " << c;
+                    EXPECT_EQ(dispatched[i][c], actual[i][c]);
+                }
+            }
+        }
+    }
+}
+
+TEST_F(IblTest, SH3BandsAfterManyDimensions) {
+    // Going through more cubemap sizes than there are cached tables must still give the right
+    // coefficients when coming back to the first ones.
+    for (size_t pass = 0; pass < 2; pass++) {
+        for (size_t dim = 4; dim <= 16; dim++) {
+            Image image;
+            Cubemap cm = createEnvironment(image, dim);
+            std::unique_ptr<float3[]> const expected = CubemapSH::computeSH(js, cm, 4, true);
+            std::unique_ptr<float3[]> const actual = CubemapSH::computeSH3Bands(js, cm, true);
+            for (size_t i = 0; i < 9; i++) {
+                for (size_t c = 0; c < 3; c++) {
+                    EXPECT_NEAR(actual[i][c], expected[i][c],
+                            1e-4f * std::max(1.0f, std::abs(expected[i][c])));
+                }
+            }
+        }
+    }
+}
+
+int main(int argc, char** argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -24,6 +24,7 @@
 
 namespace filament {
 class Engine;
+class IndirectLight;
 class View;
 class Scene;
 class Renderer;
@@ -124,6 +125,8 @@ public:
     };
 
 
+    class IncrementalSpecularFilter;
+
     /**
      * SpecularFilter is a GPU based implementation of the specular probe pre-integration filter.
      * An instance of SpecularFilter is needed per filter configuration. A filter configuration
@@ -212,12 +215,15 @@ public:
                 filament::Texture const* environmentCubemap,
                 filament::Texture* outReflectionsTexture = nullptr);
 
-        // TODO: option for progressive filtering
-
         // TODO: add a callback for when the processing is done?
 
     private:
+        friend class IBLPrefilterContext::IncrementalSpecularFilter;
         filament::Texture* createReflectionsTexture();
+        filament::MaterialInstance* prepare(Options const& options,
+                filament::Texture const* environmentCubemap);
+        void renderLevel(filament::MaterialInstance* mi, Options const& options,
+                filament::Texture* outReflectionsTexture, uint8_t lod, uint8_t side);
         IBLPrefilterContext& mContext;
         filament::Material* mKernelMaterial = nullptr;
         filament::Texture* mKernelTexture = nullptr;
@@ -225,6 +231,97 @@ public:
         uint8_t mLevelCount = 1u;
     };
 
+    /**
+     * IncrementalSpecularFilter spreads the work of a SpecularFilter over several calls to
+     * update(), typically one per frame, which avoids a large spike whenever the environment
+     * changes, e.g. with a dynamic time of day.
+     *
+     * The result is double-buffered: getReflectionsTexture() only changes when a new mipmap
+     * chain is complete.
+     *
+     * Usage Example:
+     * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+     * IBLPrefilterContext::IncrementalSpecularFilter incremental(filter);
+     *
+     * // when the environment changes
+     * incremental.start({}, environment_cubemap);
+     *
+     * // every frame
+     * incremental.update(indirectLight);
+     * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+     */
+    class IncrementalSpecularFilter {
+    public:
+        /**
+         * Incremental filter configuration.
+         */
+        struct Config {
+            /**
+             * Number of environment samples taken per update(). Work is divided in units of
+             * one mip level of 3 faces, at least one unit is processed per update().
+             */
+            uint32_t samplesPerUpdate = 32u * 1024u * 1024u;
+        };
+
+        /**
+         * Creates an IncrementalSpecularFilter.
+         * @param filter  SpecularFilter to use, it must outlive this object.
+         * @param config  Configuration of the incremental filter
+         */
+        IncrementalSpecularFilter(SpecularFilter& filter, Config config);
+
+        /**
+         * Creates an incremental filter with the default configuration.
+         * @param filter  SpecularFilter to use, it must outlive this object.
+         */
+        explicit IncrementalSpecularFilter(SpecularFilter& filter);
+
+        /**
+         * Destroys both reflections textures.
+         */
+        ~IncrementalSpecularFilter() noexcept;
+
+        IncrementalSpecularFilter(IncrementalSpecularFilter const&) = delete;
+        IncrementalSpecularFilter& operator=(IncrementalSpecularFilter const&) = delete;
+
+        /**
+         * Starts prefiltering a new environment, abandoning the one in progress if any.
+         * @param options               Options for this environment
+         * @param environmentCubemap    Environment cubemap, see SpecularFilter::operator().
+         *                              It must not be modified or destroyed until the new chain
+         *                              is complete.
+         */
+        void start(SpecularFilter::Options options, filament::Texture const* environmentCubemap);
+
+        /**
+         * Processes the next units of work within the budget.
+         * @param indirectLight If not null, its reflections are replaced with the new chain as
+         *                      soon as it is complete.
+         * @return true if this call completed a new chain.
+         */
+        bool update(filament::IndirectLight* indirectLight = nullptr);
+
+        /**
+         * Returns whether an environment is being prefiltered.
+         */
+        bool isInProgress() const noexcept { return mEnvironment != nullptr; }
+
+        /**
+         * Returns the most recently completed chain, or null if none is complete yet.
+         */
+        filament::Texture* getReflectionsTexture() const noexcept { return mFront; }
+
+    private:
+        SpecularFilter& mFilter;
+        filament::Texture const* mEnvironment = nullptr;
+        filament::Texture* mFront = nullptr;
+        filament::Texture* mBack = nullptr;
+        SpecularFilter::Options mOptions{};
+        uint32_t mSamplesPerUpdate = 0u;
+        uint8_t mLevel = 0u;
+        uint8_t mSide = 0u;
+    };
+
 private:
     friend class Filter;
     filament::Engine& mEngine;
@@ -18,6 +18,7 @@
 
 #include <filament/Engine.h>
 #include <filament/IndexBuffer.h>
+#include <filament/IndirectLight.h>
 #include <filament/Material.h>
 #include <filament/RenderTarget.h>
 #include <filament/RenderableManager.h>
@@ -38,6 +39,8 @@
 
 #include "generated/resources/iblprefilter_materials.h"
 
+#include <utility>
+
 using namespace filament::math;
 using namespace filament;
 
@@ -397,80 +400,176 @@ Texture* IBLPrefilterContext::SpecularFilter::operator()(
             "outReflectionsTexture has %u levels but %u are requested.",
             +outReflectionsTexture->getLevels(), +mLevelCount);
 
-    const TextureCubemapFace faces[2][3] = {
-            { TextureCubemapFace::POSITIVE_X, TextureCubemapFace::POSITIVE_Y, TextureCubemapFace::POSITIVE_Z },
-            { TextureCubemapFace::NEGATIVE_X, TextureCubemapFace::NEGATIVE_Y, TextureCubemapFace::NEGATIVE_Z }
-    };
+    MaterialInstance* const mi = prepare(options, environmentCubemap);
+
+    if (options.generateMipmap) {
+        // We need mipmaps for prefiltering
+        environmentCubemap->generateMipmaps(mContext.mEngine);
+    }
+
+    const uint8_t levels = outReflectionsTexture->getLevels();
+    for (uint8_t lod = 0; lod < levels; lod++) {
+        SYSTRACE_NAME("executeFilterLOD");
+        for (uint8_t side = 0; side < 2; side++) {
+            renderLevel(mi, options, outReflectionsTexture, lod, side);
+        }
+    }
+
+    return outReflectionsTexture;
+}
+
+MaterialInstance* IBLPrefilterContext::SpecularFilter::prepare(Options const& options,
+        Texture const* environmentCubemap) {
+    using namespace backend;
 
     Engine& engine = mContext.mEngine;
-    View* const view = mContext.mView;
-    Renderer* const renderer = mContext.mRenderer;
     MaterialInstance* const mi = mContext.mIntegrationMaterial->getDefaultInstance();
 
     RenderableManager& rcm = engine.getRenderableManager();
     rcm.setMaterialInstanceAt(
             rcm.getInstance(mContext.mFullScreenQuadEntity), 0, mi);
 
-    const uint32_t sampleCount = mSampleCount;
-    const float linear = options.hdrLinear;
-    const float compress = options.hdrMax;
-    const uint8_t levels = outReflectionsTexture->getLevels();
-    uint32_t dim = outReflectionsTexture->getWidth();
-    const float omegaP = (4.0f * f::PI) / float(6 * dim * dim);
-
     TextureSampler environmentSampler;
     environmentSampler.setMagFilter(SamplerMagFilter::LINEAR);
     environmentSampler.setMinFilter(SamplerMinFilter::LINEAR_MIPMAP_LINEAR);
 
     mi->setParameter("environment", environmentCubemap, environmentSampler);
     mi->setParameter("kernel", mKernelTexture, TextureSampler{ SamplerMagFilter::NEAREST });
-    mi->setParameter("compress", float2{ linear, compress });
-    mi->setParameter("lodOffset", options.lodOffset - log4(omegaP));
+    mi->setParameter("compress", float2{ options.hdrLinear, options.hdrMax });
+    return mi;
+}
 
-    if (options.generateMipmap) {
-        // We need mipmaps for prefiltering
-        environmentCubemap->generateMipmaps(engine);
-    }
+void IBLPrefilterContext::SpecularFilter::renderLevel(MaterialInstance* mi,
+        Options const& options, Texture* outReflectionsTexture, uint8_t lod, uint8_t side) {
+    using namespace backend;
 
-    RenderTarget::Builder builder;
-    builder.texture(RenderTarget::AttachmentPoint::COLOR0, outReflectionsTexture)
-           .texture(RenderTarget::AttachmentPoint::COLOR1, outReflectionsTexture)
-           .texture(RenderTarget::AttachmentPoint::COLOR2, outReflectionsTexture);
+    const TextureCubemapFace faces[2][3] = {
+            { TextureCubemapFace::POSITIVE_X, TextureCubemapFace::POSITIVE_Y, TextureCubemapFace::POSITIVE_Z },
+            { TextureCubemapFace::NEGATIVE_X, TextureCubemapFace::NEGATIVE_Y, TextureCubemapFace::NEGATIVE_Z }
+    };
 
-    for (size_t lod = 0; lod < levels; lod++) {
-        SYSTRACE_NAME("executeFilterLOD");
+    Engine& engine = mContext.mEngine;
+    View* const view = mContext.mView;
+    Renderer* const renderer = mContext.mRenderer;
 
-        mi->setParameter("sampleCount", uint32_t(lod == 0 ? 1u : sampleCount));
-        mi->setParameter("attachmentLevel", uint32_t(lod));
+    const uint8_t levels = outReflectionsTexture->getLevels();
+    const uint32_t baseDim = outReflectionsTexture->getWidth();
+    const uint32_t dim = std::max(1u, baseDim >> lod);
+    const float omegaP = (4.0f * f::PI) / float(6 * baseDim * baseDim);
 
-        if (lod == levels - 1) {
-            // this is the last lod, use a more agressive filtering because this level is also
-            // used for the diffuse brdf by filament, and we need it to be very smooth.
-            // So we set the lod offset to at least 2.
-            mi->setParameter("lodOffset", std::max(2.0f, options.lodOffset) - log4(omegaP));
-        }
+    // this is the last lod, use a more agressive filtering because this level is also
+    // used for the diffuse brdf by filament, and we need it to be very smooth.
+    // So we set the lod offset to at least 2.
+    const float lodOffset = (lod == levels - 1) ?
+            std::max(2.0f, options.lodOffset) : options.lodOffset;
+
+    mi->setParameter("sampleCount", uint32_t(lod == 0 ? 1u : mSampleCount));
+    mi->setParameter("attachmentLevel", uint32_t(lod));
+    mi->setParameter("lodOffset", lodOffset - log4(omegaP));
+    mi->setParameter("side", side == 0 ? 1.0f : -1.0f);
+
+    RenderTarget* const rt = RenderTarget::Builder()
+            .texture(RenderTarget::AttachmentPoint::COLOR0, outReflectionsTexture)
+            .texture(RenderTarget::AttachmentPoint::COLOR1, outReflectionsTexture)
+            .texture(RenderTarget::AttachmentPoint::COLOR2, outReflectionsTexture)
+            .mipLevel(RenderTarget::AttachmentPoint::COLOR0, lod)
+            .mipLevel(RenderTarget::AttachmentPoint::COLOR1, lod)
+            .mipLevel(RenderTarget::AttachmentPoint::COLOR2, lod)
+            .face(RenderTarget::AttachmentPoint::COLOR0, faces[side][0])
+            .face(RenderTarget::AttachmentPoint::COLOR1, faces[side][1])
+            .face(RenderTarget::AttachmentPoint::COLOR2, faces[side][2])
+            .build(engine);
 
-        builder.mipLevel(RenderTarget::AttachmentPoint::COLOR0, lod)
-               .mipLevel(RenderTarget::AttachmentPoint::COLOR1, lod)
-               .mipLevel(RenderTarget::AttachmentPoint::COLOR2, lod);
+    view->setViewport({ 0, 0, dim, dim });
+    view->setRenderTarget(rt);
+    renderer->renderStandaloneView(view);
+    engine.destroy(rt);
+}
 
-        view->setViewport({ 0, 0, dim, dim });
+// ------------------------------------------------------------------------------------------------
 
-        for (size_t i = 0; i < 2; i++) {
-            mi->setParameter("side", i == 0 ? 1.0f : -1.0f);
+IBLPrefilterContext::IncrementalSpecularFilter::IncrementalSpecularFilter(
+        SpecularFilter& filter, Config config)
+        : mFilter(filter), mSamplesPerUpdate(config.samplesPerUpdate) {
+}
 
-            builder.face(RenderTarget::AttachmentPoint::COLOR0, faces[i][0])
-                   .face(RenderTarget::AttachmentPoint::COLOR1, faces[i][1])
-                   .face(RenderTarget::AttachmentPoint::COLOR2, faces[i][2]);
+UTILS_NOINLINE
+IBLPrefilterContext::IncrementalSpecularFilter::IncrementalSpecularFilter(SpecularFilter& filter)
+        : IncrementalSpecularFilter(filter, {}) {
+}
 
-            RenderTarget* const rt = builder.build(engine);
-            view->setRenderTarget(rt);
-            renderer->renderStandaloneView(view);
-            engine.destroy(rt);
+IBLPrefilterContext::IncrementalSpecularFilter::~IncrementalSpecularFilter() noexcept {
+    Engine& engine = mFilter.mContext.mEngine;
+    engine.destroy(mFront);
+    engine.destroy(mBack);
+}
+
+void IBLPrefilterContext::IncrementalSpecularFilter::start(
+        SpecularFilter::Options options, Texture const* environmentCubemap) {
+    SYSTRACE_CALL();
+
+    ASSERT_PRECONDITION(environmentCubemap != nullptr, "environmentCubemap is null!");
+
+    ASSERT_PRECONDITION(environmentCubemap->getTarget() == Texture::Sampler::SAMPLER_CUBEMAP,
+            "environmentCubemap must be a cubemap.");
+
+    UTILS_UNUSED_IN_RELEASE
+    const uint8_t maxLevelCount = uint8_t(std::log2(environmentCubemap->getWidth()) + 0.5f) + 1u;
+
+    ASSERT_PRECONDITION(environmentCubemap->getLevels() == maxLevelCount,
+            "environmentCubemap must have %u mipmap levels allocated.", +maxLevelCount);
+
+    if (mBack == nullptr) {
+        mBack = mFilter.createReflectionsTexture();
+    }
+
+    if (options.generateMipmap) {
+        // We need mipmaps for prefiltering, this is cheap compared to the filter itself
+        environmentCubemap->generateMipmaps(mFilter.mContext.mEngine);
+    }
+
+    mEnvironment = environmentCubemap;
+    mOptions = options;
+    mLevel = 0;
+    mSide = 0;
+}
+
+bool IBLPrefilterContext::IncrementalSpecularFilter::update(IndirectLight* indirectLight) {
+    if (mEnvironment == nullptr) {
+        return false;
+    }
+
+    SYSTRACE_CALL();
+
+    // the material parameters are shared with all other filters, so they must be set again
+    MaterialInstance* const mi = mFilter.prepare(mOptions, mEnvironment);
+
+    const uint8_t levels = mBack->getLevels();
+    const uint32_t baseDim = mBack->getWidth();
+    uint64_t samples = 0;
+    while (mLevel < levels) {
+        const uint32_t dim = std::max(1u, baseDim >> mLevel);
+        const uint64_t cost = uint64_t(dim) * dim * 3u * (mLevel == 0 ? 1u : mFilter.mSampleCount);
+        if (samples && samples + cost > mSamplesPerUpdate) {
+            break;
+        }
+        mFilter.renderLevel(mi, mOptions, mBack, mLevel, mSide);
+        samples += cost;
+        if (++mSide == 2) {
+            mSide = 0;
+            mLevel++;
         }
+    }
 
-        dim >>= 1;
+    if (mLevel < levels) {
+        return false;
     }
 
-    return outReflectionsTexture;
+    // the new chain is complete, the previous one becomes the back buffer
+    std::swap(mFront, mBack);
+    mEnvironment = nullptr;
+    if (indirectLight) {
+        indirectLight->setReflections(mFront);
+    }
+    return true;
 }
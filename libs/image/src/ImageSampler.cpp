@@ -21,9 +21,13 @@
 #include <math/vec3.h>
 #include <math/vec4.h>
 
-#include <utils/Panic.h>
 #include <utils/CString.h>
+#include <utils/JobSystem.h>
+#include <utils/Panic.h>
 
+#include <algorithm>
+#include <functional>
+#include <limits>
 #include <memory>
 #include <vector>
 #include <unordered_map>
@@ -131,8 +135,9 @@ void generateMadProgram(uint32_t ntarget, uint32_t nsource, float left, float ri
     // As an optimization, compute the "filterBound", which is the half-width of the filter within
     // the [0,1] domain. If this were a huge number, the filtered results would look the same, but
     // the filter would perform very poorly because it would be iterating over a lot more samples
-    // than necessary.
-    const float filterBounds = domainScale * std::abs(filter.boundingRadius);
+    // than necessary. Note that "t" below is domainScale times a distance in [0,1], hence the
+    // division.
+    const float filterBounds = std::abs(filter.boundingRadius) / domainScale;
 
     // Iterate through target samples. "xtarget" points to the center of each target pixel.
     float xtarget = dtarget / 2.0f;
@@ -172,22 +177,31 @@ void generateMadProgram(uint32_t ntarget, uint32_t nsource, float left, float ri
     }
 }
 
-// Transforms a MAD program intended for single-channel data into a program intended for
-// multi-channel data.
-void expandMadProgram(uint32_t nchannels, MadProgram* program) {
-    if (nchannels == 1) {
-        return;
+// A resampling kernel in "gather" form, i.e. the MAD instructions of a single-channel program
+// grouped by target sample. This allows the executors below to keep an accumulator in registers
+// and to process all channels of a pixel, or an entire row of pixels, with each instruction.
+struct Kernel {
+    struct Tap {
+        int32_t sourceIndex;
+        float weight;
+    };
+    std::vector<uint32_t> offsets; // ntarget + 1 offsets into taps
+    std::vector<Tap> taps;
+};
+
+// MAD programs are generated in order of increasing target index, so this is a simple bucketing.
+void compileKernel(const MadProgram& program, uint32_t ntarget, Kernel* kernel) {
+    kernel->offsets.assign(ntarget + 1, 0);
+    kernel->taps.clear();
+    kernel->taps.reserve(program.size());
+    for (const auto& mad : program) {
+        assert_invariant(mad.targetIndex < ntarget);
+        kernel->offsets[mad.targetIndex + 1]++;
+        kernel->taps.push_back({ mad.sourceIndex, mad.weight });
     }
-    MadProgram result;
-    result.reserve(program->size() * nchannels);
-    for (auto mad : *program) {
-        mad.sourceIndex *= nchannels;
-        mad.targetIndex *= nchannels;
-        for (uint32_t j = 0; j < nchannels; ++j, ++mad.sourceIndex, ++mad.targetIndex) {
-            result.push_back(mad);
-        }
+    for (uint32_t i = 0; i < ntarget; ++i) {
+        kernel->offsets[i + 1] += kernel->offsets[i];
     }
-    program->swap(result);
 }
 
 FilterFunction createFilterFunction(Filter ftype) {
@@ -226,50 +240,117 @@ void normalize(LinearImage& image) {
     }
 }
 
-LinearImage resampleImage1D(const LinearImage& source, MadProgram* program,
-        uint32_t twidth, Filter filter, float left, float right, float filterRadiusMultiplier) {
-    const uint32_t swidth = source.getWidth();
-    const uint32_t sheight = source.getHeight();
-    const uint32_t nchan = source.getChannels();
-    const bool mag = twidth > swidth;
-    if (filter == Filter::DEFAULT) filter = mag ? Filter::MITCHELL : Filter::LANCZOS;
-    const FilterFunction hfn = createFilterFunction(filter);
-
-    // Generate a flat list of multiply-add (MAD) instructions.
-    program->clear();
-    generateMadProgram(twidth, swidth, left, right, hfn, filterRadiusMultiplier, program);
-    expandMadProgram(nchan, program);
+Kernel createKernel(uint32_t ntarget, uint32_t nsource, Filter filter, float left, float right,
+        float filterRadiusMultiplier) {
+    MadProgram program;
+    generateMadProgram(ntarget, nsource, left, right, createFilterFunction(filter),
+            filterRadiusMultiplier, &program);
+    Kernel kernel;
+    compileKernel(program, ntarget, &kernel);
+    return kernel;
+}
 
-    // Allocate the target image.
-    LinearImage result(twidth, sheight, nchan);
-    float const* sourceRow = source.getPixelRef();
-    float* targetRow = result.getPixelRef();
+// Runs the given functor over [0, count), split across the JobSystem when one is provided and
+// the amount of work is large enough to be worth it.
+template <typename F>
+void parallelRows(utils::JobSystem* js, uint32_t count, size_t floatsPerRow, F const& functor) {
+    constexpr size_t MIN_FLOATS_PER_JOB = 16 * 1024;
+    if (!js || count * floatsPerRow < 2 * MIN_FLOATS_PER_JOB) {
+        functor(0, count);
+        return;
+    }
+    auto* job = utils::jobs::parallel_for(*js, nullptr, 0, count, std::cref(functor),
+            utils::jobs::CountSplitter<1, 8>());
+    js->runAndWait(job);
+}
 
-    // The MIN filter is special because it starts with non-zero values and ignores filter weights.
-    if (filter == Filter::MINIMUM) {
-        for (uint32_t n = 0; n < twidth * sheight * nchan; ++n) {
-            targetRow[n] = std::numeric_limits<float>::max();
-        }
-        for (uint32_t row = 0; row < sheight; ++row) {
-            for (auto mad : *program) {
-                const float a = sourceRow[mad.sourceIndex];
-                const float b = targetRow[mad.targetIndex];
-                targetRow[mad.targetIndex] = std::min(a, b);
+// Applies the kernel to each row of the source, VecT is the type of a pixel. The accumulation
+// order of the taps is the same as the order of the MAD program.
+template <class VecT, bool MINIMUM>
+void executeRows(const Kernel& kernel, float const* source, float* target, uint32_t swidth,
+        uint32_t twidth, uint32_t row, uint32_t count) {
+    using std::min;
+    const VecT* src = (const VecT*) source + size_t(row) * swidth;
+    VecT* dst = (VecT*) target + size_t(row) * twidth;
+    const Kernel::Tap* taps = kernel.taps.data();
+    const uint32_t* offsets = kernel.offsets.data();
+    for (uint32_t n = 0; n < count; ++n, src += swidth, dst += twidth) {
+        for (uint32_t t = 0; t < twidth; ++t) {
+            VecT acc = MINIMUM ? VecT(std::numeric_limits<float>::max()) : VecT(0);
+            for (uint32_t i = offsets[t], e = offsets[t + 1]; i < e; ++i) {
+                const VecT value = src[taps[i].sourceIndex];
+                if (MINIMUM) {
+                    acc = min(acc, value);
+                } else {
+                    acc += value * taps[i].weight;
+                }
             }
-            targetRow += twidth * nchan;
-            sourceRow += swidth * nchan;
+            dst[t] = acc;
         }
-        return result;
     }
+}
 
-    // Resize the image horizontally by executing the MAD instructions over each row.
-    for (uint32_t row = 0; row < sheight; ++row) {
-        for (auto mad : *program) {
-            targetRow[mad.targetIndex] += sourceRow[mad.sourceIndex] * mad.weight;
+// Same as above for an arbitrary number of channels.
+template <bool MINIMUM>
+void executeRows(const Kernel& kernel, float const* source, float* target, uint32_t swidth,
+        uint32_t twidth, uint32_t nchan, uint32_t row, uint32_t count) {
+    const float* src = source + size_t(row) * swidth * nchan;
+    float* dst = target + size_t(row) * twidth * nchan;
+    for (uint32_t n = 0; n < count; ++n, src += swidth * nchan) {
+        for (uint32_t t = 0; t < twidth; ++t, dst += nchan) {
+            for (uint32_t c = 0; c < nchan; ++c) {
+                float acc = MINIMUM ? std::numeric_limits<float>::max() : 0.0f;
+                for (uint32_t i = kernel.offsets[t], e = kernel.offsets[t + 1]; i < e; ++i) {
+                    const float value = src[kernel.taps[i].sourceIndex * nchan + c];
+                    acc = MINIMUM ? std::min(acc, value) : acc + value * kernel.taps[i].weight;
+                }
+                dst[c] = acc;
+            }
         }
-        targetRow += twidth * nchan;
-        sourceRow += swidth * nchan;
     }
+}
+
+// Resizes the image horizontally by applying the kernel to each row.
+LinearImage resampleHorizontal(utils::JobSystem* js, const LinearImage& source, uint32_t twidth,
+        Filter filter, float left, float right, float filterRadiusMultiplier) {
+    const uint32_t swidth = source.getWidth();
+    const uint32_t sheight = source.getHeight();
+    const uint32_t nchan = source.getChannels();
+    if (filter == Filter::DEFAULT) filter = twidth > swidth ? Filter::MITCHELL : Filter::LANCZOS;
+    const Kernel kernel = createKernel(twidth, swidth, filter, left, right,
+            filterRadiusMultiplier);
+
+    LinearImage result(twidth, sheight, nchan);
+    float const* src = source.getPixelRef();
+    float* dst = result.getPixelRef();
+
+    auto work = [&](uint32_t row, uint32_t count) {
+        using namespace filament::math;
+        const bool minimum = filter == Filter::MINIMUM;
+        switch (nchan) {
+            case 1: minimum ?
+                    executeRows<float, true>(kernel, src, dst, swidth, twidth, row, count) :
+                    executeRows<float, false>(kernel, src, dst, swidth, twidth, row, count);
+                break;
+            case 2: minimum ?
+                    executeRows<float2, true>(kernel, src, dst, swidth, twidth, row, count) :
+                    executeRows<float2, false>(kernel, src, dst, swidth, twidth, row, count);
+                break;
+            case 3: minimum ?
+                    executeRows<float3, true>(kernel, src, dst, swidth, twidth, row, count) :
+                    executeRows<float3, false>(kernel, src, dst, swidth, twidth, row, count);
+                break;
+            case 4: minimum ?
+                    executeRows<float4, true>(kernel, src, dst, swidth, twidth, row, count) :
+                    executeRows<float4, false>(kernel, src, dst, swidth, twidth, row, count);
+                break;
+            default: minimum ?
+                    executeRows<true>(kernel, src, dst, swidth, twidth, nchan, row, count) :
+                    executeRows<false>(kernel, src, dst, swidth, twidth, nchan, row, count);
+                break;
+        }
+    };
+    parallelRows(js, sheight, size_t(swidth) * nchan, work);
 
     // Perform post processing for the current pass.
     if (filter == Filter::GAUSSIAN_NORMALS) {
@@ -278,16 +359,54 @@ LinearImage resampleImage1D(const LinearImage& source, MadProgram* program,
     return result;
 }
 
-} // anonymous namespace
-
-namespace image {
+// Resizes the image vertically. Each target row is a weighted sum of entire source rows, which
+// avoids transposing the image and lets the compiler vectorize the inner loop across all pixels
+// and channels of the row.
+LinearImage resampleVertical(utils::JobSystem* js, const LinearImage& source, uint32_t theight,
+        Filter filter, float top, float bottom, float filterRadiusMultiplier) {
+    const uint32_t swidth = source.getWidth();
+    const uint32_t sheight = source.getHeight();
+    const uint32_t nchan = source.getChannels();
+    if (filter == Filter::DEFAULT) filter = theight > sheight ? Filter::MITCHELL : Filter::LANCZOS;
+    const Kernel kernel = createKernel(theight, sheight, filter, top, bottom,
+            filterRadiusMultiplier);
+
+    LinearImage result(swidth, theight, nchan);
+    const size_t rowSize = size_t(swidth) * nchan;
+    float const* src = source.getPixelRef();
+    float* dst = result.getPixelRef();
+
+    auto work = [&](uint32_t row, uint32_t count) {
+        const bool minimum = filter == Filter::MINIMUM;
+        for (uint32_t t = row; t < row + count; ++t) {
+            float* UTILS_RESTRICT out = dst + t * rowSize;
+            std::fill_n(out, rowSize, minimum ? std::numeric_limits<float>::max() : 0.0f);
+            for (uint32_t i = kernel.offsets[t], e = kernel.offsets[t + 1]; i < e; ++i) {
+                float const* UTILS_RESTRICT in = src + kernel.taps[i].sourceIndex * rowSize;
+                const float weight = kernel.taps[i].weight;
+                if (minimum) {
+                    for (size_t n = 0; n < rowSize; ++n) {
+                        out[n] = std::min(out[n], in[n]);
+                    }
+                } else {
+                    for (size_t n = 0; n < rowSize; ++n) {
+                        out[n] += in[n] * weight;
+                    }
+                }
+            }
+        }
+    };
+    parallelRows(js, theight, rowSize * (kernel.taps.size() / std::max(theight, 1u) + 1), work);
 
-SingleSample::~SingleSample() {
-    delete[] data;
+    // Perform post processing for the current pass.
+    if (filter == Filter::GAUSSIAN_NORMALS) {
+        normalize(result);
+    }
+    return result;
 }
 
-LinearImage resampleImage(const LinearImage& source, uint32_t width, uint32_t height,
-        const ImageSampler& sampler) {
+LinearImage resampleImageImpl(utils::JobSystem* js, const LinearImage& source, uint32_t width,
+        uint32_t height, const ImageSampler& sampler) {
     ASSERT_PRECONDITION(
         sampler.east.mode == Boundary::EXCLUDE &&
         sampler.north.mode == Boundary::EXCLUDE &&
@@ -300,11 +419,41 @@ LinearImage resampleImage(const LinearImage& source, uint32_t width, uint32_t he
     const float top = sampler.sourceRegion.top;
     const float right = sampler.sourceRegion.right;
     const float bottom = sampler.sourceRegion.bottom;
-    MadProgram program;
-    LinearImage result;
-    result = transpose(resampleImage1D(source, &program, width, hfilter, left, right, radius));
-    result = transpose(resampleImage1D(result, &program, height, vfilter, top, bottom, radius));
-    return result;
+    LinearImage result = resampleHorizontal(js, source, width, hfilter, left, right, radius);
+    return resampleVertical(js, result, height, vfilter, top, bottom, radius);
+}
+
+void generateMipmapsImpl(utils::JobSystem* js, const LinearImage& source, Filter filter,
+        LinearImage* result, uint32_t mips) {
+    mips = std::min(mips, getMipmapCount(source));
+    uint32_t width = source.getWidth();
+    uint32_t height = source.getHeight();
+    for (uint32_t n = 0; n < mips; ++n) {
+        width = std::max(width >> 1u, 1u);
+        height = std::max(height >> 1u, 1u);
+        result[n] = resampleImageImpl(js, source, width, height, ImageSampler {
+            .horizontalFilter = filter,
+            .verticalFilter = filter
+        });
+    }
+}
+
+} // anonymous namespace
+
+namespace image {
+
+SingleSample::~SingleSample() {
+    delete[] data;
+}
+
+LinearImage resampleImage(const LinearImage& source, uint32_t width, uint32_t height,
+        const ImageSampler& sampler) {
+    return resampleImageImpl(nullptr, source, width, height, sampler);
+}
+
+LinearImage resampleImage(utils::JobSystem& js, const LinearImage& source, uint32_t width,
+        uint32_t height, const ImageSampler& sampler) {
+    return resampleImageImpl(&js, source, width, height, sampler);
 }
 
 LinearImage resampleImage(const LinearImage& source, uint32_t width, uint32_t height,
@@ -322,9 +471,8 @@ void computeSingleSample(const LinearImage& source, float x, float y, SingleSamp
     const float top = y - radius / source.getHeight();
     const float right = x + radius / source.getWidth();
     const float bottom = y + radius / source.getHeight();
-    MadProgram program;
-    LinearImage row = transpose(resampleImage1D(source, &program, 1, filter, left, right, radius));
-    row = resampleImage1D(row, &program, 1, filter, top, bottom, radius);
+    LinearImage row = resampleHorizontal(nullptr, source, 1, filter, left, right, radius);
+    row = resampleVertical(nullptr, row, 1, filter, top, bottom, radius);
     if (!result->data) {
         result->data = new float[source.getChannels()];
     }
@@ -338,14 +486,12 @@ void computeSingleSample(const LinearImage& source, float x, float y, SingleSamp
 // Unlike traditional mipmap generation, our implementation generates all levels from the original
 // image, under the premise that this produces a higher quality result.
 void generateMipmaps(const LinearImage& source, Filter filter, LinearImage* result, uint32_t mips) {
-    mips = std::min(mips, getMipmapCount(source));
-    uint32_t width = source.getWidth();
-    uint32_t height = source.getHeight();
-    for (uint32_t n = 0; n < mips; ++n) {
-        width = std::max(width >> 1u, 1u);
-        height = std::max(height >> 1u, 1u);
-        result[n] = resampleImage(source, width, height, filter);
-    }
+    generateMipmapsImpl(nullptr, source, filter, result, mips);
+}
+
+void generateMipmaps(utils::JobSystem& js, const LinearImage& source, Filter filter,
+        LinearImage* result, uint32_t mips) {
+    generateMipmapsImpl(&js, source, filter, result, mips);
 }
 
 uint32_t getMipmapCount(const LinearImage& source) {
@@ -26,6 +26,7 @@
 
 #include <gtest/gtest.h>
 
+#include <utils/JobSystem.h>
 #include <utils/Panic.h>
 #include <utils/Path.h>
 
@@ -35,6 +36,7 @@
 #include <fstream>
 #include <string>
 #include <sstream>
+#include <utility>
 #include <vector>
 
 using std::istringstream;
@@ -76,6 +78,12 @@ static void updateOrCompare(const LinearImage& limg, const utils::Path& fname);
 // Subtracts two images, does an abs(), then normalizes such that min/max transform to 0/1.
 static LinearImage diffImages(const LinearImage& a, const LinearImage& b);
 
+// Creates an image filled with pseudo-random values, with the given number of channels.
+static LinearImage createNoise(uint32_t width, uint32_t height, uint32_t channels);
+
+// Returns whether two images have the same dimensions and exactly the same pixels.
+static bool identical(const LinearImage& a, const LinearImage& b);
+
 TEST_F(ImageTest, LuminanceFilters) { // NOLINT
     auto tiny = createGrayFromAscii("000 010 000");
     ASSERT_EQ(tiny.getWidth(), 3);
@@ -362,6 +370,52 @@ TEST_F(ImageTest, Mipmaps) { // NOLINT
     }
 }
 
+TEST_F(ImageTest, ParallelResampling) { // NOLINT
+    const Filter filters[] = {
+        Filter::DEFAULT, Filter::BOX, Filter::NEAREST, Filter::HERMITE, Filter::GAUSSIAN_SCALARS,
+        Filter::GAUSSIAN_NORMALS, Filter::MITCHELL, Filter::LANCZOS, Filter::MINIMUM
+    };
+
+    utils::JobSystem js;
+    js.adopt();
+
+    // Large enough for the rows to be split across jobs. Every number of channels has its own
+    // code path, and 5 channels takes the generic one.
+    for (uint32_t channels : { 1, 2, 3, 4, 5 }) {
+        const LinearImage src = createNoise(301, 217, channels);
+        for (Filter filter : filters) {
+            if (filter == Filter::GAUSSIAN_NORMALS && channels != 3 && channels != 4) {
+                continue;
+            }
+            const ImageSampler sampler {
+                .horizontalFilter = filter,
+                .verticalFilter = filter,
+                .sourceRegion = { 0.1f, 0.05f, 0.9f, 0.8f },
+            };
+            const std::pair<uint32_t, uint32_t> sizes[] = { { 97, 83 }, { 640, 512 }, { 450, 64 } };
+            for (auto [width, height] : sizes) {
+                EXPECT_TRUE(identical(resampleImage(js, src, width, height, sampler),
+                        resampleImage(src, width, height, sampler)))
+                        << "filter " << int(filter) << ", " << channels << " channels, "
+                        << width << "x" << height;
+            }
+
+            const uint32_t count = getMipmapCount(src);
+            vector<LinearImage> expected(count);
+            vector<LinearImage> actual(count);
+            generateMipmaps(src, filter, expected.data(), count);
+            generateMipmaps(js, src, filter, actual.data(), count);
+            for (uint32_t index = 0; index < count; ++index) {
+                EXPECT_TRUE(identical(actual[index], expected[index]))
+                        << "filter " << int(filter) << ", " << channels << " channels, mip "
+                        << index + 1;
+            }
+        }
+    }
+
+    js.emancipate();
+}
+
 TEST_F(ImageTest, Ktx) { // NOLINT
     uint8_t foo[] = {1, 2, 3};
     uint8_t* data;
@@ -691,3 +745,23 @@ static LinearImage diffImages(const LinearImage& a, const LinearImage& b) {
     }
     return result;
 }
+
+static LinearImage createNoise(uint32_t width, uint32_t height, uint32_t channels) {
+    LinearImage result(width, height, channels);
+    float* data = result.getPixelRef();
+    uint32_t seed = 1;
+    for (size_t i = 0, n = size_t(width) * height * channels; i < n; ++i) {
+        seed = seed * 1664525u + 1013904223u;
+        data[i] = float(seed >> 8u) / float(1u << 24u) - 0.25f;
+    }
+    return result;
+}
+
+static bool identical(const LinearImage& a, const LinearImage& b) {
+    if (a.getWidth() != b.getWidth() || a.getHeight() != b.getHeight() ||
+            a.getChannels() != b.getChannels()) {
+        return false;
+    }
+    const size_t size = size_t(a.getWidth()) * a.getHeight() * a.getChannels() * sizeof(float);
+    return memcmp(a.getPixelRef(), b.getPixelRef(), size) == 0;
+}
@@ -21,6 +21,7 @@
 
 #include <image/LinearImage.h>
 
+#include <functional>
 #include <memory>
 #include <string>
 
@@ -30,6 +31,10 @@
 
 #include <stdint.h>
 
+namespace utils {
+class JobSystem;
+} // namespace utils
+
 namespace image {
 
 enum class CompressedFormat {
@@ -189,6 +194,27 @@ bool parseOptionString(const std::string& options, CompressionConfig* config);
 UTILS_PUBLIC
 CompressedTexture compressTexture(const CompressionConfig& config, const LinearImage& image);
 
+// Same as above, but splits the image into bands of block rows that are compressed concurrently
+// on the given JobSystem. The calling thread must be known to the JobSystem, e.g. via adopt().
+UTILS_PUBLIC
+CompressedTexture compressTexture(utils::JobSystem& js, const CompressionConfig& config,
+        const LinearImage& image);
+
+// Produces the uncompressed image for the given miplevel. This can be called concurrently from
+// several JobSystem threads.
+using MipmapGenerator = std::function<LinearImage(uint32_t level)>;
+
+// Receives the compressed image for the given miplevel. This is called on the calling thread of
+// compressMipmaps, in order of increasing level.
+using CompressedMipmapCallback = std::function<void(uint32_t level, CompressedTexture texture)>;
+
+// Compresses all levels of a mipmap chain concurrently, in addition to splitting each level into
+// bands. Levels are generated on demand and released as soon as they have been compressed, which
+// allows streaming the results into a container without holding the entire uncompressed chain.
+UTILS_PUBLIC
+void compressMipmaps(utils::JobSystem& js, const CompressionConfig& config, uint32_t levelCount,
+        const MipmapGenerator& generator, const CompressedMipmapCallback& callback);
+
 } // namespace image
 
 #endif /* IMAGEIO_BLOCKCOMPRESSION_H_ */
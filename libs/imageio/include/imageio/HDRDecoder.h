@@ -19,8 +19,44 @@
 
 #include <imageio/ImageDecoder.h>
 
+#include <math/vec3.h>
+
+#include <utils/compiler.h>
+
+#include <iosfwd>
+#include <memory>
+
+#include <stdint.h>
+
 namespace image {
 
+// Decodes a Radiance HDR stream one scanline at a time, from top to bottom. This allows processing
+// images that would be too large to be held in memory entirely.
+class UTILS_PUBLIC HDRScanlineDecoder {
+public:
+    explicit HDRScanlineDecoder(std::istream& stream);
+    ~HDRScanlineDecoder();
+
+    HDRScanlineDecoder(const HDRScanlineDecoder&) = delete;
+    HDRScanlineDecoder& operator=(const HDRScanlineDecoder&) = delete;
+
+    // Parses the header, this must be called first. Returns false if the header is invalid.
+    bool decodeHeader();
+
+    uint32_t getWidth() const noexcept { return mWidth; }
+    uint32_t getHeight() const noexcept { return mHeight; }
+
+    // Decodes the next scanline into getWidth() linear RGB values. Returns false on error.
+    bool decodeScanline(filament::math::float3* dst);
+
+private:
+    std::istream& mStream;
+    std::unique_ptr<uint8_t[]> mRgbe;
+    uint32_t mWidth = 0;
+    uint32_t mHeight = 0;
+    bool mRunLengthEncoded = false;
+};
+
 class HDRDecoder : public ImageDecoder::Decoder {
 public:
     static HDRDecoder* create(std::istream& stream);
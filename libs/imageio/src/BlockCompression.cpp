@@ -18,9 +18,15 @@
 
 #include <image/ImageOps.h>
 
+#include <utils/JobSystem.h>
+
 #include <algorithm>
+#include <bitset>
 #include <cmath>
+#include <functional>
+#include <mutex>
 #include <thread>
+#include <vector>
 
 #include <astcenc.h>
 #include <Etc.h>
@@ -32,17 +38,30 @@ namespace image {
 
 static LinearImage extendToFourChannels(LinearImage source);
 
-CompressedTexture astcCompress(const LinearImage& original, AstcConfig config) {
+// Runs the functor over ranges of [0, count), which are processed concurrently when a JobSystem
+// is provided. Block compression is expensive enough that a single row of blocks is worth a job.
+template <typename F>
+static void forEachBand(utils::JobSystem* js, uint32_t count, F const& functor) {
+    if (!js || count < 2) {
+        functor(0, count);
+        return;
+    }
+    auto* job = utils::jobs::parallel_for(*js, nullptr, 0, count, std::cref(functor),
+            utils::jobs::CountSplitter<1, 6>());
+    js->runAndWait(job);
+}
 
-    // If this is the first time, initialize the ARM encoder tables.
+// Everything astcenc needs to encode an image, as derived from an AstcConfig.
+struct AstcEncoder {
+    CompressedFormat format;
+    int xdim, ydim, zdim;
+    error_weighting_params ewp;
+    astc_decode_mode decode_mode;
+    swizzlepattern swz_encode;
+    swizzlepattern swz_decode;
+};
 
-    static bool first = true;
-    if (first) {
-        test_inappropriate_extended_precision();
-        prepare_angular_tables();
-        build_quantization_mode_table();
-        first = false;
-    }
+static bool astcCreateEncoder(AstcConfig config, AstcEncoder* encoder) {
 
     // Check the validity of the given block size.
 
@@ -77,26 +96,7 @@ CompressedTexture astcCompress(const LinearImage& original, AstcConfig config) {
     } else if (config.blocksize ==  filament::math::ushort2 {12, 12}) {
         format = config.srgb ? Format::SRGB8_ALPHA8_ASTC_12x12 : Format::RGBA_ASTC_12x12;
     } else {
-        return {};
-    }
-
-    // Create an input image for the ARM encoder in a format that it can consume.
-    // It expects four-channel data, so we extend or curtail the channel count in a reasonable way.
-    // The encoder can take half-floats or bytes, but we always give it half-floats.
-
-    LinearImage source = extendToFourChannels(original);
-    const uint32_t width = source.getWidth();
-    const uint32_t height = source.getHeight();
-    astc_codec_image* input_image = allocate_image(16, width, height, 1, 0);
-    for (int y = 0; y < height; y++) {
-        auto imagedata16 = input_image->imagedata16[0][y];
-        float const* src = source.getPixelRef(0, y);
-        for (int x = 0; x < width; x++) {
-            imagedata16[4 * x] = float_to_sf16(src[4 * x], SF_NEARESTEVEN);
-            imagedata16[4 * x + 1] = float_to_sf16(src[4 * x + 1], SF_NEARESTEVEN);
-            imagedata16[4 * x + 2] = float_to_sf16(src[4 * x + 2], SF_NEARESTEVEN);
-            imagedata16[4 * x + 3] = float_to_sf16(src[4 * x + 3], SF_NEARESTEVEN);
-        }
+        return false;
     }
 
     // Determine the bitrate based on the specified block size.
@@ -221,7 +221,7 @@ CompressedTexture astcCompress(const LinearImage& original, AstcConfig config) {
         plimit_autoset = PARTITION_COUNT;
     }
 
-    error_weighting_params ewp;
+    error_weighting_params& ewp = encoder->ewp;
     ewp.rgb_power = 1.0f;
     ewp.alpha_power = 1.0f;
     ewp.rgb_base_weight = 1.0f;
@@ -252,7 +252,7 @@ CompressedTexture astcCompress(const LinearImage& original, AstcConfig config) {
     int xdim = xdim_2d, ydim = ydim_2d, zdim = 1;
     expand_block_artifact_suppression(xdim, ydim, zdim, &ewp);
 
-    // Perform compression.
+    // Set up the decode mode and swizzles.
 
     swizzlepattern swz_encode = { 0, 1, 2, 3 };
     swizzlepattern swz_decode = { 0, 1, 2, 3 };
@@ -289,6 +289,75 @@ CompressedTexture astcCompress(const LinearImage& original, AstcConfig config) {
             break;
     }
 
+    encoder->format = format;
+    encoder->xdim = xdim;
+    encoder->ydim = ydim;
+    encoder->zdim = zdim;
+    encoder->decode_mode = decode_mode;
+    encoder->swz_encode = swz_encode;
+    encoder->swz_decode = swz_decode;
+    return true;
+}
+
+// astcenc builds its global tables lazily and without synchronization. Encoding a dummy block
+// under a lock ensures that the tables for the given block size exist before any concurrent use.
+static void astcPrepareTables(const AstcEncoder& encoder) {
+    static std::mutex lock;
+    static bool first = true;
+    static std::bitset<256> prepared;
+    std::lock_guard<std::mutex> guard(lock);
+    if (first) {
+        test_inappropriate_extended_precision();
+        prepare_angular_tables();
+        build_quantization_mode_table();
+        first = false;
+    }
+    const size_t key = encoder.xdim + 16 * encoder.ydim;
+    if (!prepared[key]) {
+        astc_codec_image* dummy = allocate_image(16, encoder.xdim, encoder.ydim, 1, 0);
+        std::fill_n(dummy->imagedata16[0][0], 4 * encoder.xdim * encoder.ydim, 0);
+        uint8_t block[16];
+        encode_astc_image(dummy, nullptr, encoder.xdim, encoder.ydim, encoder.zdim,
+                &encoder.ewp, encoder.decode_mode, encoder.swz_encode, encoder.swz_decode, block,
+                0, 1);
+        destroy_image(dummy);
+        prepared[key] = true;
+    }
+}
+
+static CompressedTexture astcCompressImpl(utils::JobSystem* js, const LinearImage& original,
+        AstcConfig config) {
+    AstcEncoder encoder;
+    if (!astcCreateEncoder(config, &encoder)) {
+        return {};
+    }
+    astcPrepareTables(encoder);
+
+    // Create an input image for the ARM encoder in a format that it can consume.
+    // It expects four-channel data, so we extend or curtail the channel count in a reasonable way.
+    // The encoder can take half-floats or bytes, but we always give it half-floats.
+
+    LinearImage source = extendToFourChannels(original);
+    const uint32_t width = source.getWidth();
+    const uint32_t height = source.getHeight();
+    astc_codec_image* input_image = allocate_image(16, width, height, 1, 0);
+    forEachBand(js, height, [&](uint32_t y0, uint32_t count) {
+        for (uint32_t y = y0; y < y0 + count; y++) {
+            auto imagedata16 = input_image->imagedata16[0][y];
+            float const* src = source.getPixelRef(0, y);
+            for (uint32_t x = 0; x < width; x++) {
+                imagedata16[4 * x] = float_to_sf16(src[4 * x], SF_NEARESTEVEN);
+                imagedata16[4 * x + 1] = float_to_sf16(src[4 * x + 1], SF_NEARESTEVEN);
+                imagedata16[4 * x + 2] = float_to_sf16(src[4 * x + 2], SF_NEARESTEVEN);
+                imagedata16[4 * x + 3] = float_to_sf16(src[4 * x + 3], SF_NEARESTEVEN);
+            }
+        }
+    });
+
+    // Perform compression.
+
+    const int xdim = encoder.xdim, ydim = encoder.ydim, zdim = encoder.zdim;
+    const error_weighting_params& ewp = encoder.ewp;
     const int threadcount = std::thread::hardware_concurrency();
 
     const int xsize = input_image->xsize;
@@ -301,18 +370,42 @@ CompressedTexture astcCompress(const LinearImage& original, AstcConfig config) {
     uint32_t size = xblocks * yblocks * zblocks * 16;
     uint8_t* buffer = new uint8_t[size];
 
-    encode_astc_image(input_image, nullptr, xdim, ydim, zdim, &ewp, decode_mode,
-            swz_encode, swz_decode, buffer, 0, threadcount);
+    // The error weights of the mean / stdev modes are looked up by absolute texel position, so
+    // those cannot be split into bands.
+    const bool positional = ewp.rgb_mean_weight != 0 || ewp.rgb_stdev_weight != 0 ||
+            ewp.alpha_mean_weight != 0 || ewp.alpha_stdev_weight != 0;
+
+    if (!js || positional) {
+        encode_astc_image(input_image, nullptr, xdim, ydim, zdim, &ewp, encoder.decode_mode,
+                encoder.swz_encode, encoder.swz_decode, buffer, 0, threadcount);
+    } else {
+        // Each band of block rows is encoded as an image that shares the rows of the input image.
+        // Blocks only ever sample texels within their own footprint, so this produces the exact
+        // same output as encoding the whole image at once.
+        forEachBand(js, yblocks, [&](uint32_t by, uint32_t count) {
+            const int y0 = by * ydim;
+            uint16_t** rows = input_image->imagedata16[0] + y0;
+            astc_codec_image band = *input_image;
+            band.imagedata16 = &rows;
+            band.ysize = std::min(int(count) * ydim, ysize - y0);
+            encode_astc_image(&band, nullptr, xdim, ydim, zdim, &ewp, encoder.decode_mode,
+                    encoder.swz_encode, encoder.swz_decode, buffer + by * xblocks * 16, 0, 1);
+        });
+    }
 
     destroy_image(input_image);
 
     return {
-        .format = format,
+        .format = encoder.format,
         .size = size,
         .data = decltype(CompressedTexture::data)(buffer)
     };
 }
 
+CompressedTexture astcCompress(const LinearImage& original, AstcConfig config) {
+    return astcCompressImpl(nullptr, original, config);
+}
+
 AstcConfig astcParseOptionString(const std::string& configString) {
     const size_t _1 = configString.find('_');
     const size_t _2 = configString.find('_', _1 + 1);
@@ -382,22 +475,33 @@ static void extract4x4RGBA(uint8_t* dst, const LinearImage& source, uint32_t x0,
 //  - DXT5 with alpha (16 input pixels into 128 bits of output, 4:1)
 //
 // TODO: investigate using something more capable than STB (eg AMD Compressenator, bimg, libsquish)
-CompressedTexture s3tcCompress(const LinearImage& original, S3tcConfig config) {
+static CompressedTexture s3tcCompressImpl(utils::JobSystem* js, const LinearImage& original,
+        S3tcConfig config) {
+    // STB initializes its tables on first use, make sure this happens before any concurrent use.
+    static std::once_flag init;
+    std::call_once(init, [] {
+        uint8_t block[64] = {};
+        uint8_t dst[16];
+        stb_compress_dxt_block(dst, block, 0, 0);
+    });
     const bool dxt5 = config.format == CompressedFormat::RGBA_S3TC_DXT5;
+    const uint32_t blockSize = dxt5 ? 16 : 8;
     LinearImage source = extendToFourChannels(original);
-    uint8_t block[64];
     uint32_t xblocks = (source.getWidth() + 3) / 4;
     uint32_t yblocks = (source.getHeight() + 3) / 4;
-    uint32_t size = xblocks * yblocks * (dxt5 ? 16 : 8);
+    uint32_t size = xblocks * yblocks * blockSize;
     uint8_t* buffer = new uint8_t[size];
-    uint8_t* dst = buffer;
-    for (int y = 0, h = source.getHeight(); y < h; y += 4) {
-        for (int x = 0, w = source.getWidth(); x < w; x += 4) {
-            extract4x4RGBA(block, source, x, y);
-            stb_compress_dxt_block(dst, block, dxt5, 8);
-            dst += dxt5 ? 16 : 8;
+    forEachBand(js, yblocks, [&](uint32_t by, uint32_t count) {
+        uint8_t block[64];
+        uint8_t* dst = buffer + by * xblocks * blockSize;
+        for (uint32_t y = by * 4, y1 = (by + count) * 4; y < y1; y += 4) {
+            for (uint32_t x = 0, w = source.getWidth(); x < w; x += 4) {
+                extract4x4RGBA(block, source, x, y);
+                stb_compress_dxt_block(dst, block, dxt5, 8);
+                dst += blockSize;
+            }
         }
-    }
+    });
     return {
         .format = config.format,
         .size = size,
@@ -405,6 +509,10 @@ CompressedTexture s3tcCompress(const LinearImage& original, S3tcConfig config) {
     };
 }
 
+CompressedTexture s3tcCompress(const LinearImage& original, S3tcConfig config) {
+    return s3tcCompressImpl(nullptr, original, config);
+}
+
 S3tcConfig s3tcParseOptionString(const std::string& options) {
     if (options == "rgb_dxt1") {
         return {CompressedFormat::RGB_S3TC_DXT1, false};
@@ -415,7 +523,8 @@ S3tcConfig s3tcParseOptionString(const std::string& options) {
     return {};
 }
 
-CompressedTexture etcCompress(const LinearImage& original, EtcConfig config) {
+static CompressedTexture etcCompressImpl(utils::JobSystem* js, const LinearImage& original,
+        EtcConfig config) {
     LinearImage source = extendToFourChannels(original);
     const int threadcount = std::thread::hardware_concurrency();
     Etc::Image::Format etcformat;
@@ -451,24 +560,69 @@ CompressedTexture etcCompress(const LinearImage& original, EtcConfig config) {
     // commented-out "delete[] m_paucEncodingBits" in their Image destructor, which is essentially
     // what our unique_ptr wrapper does (CompressedTexture::data).
 
-    Etc::Encode(source.getPixelRef(0, 0),
-        source.getWidth(), source.getHeight(),
-        etcformat,
-        etcmetric,
-        config.effort,
-        threadcount,
-        1024,
-        &paucEncodingBits, &uiEncodingBitsBytes,
-        &uiExtendedWidth, &uiExtendedHeight,
-        &iEncodingTime_ms);
+    if (!js) {
+        Etc::Encode(source.getPixelRef(0, 0),
+            source.getWidth(), source.getHeight(),
+            etcformat,
+            etcmetric,
+            config.effort,
+            threadcount,
+            1024,
+            &paucEncodingBits, &uiEncodingBitsBytes,
+            &uiExtendedWidth, &uiExtendedHeight,
+            &iEncodingTime_ms);
+
+        return {
+            .format = config.format,
+            .size = uiEncodingBitsBytes,
+            .data = decltype(CompressedTexture::data)(paucEncodingBits)
+        };
+    }
 
+    // Each band of block rows is encoded separately and the results are concatenated, which
+    // matches the block order of a whole-image encoding. Note that etc2comp spends its effort on
+    // the blocks with the highest error, which is now decided per band.
+    const uint32_t width = source.getWidth();
+    const uint32_t height = source.getHeight();
+    const uint32_t yblocks = (height + 3) / 4;
+    struct Band {
+        std::unique_ptr<uint8_t[]> data;
+        uint32_t size = 0;
+    };
+    std::vector<Band> bands(yblocks);
+    forEachBand(js, yblocks, [&](uint32_t by, uint32_t count) {
+        unsigned char *bits;
+        unsigned int bytes, extendedWidth, extendedHeight;
+        int ms;
+        const uint32_t y0 = by * 4;
+        Etc::Encode(source.getPixelRef(0, y0), width, std::min(count * 4, height - y0),
+                etcformat, etcmetric, config.effort, 1, 1,
+                &bits, &bytes, &extendedWidth, &extendedHeight, &ms);
+        bands[by].data.reset(bits);
+        bands[by].size = bytes;
+    });
+
+    uint32_t size = 0;
+    for (const Band& band : bands) {
+        size += band.size;
+    }
+    uint8_t* buffer = new uint8_t[size];
+    uint8_t* dst = buffer;
+    for (const Band& band : bands) {
+        std::copy_n(band.data.get(), band.size, dst);
+        dst += band.size;
+    }
     return {
         .format = config.format,
-        .size = uiEncodingBitsBytes,
-        .data = decltype(CompressedTexture::data)(paucEncodingBits)
+        .size = size,
+        .data = decltype(CompressedTexture::data)(buffer)
     };
 }
 
+CompressedTexture etcCompress(const LinearImage& original, EtcConfig config) {
+    return etcCompressImpl(nullptr, original, config);
+}
+
 EtcConfig etcParseOptionString(const std::string& options) {
     EtcConfig result {};
     const size_t _2 = options.rfind('_');
@@ -533,19 +687,49 @@ bool parseOptionString(const std::string& options, CompressionConfig* config) {
     return config->type != CompressionConfig::INVALID;
 }
 
-CompressedTexture compressTexture(const CompressionConfig& config, const LinearImage& image) {
+static CompressedTexture compressTextureImpl(utils::JobSystem* js,
+        const CompressionConfig& config, const LinearImage& image) {
     if (config.type == CompressionConfig::ASTC) {
-        return astcCompress(image, config.astc);
+        return astcCompressImpl(js, image, config.astc);
     }
     if (config.type == CompressionConfig::S3TC) {
-        return s3tcCompress(image, config.s3tc);
+        return s3tcCompressImpl(js, image, config.s3tc);
     }
     if (config.type == CompressionConfig::ETC) {
-        return etcCompress(image, config.etc);
+        return etcCompressImpl(js, image, config.etc);
     }
     return {};
 }
 
+CompressedTexture compressTexture(const CompressionConfig& config, const LinearImage& image) {
+    return compressTextureImpl(nullptr, config, image);
+}
+
+CompressedTexture compressTexture(utils::JobSystem& js, const CompressionConfig& config,
+        const LinearImage& image) {
+    return compressTextureImpl(&js, config, image);
+}
+
+void compressMipmaps(utils::JobSystem& js, const CompressionConfig& config, uint32_t levelCount,
+        const MipmapGenerator& generator, const CompressedMipmapCallback& callback) {
+    // Every level gets its own job, whose bands are in turn distributed across the JobSystem.
+    // The uncompressed image of a level only lives for the duration of its job.
+    std::vector<std::unique_ptr<CompressedTexture>> results(levelCount);
+    std::vector<utils::JobSystem::Job*> jobs(levelCount);
+    for (uint32_t level = 0; level < levelCount; ++level) {
+        jobs[level] = js.runAndRetain(utils::jobs::createJob(js, nullptr,
+                [&js, &config, &generator, &results, level]() {
+            LinearImage image = generator(level);
+            results[level].reset(new CompressedTexture(compressTextureImpl(&js, config, image)));
+        }));
+    }
+    for (uint32_t level = 0; level < levelCount; ++level) {
+        js.waitAndRelease(jobs[level]);
+        callback(level, std::move(*results[level]));
+        results[level].reset();
+    }
+}
+
 static LinearImage extendToFourChannels(LinearImage original) {
     LinearImage source = original;
     const uint32_t width = source.getWidth();
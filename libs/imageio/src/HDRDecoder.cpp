@@ -16,8 +16,6 @@
 
 #include <imageio/HDRDecoder.h>
 
-#include <image/ImageOps.h>
-
 #include <math/vec3.h>
 
 #include <utils/Log.h>
@@ -26,6 +24,8 @@
 #include <memory>
 #include <sstream>
 
+#include <string.h>
+
 // for ntohs
 #if defined(WIN32)
 #    include <Winsock2.h>
@@ -58,6 +58,32 @@ HDRDecoder::HDRDecoder(std::istream& stream)
 HDRDecoder::~HDRDecoder() = default;
 
 LinearImage HDRDecoder::decode() {
+    HDRScanlineDecoder decoder(mStream);
+    if (!decoder.decodeHeader()) {
+        slog.e << "invalid header" << io::endl;
+        return {};
+    }
+
+    const uint32_t width = decoder.getWidth();
+    const uint32_t height = decoder.getHeight();
+    LinearImage image(width, height, 3);
+    for (uint32_t y = 0; y < height; y++) {
+        auto* dst = reinterpret_cast<filament::math::float3*>(image.getPixelRef(0, y));
+        if (!decoder.decodeScanline(dst)) {
+            return {};
+        }
+    }
+    return image;
+}
+
+// ------------------------------------------------------------------------------------------------
+
+HDRScanlineDecoder::HDRScanlineDecoder(std::istream& stream) : mStream(stream) {
+}
+
+HDRScanlineDecoder::~HDRScanlineDecoder() = default;
+
+bool HDRScanlineDecoder::decodeHeader() {
     float gamma;
     float exposure;
     char sy, sx;
@@ -67,6 +93,7 @@ LinearImage HDRDecoder::decode() {
         do {
             char format[128];
             mStream.getline(buf, sizeof(buf), 0xa);
+            if (!mStream) return false;
             if (buf[0] == '#') continue;
             sscanf(buf, "FORMAT=%127s", format); // NOLINT
             sscanf(buf, "GAMMA=%f", &gamma); // NOLINT
@@ -77,92 +104,105 @@ LinearImage HDRDecoder::decode() {
             }
         } while (true);
     }
-    LinearImage image(width, height, 3);
+    if (!width || !height) {
+        return false;
+    }
 
-    if (sx == '-') image = (image);
-    if (sy == '+') image = verticalFlip(image);
+    mWidth = width;
+    mHeight = height;
 
     // Allocate memory to hold one row of decoded pixel data.
-    std::unique_ptr<uint8_t[]> rgbe(new uint8_t[width * 4]);
+    mRgbe.reset(new uint8_t[width * 4]);
 
-    // First, test for non-RLE images.
+    // Test for non-RLE images.
     const auto pos = mStream.tellg();
-    mStream.read((char*) rgbe.get(), 3);
+    mStream.read((char*) mRgbe.get(), 3);
     mStream.seekg(pos);
 
-    if (rgbe[0] != 0x2 || rgbe[1] != 0x2 || (rgbe[2] & 0x80) || width < 8 || width > 32767) {
-        for (uint32_t y = 0; y < height; y++) {
-            filament::math::float3* dst = reinterpret_cast<filament::math::float3*>(image.getPixelRef(0, y));
-            mStream.read((char*) rgbe.get(), width * 4);
-            // (rgb/256) * 2^(e-128)
-            size_t pixel = 0;
-            for (size_t x = 0; x < width; x++, pixel += 4) {
-                if (rgbe[pixel + 3] == 0.0f) {
-                    dst[x] = filament::math::float3{0.0f};
-                } else {
-                    filament::math::float3 v(rgbe[pixel], rgbe[pixel + 1], rgbe[pixel + 2]);
-                    dst[x] = (v + 0.5f) * std::ldexp(1.0f, rgbe[pixel + 3] - (128 + 8));
-                }
-            }
+    mRunLengthEncoded = !(mRgbe[0] != 0x2 || mRgbe[1] != 0x2 || (mRgbe[2] & 0x80) ||
+            width < 8 || width > 32767);
+    return true;
+}
+
+bool HDRScanlineDecoder::decodeScanline(filament::math::float3* dst) {
+    const uint32_t width = mWidth;
+    uint8_t* const rgbe = mRgbe.get();
+
+    if (!mRunLengthEncoded) {
+        mStream.read((char*) rgbe, width * 4);
+        if (!mStream) {
+            slog.e << "unexpected end of stream" << io::endl;
+            return false;
         }
-    } else {
-        for (uint32_t y = 0; y < height; y++) {
-            uint16_t magic;
-            mStream.read((char*) &magic, 2);
-            if (magic != 0x0202) {
-                slog.e << "invalid scanline (magic)" << io::endl;
-                return {};
+        // (rgb/256) * 2^(e-128)
+        size_t pixel = 0;
+        for (size_t x = 0; x < width; x++, pixel += 4) {
+            if (rgbe[pixel + 3] == 0.0f) {
+                dst[x] = filament::math::float3{0.0f};
+            } else {
+                filament::math::float3 v(rgbe[pixel], rgbe[pixel + 1], rgbe[pixel + 2]);
+                dst[x] = (v + 0.5f) * std::ldexp(1.0f, rgbe[pixel + 3] - (128 + 8));
             }
+        }
+        return true;
+    }
 
-            uint16_t w;
-            mStream.read((char*) &w, 2);
-            if (ntohs(w) != width) {
-                slog.e << "invalid scanline (width)" << io::endl;
-                return {};
-            }
+    uint16_t magic;
+    mStream.read((char*) &magic, 2);
+    if (magic != 0x0202) {
+        slog.e << "invalid scanline (magic)" << io::endl;
+        return false;
+    }
 
-            char* d = (char*) rgbe.get();
-            for (size_t p = 0; p < 4; p++) {
-                size_t num_bytes = 0;
-                while (num_bytes < width) {
-                    uint8_t rle_count;
-                    mStream.read((char*) &rle_count, 1);
-                    if (rle_count > 128) {
-                        char v;
-                        mStream.read(&v, 1);
-                        memset(d, v, size_t(rle_count - 128));
-                        d += rle_count - 128;
-                        num_bytes += rle_count - 128;
-                    } else {
-                        if (rle_count == 0) {
-                            slog.e << "run length is zero" << io::endl;
-                            return {};
-                        }
-                        mStream.read(d, rle_count);
-                        d += rle_count;
-                        num_bytes += rle_count;
-                    }
-                }
-            }
+    uint16_t w;
+    mStream.read((char*) &w, 2);
+    if (ntohs(w) != width) {
+        slog.e << "invalid scanline (width)" << io::endl;
+        return false;
+    }
 
-            uint8_t const* r = &rgbe[0];
-            uint8_t const* g = &rgbe[width];
-            uint8_t const* b = &rgbe[2 * width];
-            uint8_t const* e = &rgbe[3 * width];
-            filament::math::float3* dst = reinterpret_cast<filament::math::float3*>(image.getPixelRef(0, y));
-            // (rgb/256) * 2^(e-128)
-            for (size_t x = 0; x < width; x++, r++, g++, b++, e++) {
-                if (e[0] == 0.0f) {
-                    dst[x] = filament::math::float3{0.0f};
-                } else {
-                    filament::math::float3 v(r[0], g[0], b[0]);
-                    dst[x] = (v + 0.5f) * std::ldexp(1.0f, e[0] - (128 + 8));
+    char* d = (char*) rgbe;
+    for (size_t p = 0; p < 4; p++) {
+        size_t num_bytes = 0;
+        while (num_bytes < width) {
+            uint8_t rle_count;
+            mStream.read((char*) &rle_count, 1);
+            if (!mStream) {
+                slog.e << "unexpected end of stream" << io::endl;
+                return false;
+            }
+            if (rle_count > 128) {
+                char v;
+                mStream.read(&v, 1);
+                memset(d, v, size_t(rle_count - 128));
+                d += rle_count - 128;
+                num_bytes += rle_count - 128;
+            } else {
+                if (rle_count == 0) {
+                    slog.e << "run length is zero" << io::endl;
+                    return false;
                 }
+                mStream.read(d, rle_count);
+                d += rle_count;
+                num_bytes += rle_count;
             }
         }
     }
 
-    return image;
+    uint8_t const* r = &rgbe[0];
+    uint8_t const* g = &rgbe[width];
+    uint8_t const* b = &rgbe[2 * width];
+    uint8_t const* e = &rgbe[3 * width];
+    // (rgb/256) * 2^(e-128)
+    for (size_t x = 0; x < width; x++, r++, g++, b++, e++) {
+        if (e[0] == 0.0f) {
+            dst[x] = filament::math::float3{0.0f};
+        } else {
+            filament::math::float3 v(r[0], g[0], b[0]);
+            dst[x] = (v + 0.5f) * std::ldexp(1.0f, e[0] - (128 + 8));
+        }
+    }
+    return true;
 }
 
 #ifdef IMAGEIO_LITE
@@ -0,0 +1,115 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <imageio/BlockCompression.h>
+
+#include <image/LinearImage.h>
+
+#include <utils/JobSystem.h>
+
+#include <gtest/gtest.h>
+
+#include <string.h>
+
+#include <algorithm>
+#include <string>
+
+using namespace image;
+
+class BlockCompressionTest : public testing::Test {
+protected:
+    void SetUp() override {
+        mJobSystem.adopt();
+    }
+
+    void TearDown() override {
+        mJobSystem.emancipate();
+    }
+
+    utils::JobSystem mJobSystem;
+};
+
+// Fills an image with a pattern that doesn't repeat within a block row, so that a band compressed
+// at the wrong offset can't produce the same blocks.
+static LinearImage createImage(uint32_t width, uint32_t height, uint32_t channels) {
+    LinearImage image(width, height, channels);
+    float* data = image.getPixelRef();
+    for (size_t i = 0, n = size_t(width) * height * channels; i < n; ++i) {
+        data[i] = float((i * 7919) % 1000) / 1000.0f;
+    }
+    return image;
+}
+
+static bool isSame(CompressedTexture const& a, CompressedTexture const& b) {
+    return a.format == b.format && a.size == b.size && a.size > 0 &&
+            memcmp(a.data.get(), b.data.get(), a.size) == 0;
+}
+
+// etc2comp distributes its effort per band, so ETC only matches a whole-image encode at 100.
+static const char* const CONFIGS[] = {
+        "astc_fast_ldr_4x4",
+        "astc_veryfast_ldr_6x5",
+        "astc_fast_ldr_12x12",
+        "s3tc_rgb_dxt1",
+        "s3tc_rgba_dxt5",
+        "etc_rgba8_rgba_100",
+};
+
+TEST_F(BlockCompressionTest, ParallelMatchesSerial) {
+    struct Size { uint32_t width, height; };
+    // sizes that aren't multiples of the block sizes, with several bands of block rows each
+    const Size sizes[] = { { 37, 29 }, { 61, 83 } };
+    for (uint32_t channels : { 1u, 3u, 4u }) {
+        for (Size size : sizes) {
+            LinearImage image = createImage(size.width, size.height, channels);
+            for (const char* options : CONFIGS) {
+                CompressionConfig config{};
+                ASSERT_TRUE(parseOptionString(options, &config));
+                CompressedTexture serial = compressTexture(config, image);
+                CompressedTexture parallel = compressTexture(mJobSystem, config, image);
+                EXPECT_TRUE(isSame(serial, parallel)) << options << " " << size.width << "x"
+                        << size.height << " with " << channels << " channels";
+            }
+        }
+    }
+}
+
+TEST_F(BlockCompressionTest, MipmapsMatchSerial) {
+    constexpr uint32_t SIZE = 32;
+    constexpr uint32_t LEVEL_COUNT = 6;
+    auto generateLevel = [](uint32_t level) {
+        const uint32_t size = std::max(SIZE >> level, 1u);
+        return createImage(size, size, 4);
+    };
+    for (const char* options : CONFIGS) {
+        CompressionConfig config{};
+        ASSERT_TRUE(parseOptionString(options, &config));
+        uint32_t next = 0;
+        compressMipmaps(mJobSystem, config, LEVEL_COUNT, generateLevel,
+                [&](uint32_t level, CompressedTexture texture) {
+            // the levels are handed back in order, on the calling thread
+            EXPECT_EQ(level, next++);
+            CompressedTexture serial = compressTexture(config, generateLevel(level));
+            EXPECT_TRUE(isSame(serial, texture)) << options << " level " << level;
+        });
+        EXPECT_EQ(next, LEVEL_COUNT);
+    }
+}
+
+int main(int argc, char** argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
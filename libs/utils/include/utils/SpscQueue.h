@@ -0,0 +1,121 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TNT_UTILS_SPSCQUEUE_H
+#define TNT_UTILS_SPSCQUEUE_H
+
+#include <atomic>
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace utils {
+
+/*
+ * A templated, lockless, fixed-size, single-producer single-consumer FIFO queue
+ *
+ *     head                         tail
+ *      v                             v
+ *      |----|----|----|----|----|----|
+ *    pop()                        push()
+ *  consumer thread             producer thread
+ *
+ * push() and pop() never block, they fail when the queue is respectively full or empty.
+ */
+template <typename TYPE, size_t COUNT>
+class SpscQueue {
+    static_assert(!(COUNT & (COUNT - 1)), "COUNT must be a power of two");
+    static constexpr size_t MASK = COUNT - 1;
+
+    // We use 64-bits indices so we don't have to worry about wrapping around. The two indices
+    // live on their own cache line, so that the producer and consumer don't false-share.
+    using index_t = uint64_t;
+
+    alignas(64) std::atomic<index_t> mHead = { 0 };     // written only in pop()
+    alignas(64) std::atomic<index_t> mTail = { 0 };     // written only in push()
+
+    alignas(64) TYPE mItems[COUNT];
+
+public:
+    using value_type = TYPE;
+
+    inline bool push(TYPE item) noexcept;
+    inline bool pop(TYPE& item) noexcept;
+
+    size_t getSize() const noexcept { return COUNT; }
+
+    // only exact when called from the producer or consumer thread, and even then, only
+    // conservatively (i.e. the other thread can only make the queue less full or less empty)
+    size_t getCount() const noexcept {
+        index_t tail = mTail.load(std::memory_order_acquire);
+        index_t head = mHead.load(std::memory_order_acquire);
+        return size_t(tail - head);
+    }
+
+    bool empty() const noexcept { return getCount() == 0; }
+    bool full() const noexcept { return getCount() == COUNT; }
+};
+
+/*
+ * Adds an item at the TAIL of the queue. Returns false if the queue is full.
+ *
+ * Must be called from the producer thread.
+ */
+template <typename TYPE, size_t COUNT>
+bool SpscQueue<TYPE, COUNT>::push(TYPE item) noexcept {
+    // std::memory_order_relaxed is sufficient because mTail is only written by this thread
+    index_t tail = mTail.load(std::memory_order_relaxed);
+
+    // std::memory_order_acquire is needed because the slot we're about to write is released
+    // by pop(), which must be done reading it.
+    index_t head = mHead.load(std::memory_order_acquire);
+    if (tail - head == COUNT) {
+        return false;
+    }
+
+    mItems[tail & MASK] = item;
+
+    // std::memory_order_release is used because we publish the item we just wrote to pop()
+    mTail.store(tail + 1, std::memory_order_release);
+    return true;
+}
+
+/*
+ * Removes an item from the HEAD of the queue. Returns false if the queue is empty.
+ *
+ * Must be called from the consumer thread.
+ */
+template <typename TYPE, size_t COUNT>
+bool SpscQueue<TYPE, COUNT>::pop(TYPE& item) noexcept {
+    // std::memory_order_relaxed is sufficient because mHead is only written by this thread
+    index_t head = mHead.load(std::memory_order_relaxed);
+
+    // std::memory_order_acquire is needed because we're acquiring the item published in push()
+    index_t tail = mTail.load(std::memory_order_acquire);
+    if (head == tail) {
+        return false;
+    }
+
+    item = mItems[head & MASK];
+
+    // std::memory_order_release is used because we hand the slot back to push()
+    mHead.store(head + 1, std::memory_order_release);
+    return true;
+}
+
+} // namespace utils
+
+#endif // TNT_UTILS_SPSCQUEUE_H
@@ -24,7 +24,7 @@
 #define SYSTRACE_TAG_JOBSYSTEM      (1<<2)
 
 
-#if defined(ANDROID)
+#if defined(ANDROID) || defined(__linux__)
 
 #include <atomic>
 
@@ -100,6 +100,17 @@
 #define SYSTRACE_VALUE64(name, val) \
         ___tracer.value(SYSTRACE_TAG, name, int64_t(val))
 
+/**
+ * Writes the events recorded so far as a Chrome Trace Event JSON file, which can be loaded
+ * in chrome://tracing or ui.perfetto.dev. Only supported on Linux, where events are recorded
+ * in memory instead of being sent to atrace. Evaluates to true on success.
+ */
+#if defined(ANDROID)
+#define SYSTRACE_DUMP(path) false
+#else
+#define SYSTRACE_DUMP(path) ::utils::details::Systrace::dump(path)
+#endif
+
 // ------------------------------------------------------------------------------------------------
 // No user serviceable code below...
 // ------------------------------------------------------------------------------------------------
@@ -107,6 +118,8 @@
 namespace utils {
 namespace details {
 
+#if defined(ANDROID)
+
 class Systrace {
 public:
 
@@ -228,6 +241,89 @@ private:
     static void int64_body(int fd, int pid, const char* name, int64_t value) noexcept;
 };
 
+#else // !ANDROID
+
+/*
+ * On Linux, events are recorded in a per-thread ring buffer and kept in memory until they're
+ * written to a file with dump(). Recording is only available when the SYSTRACE_OUTPUT
+ * environment variable is set, in which case the trace is also written to the file it names
+ * when the process exits.
+ */
+class Systrace {
+public:
+
+    enum tags {
+        NEVER       = SYSTRACE_TAG_NEVER,
+        ALWAYS      = SYSTRACE_TAG_ALWAYS,
+        FILAMENT    = SYSTRACE_TAG_FILAMENT,
+        JOBSYSTEM   = SYSTRACE_TAG_JOBSYSTEM
+        // we could define more TAGS here, as we need them.
+    };
+
+    Systrace(uint32_t tag) noexcept {
+        if (tag) init(tag);
+    }
+
+    static void enable(uint32_t tags) noexcept;
+    static void disable(uint32_t tags) noexcept;
+
+    // writes the events recorded by all threads so far, returns false if the file can't be written
+    static bool dump(const char* path) noexcept;
+
+    inline void traceBegin(uint32_t tag, const char* name) noexcept {
+        if (tag && UTILS_UNLIKELY(mIsTracingEnabled)) {
+            record(BEGIN, name, 0);
+        }
+    }
+
+    inline void traceEnd(uint32_t tag) noexcept {
+        if (tag && UTILS_UNLIKELY(mIsTracingEnabled)) {
+            record(END, nullptr, 0);
+        }
+    }
+
+    inline void asyncBegin(uint32_t tag, const char* name, int32_t cookie) noexcept {
+        if (tag && UTILS_UNLIKELY(mIsTracingEnabled)) {
+            record(ASYNC_BEGIN, name, cookie);
+        }
+    }
+
+    inline void asyncEnd(uint32_t tag, const char* name, int32_t cookie) noexcept {
+        if (tag && UTILS_UNLIKELY(mIsTracingEnabled)) {
+            record(ASYNC_END, name, cookie);
+        }
+    }
+
+    inline void value(uint32_t tag, const char* name, int32_t value) noexcept {
+        if (tag && UTILS_UNLIKELY(mIsTracingEnabled)) {
+            record(COUNTER, name, value);
+        }
+    }
+
+    inline void value(uint32_t tag, const char* name, int64_t value) noexcept {
+        if (tag && UTILS_UNLIKELY(mIsTracingEnabled)) {
+            record(COUNTER, name, value);
+        }
+    }
+
+private:
+    friend class ScopedTrace;
+
+    enum Type : uint8_t {
+        BEGIN, END, ASYNC_BEGIN, ASYNC_END, COUNTER
+    };
+
+    void init(uint32_t tag) noexcept;
+
+    // cached value for faster access, no need to be initialized
+    bool mIsTracingEnabled;
+
+    static bool isTracingEnabled(uint32_t tag) noexcept;
+    static void record(Type type, const char* name, int64_t value) noexcept;
+};
+
+#endif // ANDROID
+
 // ------------------------------------------------------------------------------------------------
 
 class ScopedTrace {
@@ -258,7 +354,7 @@ private:
 } // namespace utils
 
 // ------------------------------------------------------------------------------------------------
-#else // !ANDROID
+#else // !ANDROID && !__linux__
 // ------------------------------------------------------------------------------------------------
 
 #define SYSTRACE_ENABLE()
@@ -272,7 +368,8 @@ private:
 #define SYSTRACE_ASYNC_END(name, cookie)
 #define SYSTRACE_VALUE32(name, val)
 #define SYSTRACE_VALUE64(name, val)
+#define SYSTRACE_DUMP(path) false
 
-#endif // ANDROID
+#endif // ANDROID || __linux__
 
 #endif // TNT_UTILS_SYSTRACE_H
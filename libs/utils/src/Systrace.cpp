@@ -220,4 +220,300 @@ void Systrace::int64_body(int fd, int pid, const char* name, int64_t value) noex
 } // namespace details
 } // namespace utils
 
+#elif defined(__linux__)
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <pthread.h>
+#include <sys/syscall.h>
+
+namespace utils {
+namespace details {
+
+namespace {
+
+// The name is copied because it's not always a string literal.
+struct Event {
+    uint64_t timestamp;     // nanoseconds since the tracer started
+    int64_t value;          // cookie or counter value
+    uint8_t type;           // a Systrace::Type
+    char name[39];
+};
+
+static_assert(sizeof(Event) == 56, "Event should be 56 bytes");
+
+// A slot of the ring buffer is a seqlock protecting one Event, 64 bytes in total. The event is
+// stored as atomic words, so that dump() can copy it while the owning thread overwrites it.
+struct EventSlot {
+    static constexpr size_t WORD_COUNT = sizeof(Event) / sizeof(uint64_t);
+
+    // 2 * index + 1 while event #index is being written, 2 * index + 2 once it's complete
+    std::atomic<uint64_t> sequence{ 0 };
+    std::atomic<uint64_t> words[WORD_COUNT] = {};
+
+    // only called by the thread owning the slot
+    void store(uint64_t index, Event const& e) noexcept {
+        uint64_t data[WORD_COUNT];
+        memcpy(data, &e, sizeof(e));
+        sequence.store(2 * index + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for (size_t i = 0; i < WORD_COUNT; i++) {
+            words[i].store(data[i], std::memory_order_relaxed);
+        }
+        sequence.store(2 * index + 2, std::memory_order_release);
+    }
+
+    // returns false if the slot doesn't hold event #index, or if it was modified while reading
+    bool load(uint64_t index, Event* e) const noexcept {
+        const uint64_t expected = 2 * index + 2;
+        if (sequence.load(std::memory_order_acquire) != expected) {
+            return false;
+        }
+        uint64_t data[WORD_COUNT];
+        for (size_t i = 0; i < WORD_COUNT; i++) {
+            data[i] = words[i].load(std::memory_order_relaxed);
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (sequence.load(std::memory_order_relaxed) != expected) {
+            return false;
+        }
+        memcpy(e, data, sizeof(*e));
+        return true;
+    }
+};
+
+static_assert(sizeof(EventSlot) == 64, "EventSlot should be 64 bytes");
+
+// Each thread records its events in its own ring buffer, so that recording never takes a lock.
+// Only the owning thread writes to a buffer, dump() reads them from any thread and discards
+// the events that were overwritten before or while it was reading them.
+struct ThreadBuffer {
+    static constexpr size_t CAPACITY = 8192;   // must be a power of two
+    std::atomic<uint64_t> head{ 0 };           // total number of events ever recorded
+    pid_t tid = 0;
+    char name[16] = {};
+    EventSlot events[CAPACITY];
+};
+
+struct GlobalState {
+    bool isTracingAvailable = false;
+    std::atomic<uint32_t> isTracingEnabled{ 0 };
+    std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+    std::string outputPath;
+
+    // protects buffers, which are never freed so that the events recorded by threads that
+    // terminated can still be dumped.
+    std::mutex lock;
+    std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+
+    GlobalState() noexcept {
+        const char* path = getenv("SYSTRACE_OUTPUT");
+        isTracingAvailable = path && *path;
+        if (isTracingAvailable) {
+            outputPath = path;
+            atexit([]() { Systrace::dump(getGlobalState().outputPath.c_str()); });
+        }
+    }
+
+    static GlobalState& getGlobalState() noexcept {
+        // never destroyed so that threads still running after exit() don't access a dead object
+        static GlobalState* const sGlobalState = new GlobalState();
+        return *sGlobalState;
+    }
+};
+
+thread_local ThreadBuffer* tThreadBuffer = nullptr;
+
+UTILS_NOINLINE
+ThreadBuffer* registerThread() noexcept {
+    GlobalState& s = GlobalState::getGlobalState();
+    std::unique_ptr<ThreadBuffer> buffer(new(std::nothrow) ThreadBuffer());
+    if (!buffer) {
+        return nullptr;
+    }
+    buffer->tid = pid_t(syscall(SYS_gettid));
+    pthread_getname_np(pthread_self(), buffer->name, sizeof(buffer->name));
+    ThreadBuffer* const p = buffer.get();
+    std::lock_guard<std::mutex> guard(s.lock);
+    s.buffers.push_back(std::move(buffer));
+    return p;
+}
+
+void writeEscaped(FILE* file, const char* str) noexcept {
+    for (char c = *str; c; c = *++str) {
+        if (c == '"' || c == '\\') {
+            fputc('\\', file);
+            fputc(c, file);
+        } else if ((unsigned char)c < 0x20) {
+            fprintf(file, "\\u%04x", c);
+        } else {
+            fputc(c, file);
+        }
+    }
+}
+
+} // anonymous namespace
+
+void Systrace::init(uint32_t tag) noexcept {
+    mIsTracingEnabled = isTracingEnabled(tag);
+}
+
+void Systrace::enable(uint32_t tags) noexcept {
+    GlobalState& s = GlobalState::getGlobalState();
+    if (UTILS_LIKELY(s.isTracingAvailable)) {
+        s.isTracingEnabled.fetch_or(tags, std::memory_order_relaxed);
+    }
+}
+
+void Systrace::disable(uint32_t tags) noexcept {
+    GlobalState& s = GlobalState::getGlobalState();
+    s.isTracingEnabled.fetch_and(~tags, std::memory_order_relaxed);
+}
+
+bool Systrace::isTracingEnabled(uint32_t tag) noexcept {
+    if (tag) {
+        GlobalState& s = GlobalState::getGlobalState();
+        return s.isTracingAvailable &&
+               ((s.isTracingEnabled.load(std::memory_order_relaxed) | SYSTRACE_TAG_ALWAYS) & tag);
+    }
+    return false;
+}
+
+void Systrace::record(Type type, const char* name, int64_t value) noexcept {
+    ThreadBuffer* buffer = tThreadBuffer;
+    if (UTILS_UNLIKELY(!buffer)) {
+        buffer = tThreadBuffer = registerThread();
+        if (!buffer) {
+            return;
+        }
+    }
+
+    const auto now = std::chrono::steady_clock::now() - GlobalState::getGlobalState().epoch;
+    Event e;
+    e.timestamp = uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(now).count());
+    e.value = value;
+    e.type = type;
+    if (name) {
+        strncpy(e.name, name, sizeof(e.name) - 1);
+        e.name[sizeof(e.name) - 1] = 0;
+    } else {
+        e.name[0] = 0;
+    }
+
+    const uint64_t head = buffer->head.load(std::memory_order_relaxed);
+    buffer->events[head & (ThreadBuffer::CAPACITY - 1)].store(head, e);
+    // publish the event
+    buffer->head.store(head + 1, std::memory_order_release);
+}
+
+bool Systrace::dump(const char* path) noexcept {
+    GlobalState& s = GlobalState::getGlobalState();
+    if (!path || !s.isTracingAvailable) {
+        return false;
+    }
+
+    FILE* file = fopen(path, "w");
+    if (!file) {
+        return false;
+    }
+
+    const pid_t pid = getpid();
+    std::vector<Event> events;
+    bool first = true;
+    auto separator = [&]() {
+        fputs(first ? "\n" : ",\n", file);
+        first = false;
+    };
+
+    fputs("{\"traceEvents\":[", file);
+
+    std::lock_guard<std::mutex> guard(s.lock);
+    for (auto const& buffer : s.buffers) {
+        // The thread keeps recording while we copy its events, so the oldest ones can be
+        // overwritten before we get to them; these are skipped.
+        const uint64_t head = buffer->head.load(std::memory_order_acquire);
+        const uint64_t begin = head > ThreadBuffer::CAPACITY ? head - ThreadBuffer::CAPACITY : 0;
+        events.clear();
+        for (uint64_t i = begin; i < head; i++) {
+            Event e;
+            if (buffer->events[i & (ThreadBuffer::CAPACITY - 1)].load(i, &e)) {
+                events.push_back(e);
+            }
+        }
+
+        // prefer the current name of the thread, which may have been set after it registered
+        char name[16];
+        strncpy(name, buffer->name, sizeof(name));
+        char commPath[64];
+        snprintf(commPath, sizeof(commPath), "/proc/self/task/%d/comm", buffer->tid);
+        if (FILE* comm = fopen(commPath, "r")) {
+            if (fgets(name, sizeof(name), comm)) {
+                name[strcspn(name, "\n")] = 0;
+            }
+            fclose(comm);
+        }
+
+        separator();
+        fprintf(file, "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":%d,\"tid\":%d,"
+                      "\"args\":{\"name\":\"", pid, buffer->tid);
+        writeEscaped(file, name);
+        fputs("\"}}", file);
+
+        // the oldest events may have been lost, in which case some END have no matching BEGIN
+        int depth = 0;
+        for (Event const& e : events) {
+            if (e.type == END) {
+                if (depth == 0) {
+                    continue;
+                }
+                depth--;
+            } else if (e.type == BEGIN) {
+                depth++;
+            }
+
+            separator();
+            const double ts = double(e.timestamp) * 1e-3;
+            switch (Type(e.type)) {
+                case BEGIN:
+                case END:
+                    fprintf(file, "{\"ph\":\"%c\",\"pid\":%d,\"tid\":%d,\"ts\":%.3f,\"name\":\"",
+                            e.type == BEGIN ? 'B' : 'E', pid, buffer->tid, ts);
+                    writeEscaped(file, e.name);
+                    fputs("\"}", file);
+                    break;
+                case ASYNC_BEGIN:
+                case ASYNC_END:
+                    fprintf(file, "{\"ph\":\"%c\",\"cat\":\"async\",\"id\":%" PRId64 ","
+                                  "\"pid\":%d,\"tid\":%d,\"ts\":%.3f,\"name\":\"",
+                            e.type == ASYNC_BEGIN ? 'b' : 'e', e.value, pid, buffer->tid, ts);
+                    writeEscaped(file, e.name);
+                    fputs("\"}", file);
+                    break;
+                case COUNTER:
+                    fprintf(file, "{\"ph\":\"C\",\"pid\":%d,\"tid\":%d,\"ts\":%.3f,\"name\":\"",
+                            pid, buffer->tid, ts);
+                    writeEscaped(file, e.name);
+                    fprintf(file, "\",\"args\":{\"value\":%" PRId64 "}}", e.value);
+                    break;
+            }
+        }
+    }
+
+    fputs("\n],\"displayTimeUnit\":\"ms\"}\n", file);
+    const bool success = !ferror(file);
+    return (fclose(file) == 0) && success;
+}
+
+} // namespace details
+} // namespace utils
+
 #endif // ANDROID
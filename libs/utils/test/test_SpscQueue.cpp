@@ -0,0 +1,76 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <utils/SpscQueue.h>
+
+#include <thread>
+
+using namespace utils;
+
+TEST(SpscQueueTest, Simple) {
+    SpscQueue<int, 4> queue;
+    int item = 0;
+
+    EXPECT_TRUE(queue.empty());
+    EXPECT_FALSE(queue.pop(item));
+
+    EXPECT_TRUE(queue.push(1));
+    EXPECT_TRUE(queue.push(2));
+    EXPECT_TRUE(queue.push(3));
+    EXPECT_TRUE(queue.push(4));
+    EXPECT_TRUE(queue.full());
+    EXPECT_FALSE(queue.push(5));
+
+    EXPECT_TRUE(queue.pop(item));
+    EXPECT_EQ(1, item);
+    EXPECT_TRUE(queue.push(5));
+
+    for (int i = 2; i <= 5; i++) {
+        EXPECT_TRUE(queue.pop(item));
+        EXPECT_EQ(i, item);
+    }
+    EXPECT_TRUE(queue.empty());
+}
+
+TEST(SpscQueueTest, ProducerConsumer) {
+    constexpr int COUNT = 100000;
+    SpscQueue<int, 16> queue;
+
+    std::thread producer([&]() {
+        for (int i = 0; i < COUNT; i++) {
+            while (!queue.push(i)) {
+                std::this_thread::yield();
+            }
+        }
+    });
+
+    // items must come out in order, none missing
+    int expected = 0;
+    while (expected < COUNT) {
+        int item;
+        if (queue.pop(item)) {
+            ASSERT_EQ(expected, item);
+            expected++;
+        } else {
+            std::this_thread::yield();
+        }
+    }
+
+    producer.join();
+    EXPECT_TRUE(queue.empty());
+}
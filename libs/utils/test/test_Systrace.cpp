@@ -0,0 +1,106 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <utils/Systrace.h>
+
+#include <atomic>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#include <stdlib.h>
+
+static std::string readFile(const char* path) {
+    std::ifstream in(path);
+    std::stringstream ss;
+    ss << in.rdbuf();
+    return ss.str();
+}
+
+TEST(SystraceTest, Dump) {
+    // recording must be requested before the first trace point is hit
+    const std::string path = testing::TempDir() + "test_systrace.json";
+    setenv("SYSTRACE_OUTPUT", path.c_str(), 0);
+    const char* output = getenv("SYSTRACE_OUTPUT");
+
+    SYSTRACE_ENABLE();
+    {
+        SYSTRACE_NAME("outer");
+        SYSTRACE_VALUE32("counter", 42);
+        std::thread t([]() {
+            SYSTRACE_NAME("worker \"quoted\"");
+        });
+        t.join();
+    }
+    {
+        SYSTRACE_CONTEXT();
+        SYSTRACE_NAME_BEGIN("inner");
+        SYSTRACE_ASYNC_BEGIN("async", 7);
+        SYSTRACE_ASYNC_END("async", 7);
+        SYSTRACE_NAME_END();
+    }
+
+    ASSERT_TRUE(SYSTRACE_DUMP(output));
+
+    std::string trace = readFile(output);
+    EXPECT_EQ(0, trace.find("{\"traceEvents\":["));
+    EXPECT_NE(std::string::npos, trace.find("\"thread_name\""));
+    EXPECT_NE(std::string::npos, trace.find("\"ph\":\"B\",\"pid\""));
+    EXPECT_NE(std::string::npos, trace.find("\"name\":\"outer\""));
+    EXPECT_NE(std::string::npos, trace.find("\"name\":\"inner\""));
+    EXPECT_NE(std::string::npos, trace.find("\"name\":\"worker \\\"quoted\\\"\""));
+    EXPECT_NE(std::string::npos, trace.find("\"ph\":\"b\",\"cat\":\"async\",\"id\":7"));
+    EXPECT_NE(std::string::npos, trace.find("\"args\":{\"value\":42}"));
+    EXPECT_NE(std::string::npos, trace.find("\"displayTimeUnit\":\"ms\"}"));
+
+    SYSTRACE_DISABLE();
+}
+
+TEST(SystraceTest, DumpWhileRecording) {
+    const std::string path = testing::TempDir() + "test_systrace.json";
+    setenv("SYSTRACE_OUTPUT", path.c_str(), 0);
+    const char* output = getenv("SYSTRACE_OUTPUT");
+
+    SYSTRACE_ENABLE();
+
+    // the worker wraps around its ring buffer many times while we dump it
+    std::atomic<bool> done{ false };
+    std::thread t([&done]() {
+        SYSTRACE_CONTEXT();
+        while (!done.load(std::memory_order_relaxed)) {
+            SYSTRACE_NAME_BEGIN("recording");
+            SYSTRACE_VALUE32("recorded", 1);
+            SYSTRACE_NAME_END();
+        }
+    });
+    for (int i = 0; i < 4; i++) {
+        ASSERT_TRUE(SYSTRACE_DUMP(output));
+        std::string trace = readFile(output);
+        EXPECT_NE(std::string::npos, trace.find("\"displayTimeUnit\":\"ms\"}"));
+    }
+    done = true;
+    t.join();
+
+    ASSERT_TRUE(SYSTRACE_DUMP(output));
+    std::string trace = readFile(output);
+    EXPECT_NE(std::string::npos, trace.find("\"name\":\"recording\""));
+    EXPECT_NE(std::string::npos, trace.find("\"name\":\"recorded\",\"args\":{\"value\":1}"));
+
+    SYSTRACE_DISABLE();
+}
@@ -375,6 +375,16 @@ int main(int argc, char** argv) {
     }
 
     auto loadAsset = [&app](utils::Path filename) {
+        // GLB files are memory-mapped, which avoids a heap copy of the entire file.
+        if (filename.getExtension() == "glb") {
+            app.asset = app.assetLoader->createAssetFromBinaryFile(filename.c_str());
+            if (!app.asset) {
+                std::cerr << "Unable to parse " << filename << std::endl;
+                exit(1);
+            }
+            return;
+        }
+
         // Peek at the file size to allow pre-allocation.
         long contentSize = static_cast<long>(getFileSize(filename.c_str()));
         if (contentSize <= 0) {
@@ -391,11 +401,7 @@ int main(int argc, char** argv) {
         }
 
         // Parse the glTF file and create Filament entities.
-        if (filename.getExtension() == "glb") {
-            app.asset = app.assetLoader->createAssetFromBinary(buffer.data(), buffer.size());
-        } else {
-            app.asset = app.assetLoader->createAssetFromJson(buffer.data(), buffer.size());
-        }
+        app.asset = app.assetLoader->createAssetFromJson(buffer.data(), buffer.size());
         buffer.clear();
         buffer.shrink_to_fit();
 
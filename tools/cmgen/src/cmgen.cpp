@@ -27,6 +27,7 @@
 #include <imageio/BlockCompression.h>
 #endif
 
+#include <imageio/HDRDecoder.h>
 #include <imageio/ImageDecoder.h>
 #include <imageio/ImageEncoder.h>
 
@@ -109,6 +110,7 @@ static bool g_deploy = false;
 static utils::Path g_deploy_dir;
 
 static size_t g_num_samples = 1024;
+static float g_ibl_quality = 1.0f;
 
 static bool g_mirror = false;
 
@@ -137,6 +139,7 @@ static void UTILS_UNUSED outputSpectrum(std::ostream& out,
 static void saveImage(const std::string& path, ImageEncoder::Format format, const Image& image,
         const std::string& compression);
 static LinearImage toLinearImage(const Image& image);
+static bool decodeEquirectangularHDR(std::istream& stream, size_t dim, Image& result);
 static void exportKtxFaces(KtxBundle& container, uint32_t miplevel, const Cubemap& cm);
 
 // -----------------------------------------------------------------------------------------------
@@ -202,6 +205,8 @@ static void printUsage(char* name) {
             "       Skip mirroring of generated cubemaps (for assets with mirroring already backed in)\n\n"
             "   --ibl-samples=numSamples\n"
             "       Number of samples to use for IBL integrations (default 1024)\n\n"
+            "   --ibl-quality=quality\n"
+            "       Quality/speed tradeoff of the roughness pre-filter in ]0, 1] (default 1)\n\n"
             "   --ibl-ld=dir\n"
             "       Roughness pre-filter into <dir>\n\n"
             "   --sh-shader\n"
@@ -278,6 +283,7 @@ static int handleCommandLineArgments(int argc, char* argv[]) {
             { "ibl-no-prefilter",           no_argument, nullptr, 'n' },
             { "ibl-min-lod-size",     required_argument, nullptr, 'S' },
             { "ibl-samples",          required_argument, nullptr, 'k' },
+            { "ibl-quality",          required_argument, nullptr, 'Q' },
             { "deploy",               required_argument, nullptr, 'x' },
             { "no-mirror",                  no_argument, nullptr, 'm' },
             { "debug",                      no_argument, nullptr, 'd' },
@@ -448,6 +454,9 @@ static int handleCommandLineArgments(int argc, char* argv[]) {
             case 'k':
                 g_num_samples = (size_t)std::stoi(arg);
                 break;
+            case 'Q':
+                g_ibl_quality = std::stof(arg);
+                break;
             case 'x':
                 g_deploy = true;
                 g_deploy_dir = arg;
@@ -539,26 +548,32 @@ int main(int argc, char* argv[]) {
             std::cout << "Decoding image..." << std::endl;
         }
         std::ifstream input_stream(iname.getPath(), std::ios::binary);
-        LinearImage linputImage = ImageDecoder::decode(input_stream, iname.getPath());
-        if (!linputImage.isValid()) {
-            std::cerr << "Unable to open image: " << iname.getPath() << std::endl;
-            exit(1);
-        }
-        if (linputImage.getChannels() != 3) {
-            std::cerr << "Input image must be RGB (3 channels)! This image has "
-                      << linputImage.getChannels() << " channels." << std::endl;
-            exit(1);
-        }
+        Image inputImage;
+        if (!decodeEquirectangularHDR(input_stream,
+                g_output_size ? g_output_size : IBL_DEFAULT_SIZE, inputImage)) {
+            LinearImage linputImage = ImageDecoder::decode(input_stream, iname.getPath());
+            if (!linputImage.isValid()) {
+                std::cerr << "Unable to open image: " << iname.getPath() << std::endl;
+                exit(1);
+            }
+            if (linputImage.getChannels() != 3) {
+                std::cerr << "Input image must be RGB (3 channels)! This image has "
+                          << linputImage.getChannels() << " channels." << std::endl;
+                exit(1);
+            }
 
-        // Convert from LinearImage to the deprecated Image object which is used throughout cmgen.
-        const size_t width = linputImage.getWidth(), height = linputImage.getHeight();
-        Image inputImage(width, height);
-        memcpy(inputImage.getData(), linputImage.getPixelRef(), height * inputImage.getBytesPerRow());
+            // Convert from LinearImage to the deprecated Image object which is used throughout
+            // cmgen.
+            inputImage = Image(linputImage.getWidth(), linputImage.getHeight());
+            memcpy(inputImage.getData(), linputImage.getPixelRef(), inputImage.getSize());
 
-        if (!g_noclamp) {
-            CubemapUtils::clamp(inputImage);
+            if (!g_noclamp) {
+                CubemapUtils::clamp(inputImage);
+            }
         }
 
+        const size_t width = inputImage.getWidth(), height = inputImage.getHeight();
+
         if ((isPOT(width) && (width * 3 == height * 4)) ||
             (isPOT(height) && (height * 3 == width * 4))) {
             // This is cross cubemap
@@ -684,7 +699,7 @@ int main(int argc, char* argv[]) {
             Image image;
             Cubemap blurred = CubemapUtils::create(image, dim);
             CubemapIBL::roughnessFilter(js, blurred, levels, linear_roughness, g_num_samples,
-                    float3{ 1, 1, 1 }, !g_ibl_no_prefilter,
+                    float3{ 1, 1, 1 }, !g_ibl_no_prefilter, g_ibl_quality,
                     [](size_t index, float v, void* userdata) {
                         if (!g_quiet) {
                             ((ProgressUpdater*) userdata)->update(index, v);
@@ -979,7 +994,7 @@ void iblRoughnessPrefilter(
             updater.start();
         }
         CubemapIBL::roughnessFilter(js, dst, levels, roughness, numSamples,
-                float3{ 1, 1, 1 }, prefilter,
+                float3{ 1, 1, 1 }, prefilter, g_ibl_quality,
                 [](size_t index, float v, void* userdata) {
                     if (!g_quiet) {
                         ((ProgressUpdater*) userdata)->update(index, v);
@@ -1245,6 +1260,77 @@ void extractCubemapFaces(utils::JobSystem& js, const utils::Path& iname, const C
     }
 }
 
+// Decodes a 2:1 equirectangular HDR image one scanline at a time, and box-filters it on the fly
+// down to a resolution that still oversamples a cubemap of the given dimension by 2x. Only the
+// reduced image is ever held in memory, which allows processing very large panoramas.
+// Returns false and rewinds the stream if it doesn't contain an equirectangular HDR image.
+static bool decodeEquirectangularHDR(std::istream& stream, size_t dim, Image& result) {
+    const std::streampos start = stream.tellg();
+    char buf[16] = {};
+    stream.read(buf, sizeof(buf));
+    stream.clear();
+    stream.seekg(start);
+    if (!HDRDecoder::checkSignature(buf)) {
+        return false;
+    }
+
+    HDRScanlineDecoder decoder(stream);
+    const bool valid = decoder.decodeHeader();
+    const size_t width = decoder.getWidth();
+    const size_t height = decoder.getHeight();
+    if (!valid || width != 2 * height) {
+        stream.clear();
+        stream.seekg(start);
+        return false;
+    }
+
+    // integer reduction factor, the last row and column of the result absorb the remainder
+    const size_t factor = std::max(size_t(1), height / (4 * dim));
+    const size_t dstHeight = height / factor;
+    const size_t dstWidth = 2 * dstHeight;
+    auto dstIndex = [factor](size_t i, size_t size) {
+        return std::min(i / factor, size - 1);
+    };
+
+    Image image(dstWidth, dstHeight);
+    memset(image.getData(), 0, image.getSize());
+    Image scanline(width, 1);
+    std::vector<uint32_t> columnCounts(dstWidth);
+    for (size_t x = 0; x < width; x++) {
+        columnCounts[dstIndex(x, dstWidth)]++;
+    }
+
+    size_t rowCount = 0;
+    for (size_t y = 0; y < height; y++) {
+        auto* const src = static_cast<float3*>(scanline.getData());
+        if (!decoder.decodeScanline(src)) {
+            std::cerr << "Unable to decode scanline " << y << std::endl;
+            exit(1);
+        }
+        if (!g_noclamp) {
+            CubemapUtils::clamp(scanline);
+        }
+
+        const size_t dy = dstIndex(y, dstHeight);
+        auto* const dst = static_cast<float3*>(image.getPixelRef(0, dy));
+        for (size_t x = 0; x < width; x++) {
+            dst[dstIndex(x, dstWidth)] += src[x];
+        }
+        rowCount++;
+
+        // normalize the destination row as soon as all its source rows have been accumulated
+        if (y + 1 == height || dstIndex(y + 1, dstHeight) != dy) {
+            for (size_t x = 0; x < dstWidth; x++) {
+                dst[x] *= 1.0f / float(columnCounts[x] * rowCount);
+            }
+            rowCount = 0;
+        }
+    }
+
+    result = std::move(image);
+    return true;
+}
+
 // Converts a cmgen Image into a libimage LinearImage
 static LinearImage toLinearImage(const Image& image) {
     LinearImage linearImage((uint32_t) image.getWidth(), (uint32_t) image.getHeight(), 3);
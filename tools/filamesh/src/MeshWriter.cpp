@@ -40,46 +40,107 @@ size_t write(unsigned char* out, const vector<T>& data) {
     return data.size() * sizeof(T);
 }
 
+// Allows the vertex cache efficiency to degrade by 5% when reordering triangles to reduce overdraw.
+static constexpr float OVERDRAW_THRESHOLD = 1.05f;
+
+// Each level of detail targets half the triangles of the previous one, with an error relative to
+// the extents of the mesh.
+static constexpr float LOD_INDEX_RATIO = 0.5f;
+static constexpr float LOD_TARGET_ERROR = 1e-2f;
+
 void MeshWriter::optimize(Mesh& mesh) {
+    const uint32_t vertexCount = mesh.vertexCount;
+
+    // Overdraw reduction and simplification need full-precision positions.
+    vector<float3> positions(vertexCount);
+    for (size_t i = 0; i < vertexCount; i++) {
+        const half4 p = (mFlags & INTERLEAVED) ? mesh.vertices[i].position : mesh.positions[i];
+        positions[i] = float3(p.xyz);
+    }
+
     // First, re-order triangles to improve cache locality and reduce the number of VS invocations.
     // Note that assimp already has aiProcess_ImproveCacheLocality, but MeshWriter doesn't know
     // about assimp, and it doesn't hurt to do it again here since this generally runs offline.
-    meshopt_optimizeVertexCache(mesh.indices.data(), mesh.indices.data(), mesh.indices.size(),
-                mesh.vertexCount);
+    // Then, re-order clusters of triangles to reduce overdraw. This is done per part, because parts
+    // are drawn separately and must remain contiguous in the index buffer.
+    for (const Part& part : mesh.parts) {
+        uint32_t* indices = mesh.indices.data() + part.offset;
+        meshopt_optimizeVertexCache(indices, indices, part.indexCount, vertexCount);
+        meshopt_optimizeOverdraw(indices, indices, part.indexCount, &positions[0].x, vertexCount,
+                sizeof(float3), OVERDRAW_THRESHOLD);
+    }
+
+    // Build the LOD chain by simplifying each part of the previous level. The simplified indices
+    // are appended to the index buffer and reference the same vertices. A part that cannot be
+    // simplified any further reuses the indices of the previous level.
+    mesh.lods.clear();
+    vector<Part> previous = mesh.parts;
+    vector<uint32_t> simplified;
+    for (uint32_t lod = 1; lod < mLodCount; lod++) {
+        vector<Part> parts = previous;
+        for (Part& part : parts) {
+            const size_t target = size_t(part.indexCount * LOD_INDEX_RATIO) / 3 * 3;
+            simplified.resize(part.indexCount);
+            const size_t count = meshopt_simplify(simplified.data(),
+                    mesh.indices.data() + part.offset, part.indexCount, &positions[0].x,
+                    vertexCount, sizeof(float3), target, LOD_TARGET_ERROR);
+            if (count == 0 || count >= part.indexCount) {
+                continue;
+            }
+            meshopt_optimizeVertexCache(simplified.data(), simplified.data(), count, vertexCount);
+            part.offset = uint32_t(mesh.indices.size());
+            part.indexCount = uint32_t(count);
+            mesh.indices.insert(mesh.indices.end(), simplified.begin(), simplified.begin() + count);
+        }
+        mesh.lods.push_back(parts);
+        previous = std::move(parts);
+    }
 
     // At this point, triangle order has been established but we still need to shuffle vertices to
     // optimize the fetch. This makes it so that lower-numbered indices generally come before
-    // higher-numbered indices.
+    // higher-numbered indices. Vertices that are not referenced by any triangle are dropped.
+    vector<uint32_t> remapping(vertexCount);
+    const size_t uniqueVertexCount = meshopt_optimizeVertexFetchRemap(remapping.data(),
+            mesh.indices.data(), mesh.indices.size(), vertexCount);
+
+    meshopt_remapIndexBuffer(mesh.indices.data(), mesh.indices.data(), mesh.indices.size(),
+            remapping.data());
+
+    auto remap = [&](auto& attribute) {
+        meshopt_remapVertexBuffer(attribute.data(), attribute.data(), vertexCount,
+                sizeof(attribute[0]), remapping.data());
+        attribute.erase(attribute.begin() + uniqueVertexCount, attribute.end());
+    };
+
     if (mFlags & INTERLEAVED) {
-        meshopt_optimizeVertexFetch(mesh.vertices.data(), mesh.indices.data(),
-                mesh.indices.size(), mesh.vertices.data(), mesh.vertices.size(),
-                sizeof(Vertex));
+        remap(mesh.vertices);
     } else {
-        const uint32_t vertexCount = mesh.vertexCount;
-
-        // Allocate a remapping table and create a copy of the index buffer.
-        vector<uint32_t> remappingVector(vertexCount);
-        vector<uint32_t> indicesVector = mesh.indices;
-        uint32_t* remapping = remappingVector.data();
-        const uint32_t* indices = indicesVector.data();
-
-        // Populate the remapping table.
-        meshopt_optimizeVertexFetchRemap(remapping, mesh.indices.data(),
-                mesh.indices.size(), vertexCount);
-
-        // Apply the remapping table.
-        meshopt_remapIndexBuffer(mesh.indices.data(), indices, mesh.indices.size(), remapping);
-        meshopt_remapVertexBuffer(mesh.positions.data(), mesh.positions.data(),
-                vertexCount, sizeof(decltype(Vertex::position)), remapping);
-        meshopt_remapVertexBuffer(mesh.tangents.data(), mesh.tangents.data(),
-                vertexCount, sizeof(decltype(Vertex::tangents)), remapping);
-        meshopt_remapVertexBuffer(mesh.colors.data(), mesh.colors.data(),
-                vertexCount, sizeof(decltype(Vertex::color)), remapping);
-        meshopt_remapVertexBuffer(mesh.uv0.data(), mesh.uv0.data(),
-                vertexCount, sizeof(decltype(Vertex::uv0)), remapping);
+        remap(mesh.positions);
+        remap(mesh.tangents);
+        remap(mesh.colors);
+        remap(mesh.uv0);
         if (!mesh.uv1.empty()) {
-            meshopt_remapVertexBuffer(mesh.uv1.data(), mesh.uv1.data(),
-                    vertexCount, sizeof(decltype(Vertex::uv0)), remapping);
+            remap(mesh.uv1);
+        }
+    }
+    mesh.vertexCount = uint32_t(uniqueVertexCount);
+
+    // The index range of each part has changed, so compute it again.
+    auto updateRange = [&mesh](Part& part) {
+        const uint32_t* indices = mesh.indices.data() + part.offset;
+        part.minIndex = numeric_limits<uint32_t>::max();
+        part.maxIndex = 0;
+        for (size_t i = 0; i < part.indexCount; i++) {
+            part.minIndex = std::min(part.minIndex, indices[i]);
+            part.maxIndex = std::max(part.maxIndex, indices[i]);
+        }
+    };
+    for (Part& part : mesh.parts) {
+        updateRange(part);
+    }
+    for (auto& parts : mesh.lods) {
+        for (Part& part : parts) {
+            updateRange(part);
         }
     }
 
@@ -171,7 +232,7 @@ bool MeshWriter::serialize(ostream& out, Mesh& mesh) {
     header.version = VERSION;
     header.parts = uint32_t(mesh.parts.size());
     header.aabb = aabb;
-    header.flags = mFlags;
+    header.flags = mFlags | (mesh.lods.empty() ? 0 : LODS);
     if (mFlags & INTERLEAVED) {
         header.offsetPosition = offsetof(Vertex, position);
         header.offsetTangents = offsetof(Vertex, tangents);
@@ -250,5 +311,12 @@ bool MeshWriter::serialize(ostream& out, Mesh& mesh) {
         write(out, char(0));
     }
 
+    if (!mesh.lods.empty()) {
+        write(out, uint32_t(mesh.lods.size() + 1));
+        for (const auto& parts : mesh.lods) {
+            write(out, parts.data(), header.parts);
+        }
+    }
+
     return true;
 }
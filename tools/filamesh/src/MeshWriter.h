@@ -42,6 +42,8 @@ struct Vertex {
 
 struct Mesh {
     std::vector<Part> parts;
+    // parts of each level of detail after the first, indexing into the same buffers
+    std::vector<std::vector<Part>> lods;
     std::vector<std::string> materials;
     uint32_t vertexCount = 0;
     std::vector<uint32_t> indices;
@@ -57,9 +59,10 @@ struct Mesh {
 
 class MeshWriter {
     uint32_t mFlags;
+    uint32_t mLodCount;
     void optimize(Mesh& mesh);
 public:
-    MeshWriter(uint32_t flags) : mFlags(flags) {}
+    MeshWriter(uint32_t flags, uint32_t lodCount = 1) : mFlags(flags), mLodCount(lodCount) {}
     bool serialize(std::ostream&, Mesh& mesh);
 };
 
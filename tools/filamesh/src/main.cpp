@@ -47,6 +47,7 @@ using Assimp::Importer;
 bool g_interleaved = false;
 bool g_snormUVs = false;
 bool g_compression = false;
+uint32_t g_lodCount = 1;
 
 Mesh g_mesh;
 float2 g_minUV = float2(std::numeric_limits<float>::max());
@@ -241,6 +242,8 @@ static void printUsage(const char* name) {
                     "       interleaves mesh attributes\n\n"
                     "   --compress, -c\n"
                     "       enable compression\n\n"
+                    "   --lods=<count>, -L <count>\n"
+                    "       generate up to <count> levels of detail by simplification (1 to 4)\n\n"
     );
 
     const std::string from("FILAMESH");
@@ -262,12 +265,13 @@ static void license() {
 }
 
 static int handleArguments(int argc, char* argv[]) {
-    static constexpr const char* OPTSTR = "hilc";
+    static constexpr const char* OPTSTR = "hilcL:";
     static const struct option OPTIONS[] = {
             { "help",        no_argument, 0, 'h' },
             { "license",     no_argument, 0, 'l' },
             { "interleaved", no_argument, 0, 'i' },
             { "compress",    no_argument, 0, 'c' },
+            { "lods",        required_argument, 0, 'L' },
             { 0, 0, 0, 0 }  // termination of the option list
     };
 
@@ -275,7 +279,7 @@ static int handleArguments(int argc, char* argv[]) {
     int optionIndex = 0;
 
     while ((opt = getopt_long(argc, argv, OPTSTR, OPTIONS, &optionIndex)) >= 0) {
-        // std::string arg(optarg ? optarg : "");
+        std::string arg(optarg ? optarg : "");
         switch (opt) {
             default:
             case 'h':
@@ -292,6 +296,16 @@ static int handleArguments(int argc, char* argv[]) {
             case 'c':
                 g_compression = true;
                 break;
+            case 'L': {
+                const int count = atoi(arg.c_str());
+                if (count < 1 || count > int(filamesh::MAX_LOD_COUNT)) {
+                    std::cerr << "The number of levels of detail must be between 1 and "
+                            << filamesh::MAX_LOD_COUNT << std::endl;
+                    exit(1);
+                }
+                g_lodCount = uint32_t(count);
+                break;
+            }
         }
     }
 
@@ -399,7 +413,7 @@ int main(int argc, char* argv[]) {
     if (g_compression) {
         flags |= filamesh::COMPRESSION;
     }
-    MeshWriter(flags).serialize(out, g_mesh);
+    MeshWriter(flags, g_lodCount).serialize(out, g_mesh);
 
     out.flush();
     out.close();
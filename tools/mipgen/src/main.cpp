@@ -27,6 +27,7 @@
 #include <imageio/ImageDecoder.h>
 #include <imageio/ImageEncoder.h>
 
+#include <utils/JobSystem.h>
 #include <utils/Path.h>
 
 #include <getopt/getopt.h>
@@ -309,14 +310,22 @@ int main(int argc, char* argv[]) {
         sourceImage = colorsToVectors(sourceImage);
     }
 
-    if (!g_quietMode) {
-        puts("Generating miplevels...");
-    }
-
     uint32_t count = getMipmapCount(sourceImage);
     count = g_mipLevelCount == 0 ? count : min(g_mipLevelCount - 1, count);
-    vector<LinearImage> miplevels(count);
-    generateMipmaps(sourceImage, g_filter, miplevels.data(), count);
+    utils::JobSystem js;
+
+    // Compressed KTX bundles generate each miplevel right before compressing it, so that the
+    // uncompressed chain is never held in memory in its entirety.
+    vector<LinearImage> miplevels;
+    if (!g_ktxContainer || g_compression.empty()) {
+        if (!g_quietMode) {
+            puts("Generating miplevels...");
+        }
+        miplevels.resize(count);
+        js.adopt();
+        generateMipmaps(js, sourceImage, g_filter, miplevels.data(), count);
+        js.emancipate();
+    }
 
     if (g_ktxContainer) {
         if (!g_quietMode) {
@@ -326,7 +335,7 @@ int main(int argc, char* argv[]) {
         // The libimage API does not include the original image in the mip array,
         // which might make sense when generating individual files, but for a KTX
         // bundle, we want to include level 0, so add 1 to the KTX level count.
-        KtxBundle container(1 + miplevels.size(), 1, false);
+        KtxBundle container(1 + count, 1, false);
         auto& info = container.info();
         info = {
             .endianness = KtxBundle::ENDIAN_DEFAULT,
@@ -372,21 +381,6 @@ int main(int argc, char* argv[]) {
                 image = vectorsToColors(image);
             }
             std::unique_ptr<uint8_t[]> data;
-#ifdef IMAGEIO_SUPPORTS_BLOCK_COMPRESSION
-            if (config.type != CompressionConfig::INVALID) {
-                // Some encoders call exit(1) upon failure, so it's very useful to print some
-                // source image information here for when this is invoked from a build script.
-                // Note that some encoders also have limitations in terms of image size.
-                if (!g_quietMode) {
-                    printf("Starting compression for %s (%dx%d)\n", inputPath.getName().c_str(),
-                            image.getWidth(), image.getHeight());
-                }
-                CompressedTexture tex = compressTexture(config, image);
-                container.setBlob({mip++}, tex.data.get(), tex.size);
-                info.glInternalFormat = (uint32_t) tex.format;
-                return;
-            }
-#endif
             if (g_grayscale && g_linearized) {
                 data = fromLinearToGrayscale<uint8_t>(image);
             } else if (g_grayscale) {
@@ -407,9 +401,45 @@ int main(int argc, char* argv[]) {
             container.setBlob({mip++, 0, 0}, data.get(), image.getWidth() * image.getHeight() *
                     container.info().glTypeSize * componentCount);
         };
-        addLevel(sourceImage);
-        for (auto image : miplevels) {
-            addLevel(image);
+        bool compressed = false;
+#ifdef IMAGEIO_SUPPORTS_BLOCK_COMPRESSION
+        if (config.type != CompressionConfig::INVALID) {
+            // Some encoders call exit(1) upon failure, so it's very useful to print some
+            // source image information here for when this is invoked from a build script.
+            // Note that some encoders also have limitations in terms of image size.
+            if (!g_quietMode) {
+                printf("Starting compression for %s (%dx%d, %d levels)\n",
+                        inputPath.getName().c_str(), sourceImage.getWidth(),
+                        sourceImage.getHeight(), 1 + count);
+            }
+            const ImageSampler sampler { .horizontalFilter = g_filter, .verticalFilter = g_filter };
+            auto generateLevel = [&](uint32_t level) {
+                LinearImage image = sourceImage;
+                if (level > 0) {
+                    image = resampleImage(js, sourceImage,
+                            std::max(sourceImage.getWidth() >> level, 1u),
+                            std::max(sourceImage.getHeight() >> level, 1u), sampler);
+                }
+                if (g_filter == Filter::GAUSSIAN_NORMALS) {
+                    image = vectorsToColors(image);
+                }
+                return image;
+            };
+            js.adopt();
+            compressMipmaps(js, config, 1 + count, generateLevel,
+                    [&](uint32_t level, CompressedTexture tex) {
+                container.setBlob({level}, tex.data.get(), tex.size);
+                info.glInternalFormat = (uint32_t) tex.format;
+            });
+            js.emancipate();
+            compressed = true;
+        }
+#endif
+        if (!compressed) {
+            addLevel(sourceImage);
+            for (auto image : miplevels) {
+                addLevel(image);
+            }
         }
         vector<uint8_t> fileContents(container.getSerializedLength());
         container.serialize(fileContents.data(), fileContents.size());